@@ -0,0 +1,300 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Headless draw transform benchmark
+ *
+ * Builds many vehicle-like hierarchies (a deep chain of parts, each with a few attached leaf
+ * parts) and times SysRender::update_draw_transforms against the previous recursive traversal.
+ * Transforms are timed both in creation order and sorted into scene graph order by
+ * SysSceneGraph::sort_by_tree, and the root range is also split between threads.
+ *
+ * All variants must produce identical draw transforms; the benchmark fails if they don't.
+ */
+
+#include <osp/activescene/basic.h>
+#include <osp/activescene/basic_fn.h>
+#include <osp/drawing/drawing_fn.h>
+#include <osp/util/logging.h>
+
+#include <Corrade/Utility/Arguments.h>
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace osp;
+using namespace osp::active;
+using namespace osp::draw;
+
+using Clock_t = std::chrono::steady_clock;
+
+namespace
+{
+
+struct Scene
+{
+    ACtxBasic                       basic;
+    ActiveEntSet_t                  needDrawTf;
+    KeyedVec<ActiveEnt, DrawEnt>    activeToDraw;
+    DrawTransforms_t                drawTf;
+    std::vector<ActiveEnt>          roots;
+};
+
+/**
+ * @brief Add a chain of parts, each with leafCount leaves attached, below a parent
+ */
+void add_chain(SubtreeBuilder &rParent, std::vector<ActiveEnt>::const_iterator &rEnt, int levels, int leafCount)
+{
+    uint32_t const descendants = leafCount + (levels - 1) * (leafCount + 1);
+
+    SubtreeBuilder bldPart = rParent.add_child(*rEnt, descendants);
+    ++rEnt;
+
+    for (int i = 0; i < leafCount; ++i)
+    {
+        bldPart.add_child(*rEnt);
+        ++rEnt;
+    }
+
+    if (levels > 1)
+    {
+        add_chain(bldPart, rEnt, levels - 1, leafCount);
+    }
+}
+
+void make_scene(Scene &rScene, int vehicles, int depth, int leafCount, bool sorted)
+{
+    std::size_t const perVehicle = std::size_t(depth) * (leafCount + 1);
+    std::size_t const total      = vehicles * perVehicle;
+
+    std::vector<ActiveEnt> ents(total);
+    rScene.basic.m_activeIds.create(ents.begin(), ents.end());
+
+    std::size_t const capacity = rScene.basic.m_activeIds.capacity();
+    rScene.basic.m_scnGraph.resize(capacity);
+    rScene.activeToDraw.resize(capacity, lgrn::id_null<DrawEnt>());
+    rScene.drawTf.resize(total);
+    rScene.needDrawTf.resize(capacity);
+
+    SubtreeBuilder bldScnRoot = SysSceneGraph::add_descendants(rScene.basic.m_scnGraph, uint32_t(total));
+
+    auto entIt = std::as_const(ents).begin();
+    for (int v = 0; v < vehicles; ++v)
+    {
+        rScene.roots.push_back(*entIt);
+        add_chain(bldScnRoot, entIt, depth, leafCount);
+    }
+
+    // Emplace transforms in a shuffled order, as if parts were created and attached over time
+    std::vector<ActiveEnt> order = ents;
+    std::shuffle(order.begin(), order.end(), std::mt19937{1337});
+
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<float> offset{-1.0f, 1.0f};
+    std::uniform_real_distribution<float> angle{-0.2f, 0.2f};
+
+    uint32_t drawEnt = 0;
+    for (ActiveEnt const ent : order)
+    {
+        Matrix4 const tf = Matrix4::translation({offset(rng), offset(rng), offset(rng)})
+                         * Matrix4::rotationZ(Rad{angle(rng)});
+        rScene.basic.m_transform.emplace(ent, ACompTransform{tf});
+        rScene.needDrawTf.insert(ent);
+        rScene.activeToDraw[ent] = DrawEnt{drawEnt};
+        ++drawEnt;
+    }
+
+    if (sorted)
+    {
+        SysSceneGraph::sort_by_tree(rScene.basic.m_scnGraph, rScene.basic.m_transform);
+    }
+}
+
+SysRender::ArgsForUpdDrawTransform args_for(Scene &rScene)
+{
+    return {
+        .scnGraph     = rScene.basic.m_scnGraph,
+        .transforms   = rScene.basic.m_transform,
+        .activeToDraw = rScene.activeToDraw,
+        .needDrawTf   = rScene.needDrawTf,
+        .rDrawTf      = rScene.drawTf
+    };
+}
+
+/**
+ * @brief Previous implementation of SysRender::update_draw_transforms, kept as a baseline
+ */
+void recurse(SysRender::ArgsForUpdDrawTransform const &args, ActiveEnt ent, Matrix4 const &parentTf)
+{
+    Matrix4 const entDrawTf = parentTf * args.transforms.get(ent).m_transform;
+
+    DrawEnt const drawEnt = args.activeToDraw[ent];
+    if (drawEnt != lgrn::id_null<DrawEnt>())
+    {
+        args.rDrawTf[drawEnt] = entDrawTf;
+    }
+
+    for (ActiveEnt const entChild : SysSceneGraph::children(args.scnGraph, ent))
+    {
+        if (args.needDrawTf.contains(entChild))
+        {
+            recurse(args, entChild, entDrawTf);
+        }
+    }
+}
+
+void update_recursive(Scene &rScene, int /*threads*/)
+{
+    static Matrix4 const identity{};
+    auto const args = args_for(rScene);
+    for (ActiveEnt const root : rScene.roots)
+    {
+        if (args.needDrawTf.contains(root))
+        {
+            recurse(args, root, identity);
+        }
+    }
+}
+
+void update_linear(Scene &rScene, int /*threads*/)
+{
+    SysRender::update_draw_transforms(args_for(rScene), rScene.roots.begin(), rScene.roots.end());
+}
+
+void update_threaded(Scene &rScene, int threads)
+{
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+
+    std::size_t const count = rScene.roots.size();
+    for (int i = 0; i < threads; ++i)
+    {
+        auto const first = rScene.roots.begin() + (count * i / threads);
+        auto const last  = rScene.roots.begin() + (count * (i + 1) / threads);
+        workers.emplace_back([&rScene, first, last] ()
+        {
+            SysRender::update_draw_transforms(args_for(rScene), first, last);
+        });
+    }
+
+    for (std::thread &rWorker : workers)
+    {
+        rWorker.join();
+    }
+}
+
+struct Variant
+{
+    char const                          *name;
+    bool                                sorted;
+    std::function<void(Scene&, int)>    update;
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Corrade::Utility::Arguments args;
+    args.addOption("vehicles", "1000")  .setHelp("vehicles",    "Number of root hierarchies")
+        .addOption("depth", "25")       .setHelp("depth",       "Length of each vehicle's chain of parts")
+        .addOption("leaves", "3")       .setHelp("leaves",      "Leaf parts attached to each part in the chain")
+        .addOption("frames", "200")     .setHelp("frames",      "Number of updates to time per variant")
+        .addOption("threads", "0")      .setHelp("threads",     "Threads for the threaded variant, 0 for hardware concurrency")
+        .setGlobalHelp("Times draw transform propagation through deep scene graph hierarchies.")
+        .parse(argc, argv);
+
+    auto pSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+    pSink->set_pattern("[%T.%e] [%n] [%^%l%$] %v");
+    osp::set_thread_logger(std::make_shared<spdlog::logger>("benchmark", std::move(pSink)));
+
+    int const vehicles = args.value<int>("vehicles");
+    int const depth    = args.value<int>("depth");
+    int const leaves   = args.value<int>("leaves");
+    int const frames   = args.value<int>("frames");
+    int const threads  = std::max(1, args.value<int>("threads") != 0 ? args.value<int>("threads")
+                                                                     : int(std::thread::hardware_concurrency()));
+
+    std::vector<Variant> const variants
+    {
+        { "recursive",          false, update_recursive },
+        { "recursive-sorted",   true,  update_recursive },
+        { "linear",             false, update_linear    },
+        { "linear-sorted",      true,  update_linear    },
+        { "threaded-sorted",    true,  update_threaded  }
+    };
+
+    OSP_LOG_INFO("{} vehicles x {} parts = {} entities, depth {}, {} threads",
+                 vehicles, depth * (leaves + 1), vehicles * depth * (leaves + 1), depth, threads);
+
+    std::printf("%-18s %12s %12s %12s\n", "variant", "total ms", "frame ms", "ns/entity");
+
+    DrawTransforms_t reference;
+    bool             mismatch = false;
+
+    for (Variant const &variant : variants)
+    {
+        Scene scene;
+        make_scene(scene, vehicles, depth, leaves, variant.sorted);
+
+        variant.update(scene, threads); // Warm up
+
+        auto const t0 = Clock_t::now();
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            variant.update(scene, threads);
+        }
+        auto const t1 = Clock_t::now();
+
+        double const totalMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        double const frameMs = totalMs / frames;
+
+        std::printf("%-18s %12.3f %12.4f %12.2f\n",
+                    variant.name, totalMs, frameMs, frameMs * 1.0e6 / double(scene.drawTf.size()));
+
+        if (reference.size() == 0)
+        {
+            reference = scene.drawTf;
+        }
+        else if ( ! std::equal(reference.begin(), reference.end(), scene.drawTf.begin()) )
+        {
+            OSP_LOG_ERROR("Variant '{}' produced different draw transforms", variant.name);
+            mismatch = true;
+        }
+    }
+
+    spdlog::shutdown();
+    return mismatch ? 1 : 0;
+}
@@ -0,0 +1,188 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "run.h"
+
+#include <ospjolt/activescene/joltinteg_fn.h>
+
+#include <utility>
+
+using namespace ospjolt;
+
+using osp::active::ActiveEnt;
+using osp::Vector3;
+
+namespace benchmark
+{
+
+namespace
+{
+
+struct JoltBackend : BackendBase
+{
+    JoltBackend(int const threadCount)
+     : jolt{(ACtxJoltWorld::initJoltGlobal(), threadCount)}
+    {
+        // Gravity, same as add_constant_acceleration
+        jolt.m_factors.push_back({
+            .m_func = [] (BodyId const bodyId, ACtxJoltWorld const& rJolt, entt::any userData, Vector3& rForce, Vector3& rTorque) noexcept
+            {
+                Vector3 const force = entt::any_cast<Vector3>(userData);
+                float const invMass = SysJolt::get_inverse_mass_no_lock(*rJolt.m_pPhysicsSystem, bodyId);
+                rForce += force / invMass;
+            },
+            .m_userData = entt::make_any<Vector3>(gc_gravity)
+        });
+        gravity.set(0);
+    }
+
+    void add(std::vector<Spawn> const &bodies, std::vector<VehicleSpawn> const &vehicles)
+    {
+        // Same as ftrPhysicsShapesJolt
+        for (Spawn const &spawn : bodies)
+        {
+            bool const dynamic = spawn.mass > 0.0f;
+            ActiveEnt const ent = create_ent(spawn.position, dynamic);
+
+            Ref<Shape> pShape = SysJolt::create_primitive(jolt, spawn.shape, Vec3MagnumToJolt(spawn.size));
+
+            BodyCreationSettings bodyCreation(pShape,
+                                              Vec3MagnumToJolt(spawn.position),
+                                              Quat::sIdentity(),
+                                              dynamic ? EMotionType::Dynamic : EMotionType::Static,
+                                              dynamic ? Layers::DEBRIS : Layers::NON_MOVING);
+            if (dynamic)
+            {
+                MassProperties massProp;
+                Vector3 const inertia = osp::collider_inertia_tensor(spawn.shape, spawn.size, spawn.mass);
+                massProp.mMass = spawn.mass;
+                massProp.mInertia = Mat44::sScale(Vec3MagnumToJolt(inertia));
+                bodyCreation.mMassPropertiesOverride = massProp;
+                bodyCreation.mOverrideMassProperties = EOverrideMassProperties::MassAndInertiaProvided;
+                bodyCreation.mLinearVelocity = Vec3MagnumToJolt(spawn.velocity);
+            }
+
+            SysJolt::create_body(jolt, ent, bodyCreation, gravity);
+        }
+
+        // Same as ftrVehicleSpawnJolt, with the compound built from VehicleParts
+        for (VehicleSpawn const &vehicle : vehicles)
+        {
+            ActiveEnt const ent = create_ent(vehicle.position, true);
+
+            // Identical vehicles share one cached compound
+            children.clear();
+            float totalMass = 0.0f;
+            for (VehiclePart const &part : vehicle.parts)
+            {
+                children.push_back({
+                    .m_position = Vec3MagnumToJolt(part.position),
+                    .m_rotation = Quat::sIdentity(),
+                    .m_shape    = SysJolt::create_primitive(jolt, part.shape, Vec3MagnumToJolt(part.size))});
+                totalMass += part.mass;
+            }
+
+            BodyCreationSettings bodyCreation(SysJolt::create_compound(jolt, children),
+                                              Vec3MagnumToJolt(vehicle.position),
+                                              Quat::sIdentity(),
+                                              EMotionType::Dynamic,
+                                              Layers::VEHICLE);
+            bodyCreation.mOverrideMassProperties        = EOverrideMassProperties::CalculateInertia;
+            bodyCreation.mMassPropertiesOverride.mMass  = totalMass;
+
+            SysJolt::create_body(jolt, ent, bodyCreation, gravity);
+        }
+
+        SysJolt::add_created_bodies(jolt);
+    }
+
+    void step(float const deltaTime)
+    {
+        SysJolt::step_world(phys, jolt, deltaTime, basic.m_transform);
+    }
+
+    void sync()
+    {
+        SysJolt::write_transforms(phys, jolt, basic.m_transform);
+    }
+
+    void delete_out_of_bounds()
+    {
+        SysJolt::update_delete(jolt, outOfBounds.cbegin(), outOfBounds.cend());
+    }
+
+    std::size_t body_count() const
+    {
+        return jolt.m_entToBody.size();
+    }
+
+    /**
+     * @brief Previous SysJolt::update_translate, kept for comparison: SetPosition on each body
+     *        through the locking BodyInterface, updating the broadphase once per body
+     */
+    void rebase_locked()
+    {
+        Vector3 const translate = std::exchange(phys.m_originTranslate, {});
+
+        BodyIDVector allBodiesIds;
+        jolt.m_pPhysicsSystem->GetBodies(allBodiesIds);
+
+        BodyInterface &bodyInterface = jolt.m_pPhysicsSystem->GetBodyInterface();
+        for (BodyID const bodyId : allBodiesIds)
+        {
+            bodyInterface.SetPosition(bodyId, bodyInterface.GetPosition(bodyId) + Vec3MagnumToJolt(translate), EActivation::DontActivate);
+        }
+
+        // Same transform write-back as update_translate, so the steps after are comparable
+        jolt.m_originTranslated = true;
+    }
+
+    ForceFactors_t                  gravity;
+    std::vector<JoltCompoundChild>  children;
+    ACtxJoltWorld                   jolt;
+};
+
+} // namespace
+
+BenchResults run_jolt(BenchScene const &scene, BenchSettings const &settings)
+{
+    return run_scene<JoltBackend>(scene, settings);
+}
+
+RebaseResults run_jolt_rebase(BenchScene const &scene, BenchSettings const &settings, int const rebases, bool const locked)
+{
+    return run_rebase<JoltBackend>(scene, settings, rebases, [locked] (JoltBackend &rBackend)
+    {
+        if (locked)
+        {
+            rBackend.rebase_locked();
+        }
+        else
+        {
+            SysJolt::update_translate(rBackend.phys, rBackend.jolt);
+        }
+    });
+}
+
+} // namespace benchmark
@@ -0,0 +1,189 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "run.h"
+
+#include <ospnewton/activescene/newtoninteg_fn.h>
+
+#include <Newton.h>
+
+using namespace ospnewton;
+
+using osp::active::ActiveEnt;
+using osp::Matrix3;
+using osp::Matrix4;
+using osp::Vector3;
+
+namespace benchmark
+{
+
+namespace
+{
+
+struct NewtonBackend : BackendBase
+{
+    NewtonBackend(int const threadCount)
+     : nwt{threadCount}
+    {
+        // Gravity, same as setup_newton_force_accel
+        nwt.m_factors.push_back({
+            .m_func = [] (NewtonBody const* pBody, BodyId const bodyID, ACtxNwtWorld const& rNwt, ACtxNwtWorld::ForceFactorFunc::UserData_t data, Vector3& rForce, Vector3& rTorque) noexcept
+            {
+                float mass = 0.0f;
+                float dummy = 0.0f;
+                NewtonBodyGetMass(pBody, &mass, &dummy, &dummy, &dummy);
+
+                auto const& force = *reinterpret_cast<Vector3 const*>(data[0]);
+                rForce += force * mass;
+            },
+            .m_userData = {&accel}
+        });
+        gravity.set(0);
+    }
+
+    NewtonBody* add_body(ActiveEnt const ent, NewtonCollision const* pCollision, Vector3 const position)
+    {
+        NewtonBody *pBody = NewtonCreateDynamicBody(nwt.m_world.get(), pCollision, Matrix4::translation(position).data());
+
+        BodyId const bodyId = nwt.m_bodyIds.create();
+        SysNewton::resize_body_data(nwt);
+
+        nwt.m_bodyPtrs[bodyId].reset(pBody);
+
+        nwt.m_bodyToEnt[bodyId]    = ent;
+        nwt.m_bodyFactors[bodyId]  = gravity;
+        nwt.m_entToBody.emplace(ent, bodyId);
+
+        NewtonBodySetLinearDamping(pBody, 0.0f);
+        NewtonBodySetForceAndTorqueCallback(pBody, &SysNewton::cb_force_torque);
+        NewtonBodySetTransformCallback(pBody, &SysNewton::cb_set_transform);
+        SysNewton::set_userdata_bodyid(pBody, bodyId);
+
+        return pBody;
+    }
+
+    void add(std::vector<Spawn> const &bodies, std::vector<VehicleSpawn> const &vehicles)
+    {
+        // Same as setup_phys_shapes_newton, but without child entities
+        for (Spawn const &spawn : bodies)
+        {
+            ActiveEnt const ent = create_ent(spawn.position, spawn.mass > 0.0f);
+
+            NwtColliderPtr_t pCollision{ SysNewton::create_primative(nwt, spawn.shape) };
+            SysNewton::orient_collision(pCollision.get(), spawn.shape, {0.0f, 0.0f, 0.0f}, Matrix3{}, spawn.size);
+
+            NewtonBody *pBody = add_body(ent, pCollision.get(), spawn.position);
+
+            Vector3 const inertia = (spawn.mass > 0.0f)
+                                  ? osp::collider_inertia_tensor(spawn.shape, spawn.size, spawn.mass)
+                                  : Vector3{0.0f};
+            NewtonBodySetMassMatrix(pBody, spawn.mass, inertia.x(), inertia.y(), inertia.z());
+
+            if (spawn.mass > 0.0f)
+            {
+                phys.m_setVelocity.emplace_back(ent, spawn.velocity);
+            }
+        }
+
+        for (VehicleSpawn const &vehicle : vehicles)
+        {
+            ActiveEnt const ent = create_ent(vehicle.position, true);
+
+            // Identical vehicles share one cached compound
+            osp::ShapeKey key;
+            key.add(std::int32_t(vehicle.parts.size()));
+            float totalMass = 0.0f;
+            for (VehiclePart const &part : vehicle.parts)
+            {
+                key.add(part.shape).add_lengths(part.position).add_lengths(part.size);
+                totalMass += part.mass;
+            }
+
+            NwtColliderPtr_t pCompound = SysNewton::find_compound(nwt, key);
+            if (pCompound == nullptr)
+            {
+                NwtColliderPtr_t pNew{ NewtonCreateCompoundCollision(nwt.m_world.get(), 0) };
+
+                NewtonCompoundCollisionBeginAddRemove(pNew.get());
+                for (VehiclePart const &part : vehicle.parts)
+                {
+                    NwtColliderPtr_t pPart{ SysNewton::create_primative(nwt, part.shape) };
+                    SysNewton::orient_collision(pPart.get(), part.shape, part.position, Matrix3{}, part.size);
+                    NewtonCompoundCollisionAddSubCollision(pNew.get(), pPart.get());
+                }
+                NewtonCompoundCollisionEndAddRemove(pNew.get());
+
+                SysNewton::cache_compound(nwt, key, std::move(pNew));
+                pCompound = SysNewton::find_compound(nwt, key);
+            }
+
+            NewtonBody *pBody = add_body(ent, pCompound.get(), vehicle.position);
+            NewtonBodySetMassProperties(pBody, totalMass, pCompound.get());
+
+            // Keeps the compound cached until the last vehicle using it is deleted
+            SysNewton::set_body_compound(nwt, SysNewton::get_userdata_bodyid(pBody), key);
+        }
+    }
+
+    void step(float const deltaTime)
+    {
+        SysNewton::step_world(phys, nwt, deltaTime, basic.m_transform);
+    }
+
+    void sync()
+    {
+        SysNewton::merge_transforms(phys, nwt, basic.m_transform);
+    }
+
+    void delete_out_of_bounds()
+    {
+        SysNewton::update_delete(nwt, outOfBounds.cbegin(), outOfBounds.cend());
+    }
+
+    std::size_t body_count() const
+    {
+        return nwt.m_entToBody.size();
+    }
+
+    Vector3         accel{gc_gravity};
+    ForceFactors_t  gravity;
+    ACtxNwtWorld    nwt;
+};
+
+} // namespace
+
+BenchResults run_newton(BenchScene const &scene, BenchSettings const &settings)
+{
+    return run_scene<NewtonBackend>(scene, settings);
+}
+
+RebaseResults run_newton_rebase(BenchScene const &scene, BenchSettings const &settings, int const rebases)
+{
+    return run_rebase<NewtonBackend>(scene, settings, rebases, [] (NewtonBackend &rBackend)
+    {
+        SysNewton::update_translate(rBackend.phys, rBackend.nwt);
+    });
+}
+
+} // namespace benchmark
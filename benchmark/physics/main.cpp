@@ -0,0 +1,222 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Headless physics benchmark comparing Jolt and Newton
+ *
+ * Builds the same scenes through SysJolt and SysNewton, steps them for a fixed number of frames,
+ * and reports step time, transform sync time, memory, and how far the backends drift apart.
+ *
+ * The 'rebase' scene instead times floating origin shifts (update_translate) of a large settled
+ * scene, and compares Jolt's bulk path against its previous locking per-body path.
+ */
+
+#include "run.h"
+
+#include <osp/util/logging.h>
+
+#include <Corrade/Utility/Arguments.h>
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace benchmark;
+
+namespace
+{
+
+std::vector<std::string> split_list(std::string const &str)
+{
+    std::vector<std::string> out;
+    std::istringstream stream{str};
+    for (std::string item; std::getline(stream, item, ','); )
+    {
+        out.push_back(item);
+    }
+    return out;
+}
+
+bool contains(std::vector<std::string> const &list, char const* item)
+{
+    return std::find(list.begin(), list.end(), item) != list.end();
+}
+
+void print_results(std::string const &scene, char const* engine, int const threads, int const frames, BenchResults const &results)
+{
+    std::printf("%-9s %-7s %7d %11.3f %11.3f %11.3f %11.3f %10.2f %8zu %8zu\n",
+                scene.c_str(), engine, threads,
+                results.stepTotalMs, results.stepTotalMs / frames, results.stepWorstMs,
+                results.syncTotalMs / frames,
+                double(results.memoryBytes) / (1024.0 * 1024.0),
+                results.bodiesSpawned, results.bodiesAtEnd);
+}
+
+/**
+ * @brief Compare final body positions between two runs of the same scene
+ */
+void print_drift(std::string const &scene, int const threads, BenchResults const &a, BenchResults const &b)
+{
+    double      sumSq       = 0.0;
+    double      maxDist     = 0.0;
+    std::size_t compared    = 0;
+    std::size_t mismatched  = 0; // deleted by only one of the backends
+
+    std::size_t const count = std::min(a.finalPositions.size(), b.finalPositions.size());
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        bool const nanA = std::isnan(a.finalPositions[i].x());
+        bool const nanB = std::isnan(b.finalPositions[i].x());
+        if (nanA || nanB)
+        {
+            mismatched += (nanA != nanB) ? 1 : 0;
+            continue;
+        }
+
+        double const dist = (a.finalPositions[i] - b.finalPositions[i]).length();
+        sumSq   += dist * dist;
+        maxDist  = std::max(maxDist, dist);
+        ++compared;
+    }
+
+    std::printf("%-9s drift   %7d  rms %.3f m, max %.3f m over %zu bodies, %zu deleted by only one backend\n",
+                scene.c_str(), threads,
+                (compared != 0) ? std::sqrt(sumSq / double(compared)) : 0.0, maxDist, compared, mismatched);
+}
+
+void print_rebase(char const* engine, int const threads, int const rebases, RebaseResults const &results)
+{
+    std::printf("%-10s %7d %8zu %13.3f %13.3f %15.3f %14.3f\n",
+                engine, threads, results.bodies,
+                results.rebaseTotalMs / rebases, results.rebaseWorstMs,
+                results.stepBeforeMs / rebases, results.stepAfterMs / rebases);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Corrade::Utility::Arguments args;
+    args.addOption("frames", "1200")        .setHelp("frames",      "Number of 60Hz steps to run per configuration")
+        .addOption("threads", "1,2,4,8")    .setHelp("threads",     "Comma-separated worker thread counts to compare")
+        .addOption("throw", "0.25")         .setHelp("throw",       "Seconds between thrown grids of spheres in 'droppers', 0 to disable")
+        .addOption("scenes", "droppers,scatter,piles,vehicles,rebase").setHelp("scenes", "Comma-separated scenes to run")
+        .addOption("engines", "jolt,newton") .setHelp("engines",    "Comma-separated physics engines to run")
+        .addOption("bodies", "1000")        .setHelp("bodies",      "Number of bodies in 'scatter'")
+        .addOption("rebases", "20")         .setHelp("rebases",     "Number of origin shifts in 'rebase'")
+        .addOption("rebase-bodies", "10000").setHelp("rebase-bodies", "Number of bodies in 'rebase'")
+        .setGlobalHelp("Runs identical physics scenes on Jolt and Newton headlessly and compares them.")
+        .parse(argc, argv);
+
+    auto pSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+    pSink->set_pattern("[%T.%e] [%n] [%^%l%$] %v");
+    osp::set_thread_logger(std::make_shared<spdlog::logger>("benchmark", std::move(pSink)));
+
+    BenchSettings settings
+    {
+        .frames         = args.value<int>("frames"),
+        .throwInterval  = args.value<float>("throw")
+    };
+
+    std::vector<std::string> const sceneNames = split_list(args.value("scenes"));
+    std::vector<std::string> const engines    = split_list(args.value("engines"));
+
+    std::vector<BenchScene> scenes;
+    if (contains(sceneNames, "droppers")) { scenes.push_back(make_scene_droppers()); }
+    if (contains(sceneNames, "scatter"))  { scenes.push_back(make_scene_scatter(args.value<int>("bodies"))); }
+    if (contains(sceneNames, "piles"))    { scenes.push_back(make_scene_piles(64, 10)); }
+    if (contains(sceneNames, "vehicles")) { scenes.push_back(make_scene_vehicles(50, 20)); }
+
+    std::printf("%-9s %-7s %7s %11s %11s %11s %11s %10s %8s %8s\n",
+                "scene", "engine", "threads", "total_ms", "avg_step_ms", "worst_ms", "avg_sync_ms", "mem_mib", "spawned", "at_end");
+
+    for (BenchScene const &scene : scenes)
+    {
+        for (std::string const &threadsStr : split_list(args.value("threads")))
+        {
+            settings.threads = std::stoi(threadsStr);
+
+            BenchResults jolt;
+            BenchResults newton;
+
+            if (contains(engines, "jolt"))
+            {
+                jolt = run_jolt(scene, settings);
+                print_results(scene.name, "jolt", settings.threads, settings.frames, jolt);
+            }
+            if (contains(engines, "newton"))
+            {
+                newton = run_newton(scene, settings);
+                print_results(scene.name, "newton", settings.threads, settings.frames, newton);
+            }
+            if ( ! jolt.finalPositions.empty() && ! newton.finalPositions.empty() )
+            {
+                print_drift(scene.name, settings.threads, jolt, newton);
+            }
+        }
+    }
+
+    if (contains(sceneNames, "rebase"))
+    {
+        int const        rebases = std::max(args.value<int>("rebases"), 1);
+        BenchScene const scene   = make_scene_scatter(args.value<int>("rebase-bodies"));
+
+        std::printf("\n%-10s %7s %8s %13s %13s %15s %14s\n",
+                    "rebase", "threads", "bodies", "avg_rebase_ms", "worst_ms", "step_before_ms", "step_after_ms");
+
+        for (std::string const &threadsStr : split_list(args.value("threads")))
+        {
+            settings.threads = std::stoi(threadsStr);
+
+            if (contains(engines, "jolt"))
+            {
+                RebaseResults const bulk   = run_jolt_rebase(scene, settings, rebases, false);
+                RebaseResults const locked = run_jolt_rebase(scene, settings, rebases, true);
+                print_rebase("jolt", settings.threads, rebases, bulk);
+                print_rebase("jolt-lock", settings.threads, rebases, locked);
+
+                // Rebase and the step after it, as a degraded broadphase makes the step slower
+                double const bulkMs   = bulk.rebaseTotalMs   + bulk.stepAfterMs;
+                double const lockedMs = locked.rebaseTotalMs + locked.stepAfterMs;
+                std::printf("%-10s %7d  rebase + next step %.2fx faster than jolt-lock\n",
+                            "jolt", settings.threads, (bulkMs > 0.0) ? lockedMs / bulkMs : 0.0);
+            }
+            if (contains(engines, "newton"))
+            {
+                print_rebase("newton", settings.threads, rebases, run_newton_rebase(scene, settings, rebases));
+            }
+        }
+    }
+
+    spdlog::shutdown();
+    return 0;
+}
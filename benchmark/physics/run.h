@@ -0,0 +1,253 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scene.h"
+
+#include <osp/activescene/basic.h>
+#include <osp/activescene/physics.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace benchmark
+{
+
+/**
+ * @brief Scene state shared by all physics backends
+ */
+struct BackendBase
+{
+    using ActiveEnt = osp::active::ActiveEnt;
+
+    /**
+     * @brief Create an entity with a transform for a new body, recorded in spawn order
+     */
+    ActiveEnt create_ent(osp::Vector3 const position, bool const dynamic)
+    {
+        ActiveEnt const ent = basic.m_activeIds.create();
+        basic.m_transform.emplace(ent, osp::active::ACompTransform{osp::Matrix4::translation(position)});
+
+        std::size_t const capacity = basic.m_activeIds.capacity();
+        this->dynamic   .resize(capacity);
+        phys.m_moved    .resize(capacity);
+
+        // Same as the spawn tasks, new bodies count as moved until the next step
+        phys.m_moved.insert(ent);
+
+        spawned.push_back(dynamic ? ent : lgrn::id_null<ActiveEnt>());
+        if (dynamic)
+        {
+            this->dynamic.insert(ent);
+        }
+        return ent;
+    }
+
+    /**
+     * @brief Move bodies below gc_boundsMinZ to outOfBounds, same as ftrBounds
+     *
+     * Only bodies in ACtxPhysics::m_moved are checked. IDs are not reused, so spawned can still
+     * refer to deleted entities.
+     */
+    void find_out_of_bounds()
+    {
+        for (ActiveEnt const ent : phys.m_moved)
+        {
+            if (   dynamic.contains(ent)
+                && basic.m_transform.get(ent).m_transform.translation().z() < gc_boundsMinZ)
+            {
+                outOfBounds.push_back(ent);
+            }
+        }
+
+        for (ActiveEnt const ent : outOfBounds)
+        {
+            dynamic     .erase(ent);
+            phys.m_moved.erase(ent);
+        }
+    }
+
+    void remove_out_of_bounds_transforms()
+    {
+        for (ActiveEnt const ent : outOfBounds)
+        {
+            basic.m_transform.remove(ent);
+        }
+        outOfBounds.clear();
+    }
+
+    std::vector<osp::Vector3> final_positions() const
+    {
+        constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+
+        std::vector<osp::Vector3> out;
+        out.reserve(spawned.size());
+        for (ActiveEnt const ent : spawned)
+        {
+            out.push_back( (ent != lgrn::id_null<ActiveEnt>() && basic.m_transform.contains(ent))
+                           ? basic.m_transform.get(ent).m_transform.translation()
+                           : osp::Vector3{nan});
+        }
+        return out;
+    }
+
+    osp::active::ACtxBasic      basic;
+    osp::active::ACtxPhysics    phys;
+
+    std::vector<ActiveEnt>      spawned;
+    osp::active::ActiveEntSet_t dynamic;
+    std::vector<ActiveEnt>      outOfBounds;
+};
+
+/**
+ * @brief Run a BenchScene on a physics backend
+ *
+ * BACKEND_T derives from BackendBase, is constructible from a thread count, and has:
+ * add(bodies, vehicles), step(deltaTime), sync(), delete_out_of_bounds(), and body_count().
+ */
+template <typename BACKEND_T>
+BenchResults run_scene(BenchScene const &scene, BenchSettings const &settings)
+{
+    using Clock_t = std::chrono::steady_clock;
+
+    BenchResults out;
+
+    std::size_t const memoryBefore = resident_bytes();
+    std::size_t       memoryPeak   = memoryBefore;
+
+    BACKEND_T backend{settings.threads};
+    backend.add(scene.bodies, scene.vehicles);
+    out.bodiesSpawned = scene.bodies.size() + scene.vehicles.size();
+
+    PhysicsLoad         load{ .throwInterval = settings.throwInterval };
+    std::vector<Spawn>  spawns;
+
+    float const deltaTime = 1.0f / 60.0f;
+
+    for (int frame = 0; frame < settings.frames; ++frame)
+    {
+        if (scene.droppers)
+        {
+            load.update(deltaTime, spawns);
+            backend.add(spawns, {});
+            out.bodiesSpawned += spawns.size();
+            spawns.clear();
+        }
+
+        auto const t0 = Clock_t::now();
+        backend.step(deltaTime);
+        auto const t1 = Clock_t::now();
+        backend.sync();
+        auto const t2 = Clock_t::now();
+
+        double const stepMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        out.stepTotalMs += stepMs;
+        out.stepWorstMs  = std::max(out.stepWorstMs, stepMs);
+        out.syncTotalMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+        backend.find_out_of_bounds();
+        backend.delete_out_of_bounds();
+        backend.remove_out_of_bounds_transforms();
+
+        if (frame % 60 == 0)
+        {
+            memoryPeak = std::max(memoryPeak, resident_bytes());
+        }
+    }
+
+    memoryPeak          = std::max(memoryPeak, resident_bytes());
+    out.memoryBytes     = memoryPeak - memoryBefore;
+    out.bodiesAtEnd     = backend.body_count();
+    out.finalPositions  = backend.final_positions();
+
+    return out;
+}
+
+/**
+ * @brief Time floating origin shifts of an already settled scene
+ *
+ * Each rebase moves the origin back and forth by 2km along X, and is surrounded by two timed
+ * steps to show the cost of a degraded broadphase.
+ *
+ * @param rebase    [in] Called with the backend after setting ACtxPhysics::m_originTranslate
+ */
+template <typename BACKEND_T, typename FUNC_T>
+RebaseResults run_rebase(BenchScene const &scene, BenchSettings const &settings, int const rebases, FUNC_T&& rebase)
+{
+    using Clock_t = std::chrono::steady_clock;
+
+    constexpr float deltaTime   = 1.0f / 60.0f;
+    constexpr int   settleSteps = 60;
+
+    auto const timed_step = [deltaTime] (BACKEND_T &rBackend) -> double
+    {
+        auto const t0 = Clock_t::now();
+        rBackend.step(deltaTime);
+        rBackend.sync();
+        return std::chrono::duration<double, std::milli>(Clock_t::now() - t0).count();
+    };
+
+    RebaseResults out;
+
+    BACKEND_T backend{settings.threads};
+    backend.add(scene.bodies, scene.vehicles);
+
+    for (int i = 0; i < settleSteps; ++i)
+    {
+        timed_step(backend);
+    }
+
+    for (int i = 0; i < rebases; ++i)
+    {
+        out.stepBeforeMs += timed_step(backend);
+
+        backend.phys.m_originTranslate = osp::Vector3{(i % 2 == 0) ? 2000.0f : -2000.0f, 0.0f, 0.0f};
+
+        auto const t0 = Clock_t::now();
+        rebase(backend);
+        double const rebaseMs = std::chrono::duration<double, std::milli>(Clock_t::now() - t0).count();
+        out.rebaseTotalMs += rebaseMs;
+        out.rebaseWorstMs  = std::max(out.rebaseWorstMs, rebaseMs);
+
+        out.stepAfterMs += timed_step(backend);
+    }
+
+    out.bodies = backend.body_count();
+    return out;
+}
+
+BenchResults run_newton(BenchScene const &scene, BenchSettings const &settings);
+
+BenchResults run_jolt(BenchScene const &scene, BenchSettings const &settings);
+
+RebaseResults run_newton_rebase(BenchScene const &scene, BenchSettings const &settings, int rebases);
+
+/**
+ * @param locked    [in] Use the locking per-body SetPosition path update_translate used to have
+ */
+RebaseResults run_jolt_rebase(BenchScene const &scene, BenchSettings const &settings, int rebases, bool locked);
+
+} // namespace benchmark
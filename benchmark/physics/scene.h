@@ -0,0 +1,326 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <osp/core/math_types.h>
+#include <osp/scientific/shapes.h>
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+    #include <unistd.h>
+#endif
+
+namespace benchmark
+{
+
+/**
+ * @brief A rigid body to add to the scene, same as adera::SpawnShape
+ */
+struct Spawn
+{
+    osp::Vector3    position;
+    osp::Vector3    velocity;
+    osp::Vector3    size;
+    float           mass;
+    osp::EShape     shape;
+};
+
+/**
+ * @brief Collider of a VehicleSpawn, relative to the vehicle's origin
+ */
+struct VehiclePart
+{
+    osp::Vector3    position;
+    osp::Vector3    size;
+    float           mass;
+    osp::EShape     shape;
+};
+
+/**
+ * @brief Single rigid body made of many parts, like a Weld of a vehicle
+ */
+struct VehicleSpawn
+{
+    osp::Vector3                position;
+    std::vector<VehiclePart>    parts;
+};
+
+/**
+ * @brief Initial contents of a benchmark scene, and whether to add droppers over time
+ */
+struct BenchScene
+{
+    std::string                 name;
+    std::vector<Spawn>          bodies;
+    std::vector<VehicleSpawn>   vehicles;
+    bool                        droppers{false};
+};
+
+struct BenchSettings
+{
+    int     threads         {2};
+    int     frames          {1200};
+    float   throwInterval   {0.25f};
+};
+
+/**
+ * @brief Timings and state after running a BenchScene
+ */
+struct BenchResults
+{
+    double      stepTotalMs     {};
+    double      stepWorstMs     {};
+    double      syncTotalMs     {};     ///< Time spent writing transforms back to ACompTransform
+    std::size_t memoryBytes     {};     ///< Growth of resident memory while running, approximate
+    std::size_t bodiesAtEnd     {};
+    std::size_t bodiesSpawned   {};
+
+    /// Final position of each body in spawn order (initial bodies, vehicles, then droppers).
+    /// NaN for bodies that were deleted or are static.
+    std::vector<osp::Vector3> finalPositions;
+};
+
+/**
+ * @brief Cost of floating origin shifts, see run_rebase
+ */
+struct RebaseResults
+{
+    double      rebaseTotalMs   {};
+    double      rebaseWorstMs   {};
+    double      stepBeforeMs    {};     ///< Total of the steps just before each rebase
+    double      stepAfterMs     {};     ///< Total of the steps just after each rebase
+    std::size_t bodies          {};
+};
+
+inline constexpr osp::Vector3 gc_gravity{0.0f, 0.0f, -9.81f};
+
+/// Bodies below this height are deleted, same as ftrBounds
+inline constexpr float gc_boundsMinZ = -10.0f;
+
+/**
+ * @brief Static boxes scattered around the origin, same as adera::add_floor
+ */
+inline void add_floor(int const size, std::vector<Spawn> &rSpawn)
+{
+    std::mt19937 randGen(69);
+    auto distSizeX  = std::uniform_real_distribution<float>{20.0, 80.0};
+    auto distSizeY  = std::uniform_real_distribution<float>{20.0, 80.0};
+    auto distHeight = std::uniform_real_distribution<float>{1.0, 10.0};
+
+    constexpr float spread = 128.0f;
+
+    for (int x = -size; x < size+1; ++x)
+    {
+        for (int y = -size; y < size+1; ++y)
+        {
+            float const heightZ = distHeight(randGen);
+            rSpawn.push_back({
+                .position = osp::Vector3{float(x)*spread, float(y)*spread, heightZ},
+                .velocity = {0.0f, 0.0f, 0.0f},
+                .size     = osp::Vector3{distSizeX(randGen), distSizeY(randGen), heightZ},
+                .mass     = 0.0f,
+                .shape    = osp::EShape::Box });
+        }
+    }
+}
+
+/**
+ * @brief The 'physics' scenario: floor, Droppers, and a repeating Thrower
+ */
+inline BenchScene make_scene_droppers()
+{
+    BenchScene out{ .name = "droppers", .droppers = true };
+    add_floor(4, out.bodies);
+    return out;
+}
+
+/**
+ * @brief Grid of count mixed spheres, boxes, and cylinders falling onto a large static box
+ */
+inline BenchScene make_scene_scatter(int const count)
+{
+    using osp::EShape;
+
+    BenchScene out{ .name = "scatter" };
+    out.bodies.push_back({ {0.0f, 0.0f, -1.0f}, {}, {200.0f, 200.0f, 1.0f}, 0.0f, EShape::Box });
+
+    constexpr std::array<EShape, 3> shapes{ EShape::Sphere, EShape::Box, EShape::Cylinder };
+    int const side = int(std::ceil(std::cbrt(float(count))));
+
+    for (int i = 0; i < count; ++i)
+    {
+        int const x = i % side;
+        int const y = (i / side) % side;
+        int const z = i / (side * side);
+        out.bodies.push_back({
+            .position = osp::Vector3{float(x - side/2) * 3.0f, float(y - side/2) * 3.0f, 5.0f + float(z) * 3.0f},
+            .velocity = {},
+            .size     = osp::Vector3{1.0f},
+            .mass     = 1.0f,
+            .shape    = shapes[std::size_t(i) % shapes.size()] });
+    }
+    return out;
+}
+
+/**
+ * @brief Columns of stacked boxes resting on a large static box
+ */
+inline BenchScene make_scene_piles(int const columns, int const height)
+{
+    BenchScene out{ .name = "piles" };
+    out.bodies.push_back({ {0.0f, 0.0f, -1.0f}, {}, {200.0f, 200.0f, 1.0f}, 0.0f, osp::EShape::Box });
+
+    int const side = int(std::ceil(std::sqrt(float(columns))));
+    for (int c = 0; c < columns; ++c)
+    {
+        float const x = float(c % side - side/2) * 4.0f;
+        float const y = float(c / side - side/2) * 4.0f;
+        for (int z = 0; z < height; ++z)
+        {
+            out.bodies.push_back({ {x, y, 1.0f + 2.0f * float(z)}, {}, {1.0f, 1.0f, 1.0f}, 1.0f, osp::EShape::Box });
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Vehicles shaped like the prebuilt rocket: a column of tanks with RCS blocks
+ *
+ * Stand-in for VehicleBuilder, which needs part prefabs loaded from resources.
+ */
+inline BenchScene make_scene_vehicles(int const count, int const tanks)
+{
+    using osp::EShape;
+
+    BenchScene out{ .name = "vehicles" };
+    out.bodies.push_back({ {0.0f, 0.0f, -1.0f}, {}, {400.0f, 400.0f, 1.0f}, 0.0f, EShape::Box });
+
+    int const side = int(std::ceil(std::sqrt(float(count))));
+    for (int v = 0; v < count; ++v)
+    {
+        VehicleSpawn &rVehicle = out.vehicles.emplace_back();
+        rVehicle.position = { float(v % side - side/2) * 12.0f, float(v / side - side/2) * 12.0f, 2.0f };
+
+        for (int t = 0; t < tanks; ++t)
+        {
+            float const z = 2.0f * float(t);
+            rVehicle.parts.push_back({ {0.0f, 0.0f, z}, {1.0f, 1.0f, 1.0f}, 1.0f, EShape::Cylinder });
+
+            // RCS blocks on every second tank
+            if (t % 2 == 0)
+            {
+                for (osp::Vector3 const dir : { osp::Vector3::xAxis(), -osp::Vector3::xAxis(), osp::Vector3::yAxis(), -osp::Vector3::yAxis() })
+                {
+                    rVehicle.parts.push_back({ dir * 1.25f + osp::Vector3{0.0f, 0.0f, z}, {0.25f, 0.25f, 0.25f}, 0.1f, EShape::Box });
+                }
+            }
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Reproduces the spawns of the 'physics' scenario's Droppers and Thrower features
+ *
+ * Droppers add a box every 2 seconds and a cylinder every second. Instead of waiting for a key
+ * press, the thrower throws a 5x5 grid of spheres every throwInterval seconds.
+ */
+struct PhysicsLoad
+{
+    void update(float const deltaTime, std::vector<Spawn> &rSpawn)
+    {
+        using osp::EShape;
+
+        timerA += deltaTime;
+        if (timerA >= 2.0f)
+        {
+            timerA -= 2.0f;
+            rSpawn.push_back({ {10.0f, 0.0f, 30.0f}, {}, {2.0f, 2.0f, 1.0f}, 1.0f, EShape::Box });
+        }
+
+        timerB += deltaTime;
+        if (timerB >= 1.0f)
+        {
+            timerB -= 1.0f;
+            rSpawn.push_back({ {-10.0f, 0.0f, 30.0f}, {}, {2.0f, 2.0f, 1.0f}, 1.0f, EShape::Cylinder });
+        }
+
+        timerThrow += deltaTime;
+        if (throwInterval > 0.0f && timerThrow >= throwInterval)
+        {
+            timerThrow -= throwInterval;
+
+            // Camera at (0, -60, 10) looking towards +Y, see ftrThrower
+            for (int x = -2; x < 3; ++x)
+            {
+                for (int y = -2; y < 3; ++y)
+                {
+                    rSpawn.push_back({
+                        .position = osp::Vector3{float(x) * 5.5f, -52.0f, 10.0f + float(y) * 5.5f},
+                        .velocity = osp::Vector3{0.0f, 120.0f, 0.0f},
+                        .size     = osp::Vector3{1.0f},
+                        .mass     = 1.0f,
+                        .shape    = EShape::Sphere });
+                }
+            }
+        }
+    }
+
+    float throwInterval {0.25f};
+
+    float timerA        {0.0f};
+    float timerB        {0.0f};
+    float timerThrow    {0.0f};
+};
+
+/**
+ * @brief Current resident memory of this process in bytes, or 0 if unsupported
+ */
+inline std::size_t resident_bytes() noexcept
+{
+#if defined(__linux__)
+    std::size_t pages = 0;
+    std::size_t resident = 0;
+    if (std::FILE *pFile = std::fopen("/proc/self/statm", "r"))
+    {
+        if (std::fscanf(pFile, "%zu %zu", &pages, &resident) != 2)
+        {
+            resident = 0;
+        }
+        std::fclose(pFile);
+    }
+    return resident * std::size_t(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+} // namespace benchmark
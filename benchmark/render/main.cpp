@@ -0,0 +1,286 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Headless render benchmark of the testapp scenarios
+ *
+ * Loads scenarios such as 'physics' and 'vehicles' through the same features as testapp, but
+ * draws them with the headless render backend (SysRenderNull) instead of Magnum. Each frame is
+ * driven as two cycles: a scene update with renderer sync, then a render-only cycle. The render
+ * cycle covers draw transforms, snapshots, culling, render queues, and recorded draw calls.
+ *
+ * Run from a directory containing OSPData, such as the osp-magnum build output.
+ */
+
+#include <testapp/feature_interfaces.h>
+#include <testapp/scenarios.h>
+#include <testapp/scenarios_headless.h>
+#include <testapp/testapp.h>
+
+#include <adera_app/application.h>
+#include <adera_app/feature_interfaces.h>
+#include <adera_app/features/common.h>
+
+#include <osp/framework/builder.h>
+#include <osp/framework/executor.h>
+#include <osp/util/logging.h>
+#include <osp_drawing_null/rendernull.h>
+
+#include <Corrade/Utility/Arguments.h>
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace adera;
+using namespace ftr_inter;
+using namespace osp::draw;
+using namespace osp::fw;
+using namespace testapp;
+
+using Clock_t = std::chrono::steady_clock;
+
+namespace
+{
+
+struct BenchResults
+{
+    double          updateTotalMs   {0.0};
+    double          renderTotalMs   {0.0};
+    double          renderWorstMs   {0.0};
+    NullCmdStats    cmdTotals;
+    std::size_t     drawEntsAtEnd   {0};
+};
+
+std::vector<std::string> split_list(std::string const &str)
+{
+    std::vector<std::string> out;
+    std::istringstream stream{str};
+    for (std::string item; std::getline(stream, item, ','); )
+    {
+        out.push_back(item);
+    }
+    return out;
+}
+
+double elapsed_ms(Clock_t::time_point const t0, Clock_t::time_point const t1)
+{
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+/**
+ * @brief Load a scenario and a headless renderer for it into a freshly initialized TestApp
+ */
+void load_headless(TestApp &rTestApp, ScenarioOption const &scenario)
+{
+    Framework &rFW = rTestApp.m_framework;
+    auto const mainApp       = rFW.get_interface<FIMainApp>      (rTestApp.m_mainContext);
+    auto       &rMainLoopCtrl = rFW.data_get<MainLoopControl>    (mainApp.di.mainLoopCtrl);
+
+    // Stop the framework main loop to add contexts
+    rMainLoopCtrl.doUpdate = false;
+    rTestApp.m_pExecutor->signal(rFW, mainApp.pl.mainLoop);
+    rTestApp.m_pExecutor->wait(rFW);
+
+    scenario.loadFunc(rTestApp);
+    start_headless_renderer(rFW, rTestApp.m_mainContext, entt::make_any<TestApp&>(rTestApp));
+
+    rTestApp.m_pExecutor->load(rFW);
+    rTestApp.m_pExecutor->run(rFW, mainApp.pl.mainLoop);
+
+    // Resync+Sync without stepping through time, same as when Magnum opens
+    rTestApp.drive_scene_cycle({.deltaTimeIn = 0.0f,
+                                .update      = true,
+                                .sceneUpdate = false,
+                                .resync      = true,
+                                .sync        = true,
+                                .render      = false });
+}
+
+void close_headless(TestApp &rTestApp)
+{
+    Framework &rFW = rTestApp.m_framework;
+    auto const mainApp  = rFW.get_interface<FIMainApp>(rTestApp.m_mainContext);
+    auto const &rAppCtxs = rFW.data_get<AppContexts>  (mainApp.di.appContexts);
+
+    // Stops the pipeline loop
+    rTestApp.drive_scene_cycle({.deltaTimeIn = 0.0f,
+                                .update      = false,
+                                .sceneUpdate = false,
+                                .resync      = false,
+                                .sync        = false,
+                                .render      = false });
+
+    if (rTestApp.m_pExecutor->is_running(rFW))
+    {
+        OSP_LOG_CRITICAL("Expected main loop to stop, but something is blocking it and cannot exit");
+        std::abort();
+    }
+
+    rTestApp.run_context_cleanup(rAppCtxs.sceneRender);
+    rTestApp.run_context_cleanup(rAppCtxs.window);
+    rTestApp.run_context_cleanup(rAppCtxs.scene);
+    rTestApp.clear_resource_owners();
+}
+
+BenchResults run_scenario(ScenarioOption const &scenario, int const frames, int const warmup)
+{
+    static osp::fw::SingleThreadedExecutor s_executor;
+
+    TestApp testApp;
+    testApp.m_pExecutor   = &s_executor;
+    testApp.m_mainContext = testApp.m_framework.m_contextIds.create();
+
+    ContextBuilder mainCB { testApp.m_mainContext, {}, testApp.m_framework };
+    mainCB.add_feature(ftrMain);
+    ContextBuilder::finalize(std::move(mainCB));
+
+    testApp.init();
+    load_headless(testApp, scenario);
+
+    Framework &rFW = testApp.m_framework;
+    auto const mainApp      = rFW.get_interface<FIMainApp>      (testApp.m_mainContext);
+    auto const &rAppCtxs    = rFW.data_get<AppContexts>         (mainApp.di.appContexts);
+    auto const scnRender    = rFW.get_interface<FISceneRenderer>(rAppCtxs.sceneRender);
+    auto const headlessScn  = rFW.get_interface<FIHeadlessScene>(rAppCtxs.sceneRender);
+    auto const &rScnRender  = rFW.data_get<ACtxSceneRender>     (scnRender.di.scnRender);
+    auto const &rScnRdrNull = rFW.data_get<ACtxSceneRenderNull> (headlessScn.di.scnRenderNull);
+
+    BenchResults results;
+
+    for (int frame = -warmup; frame < frames; ++frame)
+    {
+        auto const t0 = Clock_t::now();
+
+        testApp.drive_scene_cycle({.deltaTimeIn = 1.0f/60.0f,
+                                   .update      = true,
+                                   .sceneUpdate = true,
+                                   .resync      = false,
+                                   .sync        = true,
+                                   .render      = false });
+
+        auto const t1 = Clock_t::now();
+
+        testApp.drive_scene_cycle({.deltaTimeIn = 1.0f/60.0f,
+                                   .update      = true,
+                                   .sceneUpdate = false,
+                                   .resync      = false,
+                                   .sync        = false,
+                                   .render      = true });
+
+        auto const t2 = Clock_t::now();
+
+        if (frame < 0)
+        {
+            continue;
+        }
+
+        double const renderMs = elapsed_ms(t1, t2);
+        results.updateTotalMs += elapsed_ms(t0, t1);
+        results.renderTotalMs += renderMs;
+        results.renderWorstMs  = std::max(results.renderWorstMs, renderMs);
+
+        NullCmdStats const stats = SysRenderNull::count(rScnRdrNull.m_commands);
+        results.cmdTotals.drawCalls       += stats.drawCalls;
+        results.cmdTotals.instancedCalls  += stats.instancedCalls;
+        results.cmdTotals.entsDrawn       += stats.entsDrawn;
+        results.cmdTotals.shaderChanges   += stats.shaderChanges;
+        results.cmdTotals.materialChanges += stats.materialChanges;
+        results.cmdTotals.textureChanges  += stats.textureChanges;
+        results.cmdTotals.meshChanges     += stats.meshChanges;
+    }
+
+    results.drawEntsAtEnd = rScnRender.m_drawIds.size();
+
+    close_headless(testApp);
+
+    return results;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Corrade::Utility::Arguments args;
+    args.addOption("frames", "600")             .setHelp("frames",  "Number of 60Hz frames to time per scenario")
+        .addOption("warmup", "60")              .setHelp("warmup",  "Number of frames to run before timing")
+        .addOption("scenes", "physics,vehicles").setHelp("scenes",  "Comma-separated testapp scenarios to run")
+        .setGlobalHelp("Runs testapp scenarios with the headless render backend and reports CPU "
+                       "render cost per frame. Run from a directory containing OSPData.")
+        .parse(argc, argv);
+
+    auto pSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+    pSink->set_pattern("[%T.%e] [%n] [%^%l%$] %v");
+    osp::set_thread_logger(std::make_shared<spdlog::logger>("benchmark", std::move(pSink)));
+
+    register_stage_enums();
+
+    int const frames = args.value<int>("frames");
+    int const warmup = args.value<int>("warmup");
+
+    std::vector<BenchResults> allResults;
+    std::vector<std::string>  sceneNames;
+
+    for (std::string const &scene : split_list(args.value("scenes")))
+    {
+        auto const it = scenarios().find(scene);
+        if (it == scenarios().end())
+        {
+            OSP_LOG_ERROR("Unknown scenario '{}'", scene);
+            spdlog::shutdown();
+            return 1;
+        }
+
+        OSP_LOG_INFO("Running '{}' for {} frames", scene, frames);
+        allResults.push_back(run_scenario(it->second, frames, warmup));
+        sceneNames.push_back(scene);
+    }
+
+    std::printf("%-10s %11s %11s %11s %9s %9s %9s %9s %9s %8s\n",
+                "scenario", "update ms", "render ms", "worst ms", "draws", "instanced", "ents", "shaders", "meshes", "drawents");
+
+    for (std::size_t i = 0; i < allResults.size(); ++i)
+    {
+        BenchResults const &r = allResults[i];
+        double const        n = frames;
+
+        std::printf("%-10s %11.4f %11.4f %11.4f %9.1f %9.1f %9.1f %9.1f %9.1f %8zu\n",
+                    sceneNames[i].c_str(),
+                    r.updateTotalMs / n, r.renderTotalMs / n, r.renderWorstMs,
+                    double(r.cmdTotals.drawCalls) / n, double(r.cmdTotals.instancedCalls) / n,
+                    double(r.cmdTotals.entsDrawn) / n, double(r.cmdTotals.shaderChanges) / n,
+                    double(r.cmdTotals.meshChanges) / n, r.drawEntsAtEnd);
+    }
+
+    spdlog::shutdown();
+    return 0;
+}
@@ -0,0 +1,549 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Headless terrain benchmark
+ *
+ * Flies a viewer along scripted paths around an Earth-sized icosahedron planet, running the same
+ * subdivision and chunk update functions as the TerrainSubdivDist feature. No window or GPU.
+ *
+ * Reports per-path timings, chunk counts, memory use, and a hash of the output mesh buffers so
+ * that changes to terrain generation can be checked for both speed and identical output.
+ */
+
+#include <planet-a/activescene/terrain.h>
+#include <planet-a/activescene/terrain_fn.h>
+
+#include <osp/core/math_2pow.h>
+#include <osp/util/logging.h>
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Utility/Arguments.h>
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace planeta;
+
+using osp::Vector3d;
+using osp::Vector3l;
+
+using Clock_t = std::chrono::steady_clock;
+
+namespace
+{
+
+/// Meters per floating origin translation, same as the TerrainDebugDraw feature
+constexpr double gc_originStep = 65536.0;
+
+/**
+ * @brief Viewer position in meters for a frame, given progress t from 0.0 to 1.0 along a path
+ */
+using FlightPath_t = std::function<Vector3d(double t)>;
+
+struct Path
+{
+    char const      *name;
+    FlightPath_t    position;
+};
+
+struct PathResults
+{
+    double          subdivMs        {};
+    double          chunksMs        {};
+    double          worstFrameMs    {};
+    std::uint64_t   hash            {};
+};
+
+/**
+ * @brief 64-bit FNV-1a hash
+ */
+std::uint64_t fnv1a(Corrade::Containers::ArrayView<std::byte const> data, std::uint64_t hash = 0xcbf29ce484222325ull) noexcept
+{
+    for (std::byte const b : data)
+    {
+        hash ^= std::uint64_t(b);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::uint64_t hash_mesh(ACtxTerrain const &rTerrain) noexcept
+{
+    auto const &geom = rTerrain.chunkGeom;
+    std::uint64_t const hash = fnv1a(Corrade::Containers::arrayView(geom.vrtxBuffer));
+    return fnv1a({reinterpret_cast<std::byte const*>(geom.indxBuffer.data()), geom.indxBuffer.size() * sizeof(osp::Vector3u)}, hash);
+}
+
+template <typename VEC_T>
+std::size_t vec_bytes(VEC_T const &vec) noexcept
+{
+    return vec.capacity() * sizeof(typename VEC_T::value_type);
+}
+
+/**
+ * @brief Rough estimate of heap memory used by terrain, in bytes
+ */
+std::size_t terrain_memory(ACtxTerrain const &rTerrain) noexcept
+{
+    auto const &skData = rTerrain.skData;
+    return   vec_bytes(skData.positions.base()) + vec_bytes(skData.normals.base())
+           + vec_bytes(skData.centers.base())
+           + rTerrain.skeleton.tri_group_ids().capacity() * sizeof(SkTriGroup)
+           + rTerrain.chunkGeom.vrtxBuffer.size()
+           + rTerrain.chunkGeom.indxBuffer.size() * sizeof(osp::Vector3u)
+           + rTerrain.chunkGeomCompact.vrtxBuffer.size()
+           + rTerrain.chunkCache.capacity() * rTerrain.chunkInfo.fillVrtxCount * sizeof(osp::Vector3);
+}
+
+/**
+ * @brief Point on a sphere of radius r, given latitude and longitude in radians
+ */
+Vector3d on_sphere(double r, double lat, double lon) noexcept
+{
+    return { r * std::cos(lat) * std::cos(lon), r * std::cos(lat) * std::sin(lon), r * std::sin(lat) };
+}
+
+PathResults run_path(TerrainIcoSpecs const &specs, Path const &path, int frames, bool csv)
+{
+    ACtxTerrainFrame terrainFrame;
+    ACtxTerrain      terrain;
+    ACtxTerrainIco   terrainIco;
+
+    SysTerrainIco::initialize(specs, terrainFrame, terrain, terrainIco);
+
+    double const scale       = osp::math::int_2pow<int>(terrain.skData.precision);
+    double const minDistance = (terrainIco.radius + terrainIco.height) * scale;
+    Vector3d     origin      {0.0};
+
+    PathResults out;
+
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        Vector3d const viewer = path.position(double(frame) / double(std::max(frames - 1, 1)));
+
+        // Emulate floating origin. Terrain mesh is rebuilt relative to terrainFrame.position.
+        Vector3d const rel = viewer - origin;
+        for (int i = 0; i < 3; ++i)
+        {
+            if (std::abs(rel[i]) > gc_originStep)
+            {
+                origin[i] += std::copysign(std::floor(std::abs(rel[i]) / gc_originStep) * gc_originStep, rel[i]);
+            }
+        }
+        terrainFrame.position = Vector3l{origin * scale};
+
+        // Enforce minimum distance to center, same as TerrainDebugDraw
+        Vector3d viewerSkel = viewer * scale;
+        if (double const distance = viewerSkel.length(); distance < minDistance)
+        {
+            viewerSkel *= minDistance / distance;
+        }
+        terrain.scratchpad.viewerPosition = Vector3l{viewerSkel};
+
+        auto const t0 = Clock_t::now();
+        SysTerrainIco::subdivide_by_distance(terrain, terrainIco);
+        auto const t1 = Clock_t::now();
+        SysTerrainIco::update_chunks(terrainFrame, terrain, terrainIco);
+        auto const t2 = Clock_t::now();
+
+        terrain.scratchpad.surfaceAdded  .clear();
+        terrain.scratchpad.surfaceRemoved.clear();
+        terrain.chunkSP.vrtxDirty.clear();
+        terrain.chunkSP.faceDirty.clear();
+
+        double const subdivMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        double const chunksMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+        out.subdivMs     += subdivMs;
+        out.chunksMs     += chunksMs;
+        out.worstFrameMs  = std::max(out.worstFrameMs, subdivMs + chunksMs);
+
+        if (csv)
+        {
+            std::printf("%s,%d,%.4f,%.4f,%zu,%zu,%016llx\n",
+                        path.name, frame, subdivMs, chunksMs,
+                        terrain.skChunks.m_chunkIds.size(), terrain.skChunks.m_sharedIds.size(),
+                        static_cast<unsigned long long>(hash_mesh(terrain)));
+        }
+    }
+
+    out.hash = hash_mesh(terrain);
+
+    if ( ! csv )
+    {
+        OSP_LOG_INFO("Path '{}' over {} frames:\n"
+                     "* Subdivide total:      {:.3f} ms\n"
+                     "* Update chunks total:  {:.3f} ms\n"
+                     "* Average frame:        {:.3f} ms\n"
+                     "* Worst frame:          {:.3f} ms\n"
+                     "* Skeleton Triangles:   {}\n"
+                     "* Chunks:               {}/{}\n"
+                     "* Shared Vertices:      {}/{}\n"
+                     "* Cached Chunks:        {}/{} ({} hits, {} misses)\n"
+                     "* Memory estimate:      {:.2f} MiB\n"
+                     "* Mesh hash:            {:016x}\n",
+                     path.name, frames,
+                     out.subdivMs, out.chunksMs, (out.subdivMs + out.chunksMs) / frames, out.worstFrameMs,
+                     terrain.skeleton.tri_group_ids().size()*4,
+                     terrain.skChunks.m_chunkIds.size(), terrain.skChunks.m_chunkIds.capacity(),
+                     terrain.skChunks.m_sharedIds.size(), terrain.skChunks.m_sharedIds.capacity(),
+                     terrain.chunkCache.size(), terrain.chunkCache.capacity(), terrain.chunkCache.hits, terrain.chunkCache.misses,
+                     double(terrain_memory(terrain)) / (1024.0 * 1024.0),
+                     out.hash);
+    }
+
+    // skChunks holds owners referring to skeleton, see ftrTerrain's cleanup task
+    terrain.skChunks.clear(terrain.skeleton);
+
+    return out;
+}
+
+/**
+ * @brief Scratch containers shared between terrains that are updated one after another
+ *
+ * Only containers that are always empty between updates are shared. Per-terrain state such as
+ * distance thresholds, viewerPosition, surface changes, and dirty ranges stays in each ACtxTerrain.
+ */
+struct TerrainScratchPool
+{
+    ChunkScratchpad             chunkSP;
+    SkeletonSubdivScratchpad    scratchpad;
+};
+
+/**
+ * @brief Free a terrain's own copies of the containers held by TerrainScratchPool
+ */
+void release_scratch(ACtxTerrain &rTerrain)
+{
+    SkeletonSubdivScratchpad &rSkSP = rTerrain.scratchpad;
+    ChunkScratchpad          &rChSP = rTerrain.chunkSP;
+
+    rSkSP.levels             = {};
+    rSkSP.distanceTestDone   = {};
+    rSkSP.tryUnsubdiv        = {};
+    rSkSP.cantUnsubdiv       = {};
+
+    rChSP.edgeVertices       = {};
+    rChSP.stitchCmds         = {};
+    rChSP.chunksAdded        = {};
+    rChSP.chunksRemoved      = {};
+    rChSP.sharedAdded        = {};
+    rChSP.sharedRemoved      = {};
+    rChSP.sharedNormalsDirty = {};
+}
+
+/**
+ * @brief Swap scratch containers that are empty between updates; used to borrow and return them
+ */
+void swap_scratch(ACtxTerrain &rTerrain, TerrainScratchPool &rPool) noexcept
+{
+    using std::swap;
+
+    SkeletonSubdivScratchpad &rSkSP = rTerrain.scratchpad;
+    ChunkScratchpad          &rChSP = rTerrain.chunkSP;
+
+    swap(rSkSP.levels,              rPool.scratchpad.levels);
+    swap(rSkSP.distanceTestDone,    rPool.scratchpad.distanceTestDone);
+    swap(rSkSP.tryUnsubdiv,         rPool.scratchpad.tryUnsubdiv);
+    swap(rSkSP.cantUnsubdiv,        rPool.scratchpad.cantUnsubdiv);
+
+    swap(rChSP.edgeVertices,        rPool.chunkSP.edgeVertices);
+    swap(rChSP.stitchCmds,          rPool.chunkSP.stitchCmds);
+    swap(rChSP.chunksAdded,         rPool.chunkSP.chunksAdded);
+    swap(rChSP.chunksRemoved,       rPool.chunkSP.chunksRemoved);
+    swap(rChSP.sharedAdded,         rPool.chunkSP.sharedAdded);
+    swap(rChSP.sharedRemoved,       rPool.chunkSP.sharedRemoved);
+    swap(rChSP.sharedNormalsDirty,  rPool.chunkSP.sharedNormalsDirty);
+}
+
+/**
+ * @brief Subdivide, update chunks, and clear surface changes using the pool's scratch containers
+ */
+void update_pooled(
+        ACtxTerrainFrame            const &rTerrainFrame,
+        ACtxTerrain                       &rTerrain,
+        ACtxTerrainIco              const &rTerrainIco,
+        TerrainScratchPool                &rPool)
+{
+    swap_scratch(rTerrain, rPool);
+
+    // Pool may have been last used by a smaller terrain. Vectors keep their capacity when
+    // shrunk, so alternating between terrains doesn't reallocate.
+    rTerrain.scratchpad.resize(rTerrain.skeleton);
+    rTerrain.chunkSP   .resize(rTerrain.skChunks);
+
+    SysTerrainIco::subdivide_by_distance(rTerrain, rTerrainIco);
+    SysTerrainIco::update_chunks(rTerrainFrame, rTerrain, rTerrainIco);
+
+    rTerrain.scratchpad.surfaceAdded  .clear();
+    rTerrain.scratchpad.surfaceRemoved.clear();
+
+    // chunksAdded and friends are only read within update_chunks(...), clear them so the next
+    // terrain gets an empty pool
+    rTerrain.chunkSP.chunksAdded       .clear();
+    rTerrain.chunkSP.chunksRemoved     .clear();
+    rTerrain.chunkSP.sharedAdded       .clear();
+    rTerrain.chunkSP.sharedRemoved     .clear();
+    rTerrain.chunkSP.sharedNormalsDirty.clear();
+
+    swap_scratch(rTerrain, rPool);
+}
+
+/**
+ * @brief Fly past a planet and two moons sharing a scratch pool and a global chunk budget
+ */
+void run_system(TerrainIcoSpecs const &planetSpecs, std::uint32_t const totalChunks, int const frames, bool const csv)
+{
+    struct Body
+    {
+        ACtxTerrainFrame    frame;
+        ACtxTerrain         terrain;
+        ACtxTerrainIco      ico;
+        Vector3d            center;
+    };
+
+    TerrainIcoSpecs moonSpecs = planetSpecs;
+    moonSpecs.radius = 1737000.0;
+    moonSpecs.height = 10000.0;
+
+    std::array<TerrainIcoSpecs const*, 3> const specs { &planetSpecs, &moonSpecs, &moonSpecs };
+    std::array<Vector3d, 3> const centers { Vector3d{0.0}, Vector3d{0.0, 3.0e7, 0.0}, Vector3d{0.0, -2.0e7, 1.0e7} };
+    float const fovY = 45.0f * 3.14159265f / 180.0f;
+
+    std::array<TerrainLod, 3> lods;
+
+    auto const viewer_at = [frames] (int const frame) -> Vector3d
+    {
+        double const t = double(frame) / double(std::max(frames - 1, 1));
+        return Vector3d{2.0e7, -1.0e7, 5.0e6} + Vector3d{-2.0e7, 4.5e7, 0.0} * t;
+    };
+
+    auto const distribute = [&lods, &specs, &centers, fovY, totalChunks] (Vector3d const viewer)
+    {
+        for (std::size_t i = 0; i < lods.size(); ++i)
+        {
+            lods[i].screenSize = SysTerrainIco::screen_size(specs[i]->radius, (viewer - centers[i]).length(), fovY, 1080.0f);
+        }
+        SysTerrainIco::distribute_chunk_budget(totalChunks, {lods.data(), lods.size()});
+    };
+
+    // Partition the budget into fixed capacities, in proportion to the largest share each body
+    // gets along the path. Capacities add up to totalChunks, so mesh buffers stay bounded by the
+    // budget no matter how shares move between bodies. update_lod then keeps each body under
+    // both its share and its capacity.
+    std::array<std::uint32_t, 3> maxLimits{};
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        distribute(viewer_at(frame));
+        for (std::size_t i = 0; i < lods.size(); ++i)
+        {
+            maxLimits[i] = std::max(maxLimits[i], lods[i].chunkLimit);
+        }
+    }
+
+    std::uint64_t maxLimitsTotal = 0;
+    for (std::uint32_t const maxLimit : maxLimits)
+    {
+        maxLimitsTotal += maxLimit;
+    }
+
+    // ACtxTerrainIco is referred to by pointer from the subdivision callback, don't move it
+    std::vector<std::unique_ptr<Body>> bodies;
+    TerrainScratchPool pool;
+
+    for (std::size_t i = 0; i < specs.size(); ++i)
+    {
+        TerrainIcoSpecs bodySpecs = *specs[i];
+        std::uint64_t const share = std::uint64_t(totalChunks) * maxLimits[i] / std::max<std::uint64_t>(maxLimitsTotal, 1);
+        bodySpecs.maxChunks = std::max(SysTerrainIco::gc_minTerrainChunks, std::uint32_t(share));
+
+        auto &rBody = *bodies.emplace_back(std::make_unique<Body>());
+        rBody.center = centers[i];
+        SysTerrainIco::initialize(bodySpecs, rBody.frame, rBody.terrain, rBody.ico);
+        release_scratch(rBody.terrain);
+    }
+
+    double       totalMs      = 0.0;
+    double       worstFrameMs = 0.0;
+    std::size_t  maxChunks    = 0;
+
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        Vector3d const viewer = viewer_at(frame);
+
+        auto const t0 = Clock_t::now();
+
+        distribute(viewer);
+
+        std::size_t chunks = 0;
+        for (std::size_t i = 0; i < bodies.size(); ++i)
+        {
+            Body &rBody = *bodies[i];
+            double const scale = std::exp2(double(rBody.terrain.skData.precision));
+
+            Vector3d viewerSkel = (viewer - rBody.center) * scale;
+            double const minDistance = (rBody.ico.radius + rBody.ico.height) * scale;
+            if (double const distance = viewerSkel.length(); distance < minDistance)
+            {
+                viewerSkel *= minDistance / distance;
+            }
+            // Mesh stays relative to body centers, no floating origin here
+            rBody.terrain.scratchpad.viewerPosition = Vector3l{viewerSkel};
+
+            SysTerrainIco::update_lod(lods[i], rBody.terrain, rBody.ico);
+            update_pooled(rBody.frame, rBody.terrain, rBody.ico, pool);
+
+            rBody.terrain.chunkSP.vrtxDirty.clear();
+            rBody.terrain.chunkSP.faceDirty.clear();
+
+            chunks += rBody.terrain.skChunks.m_chunkIds.size();
+        }
+
+        double const frameMs = std::chrono::duration<double, std::milli>(Clock_t::now() - t0).count();
+        totalMs      += frameMs;
+        worstFrameMs  = std::max(worstFrameMs, frameMs);
+        maxChunks     = std::max(maxChunks, chunks);
+
+        if (csv)
+        {
+            std::printf("system,%d,%.4f,0,%zu,0,0\n", frame, frameMs, chunks);
+        }
+    }
+
+    if ( ! csv )
+    {
+        OSP_LOG_INFO("Path 'system' (planet and 2 moons) over {} frames:\n"
+                     "* Update total:         {:.3f} ms\n"
+                     "* Average frame:        {:.3f} ms\n"
+                     "* Worst frame:          {:.3f} ms\n"
+                     "* Max chunks:           {} (budget {})\n"
+                     "* Chunks per body:      {}, {}, {}\n"
+                     "* Capacity per body:    {}, {}, {}\n",
+                     frames, totalMs, totalMs / frames, worstFrameMs, maxChunks, totalChunks,
+                     bodies[0]->terrain.skChunks.m_chunkIds.size(),
+                     bodies[1]->terrain.skChunks.m_chunkIds.size(),
+                     bodies[2]->terrain.skChunks.m_chunkIds.size(),
+                     bodies[0]->terrain.skChunks.m_chunkIds.capacity(),
+                     bodies[1]->terrain.skChunks.m_chunkIds.capacity(),
+                     bodies[2]->terrain.skChunks.m_chunkIds.capacity());
+    }
+
+    for (auto &pBody : bodies)
+    {
+        pBody->terrain.skChunks.clear(pBody->terrain.skeleton);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Corrade::Utility::Arguments args;
+    args.addOption("frames", "600")     .setHelp("frames",      "Number of frames to simulate per flight path")
+        .addOption("cache-mib", "16")   .setHelp("cache-mib",   "Chunk fill cache size in MiB, 0 to disable")
+        .addOption("compact", "none")   .setHelp("compact",     "Compact vertex normals: none, oct8, or oct16")
+        .addOption("system-chunks", "1200").setHelp("system-chunks", "Global chunk budget for the planet and moons path")
+        .addBooleanOption("csv")        .setHelp("csv",         "Print per-frame results as CSV instead of a summary")
+        .setGlobalHelp("Flies a viewer along scripted paths around an Earth-sized planet and measures terrain updates.")
+        .parse(argc, argv);
+
+    auto pSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+    pSink->set_pattern("[%T.%e] [%n] [%^%l%$] %v");
+    osp::set_thread_logger(std::make_shared<spdlog::logger>("benchmark", std::move(pSink)));
+
+    std::string const compact = args.value("compact");
+
+    TerrainIcoSpecs const specs
+    {
+        .radius              = 6371000.0, // Earth (average)
+        .height              = 20000.0,   // Approx. Earth height * 2
+        .skelPrecision       = 10,        // 2^10 units = 1 meter
+        .skelMaxSubdivLevels = 19,
+        .chunkSubdivLevels   = 4,
+        .compactNormals      = (compact == "oct8")  ? EChunkCompactNormals::Oct8
+                             : (compact == "oct16") ? EChunkCompactNormals::Oct16
+                                                    : EChunkCompactNormals::None,
+        .chunkCacheBytes     = args.value<std::size_t>("cache-mib") * 1024u * 1024u
+    };
+
+    double const radius = specs.radius + specs.height;
+    double const pi     = std::acos(-1.0);
+
+    std::vector<Path> const paths
+    {
+        // Exponential descent from 2 planet radii down to 100m above the surface
+        { "descent", [=] (double t)
+        {
+            double const altitude = radius * std::pow(100.0 / radius, t);
+            return on_sphere(radius + altitude, 0.3, 0.2);
+        }},
+
+        // Fast low altitude flight, a quarter way around the planet at 1km altitude
+        { "low-flight", [=] (double t)
+        {
+            return on_sphere(radius + 1000.0, 0.1 + 0.2 * t, 0.5 * pi * t);
+        }},
+
+        // Teleport between 6 points at 500m altitude above each icosahedron axis
+        { "teleport", [=] (double t)
+        {
+            static constexpr std::array<std::array<double, 3>, 6> axes
+            {{ {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1} }};
+            auto const &axis = axes[std::min(std::size_t(t * axes.size()), axes.size() - 1)];
+            return Vector3d{axis[0], axis[1], axis[2]} * (radius + 500.0);
+        }}
+    };
+
+    int  const frames = args.value<int>("frames");
+    bool const csv    = args.isSet("csv");
+
+    if (csv)
+    {
+        std::printf("path,frame,subdiv_ms,chunks_ms,chunks,shared,mesh_hash\n");
+    }
+
+    for (Path const &path : paths)
+    {
+        run_path(specs, path, frames, csv);
+    }
+
+    run_system(specs, args.value<std::uint32_t>("system-chunks"), frames, csv);
+
+    spdlog::shutdown();
+    return 0;
+}
@@ -482,6 +482,7 @@ struct FITerrain {
     struct DataIds {
         DataId terrainFrame;
         DataId terrain;
+        DataId lod;
     };
 
     struct Pipelines {
@@ -508,6 +509,24 @@ struct FITerrainDbgDraw {
     struct Pipelines { };
 };
 
+struct FITerrainCollision {
+    struct DataIds {
+        DataId terrainColl;
+    };
+
+    struct Pipelines {
+        PipelineDef<EStgCont> chunkColliders    {"chunkColliders    - ACtxTerrainCollision::added and removed"};
+    };
+};
+
+struct FITerrainCollisionJolt {
+    struct DataIds {
+        DataId colliders;
+    };
+
+    struct Pipelines { };
+};
+
 
 
 
@@ -601,6 +620,7 @@ struct FISceneRenderer {
     struct DataIds {
         DataId scnRender;
         DataId drawTfObservers;
+        DataId snapshots;
     };
 
     struct Pipelines {
@@ -617,6 +637,7 @@ struct FISceneRenderer {
         PipelineDef<EStgIntr> materialDirty     {"materialDirty"};
 
         PipelineDef<EStgIntr> drawTransforms    {"drawTransforms"};
+        PipelineDef<EStgCont> snapshot          {"snapshot          - ACtxRenderSnapshots, draw state published for renderers"};
 
         PipelineDef<EStgCont> group             {"group"};
         PipelineDef<EStgCont> groupEnts         {"groupEnts"};
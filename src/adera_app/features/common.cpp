@@ -32,6 +32,7 @@
 #include <osp/core/Resources.h>
 #include <osp/core/unpack.h>
 #include <osp/drawing/drawing_fn.h>
+#include <osp/drawing/render_snapshot.h>
 #include <osp/util/UserInputHandler.h>
 
 using namespace adera;
@@ -145,6 +146,17 @@ FeatureDef const ftrCommonScene = feature_def("CommonScene", [] (
         update_delete_basic(rBasic, rActiveEntDel.cbegin(), rActiveEntDel.cend());
     });
 
+    rFB.task()
+        .name       ("Sort transforms into scene graph order")
+        .run_on     ({scn.pl.update(Run)})
+        .sync_with  ({comScn.pl.hierarchy(Ready), comScn.pl.transform(Modify)})
+        .args       ({     comScn.di.basic })
+        .func       ([] (ACtxBasic &rBasic) noexcept
+    {
+        // Only sorts if the hierarchy changed. Lets update_draw_transforms read in memory order.
+        SysSceneGraph::sort_by_tree(rBasic.m_scnGraph, rBasic.m_transform);
+    });
+
     rFB.task()
         .name       ("Clear ActiveEnt delete vector once we're done with it")
         .run_on     ({comScn.pl.activeEntDelete(Clear)})
@@ -249,6 +261,7 @@ FeatureDef const ftrSceneRenderer = feature_def("SceneRenderer", [] (
     rFB.pipeline(scnRender.pl.entTextureDirty) .parent(windowApp.pl.sync);
     rFB.pipeline(scnRender.pl.entMeshDirty)    .parent(windowApp.pl.sync);
     rFB.pipeline(scnRender.pl.drawTransforms)  .parent(scnRender.pl.render);
+    rFB.pipeline(scnRender.pl.snapshot)        .parent(scnRender.pl.render);
     rFB.pipeline(scnRender.pl.material)        .parent(windowApp.pl.sync);
     rFB.pipeline(scnRender.pl.materialDirty)   .parent(windowApp.pl.sync);
     rFB.pipeline(scnRender.pl.group)           .parent(windowApp.pl.sync);
@@ -262,6 +275,7 @@ FeatureDef const ftrSceneRenderer = feature_def("SceneRenderer", [] (
 
     auto &rScnRender = rFB.data_emplace<ACtxSceneRender>(scnRender.di.scnRender);
     /* unused */       rFB.data_emplace<DrawTfObservers>(scnRender.di.drawTfObservers);
+    /* unused */       rFB.data_emplace<ACtxRenderSnapshots>(scnRender.di.snapshots);
 
     // TODO: format after framework changes
 
@@ -305,6 +319,19 @@ FeatureDef const ftrSceneRenderer = feature_def("SceneRenderer", [] (
         rScnRender.resize_active(rBasic.m_activeIds.capacity());
     });
 
+    // Renderers sync everything through the dirty lists they already consume each frame, after
+    // resync tasks of other features create DrawEnts and assign their components
+    rFB.task()
+        .name       ("Mark all DrawEnts dirty for renderer resync")
+        .run_on     ({windowApp.pl.resync(Run)})
+        .sync_with  ({scnRender.pl.drawEnt(Ready), scnRender.pl.material(Ready), scnRender.pl.drawEntResized(Done),
+                      scnRender.pl.entMeshDirty(Modify_), scnRender.pl.entTextureDirty(Modify_), scnRender.pl.materialDirty(Modify_)})
+        .args       ({            scnRender.di.scnRender})
+        .func([] (ACtxSceneRender &rScnRender) noexcept
+    {
+        SysRender::mark_all_dirty(rScnRender);
+    });
+
     rFB.task()
         .name       ("Schedule Assign GL textures")
         .schedules  ({scnRender.pl.entTextureDirty(Schedule_)})
@@ -339,7 +366,9 @@ FeatureDef const ftrSceneRenderer = feature_def("SceneRenderer", [] (
                     .transforms   = rBasic    .m_transform,
                     .activeToDraw = rScnRender.m_activeToDraw,
                     .needDrawTf   = rScnRender.m_needDrawTf,
-                    .rDrawTf      = rScnRender.m_drawTransform
+                    .rDrawTf      = rScnRender.m_drawTransform,
+                    .pUnchanged   = &rScnRender.m_drawTfUnchanged,
+                    .pDirty       = &rScnRender.m_drawTfDirty
                 },
                 rootChildren.begin(),
                 rootChildren.end(),
@@ -356,6 +385,16 @@ FeatureDef const ftrSceneRenderer = feature_def("SceneRenderer", [] (
         });
     });
 
+    rFB.task()
+        .name       ("Publish draw state to render snapshot")
+        .run_on     ({scnRender.pl.render(Run)})
+        .sync_with  ({scnRender.pl.drawTransforms(UseOrRun), scnRender.pl.drawEntResized(Done), scnRender.pl.snapshot(Modify)})
+        .args       ({            scnRender.di.scnRender,                     scnRender.di.snapshots })
+        .func([] (ACtxSceneRender &rScnRender, ACtxRenderSnapshots &rSnapshots) noexcept
+    {
+        SysRenderSnapshot::publish(rSnapshots, rScnRender);
+    });
+
     rFB.task()
         .name       ("Delete DrawEntity of deleted ActiveEnts")
         .run_on     ({comScn.pl.activeEntDelete(UseOrRun)})
@@ -369,6 +408,10 @@ FeatureDef const ftrSceneRenderer = feature_def("SceneRenderer", [] (
             {
                 continue;
             }
+            rScnRender.m_drawTfObserved.erase(ent);
+            rScnRender.m_drawTfValid   .erase(ent);
+            rScnRender.m_drawTfMoved   .erase(ent);
+
             DrawEnt const drawEnt = std::exchange(rScnRender.m_activeToDraw[ent], lgrn::id_null<DrawEnt>());
             if (drawEnt != lgrn::id_null<DrawEnt>())
             {
@@ -39,6 +39,8 @@
 
 #include <ospjolt/activescene/joltinteg_fn.h>
 
+#include <planet-a/activescene/terrain_fn.h>
+
 using namespace ftr_inter::stages;
 using namespace ftr_inter;
 using namespace osp::active;
@@ -68,7 +70,7 @@ FeatureDef const ftrJolt = feature_def("Jolt", [] (
 
     rFB.pipeline(jolt.pl.joltBody).parent(scn.pl.update);
 
-    rFB.data_emplace< ACtxJoltWorld >(jolt.di.jolt, 2);
+    rFB.data_emplace< ACtxJoltWorld >(jolt.di.jolt, 2, make_osp_layer_table());
 
     using ospjolt::SysJolt;
 
@@ -89,10 +91,9 @@ FeatureDef const ftrJolt = feature_def("Jolt", [] (
         .args({             comScn.di.basic,             phys.di.phys,              jolt.di.jolt,           scn.di.deltaTimeIn })
         .func([] (ACtxBasic& rBasic, ACtxPhysics& rPhys, ACtxJoltWorld& rJolt, float const deltaTimeIn) noexcept
     {
+        SysJolt::update_translate(rPhys, rJolt);
         SysJolt::update_world(rPhys, rJolt, deltaTimeIn, rBasic.m_transform);
     });
-
-    rFB.data_emplace< ACtxJoltWorld >(jolt.di.jolt, 2);
 }); // ftrJolt
 
 
@@ -159,14 +160,8 @@ FeatureDef const ftrPhysicsShapesJolt = feature_def("PhysicsShapesJolt", [] (
         .args       ({           comScn.di.basic,    physShapes.di.physShapes,       phys.di.phys,         jolt.di.jolt,    physShapesJolt.di.factors})
         .func       ([] (ACtxBasic const &rBasic, ACtxPhysShapes& rPhysShapes, ACtxPhysics& rPhys, ACtxJoltWorld& rJolt, ForceFactors_t const factors) noexcept
     {
-        PhysicsSystem *pJoltWorld = rJolt.m_pPhysicsSystem.get();
-        BodyInterface &bodyInterface = pJoltWorld->GetBodyInterface();
+        std::size_t const numBodies = rPhysShapes.m_spawnRequest.size();
 
-        int numBodies = static_cast<int>(rPhysShapes.m_spawnRequest.size());
-
-        std::vector<JPH::BodyID> addedBodies;
-        addedBodies.reserve(numBodies);
-        
         for (std::size_t i = 0; i < numBodies; ++i)
         {
             SpawnShape const &spawn = rPhysShapes.m_spawnRequest[i];
@@ -174,15 +169,13 @@ FeatureDef const ftrPhysicsShapesJolt = feature_def("PhysicsShapesJolt", [] (
             ActiveEnt const child   = rPhysShapes.m_ents[i * 2 + 1];
 
             Ref<Shape> pShape = SysJolt::create_primitive(rJolt, spawn.m_shape, Vec3MagnumToJolt(spawn.m_size));
-            
-            BodyId const bodyId = rJolt.m_bodyIds.create();
-            SysJolt::resize_body_data(rJolt);
 
+            // Loose shapes are debris, kept out of the broadphase tree of vehicles
             BodyCreationSettings bodyCreation(pShape, 
                                             Vec3MagnumToJolt(spawn.m_position), 
                                             Quat::sIdentity(), 
                                             EMotionType::Dynamic, 
-                                            Layers::MOVING);
+                                            Layers::DEBRIS);
             
             if (spawn.m_mass > 0.0f) 
             { 
@@ -196,55 +189,40 @@ FeatureDef const ftrPhysicsShapesJolt = feature_def("PhysicsShapesJolt", [] (
             else
             {   
                 bodyCreation.mMotionType = EMotionType::Static;
-                bodyCreation.mObjectLayer = Layers::MOVING;
+                bodyCreation.mObjectLayer = Layers::NON_MOVING;
             }
-            //TODO helper function ? 
-            
-            JPH::BodyID joltBodyId = BToJolt(bodyId);
-            bodyInterface.CreateBodyWithID(joltBodyId, bodyCreation);
-            addedBodies.push_back(joltBodyId);
-
-            rJolt.m_bodyToEnt[bodyId]    = root;
-            rJolt.m_bodyFactors[bodyId]  = factors;
-            rJolt.m_entToBody.emplace(root, bodyId);
 
+            SysJolt::create_body(rJolt, root, bodyCreation, factors);
         }
-        //Bodies are added all at once for performance reasons.
-        BodyInterface::AddState addState = bodyInterface.AddBodiesPrepare(addedBodies.data(), numBodies);
-        bodyInterface.AddBodiesFinalize(addedBodies.data(), numBodies, addState, EActivation::Activate);
+
+        SysJolt::add_created_bodies(rJolt);
     });
 
 }); // ftrPhysicsShapesJolt
 
 void compound_collect_recurse(
-        ACtxPhysics const&      rCtxPhys,
-        ACtxJoltWorld&          rCtxWorld,
-        ACtxBasic const&        rBasic,
-        ActiveEnt               ent,
-        Matrix4 const&          transform,
-        CompoundShapeSettings&  rCompound)
+        ACtxPhysics const&                  rCtxPhys,
+        ACtxJoltWorld&                      rCtxWorld,
+        ACtxBasic const&                    rBasic,
+        ActiveEnt                           ent,
+        Matrix4 const&                      transform,
+        std::vector<JoltCompoundChild>&     rChildren)
 {
     EShape const shape = rCtxPhys.m_shape[ent];
 
     if (shape != EShape::None)
     {
-        bool entExists = rCtxWorld.m_shapes.contains(ent);
-        Ref<Shape> rShape = entExists
-                               ? rCtxWorld.m_shapes.get(ent)
-                               : rCtxWorld.m_shapes.emplace(ent);
-
-        if (!entExists)
+        // Stored shapes already include their scale. Shapes come from the cache, so identical
+        // parts share a single Shape.
+        if ( ! rCtxWorld.m_shapes.contains(ent) )
         {
-            rShape = SysJolt::create_primitive(rCtxWorld, shape, Vec3MagnumToJolt(transform.scaling()));
-        }
-        else 
-        {
-            SysJolt::scale_shape(rShape, Vec3MagnumToJolt(transform.scaling()));
+            rCtxWorld.m_shapes.emplace(ent, SysJolt::create_primitive(rCtxWorld, shape, Vec3MagnumToJolt(transform.scaling())));
         }
 
-        rCompound.AddShape( Vec3MagnumToJolt(transform.translation()), 
-                            QuatMagnumToJolt(osp::Quaternion::fromMatrix(transform.rotation())), 
-                            rShape);
+        rChildren.push_back({
+            .m_position = Vec3MagnumToJolt(transform.translation()),
+            .m_rotation = QuatMagnumToJolt(osp::Quaternion::fromMatrix(transform.rotation())),
+            .m_shape    = rCtxWorld.m_shapes.get(ent)});
     }
 
     if ( ! rCtxPhys.m_hasColliders.contains(ent) )
@@ -262,7 +240,7 @@ void compound_collect_recurse(
             Matrix4 const childMatrix = transform * rChildTransform.m_transform;
 
             compound_collect_recurse(
-                    rCtxPhys, rCtxWorld, rBasic, child, childMatrix, rCompound);
+                    rCtxPhys, rCtxWorld, rBasic, child, childMatrix, rChildren);
         }
     }
 } // void compound_collect_recurse
@@ -373,15 +351,13 @@ FeatureDef const ftrVehicleSpawnJolt = feature_def("VehicleSpawnJolt", [] (
         LGRN_ASSERT(rVehicleSpawn.new_vehicle_count() != 0);
 
         rPhys.m_hasColliders.resize(rBasic.m_activeIds.capacity());
+        rPhys.m_moved.resize(rBasic.m_activeIds.capacity());
 
         auto const& itWeldsFirst        = std::begin(rVehicleSpawn.spawnedWelds);
         auto const& itWeldOffsetsLast   = std::end(rVehicleSpawn.spawnedWeldOffsets);
         auto itWeldOffsets              = std::begin(rVehicleSpawn.spawnedWeldOffsets);
 
-        PhysicsSystem *pJoltWorld = rJolt.m_pPhysicsSystem.get();
-        BodyInterface &bodyInterface = pJoltWorld->GetBodyInterface();
-
-        std::vector<JPH::BodyID> addedBodies;
+        std::vector<JoltCompoundChild> children;
 
         for (ACtxVehicleSpawn::TmpToInit const& toInit : rVehicleSpawn.spawnRequest)
         {
@@ -392,41 +368,27 @@ FeatureDef const ftrVehicleSpawnJolt = feature_def("VehicleSpawnJolt", [] (
 
             std::for_each(itWeldsFirst + std::ptrdiff_t{*itWeldOffsets},
                           itWeldsFirst + std::ptrdiff_t{weldOffsetNext},
-                          [&rBasic, &rScnParts, &rVehicleSpawn, &toInit, &rPhys, &rJolt, &addedBodies, factors] (WeldId const weld)
+                          [&rBasic, &rScnParts, &rVehicleSpawn, &toInit, &rPhys, &rJolt, &children, factors] (WeldId const weld)
             {
                 ActiveEnt const weldEnt = rScnParts.weldToActive[weld];
 
-                MutableCompoundShapeSettings compound;
-
                 rPhys.m_hasColliders.insert(weldEnt);
+                rPhys.m_moved.insert(weldEnt);
 
                 // Collect all colliders from hierarchy.
-                compound_collect_recurse( rPhys, rJolt, rBasic, weldEnt, Matrix4{}, compound );
-
-                Ref<Shape> compoundShape = compound.Create().Get();
-                BodyCreationSettings bodyCreation(compoundShape, Vec3Arg::sZero(), Quat::sZero(), EMotionType::Dynamic, Layers::MOVING);
-
-                BodyId const bodyId = rJolt.m_bodyIds.create();
-                SysJolt::resize_body_data(rJolt);
-
-                rJolt.m_bodyToEnt[bodyId] = weldEnt;
-                rJolt.m_bodyFactors[bodyId] = factors;
-                rJolt.m_entToBody.emplace(weldEnt, bodyId);
-
-                float   totalMass = 0.0f;
-                Vector3 massPos{0.0f};
-                SysPhysics::calculate_subtree_mass_center(rBasic.m_transform, rPhys, rBasic.m_scnGraph, weldEnt, massPos, totalMass);
+                children.clear();
+                compound_collect_recurse( rPhys, rJolt, rBasic, weldEnt, Matrix4{}, children );
 
-                Vector3 const com = massPos / totalMass;
-                auto const comToOrigin = Matrix4::translation( - com );
+                // Welds with the same parts in the same places share a compound
+                Ref<Shape> compoundShape = SysJolt::create_compound(rJolt, children);
+                BodyCreationSettings bodyCreation(compoundShape, Vec3Arg::sZero(), Quat::sZero(), EMotionType::Dynamic, Layers::VEHICLE);
 
-                Matrix3 inertiaTensor{0.0f};
-                SysPhysics::calculate_subtree_mass_inertia(rBasic.m_transform, rPhys, rBasic.m_scnGraph, weldEnt, inertiaTensor, comToOrigin);
+                ACompSubtreeMass const &subtree = SysPhysics::subtree_mass(rBasic.m_transform, rPhys, rBasic.m_scnGraph, weldEnt);
 
-                Matrix4 const inertiaTensorMat4{inertiaTensor};
+                Matrix4 const inertiaTensorMat4{SysPhysics::subtree_inertia_about_center(subtree)};
 
                 MassProperties massProp;
-                massProp.mMass = totalMass;
+                massProp.mMass = subtree.m_mass;
                 massProp.mInertia = Mat44::sLoadFloat4x4((Float4*) inertiaTensorMat4.data());
 
                 bodyCreation.mMassPropertiesOverride = massProp;
@@ -442,20 +404,14 @@ FeatureDef const ftrVehicleSpawnJolt = feature_def("VehicleSpawnJolt", [] (
     
                 bodyCreation.mRotation = joltRotation;
 
-                PhysicsSystem *pJoltWorld = rJolt.m_pPhysicsSystem.get();
-                BodyInterface &bodyInterface = pJoltWorld->GetBodyInterface();
-                JPH::BodyID joltBodyId = BToJolt(bodyId);
-                bodyInterface.CreateBodyWithID(joltBodyId, bodyCreation);
-                addedBodies.push_back(joltBodyId);
+                SysJolt::create_body(rJolt, weldEnt, bodyCreation, factors);
                 rPhys.m_setVelocity.emplace_back(weldEnt, toInit.velocity);
             });
 
             itWeldOffsets = itWeldOffsetsNext;
         }
-        //Bodies are added all at once for performance reasons.
-        int numBodies = static_cast<int>(addedBodies.size());
-        BodyInterface::AddState addState = bodyInterface.AddBodiesPrepare(addedBodies.data(), numBodies);
-        bodyInterface.AddBodiesFinalize(addedBodies.data(), numBodies, addState, EActivation::Activate);
+
+        SysJolt::add_created_bodies(rJolt);
     });
 }); // ftrVehicleSpawnJolt
 
@@ -707,4 +663,118 @@ FeatureDef const ftrRocketThrustJolt = feature_def("RocketThrustJolt", [] (
 }); // ftrRocketThrustJolt
 
 
+struct TerrainCollidersJolt
+{
+    osp::KeyedVec<planeta::ChunkId, BodyId> chunkToBody;
+
+    /// Removed from the world but not destroyed, reused with a new shape for the next chunk
+    std::vector<BodyId>                     freeBodies;
+
+    /// Terrain frame rotation when collider rotations were last set. Floating origin
+    /// translations are applied by SysJolt::update_translate like any other body.
+    Quaterniond                             frameRotation;
+
+    /// Scratch for SysTerrainCollision::chunk_triangles
+    std::vector<Vector3>                    triangles;
+};
+
+FeatureDef const ftrTerrainCollisionJolt = feature_def("TerrainCollisionJolt", [] (
+        FeatureBuilder                      &rFB,
+        Implement<FITerrainCollisionJolt>   terrainCollJolt,
+        DependOn<FIScene>                   scn,
+        DependOn<FIJolt>                    jolt,
+        DependOn<FITerrain>                 terrain,
+        DependOn<FITerrainCollision>        terrainColl)
+{
+    using planeta::ACtxTerrain;
+    using planeta::ACtxTerrainCollision;
+    using planeta::ACtxTerrainFrame;
+    using planeta::ChunkId;
+    using planeta::SysTerrainCollision;
+
+    rFB.data_emplace< TerrainCollidersJolt >(terrainCollJolt.di.colliders);
+
+    rFB.task()
+        .name       ("Create, reuse, and move Jolt terrain chunk colliders")
+        .run_on     ({scn.pl.update(Run)})
+        .sync_with  ({terrainColl.pl.chunkColliders(Ready), terrain.pl.terrainFrame(Ready), terrain.pl.chunkMesh(Ready), jolt.pl.joltBody(New)})
+        .args({         terrainCollJolt.di.colliders,             terrainColl.di.terrainColl,                  terrain.di.terrainFrame,                   terrain.di.terrain,              jolt.di.jolt })
+        .func([] (TerrainCollidersJolt &rColliders, ACtxTerrainCollision const &rTerrainColl, ACtxTerrainFrame const &rTerrainFrame, ACtxTerrain const &rTerrain, ACtxJoltWorld &rJolt) noexcept
+    {
+        BodyInterface &bodyInterface = rJolt.m_pPhysicsSystem->GetBodyInterface();
+
+        rColliders.chunkToBody.resize(rTerrain.skChunks.m_chunkIds.capacity(), lgrn::id_null<BodyId>());
+
+        for (ChunkId const chunkId : rTerrainColl.removed)
+        {
+            BodyId const bodyId = std::exchange(rColliders.chunkToBody[chunkId], lgrn::id_null<BodyId>());
+            if (bodyId != lgrn::id_null<BodyId>())
+            {
+                bodyInterface.RemoveBody(BToJolt(bodyId));
+                rColliders.freeBodies.push_back(bodyId);
+            }
+        }
+
+        Quat const rotation = QuatMagnumToJolt(Quaternion{rTerrainFrame.rotation});
+
+        // Rotating terrain, move remaining colliders along with the scene
+        if (rColliders.frameRotation != rTerrainFrame.rotation)
+        {
+            rColliders.frameRotation = rTerrainFrame.rotation;
+            for (ChunkId const chunkId : rTerrainColl.active)
+            {
+                BodyId const bodyId = rColliders.chunkToBody[chunkId];
+                if (bodyId != lgrn::id_null<BodyId>())
+                {
+                    Vector3 const pos = SysTerrainCollision::chunk_position(rTerrain, rTerrainFrame, chunkId);
+                    bodyInterface.SetPositionAndRotation(BToJolt(bodyId), Vec3MagnumToJolt(pos), rotation, EActivation::DontActivate);
+                }
+            }
+        }
+
+        for (ChunkId const chunkId : rTerrainColl.added)
+        {
+            rColliders.triangles.clear();
+            SysTerrainCollision::chunk_triangles(rTerrain, chunkId, rColliders.triangles);
+
+            TriangleList triangles;
+            triangles.reserve(rColliders.triangles.size() / 3);
+            for (std::size_t i = 0; i + 2 < rColliders.triangles.size(); i += 3)
+            {
+                triangles.emplace_back(Vec3MagnumToJolt(rColliders.triangles[i]),
+                                       Vec3MagnumToJolt(rColliders.triangles[i + 1]),
+                                       Vec3MagnumToJolt(rColliders.triangles[i + 2]));
+            }
+
+            ShapeSettings::ShapeResult const result = MeshShapeSettings(triangles).Create();
+            if (result.HasError())
+            {
+                OSP_LOG_WARN("Terrain chunk {} has no collider: {}", chunkId.value, result.GetError().c_str());
+                continue;
+            }
+
+            Vec3 const position = Vec3MagnumToJolt(SysTerrainCollision::chunk_position(rTerrain, rTerrainFrame, chunkId));
+
+            BodyId bodyId;
+            if ( ! rColliders.freeBodies.empty() )
+            {
+                bodyId = rColliders.freeBodies.back();
+                rColliders.freeBodies.pop_back();
+
+                bodyInterface.SetShape(BToJolt(bodyId), result.Get(), false, EActivation::DontActivate);
+                bodyInterface.SetPositionAndRotation(BToJolt(bodyId), position, rotation, EActivation::DontActivate);
+            }
+            else
+            {
+                BodyCreationSettings const settings(result.Get(), position, rotation, EMotionType::Static, Layers::TERRAIN);
+                bodyId = SysJolt::create_unowned_body(rJolt, settings);
+            }
+
+            bodyInterface.AddBody(BToJolt(bodyId), EActivation::DontActivate);
+            rColliders.chunkToBody[chunkId] = bodyId;
+        }
+    });
+}); // ftrTerrainCollisionJolt
+
+
 } // namespace adera
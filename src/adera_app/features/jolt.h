@@ -85,5 +85,10 @@ extern osp::fw::FeatureDef const ftrVehicleSpawnJolt;
  */
 extern osp::fw::FeatureDef const ftrRocketThrustJolt;
 
+/**
+ * @brief Static Jolt mesh colliders for terrain chunks picked by ftrTerrainCollision
+ */
+extern osp::fw::FeatureDef const ftrTerrainCollisionJolt;
+
 } // namespace adera
 
@@ -87,6 +87,7 @@ FeatureDef const ftrCursor = feature_def("Cursor", [] (
 
     rScnRender.m_mesh[cursorEnt] = SysRender::add_drawable_mesh(rDrawing, rDrawingRes, rResources, pkg, "cubewire");
     rScnRender.m_color[cursorEnt] = { 0.0f, 1.0f, 0.0f, 1.0f };
+    rScnRender.m_colorDirty.mark(cursorEnt);
     rScnRender.m_visible.insert(cursorEnt);
     rScnRender.m_opaque.insert(cursorEnt);
 
@@ -101,6 +102,7 @@ FeatureDef const ftrCursor = feature_def("Cursor", [] (
         .func([] (DrawEnt const cursorEnt, ACtxCameraController const& rCamCtrl, ACtxSceneRender& rScnRender) noexcept
     {
         rScnRender.m_drawTransform[cursorEnt] = Matrix4::translation(rCamCtrl.m_target.value());
+        rScnRender.m_drawTfDirty.mark(cursorEnt);
     });
 
 }); // ftrCursor
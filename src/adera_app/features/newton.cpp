@@ -95,6 +95,7 @@ Session setup_newton(
         .args({             comScn.di.basic,             phys.di.phys,              idNwt,           scn.di.deltaTimeIn })
         .func([] (ACtxBasic& rBasic, ACtxPhysics& rPhys, ACtxNwtWorld& rNwt, float const deltaTimeIn, WorkerContext ctx) noexcept
     {
+        SysNewton::update_translate(rPhys, rNwt);
         SysNewton::update_world(rPhys, rNwt, deltaTimeIn, rBasic.m_scnGraph, rBasic.m_transform);
     });
 
@@ -443,19 +444,12 @@ Session setup_vehicle_spawn_newton(
                 rNwt.m_bodyFactors[bodyId] = {1}; // TODO: temporary
                 rNwt.m_entToBody.emplace(weldEnt, bodyId);
 
-                float   totalMass = 0.0f;
-                Vector3 massPos{0.0f};
-                SysPhysics::calculate_subtree_mass_center(rBasic.m_transform, rPhys, rBasic.m_scnGraph, weldEnt, massPos, totalMass);
+                ACompSubtreeMass const &subtree = SysPhysics::subtree_mass(rBasic.m_transform, rPhys, rBasic.m_scnGraph, weldEnt);
 
-                Vector3 const com = massPos / totalMass;
-                auto const comToOrigin = Matrix4::translation( - com );
-
-                Matrix3 inertiaTensor{0.0f};
-                SysPhysics::calculate_subtree_mass_inertia(rBasic.m_transform, rPhys, rBasic.m_scnGraph, weldEnt, inertiaTensor, comToOrigin);
-
-                Matrix4 const inertiaTensorMat4{inertiaTensor};
+                Vector3 const com = SysPhysics::subtree_center(subtree);
+                Matrix4 const inertiaTensorMat4{SysPhysics::subtree_inertia_about_center(subtree)};
                 //NewtonBodySetMassMatrix(pBody, 0.0f, 1.0f, 1.0f, 1.0f);
-                NewtonBodySetFullMassMatrix         (pBody, totalMass, inertiaTensorMat4.data());
+                NewtonBodySetFullMassMatrix         (pBody, subtree.m_mass, inertiaTensorMat4.data());
                 NewtonBodySetCentreOfMass           (pBody, com.data());
                 NewtonBodySetGyroscopicTorque       (pBody, 1);
                 NewtonBodySetMatrix                 (pBody, transform.data());
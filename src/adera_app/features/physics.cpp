@@ -67,6 +67,20 @@ FeatureDef const ftrPhysics = feature_def("Physics", [] (
     {
         SysPhysics::update_delete_phys(rPhys, rActiveEntDel.cbegin(), rActiveEntDel.cend());
     });
+
+    rFB.task()
+        .name       ("Invalidate subtree masses of entities with changed colliders")
+        .run_on     ({scn.pl.update(Run)})
+        .sync_with  ({phys.pl.physBody(Modify), comScn.pl.hierarchy(Ready)})
+        .args       ({           comScn.di.basic,       phys.di.phys })
+        .func       ([] (ACtxBasic const &rBasic, ACtxPhysics &rPhys) noexcept
+    {
+        for (ActiveEnt const ent : rPhys.m_colliderDirty)
+        {
+            SysPhysics::subtree_mass_invalidate(rPhys, rBasic.m_scnGraph, ent);
+        }
+        rPhys.m_colliderDirty.clear();
+    });
 }); // ftrPhysics
 
 
@@ -206,8 +220,7 @@ FeatureDef const ftrPrefabDraw = feature_def("PrefabDraw", [] (
     rFB.task()
         .name       ("Resync spawned shapes mesh and material")
         .run_on     ({windowApp.pl.resync(Run)})
-        .sync_with  ({prefabs.pl.ownedEnts(UseOrRun_), scnRender.pl.entMesh(New), scnRender.pl.material(New), scnRender.pl.drawEnt(New), scnRender.pl.drawEntResized(Done),
-                      scnRender.pl.materialDirty(Modify_), scnRender.pl.entMeshDirty(Modify_)})
+        .sync_with  ({prefabs.pl.ownedEnts(UseOrRun_), scnRender.pl.entMesh(New), scnRender.pl.material(New), scnRender.pl.drawEnt(New), scnRender.pl.drawEntResized(Done)})
         .args       ({      prefabs.di.prefabs,  mainApp.di.resources,         comScn.di.basic,     comScn.di.drawing,        comScn.di.drawingRes,      scnRender.di.scnRender, prefabDraw.di.material})
         .func       ([] (ACtxPrefabs &rPrefabs, Resources &rResources, ACtxBasic const &rBasic, ACtxDrawing &rDrawing, ACtxDrawingRes &rDrawingRes, ACtxSceneRender &rScnRender,    MaterialId material) noexcept
     {
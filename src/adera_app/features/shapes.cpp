@@ -149,11 +149,12 @@ FeatureDef const ftrPhysicsShapes = feature_def("PhysicsShapes", [] (
     rFB.task()
         .name       ("Add physics to spawned shapes")
         .run_on     ({physShapes.pl.spawnRequest(UseOrRun)})
-        .sync_with  ({physShapes.pl.spawnedEnts(UseOrRun), phys.pl.physBody(Modify), phys.pl.physUpdate(Done)})
+        .sync_with  ({physShapes.pl.spawnedEnts(UseOrRun), phys.pl.physBody(Modify), phys.pl.physUpdate(Done), comScn.pl.hierarchy(Ready), comScn.pl.transform(Ready)})
         .args       ({            comScn.di.basic,                physShapes.di.physShapes,             phys.di.phys })
         .func([] (ACtxBasic const &rBasic, ACtxPhysShapes &rPhysShapes, ACtxPhysics &rPhys) noexcept
     {
         rPhys.m_hasColliders.resize(rBasic.m_activeIds.capacity());
+        rPhys.m_moved.resize(rBasic.m_activeIds.capacity());
         rPhys.m_shape.resize(rBasic.m_activeIds.capacity());
 
         for (std::size_t i = 0; i < rPhysShapes.m_spawnRequest.size(); ++i)
@@ -163,12 +164,14 @@ FeatureDef const ftrPhysicsShapes = feature_def("PhysicsShapes", [] (
             ActiveEnt const child   = rPhysShapes.m_ents[i * 2 + 1];
 
             rPhys.m_hasColliders.insert(root);
+            rPhys.m_moved.insert(root);
             if (spawn.m_mass != 0.0f)
             {
                 rPhys.m_setVelocity.emplace_back(root, spawn.m_velocity);
                 Vector3 const inertia = collider_inertia_tensor(spawn.m_shape, spawn.m_size, spawn.m_mass);
                 Vector3 const offset{0.0f, 0.0f, 0.0f};
-                rPhys.m_mass.emplace( child, ACompMass{ inertia, offset, spawn.m_mass } );
+                rPhys.m_mass.emplace( child, ACompMass{ offset, inertia, spawn.m_mass } );
+                SysPhysics::subtree_mass_add(rBasic.m_transform, rPhys, rBasic.m_scnGraph, child);
             }
 
             rPhys.m_shape[child] = spawn.m_shape;
@@ -202,6 +205,7 @@ FeatureDef const ftrPhysicsShapes = feature_def("PhysicsShapes", [] (
 FeatureDef const ftrPhysicsShapesDraw = feature_def("PhysicsShapesDraw", [] (
         FeatureBuilder              &rFB,
         Implement<FIPhysShapesDraw> physShapesDraw,
+        DependOn<FIScene>           scn,
         DependOn<FISceneRenderer>   scnRender,
         DependOn<FICommonScene>     comScn,
         DependOn<FIPhysics>         phys,
@@ -252,16 +256,60 @@ FeatureDef const ftrPhysicsShapesDraw = feature_def("PhysicsShapesDraw", [] (
             rScnRender.m_needDrawTf.insert(child);
 
             rScnRender.m_mesh[drawEnt] = rDrawing.m_meshRefCounts.ref_add(rNamedMeshes.m_shapeToMesh.at(spawn.m_shape));
-            rScnRender.m_meshDirty.push_back(drawEnt);
+            rScnRender.m_meshDirty.mark(drawEnt);
 
             rMat.m_ents.insert(drawEnt);
-            rMat.m_dirty.push_back(drawEnt);
+            rMat.m_dirty.mark(drawEnt);
 
             rScnRender.m_visible.insert(drawEnt);
             rScnRender.m_opaque.insert(drawEnt);
         }
     });
 
+    // m_moved is rewritten every physics step, which may run more than once per rendered frame
+    rFB.task()
+        .name       ("Accumulate moved physics bodies until draw transforms are calculated")
+        .run_on     ({scn.pl.update(Run)})
+        .sync_with  ({phys.pl.physBody(Ready), phys.pl.physUpdate(Done), comScn.pl.activeEntResized(Done)})
+        .args       ({             phys.di.phys,      scnRender.di.scnRender })
+        .func([]    (ACtxPhysics const &rPhys, ACtxSceneRender &rScnRender) noexcept
+    {
+        for (ActiveEnt const ent : rPhys.m_moved)
+        {
+            rScnRender.m_drawTfMoved.insert(ent);
+        }
+    });
+
+    // Covers every physics body, not only shapes: m_hasColliders includes vehicle welds too
+    rFB.task()
+        .name       ("Skip draw transforms of resting physics bodies")
+        .run_on     ({scnRender.pl.render(Run)})
+        .sync_with  ({scnRender.pl.drawTransforms(Resize), comScn.pl.hierarchy(Ready), phys.pl.physBody(Ready), phys.pl.physUpdate(Done)})
+        .args       ({       comScn.di.basic,             phys.di.phys,      scnRender.di.scnRender })
+        .func([]    (ACtxBasic const &rBasic, ACtxPhysics const &rPhys, ACtxSceneRender &rScnRender) noexcept
+    {
+        rScnRender.m_drawTfUnchanged.clear();
+
+        for (ActiveEnt const root : SysSceneGraph::children(rBasic.m_scnGraph))
+        {
+            bool const resting =    rPhys.m_hasColliders.contains(root)
+                               && ! rScnRender.m_drawTfMoved.contains(root)
+                               && ! rScnRender.m_drawTfObserved.contains(root);
+
+            if (resting && rScnRender.m_drawTfValid.contains(root))
+            {
+                rScnRender.m_drawTfUnchanged.insert(root);
+            }
+            else
+            {
+                // Calculated this frame
+                rScnRender.m_drawTfValid.insert(root);
+            }
+        }
+
+        rScnRender.m_drawTfMoved.clear();
+    });
+
     // When does resync run relative to deletes?
 
     rFB.task()
@@ -284,8 +332,7 @@ FeatureDef const ftrPhysicsShapesDraw = feature_def("PhysicsShapesDraw", [] (
     rFB.task()
         .name       ("Resync spawned shapes mesh and material")
         .run_on     ({windowApp.pl.resync(Run)})
-        .sync_with  ({physShapes.pl.ownedEnts(UseOrRun_), scnRender.pl.entMesh(New), scnRender.pl.material(New), scnRender.pl.drawEnt(New), scnRender.pl.drawEntResized(Done),
-                      scnRender.pl.materialDirty(Modify_), scnRender.pl.entMeshDirty(Modify_)})
+        .sync_with  ({physShapes.pl.ownedEnts(UseOrRun_), scnRender.pl.entMesh(New), scnRender.pl.material(New), scnRender.pl.drawEnt(New), scnRender.pl.drawEntResized(Done)})
         .args       ({           comScn.di.basic,     comScn.di.drawing,       phys.di.phys,    physShapes.di.physShapes,      scnRender.di.scnRender,     comScn.di.namedMeshes, physShapesDraw.di.material })
         .func       ([] (ACtxBasic const &rBasic, ACtxDrawing &rDrawing, ACtxPhysics &rPhys, ACtxPhysShapes &rPhysShapes, ACtxSceneRender &rScnRender, NamedMeshes &rNamedMeshes,  MaterialId const material) noexcept
     {
@@ -303,10 +350,9 @@ FeatureDef const ftrPhysicsShapesDraw = feature_def("PhysicsShapesDraw", [] (
 
             EShape const shape = rPhys.m_shape.at(child);
             rScnRender.m_mesh[drawEnt] = rDrawing.m_meshRefCounts.ref_add(rNamedMeshes.m_shapeToMesh.at(shape));
-            rScnRender.m_meshDirty.push_back(drawEnt);
 
+            // Not marked dirty, "Mark all DrawEnts dirty for renderer resync" covers these
             rMat.m_ents.insert(drawEnt);
-            rMat.m_dirty.push_back(drawEnt);
 
             rScnRender.m_visible.insert(drawEnt);
             rScnRender.m_opaque.insert(drawEnt);
@@ -437,6 +483,7 @@ FeatureDef const ftrBounds = feature_def("Bounds", [] (
         Implement<FIBounds>         bounds,
         DependOn<FIScene>           scn,
         DependOn<FICommonScene>     comScn,
+        DependOn<FIPhysics>         phys,
         DependOn<FIPhysShapes>      physShapes)
 {
     rFB.pipeline(bounds.pl.boundsSet)     .parent(scn.pl.update);
@@ -448,12 +495,18 @@ FeatureDef const ftrBounds = feature_def("Bounds", [] (
     rFB.task()
         .name       ("Check for out-of-bounds entities")
         .run_on     ({scn.pl.update(Run)})
-        .sync_with  ({comScn.pl.transform(Ready), bounds.pl.boundsSet(Ready), bounds.pl.outOfBounds(Modify__)})
-        .args       ({    comScn.di.basic,              bounds.di.bounds,        bounds.di.outOfBounds })
-        .func([] (ACtxBasic const &rBasic, ActiveEntSet_t const &rBounds, ActiveEntVec_t &rOutOfBounds) noexcept
+        .sync_with  ({comScn.pl.transform(Ready), phys.pl.physUpdate(Done), bounds.pl.boundsSet(Ready), bounds.pl.outOfBounds(Modify__)})
+        .args       ({    comScn.di.basic,             phys.di.phys,              bounds.di.bounds,        bounds.di.outOfBounds })
+        .func([] (ACtxBasic const &rBasic, ACtxPhysics const &rPhys, ActiveEntSet_t const &rBounds, ActiveEntVec_t &rOutOfBounds) noexcept
     {
-        for (ActiveEnt const ent : rBounds)
+        // Only bodies that moved can newly go out of bounds; resting ones are skipped
+        for (ActiveEnt const ent : rPhys.m_moved)
         {
+            if ( ! rBounds.contains(ent) )
+            {
+                continue;
+            }
+
             ACompTransform const &entTf = rBasic.m_transform.get(ent);
             if (entTf.m_transform.translation().z() < -10)
             {
@@ -465,10 +518,16 @@ FeatureDef const ftrBounds = feature_def("Bounds", [] (
     rFB.task()
         .name       ("Queue-Delete out-of-bounds entities")
         .run_on     ({bounds.pl.outOfBounds(UseOrRun_)})
-        .sync_with  ({comScn.pl.activeEntDelete(Modify_), comScn.pl.hierarchy(Delete)})
-        .args       ({     comScn.di.basic,        comScn.di.activeEntDel,        bounds.di.outOfBounds })
-        .func       ([] (ACtxBasic &rBasic, ActiveEntVec_t &rActiveEntDel, ActiveEntVec_t &rOutOfBounds) noexcept
+        .sync_with  ({comScn.pl.activeEntDelete(Modify_), comScn.pl.hierarchy(Delete), phys.pl.physUpdate(Done)})
+        .args       ({     comScn.di.basic,        comScn.di.activeEntDel,        bounds.di.outOfBounds,       phys.di.phys })
+        .func       ([] (ACtxBasic &rBasic, ActiveEntVec_t &rActiveEntDel, ActiveEntVec_t &rOutOfBounds, ACtxPhysics &rPhys) noexcept
     {
+        // Parents are cut off when queued, so take deleted subtrees out of their ancestors' masses first
+        for (ActiveEnt const ent : rOutOfBounds)
+        {
+            SysPhysics::subtree_mass_remove(rBasic.m_transform, rPhys, rBasic.m_scnGraph, ent);
+        }
+
         SysSceneGraph::queue_delete_entities(rBasic.m_scnGraph, rActiveEntDel, rOutOfBounds.begin(), rOutOfBounds.end());
     });
 
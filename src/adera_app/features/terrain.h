@@ -24,6 +24,8 @@
  */
 #pragma once
 
+#include <planet-a/activescene/terrain_fn.h>
+
 #include <osp/framework/builder.h>
 
 namespace adera
@@ -46,24 +48,8 @@ extern osp::fw::FeatureDef const ftrTerrainIcosahedron;
  */
 extern osp::fw::FeatureDef const ftrTerrainSubdivDist;
 
-struct TerrainTestPlanetSpecs
-{
-    /// Planet lowest ground level in meters
-    double          radius              {};
-
-    /// Planet max ground height in meters
-    double          height              {};
-
-    /// Skeleton Vector3l precision (2^precision units = 1 meter)
-    int             skelPrecision       {};
-
-    /// Skeleton max subdivision levels. 0 for no subdivision. Max is 23.
-    std::uint8_t    skelMaxSubdivLevels {};
-
-    /// Number of times an initial triangle is subdivided to form a chunk.
-    /// Due to bugs (LOL XD): Minimum is 2, Maximum is 8.
-    std::uint8_t    chunkSubdivLevels   {};
-};
+/// See \c planeta::TerrainIcoSpecs
+using TerrainTestPlanetSpecs = planeta::TerrainIcoSpecs;
 
 
 /**
@@ -75,6 +61,14 @@ void initialize_ico_terrain(
         TerrainTestPlanetSpecs      specs);
 
 
+/**
+ * @brief Pick terrain chunks near physics bodies to give colliders to, see ACtxTerrainCollision
+ *
+ * Physics engine specific features such as ftrTerrainCollisionJolt build the colliders.
+ */
+extern osp::fw::FeatureDef const ftrTerrainCollision;
+
+
 /**
  * @brief Uses camera target as position relative to planet, and visualizes terrain skeleton.
  */
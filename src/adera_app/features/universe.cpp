@@ -379,33 +379,34 @@ FeatureDef const ftrUniverseTestPlanetsDraw = feature_def("UniverseTestPlanetsDr
             DrawEnt const drawEnt = rPlanetDraw.drawEnts[i];
 
             rScnRender.m_mesh[drawEnt] = rDrawing.m_meshRefCounts.ref_add(sphereMeshId);
-            rScnRender.m_meshDirty.push_back(drawEnt);
+            rScnRender.m_meshDirty.mark(drawEnt);
             rScnRender.m_visible.insert(drawEnt);
             rScnRender.m_opaque.insert(drawEnt);
             rMatPlanet.m_ents.insert(drawEnt);
-            rMatPlanet.m_dirty.push_back(drawEnt);
+            rMatPlanet.m_dirty.mark(drawEnt);
         }
 
         rScnRender.m_mesh[rPlanetDraw.attractor] = rDrawing.m_meshRefCounts.ref_add(sphereMeshId);
-        rScnRender.m_meshDirty.push_back(rPlanetDraw.attractor);
+        rScnRender.m_meshDirty.mark(rPlanetDraw.attractor);
         rScnRender.m_visible.insert(rPlanetDraw.attractor);
         rScnRender.m_opaque.insert(rPlanetDraw.attractor);
         rMatPlanet.m_ents.insert(rPlanetDraw.attractor);
-        rMatPlanet.m_dirty.push_back(rPlanetDraw.attractor);
+        rMatPlanet.m_dirty.mark(rPlanetDraw.attractor);
 
         for (DrawEnt const drawEnt : rPlanetDraw.axis)
         {
             rScnRender.m_mesh[drawEnt] = rDrawing.m_meshRefCounts.ref_add(cubeMeshId);
-            rScnRender.m_meshDirty.push_back(drawEnt);
+            rScnRender.m_meshDirty.mark(drawEnt);
             rScnRender.m_visible.insert(drawEnt);
             rScnRender.m_opaque.insert(drawEnt);
             rMatAxis.m_ents.insert(drawEnt);
-            rMatAxis.m_dirty.push_back(drawEnt);
+            rMatAxis.m_dirty.mark(drawEnt);
         }
 
         rScnRender.m_color[rPlanetDraw.axis[0]] = {1.0f, 0.0f, 0.0f, 1.0f};
         rScnRender.m_color[rPlanetDraw.axis[1]] = {0.0f, 1.0f, 0.0f, 1.0f};
         rScnRender.m_color[rPlanetDraw.axis[2]] = {0.0f, 0.0f, 1.0f, 1.0f};
+        rScnRender.m_colorDirty.mark(rPlanetDraw.axis.begin(), rPlanetDraw.axis.end());
     });
 
     rFB.task()
@@ -464,6 +465,9 @@ FeatureDef const ftrUniverseTestPlanetsDraw = feature_def("UniverseTestPlanetsDr
             * Matrix4{mainToAreaRot.toMatrix()}
             * Matrix4::scaling({10, 10, 500000});
 
+        rScnRender.m_drawTfDirty.mark(rPlanetDraw.attractor);
+        rScnRender.m_drawTfDirty.mark(rPlanetDraw.axis.begin(), rPlanetDraw.axis.end());
+
         for (std::size_t i = 0; i < rMainSpace.m_satCount; ++i)
         {
             Vector3g const relative = mainToArea.transform_position({x[i], y[i], z[i]});
@@ -477,6 +481,7 @@ FeatureDef const ftrUniverseTestPlanetsDraw = feature_def("UniverseTestPlanetsDr
                 = Matrix4::translation(relativeMeters)
                 * Matrix4::scaling({200, 200, 200})
                 * Matrix4{(mainToAreaRot * Quaternion{rot}).toMatrix()};
+            rScnRender.m_drawTfDirty.mark(drawEnt);
         }
     });
 }); // setup_testplanets_draw
@@ -774,13 +779,14 @@ FeatureDef const ftrSolarSystemDraw = feature_def("SolarSystemDraw", [] (
             DrawEnt const drawEnt = rPlanetDraw.drawEnts[i];
 
             rScnRender.m_mesh[drawEnt] = rDrawing.m_meshRefCounts.ref_add(sphereMeshId);
-            rScnRender.m_meshDirty.push_back(drawEnt);
+            rScnRender.m_meshDirty.mark(drawEnt);
             rScnRender.m_visible.insert(drawEnt);
             rScnRender.m_opaque.insert(drawEnt);
             rMatPlanet.m_ents.insert(drawEnt);
-            rMatPlanet.m_dirty.push_back(drawEnt);
+            rMatPlanet.m_dirty.mark(drawEnt);
 
             rScnRender.m_color[drawEnt] = colorView[i];
+            rScnRender.m_colorDirty.mark(drawEnt);
         }
     });
 
@@ -837,6 +843,7 @@ FeatureDef const ftrSolarSystemDraw = feature_def("SolarSystemDraw", [] (
                 * Matrix4 {
                 (mainToAreaRot * Quaternion{ rot }).toMatrix()
             };
+            rScnRender.m_drawTfDirty.mark(drawEnt);
         }
     });
 }); // ftrSolarSystemDraw
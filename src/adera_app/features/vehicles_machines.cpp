@@ -166,23 +166,27 @@ FeatureDef const ftrMagicRocketThrustIndicator = feature_def("MagicRocketThrustI
             if (!rMat.m_ents.contains(drawEnt))
             {
                 rMat.m_ents.insert(drawEnt);
-                rMat.m_dirty.push_back(drawEnt);
+                rMat.m_dirty.mark(drawEnt);
             }
 
             MeshIdOwner_t &rMeshOwner = rScnRender.m_mesh[drawEnt];
             if ( ! rMeshOwner.has_value() )
             {
                 rScnRender.m_mesh[drawEnt] = rDrawing.m_meshRefCounts.ref_add(rThrustIndicator.mesh.value());
-                rScnRender.m_meshDirty.push_back(drawEnt);
+                rScnRender.m_meshDirty.mark(drawEnt);
             }
 
             rScnRender.m_visible.insert(drawEnt);
             rScnRender.m_opaque .insert(drawEnt);
 
             rScnRender.m_color              [drawEnt] = rThrustIndicator.color;
+            rScnRender.m_colorDirty.mark(drawEnt);
             rScnRender.drawTfObserverEnable [partEnt] = 1;
 
             SysRender::needs_draw_transforms(rBasic.m_scnGraph, rScnRender.m_needDrawTf, partEnt);
+
+            // Indicator changes with throttle, so keep updating even if the vehicle is resting
+            SysRender::needs_draw_transforms(rBasic.m_scnGraph, rScnRender.m_drawTfObserved, partEnt);
         }
     });
 
@@ -222,7 +226,9 @@ FeatureDef const ftrMagicRocketThrustIndicator = feature_def("MagicRocketThrustI
                         = drawTf
                         * Matrix4::scaling({1.0f, 1.0f, thrustMag * rThrustIndicator.indicatorScale})
                         * Matrix4::translation({0.0f, 0.0f, -1.0f})
-                        * Matrix4::scaling({0.2f, 0.2f, 1.0f}); }
+                        * Matrix4::scaling({0.2f, 0.2f, 1.0f});
+                rCtxScnRdr.m_drawTfDirty.mark(drawEnt);
+            }
         }
     };
 
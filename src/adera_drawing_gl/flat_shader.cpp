@@ -24,39 +24,171 @@
  */
 #include "flat_shader.h"
 
+#include <utility>
+
 using namespace osp;
 using namespace osp::draw;
 
+namespace
+{
+
+using adera::shader::FlatGL3D;
+using adera::shader::FlatUniformBuffers;
+
+using Magnum::Shaders::FlatDrawUniform;
+using Magnum::Shaders::FlatMaterialUniform;
+using Magnum::Shaders::TransformationProjectionUniform3D;
+
+constexpr std::uint32_t gc_drawsPerChunk = FlatUniformBuffers::smc_drawsPerChunk;
+
+// Buffer ranges must be aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, which is at most 256
+static_assert(gc_drawsPerChunk * sizeof(TransformationProjectionUniform3D)  % 256 == 0);
+static_assert(gc_drawsPerChunk * sizeof(FlatDrawUniform)                    % 256 == 0);
+static_assert(gc_drawsPerChunk * sizeof(FlatMaterialUniform)                % 256 == 0);
+
+void bind_chunk(FlatGL3D &rShader, FlatUniformBuffers &rBuffers, std::uint32_t chunk)
+{
+    auto const range = [chunk] (std::size_t size) noexcept
+    {
+        return std::make_pair(Magnum::GLintptr(chunk * gc_drawsPerChunk * size),
+                              Magnum::GLsizeiptr(gc_drawsPerChunk * size));
+    };
+
+    auto const [tfOffset,   tfSize]     = range(sizeof(TransformationProjectionUniform3D));
+    auto const [drawOffset, drawSize]   = range(sizeof(FlatDrawUniform));
+    auto const [matOffset,  matSize]    = range(sizeof(FlatMaterialUniform));
+
+    rShader
+        .bindTransformationProjectionBuffer (rBuffers.transformationProjection, tfOffset, tfSize)
+        .bindDrawBuffer                     (rBuffers.draw, drawOffset, drawSize)
+        .bindMaterialBuffer                 (rBuffers.material, matOffset, matSize);
+
+    rBuffers.boundChunk = chunk;
+}
+
+} // namespace
+
+void adera::shader::prepare_ent_flat(
+        ArrayView<DrawEnt const>    ents,
+        ViewProjMatrix const&       viewProj,
+        EntityToDraw::UserData_t    userData) noexcept
+{
+    using Magnum::GL::Buffer;
+    using Magnum::GL::BufferUsage;
+
+    void* const pData    = std::get<0>(userData);
+    void* const pBuffers = std::get<3>(userData);
+    assert(pData    != nullptr);
+    assert(pBuffers != nullptr);
+
+    auto &rData    = *reinterpret_cast<ACtxDrawFlat*>(pData);
+    auto &rBuffers = *reinterpret_cast<FlatUniformBuffers*>(pBuffers);
+
+    if (rBuffers.draw.id() == 0)
+    {
+        rBuffers.transformationProjection   = Buffer{Buffer::TargetHint::Uniform};
+        rBuffers.draw                       = Buffer{Buffer::TargetHint::Uniform};
+        rBuffers.material                   = Buffer{Buffer::TargetHint::Uniform};
+    }
+
+    // Pad to a whole number of chunks, so the last chunk's range fits in the buffers
+    std::size_t const chunks = (ents.size() + gc_drawsPerChunk - 1) / gc_drawsPerChunk;
+    rData.transformUniforms .resize(chunks * gc_drawsPerChunk);
+    rData.drawUniforms      .resize(chunks * gc_drawsPerChunk);
+    rData.materialUniforms  .resize(chunks * gc_drawsPerChunk);
+    rData.drawIndex         .resize(rData.pDrawTf->size());
+
+    for (std::uint32_t i = 0; i < ents.size(); ++i)
+    {
+        DrawEnt const ent = ents[i];
+
+        rData.transformUniforms[i].setTransformationProjectionMatrix(viewProj.m_viewProj * (*rData.pDrawTf)[ent]);
+
+        // Material IDs are relative to the chunk's bound material range, one material per draw
+        rData.drawUniforms[i].setMaterialId(i % gc_drawsPerChunk);
+
+        rData.materialUniforms[i].setColor((rData.pColor != nullptr) ? (*rData.pColor)[ent] : Magnum::Color4{1.0f});
+
+        rData.drawIndex[ent] = i;
+    }
+
+    rBuffers.transformationProjection   .setData(arrayView(rData.transformUniforms), BufferUsage::StreamDraw);
+    rBuffers.draw                       .setData(arrayView(rData.drawUniforms),      BufferUsage::StreamDraw);
+    rBuffers.material                   .setData(arrayView(rData.materialUniforms),  BufferUsage::StreamDraw);
+
+    rBuffers.boundChunk = FlatUniformBuffers::smc_noChunk;
+}
+
 void adera::shader::draw_ent_flat(
         DrawEnt                     ent,
         ViewProjMatrix const&       viewProj,
-        EntityToDraw::UserData_t    userData) noexcept
+        EntityToDraw::UserData_t    userData,
+        RenderStateChanges          changed) noexcept
+{
+    void* const pData    = std::get<0>(userData);
+    void* const pShader  = std::get<1>(userData);
+    void* const pBuffers = std::get<3>(userData);
+    assert(pData    != nullptr);
+    assert(pShader  != nullptr);
+    assert(pBuffers != nullptr);
+
+    auto &rData    = *reinterpret_cast<ACtxDrawFlat*>(pData);
+    auto &rShader  = *reinterpret_cast<FlatGL3D*>(pShader);
+    auto &rBuffers = *reinterpret_cast<FlatUniformBuffers*>(pBuffers);
+
+    // All uniforms were uploaded by prepare_ent_flat. Uniform buffer binding points are shared
+    // between shaders, so they need to be bound again after a shader switch.
+    std::uint32_t const drawIndex = rData.drawIndex[ent];
+    std::uint32_t const chunk     = drawIndex / gc_drawsPerChunk;
+    if ((changed & RenderStateChange::Shader) || chunk != rBuffers.boundChunk)
+    {
+        bind_chunk(rShader, rBuffers, chunk);
+    }
+
+    if ((rShader.flags() & FlatGL3D::Flag::Textured) && (changed & RenderStateChange::Texture))
+    {
+        TexGlId const texGlId = (*rData.pDiffuseTexId)[ent].m_glId;
+        rShader.bindTexture(rData.pTexGl->get(texGlId));
+    }
+
+    MeshGlId const      meshId = (*rData.pMeshId)[ent].m_glId;
+    Magnum::GL::Mesh    &rMesh = rData.pMeshGl->get(meshId);
+
+    rShader.setDrawOffset(drawIndex % gc_drawsPerChunk)
+           .draw(rMesh);
+}
+
+void adera::shader::draw_ent_flat_instanced(
+        DrawEnt                         firstEnt,
+        ArrayView<InstanceData const>   instances,
+        ViewProjMatrix const&           viewProj,
+        EntityToDraw::UserData_t        userData,
+        RenderStateChanges              changed) noexcept
 {
     void* const pData   = std::get<0>(userData);
-    void* const pShader = std::get<1>(userData);
+    void* const pShader = std::get<2>(userData);
     assert(pData   != nullptr);
     assert(pShader != nullptr);
 
     auto &rData   = *reinterpret_cast<ACtxDrawFlat*>(pData);
     auto &rShader = *reinterpret_cast<FlatGL3D*>(pShader);
 
-    // Collect uniform information
-    Matrix4 const &drawTf = (*rData.pDrawTf)[ent];
-
-    if (rShader.flags() & FlatGL3D::Flag::Textured)
+    if (changed & RenderStateChange::Shader)
     {
-        TexGlId const texGlId = (*rData.pDiffuseTexId)[ent].m_glId;
-        rShader.bindTexture(rData.pTexGl->get(texGlId));
+        // Per-instance colors and transforms are multiplied with these
+        rShader.setColor(Magnum::Color4{1.0f})
+               .setTransformationProjectionMatrix(viewProj.m_viewProj);
     }
 
-    if (rData.pColor != nullptr)
+    if ((rShader.flags() & FlatGL3D::Flag::Textured) && (changed & RenderStateChange::Texture))
     {
-        rShader.setColor((*rData.pColor)[ent]);
+        TexGlId const texGlId = (*rData.pDiffuseTexId)[firstEnt].m_glId;
+        rShader.bindTexture(rData.pTexGl->get(texGlId));
     }
 
-    MeshGlId const      meshId = (*rData.pMeshId)[ent].m_glId;
-    Magnum::GL::Mesh    &rMesh = rData.pMeshGl->get(meshId);
+    MeshGlId const      meshId = (*rData.pMeshId)[firstEnt].m_glId;
+    Magnum::GL::Mesh    &rMesh = SysRenderGL::prepare_instanced(*rData.pMeshGl, *rData.pInstanceBufGl, meshId, instances);
 
-    rShader.setTransformationProjectionMatrix(viewProj.m_viewProj * drawTf)
-           .draw(rMesh);
+    rShader.draw(rMesh);
+    rMesh.setInstanceCount(1);
 }
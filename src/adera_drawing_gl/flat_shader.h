@@ -26,46 +26,100 @@
 
 #include <osp_drawing_gl/rendergl.h>
 
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/Shaders/Flat.h>
 #include <Magnum/Shaders/FlatGL.h>
+#include <Magnum/Shaders/Generic.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
 
 namespace adera::shader
 {
 
 using FlatGL3D = Magnum::Shaders::FlatGL3D;
 
+/**
+ * @brief Uniform buffers of a Flat shader compiled with Flag::UniformBuffers
+ *
+ * Same chunked layout as PhongUniformBuffers, refilled once per frame by prepare_ent_flat.
+ */
+struct FlatUniformBuffers
+{
+    static constexpr std::uint32_t smc_drawsPerChunk = 128;
+    static constexpr std::uint32_t smc_noChunk       = std::numeric_limits<std::uint32_t>::max();
+
+    Magnum::GL::Buffer  transformationProjection    {Corrade::NoCreate};
+    Magnum::GL::Buffer  draw                        {Corrade::NoCreate};
+    Magnum::GL::Buffer  material                    {Corrade::NoCreate};
+
+    std::uint32_t       boundChunk                  {smc_noChunk};
+};
 
 struct ACtxDrawFlat
 {
     FlatGL3D                    shaderUntextured    {Corrade::NoCreate};
     FlatGL3D                    shaderDiffuse       {Corrade::NoCreate};
 
-    osp::draw::DrawTransforms_t    *pDrawTf         {nullptr};
-    osp::draw::DrawEntColors_t     *pColor          {nullptr};
-    osp::draw::TexGlEntStorage_t   *pDiffuseTexId   {nullptr};
-    osp::draw::MeshGlEntStorage_t  *pMeshId         {nullptr};
+    // Same as above, with InstancedTransformation and VertexColor flags
+    FlatGL3D                    shaderUntexturedInstanced   {Corrade::NoCreate};
+    FlatGL3D                    shaderDiffuseInstanced      {Corrade::NoCreate};
+
+    // Uniform buffers of shaderUntextured and shaderDiffuse
+    FlatUniformBuffers          buffersUntextured;
+    FlatUniformBuffers          buffersDiffuse;
+
+    // Index into the per-draw uniform buffers of each entity, assigned by prepare_ent_flat
+    osp::KeyedVec<osp::draw::DrawEnt, std::uint32_t>                    drawIndex;
+
+    // Reused each frame to fill the per-draw uniform buffers
+    std::vector<Magnum::Shaders::TransformationProjectionUniform3D>     transformUniforms;
+    std::vector<Magnum::Shaders::FlatDrawUniform>                       drawUniforms;
+    std::vector<Magnum::Shaders::FlatMaterialUniform>                   materialUniforms;
 
-    osp::draw::TexGlStorage_t      *pTexGl          {nullptr};
-    osp::draw::MeshGlStorage_t     *pMeshGl         {nullptr};
+    osp::draw::DrawTransforms_t        *pDrawTf         {nullptr};
+    osp::draw::DrawEntColors_t         *pColor          {nullptr};
+    osp::draw::TexGlEntStorage_t       *pDiffuseTexId   {nullptr};
+    osp::draw::MeshGlEntStorage_t      *pMeshId         {nullptr};
+
+    osp::draw::TexGlStorage_t          *pTexGl          {nullptr};
+    osp::draw::MeshGlStorage_t         *pMeshGl         {nullptr};
+    osp::draw::InstanceBufGlStorage_t  *pInstanceBufGl  {nullptr};
 
     osp::draw::MaterialId materialId { lgrn::id_null<osp::draw::MaterialId>() };
 
-    constexpr void assign_pointers(osp::draw::ACtxSceneRender&   rScnRender,
+    constexpr void assign_pointers(osp::draw::RenderFrame&       rFrame,
                                    osp::draw::ACtxSceneRenderGL& rScnRenderGl,
                                    osp::draw::RenderGL&          rRenderGl) noexcept
     {
-        pDrawTf         = &rScnRender   .m_drawTransform;
-        pColor          = &rScnRender   .m_color;
+        pDrawTf         = &rFrame       .drawTransform;
+        pColor          = &rFrame       .color;
         pDiffuseTexId   = &rScnRenderGl .m_diffuseTexId;
         pMeshId         = &rScnRenderGl .m_meshId;
         pTexGl          = &rRenderGl    .m_texGl;
         pMeshGl         = &rRenderGl    .m_meshGl;
+        pInstanceBufGl  = &rRenderGl    .m_instanceBufGl;
     }
 };
 
+void prepare_ent_flat(
+        osp::ArrayView<osp::draw::DrawEnt const>    ents,
+        osp::draw::ViewProjMatrix const&            viewProj,
+        osp::draw::EntityToDraw::UserData_t         userData) noexcept;
+
 void draw_ent_flat(
         osp::draw::DrawEnt                   ent,
         osp::draw::ViewProjMatrix const&     viewProj,
-        osp::draw::EntityToDraw::UserData_t  userData) noexcept;
+        osp::draw::EntityToDraw::UserData_t  userData,
+        osp::draw::RenderStateChanges        changed) noexcept;
+
+void draw_ent_flat_instanced(
+        osp::draw::DrawEnt                                  firstEnt,
+        osp::ArrayView<osp::draw::InstanceData const>       instances,
+        osp::draw::ViewProjMatrix const&                    viewProj,
+        osp::draw::EntityToDraw::UserData_t                 userData,
+        osp::draw::RenderStateChanges                       changed) noexcept;
 
 struct ArgsForSyncDrawEntFlat
 {
@@ -87,11 +141,17 @@ inline void sync_drawent_flat(osp::draw::DrawEnt ent, ArgsForSyncDrawEntFlat con
     FlatGL3D *pShader = hasTexture
                       ? &args.rData.shaderDiffuse
                       : &args.rData.shaderUntextured;
+    FlatGL3D *pShaderInstanced = hasTexture
+                               ? &args.rData.shaderDiffuseInstanced
+                               : &args.rData.shaderUntexturedInstanced;
+    FlatUniformBuffers *pBuffers = hasTexture
+                                 ? &args.rData.buffersDiffuse
+                                 : &args.rData.buffersUntextured;
 
     if (args.pStorageTransparent != nullptr)
     {
         auto value = (hasMaterial && args.transparent.contains(ent))
-                   ? std::make_optional(osp::draw::EntityToDraw{&draw_ent_flat, {&args.rData, pShader}})
+                   ? std::make_optional(osp::draw::EntityToDraw{&draw_ent_flat, {&args.rData, pShader, pShaderInstanced, pBuffers}, &draw_ent_flat_instanced, &prepare_ent_flat})
                    : std::nullopt;
 
         osp::storage_assign(*args.pStorageTransparent, ent, std::move(value));
@@ -100,7 +160,7 @@ inline void sync_drawent_flat(osp::draw::DrawEnt ent, ArgsForSyncDrawEntFlat con
     if (args.pStorageOpaque != nullptr)
     {
         auto value = (hasMaterial && args.opaque.contains(ent))
-                   ? std::make_optional(osp::draw::EntityToDraw{&draw_ent_flat, {&args.rData, pShader}})
+                   ? std::make_optional(osp::draw::EntityToDraw{&draw_ent_flat, {&args.rData, pShader, pShaderInstanced, pBuffers}, &draw_ent_flat_instanced, &prepare_ent_flat})
                    : std::nullopt;
 
         osp::storage_assign(*args.pStorageOpaque, ent, std::move(value));
@@ -24,39 +24,208 @@
  */
 #include "phong_shader.h"
 
+#include <array>
+#include <utility>
+
 // for the 0xrrggbb_rgbf and angle literals
 using namespace Magnum::Math::Literals;
 
 using namespace osp;
 using namespace osp::draw;
 
-void adera::shader::draw_ent_phong(
-        DrawEnt                     ent,
+namespace
+{
+
+using adera::shader::PhongGL;
+using adera::shader::PhongUniformBuffers;
+
+using Magnum::Shaders::PhongDrawUniform;
+using Magnum::Shaders::PhongLightUniform;
+using Magnum::Shaders::PhongMaterialUniform;
+using Magnum::Shaders::ProjectionUniform3D;
+using Magnum::Shaders::TransformationUniform3D;
+
+constexpr std::uint32_t gc_drawsPerChunk = PhongUniformBuffers::smc_drawsPerChunk;
+
+// Buffer ranges must be aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, which is at most 256
+static_assert(gc_drawsPerChunk * sizeof(TransformationUniform3D) % 256 == 0);
+static_assert(gc_drawsPerChunk * sizeof(PhongDrawUniform)        % 256 == 0);
+static_assert(gc_drawsPerChunk * sizeof(PhongMaterialUniform)    % 256 == 0);
+
+constexpr Magnum::Color4 gc_ambientColor    = 0x1a1e29ff_rgbaf;
+constexpr Magnum::Color4 gc_specularColor   = 0xffffff00_rgbaf;
+
+// TODO: find a better way to deal with lights instead of hard-coding it
+struct Light
+{
+    Vector4         direction;
+    Magnum::Color3  color;
+    Magnum::Color3  specularColor;
+};
+
+std::array<Light, 2> const gc_lights
+{{
+    // Lights with w=0.0f are directional lights
+    { Vector4{ Vector3{0.2f, 0.6f, 0.5f}.normalized(), 0.0f},  0xddd4Cd_rgbf, 0xfff5ed_rgbf },
+    { Vector4{-Vector3{0.0f, 0.0f, 1.0f}, 0.0f},                0x32354e_rgbf, 0x000000_rgbf }
+}};
+
+/**
+ * @brief Set uniforms that are the same for all entities drawn in a frame, for shaders without
+ *        uniform buffers
+ */
+void set_frame_uniforms(PhongGL &rShader, ViewProjMatrix const& viewProj)
+{
+    // Directonal lights are camera-relative, so we need 'viewProj.m_view *'
+    auto const lightPositions =
+    {
+        viewProj.m_view * gc_lights[0].direction,
+        viewProj.m_view * gc_lights[1].direction
+    };
+
+    rShader
+        .setAmbientColor(gc_ambientColor)
+        .setSpecularColor(gc_specularColor)
+        .setLightColors({gc_lights[0].color, gc_lights[1].color})
+        .setLightSpecularColors({gc_lights[0].specularColor, gc_lights[1].specularColor})
+        .setLightPositions(lightPositions)
+        .setProjectionMatrix(viewProj.m_proj);
+}
+
+/**
+ * @brief Bind per-frame uniform buffers and the per-draw buffer ranges of a chunk
+ */
+void bind_chunk(PhongGL &rShader, PhongUniformBuffers &rBuffers, std::uint32_t chunk)
+{
+    auto const range = [chunk] (std::size_t size) noexcept
+    {
+        return std::make_pair(Magnum::GLintptr(chunk * gc_drawsPerChunk * size),
+                              Magnum::GLsizeiptr(gc_drawsPerChunk * size));
+    };
+
+    auto const [tfOffset,   tfSize]     = range(sizeof(TransformationUniform3D));
+    auto const [drawOffset, drawSize]   = range(sizeof(PhongDrawUniform));
+    auto const [matOffset,  matSize]    = range(sizeof(PhongMaterialUniform));
+
+    rShader
+        .bindProjectionBuffer       (rBuffers.projection)
+        .bindLightBuffer            (rBuffers.light)
+        .bindTransformationBuffer   (rBuffers.transformation, tfOffset, tfSize)
+        .bindDrawBuffer             (rBuffers.draw, drawOffset, drawSize)
+        .bindMaterialBuffer         (rBuffers.material, matOffset, matSize);
+
+    rBuffers.boundChunk = chunk;
+}
+
+} // namespace
+
+void adera::shader::prepare_ent_phong(
+        ArrayView<DrawEnt const>    ents,
         ViewProjMatrix const&       viewProj,
         EntityToDraw::UserData_t    userData) noexcept
 {
-    using Flag = PhongGL::Flag;
+    using Magnum::GL::Buffer;
+    using Magnum::GL::BufferUsage;
 
-    void* const pData   = std::get<0>(userData);
-    void* const pShader = std::get<1>(userData);
-    assert(pData   != nullptr);
-    assert(pShader != nullptr);
+    void* const pData    = std::get<0>(userData);
+    void* const pBuffers = std::get<3>(userData);
+    assert(pData    != nullptr);
+    assert(pBuffers != nullptr);
 
-    auto &rData   = *reinterpret_cast<ACtxDrawPhong*>(pData);
-    auto &rShader = *reinterpret_cast<PhongGL*>(pShader);
+    auto &rData    = *reinterpret_cast<ACtxDrawPhong*>(pData);
+    auto &rBuffers = *reinterpret_cast<PhongUniformBuffers*>(pBuffers);
 
-    // Collect uniform information
-    Matrix4 const &drawTf = (*rData.pDrawTf)[ent];
+    if (rBuffers.projection.id() == 0)
+    {
+        rBuffers.projection     = Buffer{Buffer::TargetHint::Uniform};
+        rBuffers.light          = Buffer{Buffer::TargetHint::Uniform};
+        rBuffers.transformation = Buffer{Buffer::TargetHint::Uniform};
+        rBuffers.draw           = Buffer{Buffer::TargetHint::Uniform};
+        rBuffers.material       = Buffer{Buffer::TargetHint::Uniform};
+    }
 
-    Magnum::Matrix4 entRelative = viewProj.m_view * drawTf;
+    // Per-frame uniforms
 
-    /* 4th component indicates light type. A value of 0.0f indicates that the
-     * light is a direction light coming from the specified direction relative
-     * to the camera.
-     */
-    //Vector4 light = ;
+    rBuffers.projection.setData({ ProjectionUniform3D{}.setProjectionMatrix(viewProj.m_proj) },
+                                BufferUsage::StreamDraw);
 
-    if (rShader.flags() & Flag::DiffuseTexture)
+    // Directonal lights are camera-relative, so we need 'viewProj.m_view *'
+    std::array<PhongLightUniform, gc_lights.size()> lightUniforms;
+    for (std::size_t i = 0; i < gc_lights.size(); ++i)
+    {
+        lightUniforms[i]
+            .setPosition        (viewProj.m_view * gc_lights[i].direction)
+            .setColor           (gc_lights[i].color)
+            .setSpecularColor   (gc_lights[i].specularColor);
+    }
+    rBuffers.light.setData(arrayView(lightUniforms), BufferUsage::StreamDraw);
+
+    // Per-draw uniforms. Pad to a whole number of chunks, so the last chunk's range fits in the
+    // buffers.
+
+    std::size_t const chunks = (ents.size() + gc_drawsPerChunk - 1) / gc_drawsPerChunk;
+    rData.transformUniforms .resize(chunks * gc_drawsPerChunk);
+    rData.drawUniforms      .resize(chunks * gc_drawsPerChunk);
+    rData.materialUniforms  .resize(chunks * gc_drawsPerChunk);
+    rData.drawIndex         .resize(rData.pDrawTf->size());
+
+    for (std::uint32_t i = 0; i < ents.size(); ++i)
+    {
+        DrawEnt const ent = ents[i];
+        Magnum::Matrix4 const entRelative = viewProj.m_view * (*rData.pDrawTf)[ent];
+        Magnum::Color4 const  color = (rData.pColor != nullptr) ? (*rData.pColor)[ent] : Magnum::Color4{1.0f};
+
+        rData.transformUniforms[i].setTransformationMatrix(entRelative);
+
+        // Material IDs are relative to the chunk's bound material range, one material per draw
+        rData.drawUniforms[i]
+            .setNormalMatrix    (entRelative.normalMatrix())
+            .setMaterialId      (i % gc_drawsPerChunk);
+
+        rData.materialUniforms[i]
+            .setAmbientColor    (gc_ambientColor)
+            .setDiffuseColor    (color)
+            .setSpecularColor   (gc_specularColor);
+
+        rData.drawIndex[ent] = i;
+    }
+
+    rBuffers.transformation .setData(arrayView(rData.transformUniforms), BufferUsage::StreamDraw);
+    rBuffers.draw           .setData(arrayView(rData.drawUniforms),      BufferUsage::StreamDraw);
+    rBuffers.material       .setData(arrayView(rData.materialUniforms),  BufferUsage::StreamDraw);
+
+    rBuffers.boundChunk = PhongUniformBuffers::smc_noChunk;
+}
+
+void adera::shader::draw_ent_phong(
+        DrawEnt                     ent,
+        ViewProjMatrix const&       viewProj,
+        EntityToDraw::UserData_t    userData,
+        RenderStateChanges          changed) noexcept
+{
+    using Flag = PhongGL::Flag;
+
+    void* const pData    = std::get<0>(userData);
+    void* const pShader  = std::get<1>(userData);
+    void* const pBuffers = std::get<3>(userData);
+    assert(pData    != nullptr);
+    assert(pShader  != nullptr);
+    assert(pBuffers != nullptr);
+
+    auto &rData    = *reinterpret_cast<ACtxDrawPhong*>(pData);
+    auto &rShader  = *reinterpret_cast<PhongGL*>(pShader);
+    auto &rBuffers = *reinterpret_cast<PhongUniformBuffers*>(pBuffers);
+
+    // All uniforms were uploaded by prepare_ent_phong. Uniform buffer binding points are shared
+    // between shaders, so they need to be bound again after a shader switch.
+    std::uint32_t const drawIndex = rData.drawIndex[ent];
+    std::uint32_t const chunk     = drawIndex / gc_drawsPerChunk;
+    if ((changed & RenderStateChange::Shader) || chunk != rBuffers.boundChunk)
+    {
+        bind_chunk(rShader, rBuffers, chunk);
+    }
+
+    if ((rShader.flags() & Flag::DiffuseTexture) && (changed & RenderStateChange::Texture))
     {
         TexGlId const texGlId = (*rData.pDiffuseTexId)[ent].m_glId;
         Magnum::GL::Texture2D &rTexture = rData.pTexGl->get(texGlId);
@@ -68,47 +237,58 @@ void adera::shader::draw_ent_phong(
         }
     }
 
-    if (rData.pColor != nullptr)
-    {
-        rShader.setDiffuseColor((*rData.pColor)[ent]);
-    }
-
     MeshGlId const      meshId = (*rData.pMeshId)[ent].m_glId;
     Magnum::GL::Mesh    &rMesh = rData.pMeshGl->get(meshId);
 
-    Matrix3 a{viewProj.m_view};
+    rShader
+        .setDrawOffset(drawIndex % gc_drawsPerChunk)
+        .draw(rMesh);
+}
 
+void adera::shader::draw_ent_phong_instanced(
+        DrawEnt                         firstEnt,
+        ArrayView<InstanceData const>   instances,
+        ViewProjMatrix const&           viewProj,
+        EntityToDraw::UserData_t        userData,
+        RenderStateChanges              changed) noexcept
+{
+    using Flag = PhongGL::Flag;
 
-    // Lights with w=0.0f are directional lights
-    // Directonal lights are camera-relative, so we need 'viewProj.m_view *'
-    auto const lightPositions =
-    {
-        viewProj.m_view * Vector4{ Vector3{0.2f, 0.6f, 0.5f}.normalized(), 0.0f},
-        viewProj.m_view * Vector4{-Vector3{0.0f, 0.0f, 1.0f}, 0.0f}
-    };
+    void* const pData   = std::get<0>(userData);
+    void* const pShader = std::get<2>(userData);
+    assert(pData   != nullptr);
+    assert(pShader != nullptr);
 
-    auto const lightColors =
+    auto &rData   = *reinterpret_cast<ACtxDrawPhong*>(pData);
+    auto &rShader = *reinterpret_cast<PhongGL*>(pShader);
+
+    if (changed & RenderStateChange::Shader)
     {
-        0xddd4Cd_rgbf,
-        0x32354e_rgbf
-    };
+        set_frame_uniforms(rShader, viewProj);
 
-    auto const lightSpecColors =
+        // Per-instance colors are multiplied with the diffuse color. Per-instance transforms are
+        // in world space, so the view matrix goes into the transformation uniforms.
+        rShader
+            .setDiffuseColor(0xffffffff_rgbaf)
+            .setTransformationMatrix(viewProj.m_view)
+            .setNormalMatrix(viewProj.m_view.normalMatrix());
+    }
+
+    if ((rShader.flags() & Flag::DiffuseTexture) && (changed & RenderStateChange::Texture))
     {
-        0xfff5ed_rgbf,
-        0x000000_rgbf
-    };
+        TexGlId const texGlId = (*rData.pDiffuseTexId)[firstEnt].m_glId;
+        Magnum::GL::Texture2D &rTexture = rData.pTexGl->get(texGlId);
+        rShader.bindDiffuseTexture(rTexture);
 
-    // TODO: find a better way to deal with lights instead of hard-coding it
-    rShader
-        .setAmbientColor(0x1a1e29ff_rgbaf)
-        .setSpecularColor(0xffffff00_rgbaf)
-        .setLightColors(lightColors)
-        .setLightSpecularColors(lightSpecColors)
-        .setLightPositions(lightPositions)
-        .setTransformationMatrix(entRelative)
-        .setProjectionMatrix(viewProj.m_proj)
-        .setNormalMatrix(entRelative.normalMatrix())
-        .draw(rMesh);
-}
+        if (rShader.flags() & (Flag::AmbientTexture | Flag::AlphaMask))
+        {
+            rShader.bindAmbientTexture(rTexture);
+        }
+    }
+
+    MeshGlId const      meshId = (*rData.pMeshId)[firstEnt].m_glId;
+    Magnum::GL::Mesh    &rMesh = SysRenderGL::prepare_instanced(*rData.pMeshGl, *rData.pInstanceBufGl, meshId, instances);
 
+    rShader.draw(rMesh);
+    rMesh.setInstanceCount(1);
+}
@@ -26,13 +26,41 @@
 
 #include <osp_drawing_gl/rendergl.h>
 
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/Shaders/Generic.h>
+#include <Magnum/Shaders/Phong.h>
 #include <Magnum/Shaders/PhongGL.h>
 
+#include <cstdint>
+#include <limits>
+#include <vector>
+
 namespace adera::shader
 {
 
 using PhongGL = Magnum::Shaders::PhongGL;
 
+/**
+ * @brief Uniform buffers of a Phong shader compiled with Flag::UniformBuffers
+ *
+ * Refilled once per frame by prepare_ent_phong. Per-draw uniforms are split into chunks of
+ * smc_drawsPerChunk, which is also the shader's draw and material count. A draw binds the range
+ * of its chunk, then selects its entry with setDrawOffset.
+ */
+struct PhongUniformBuffers
+{
+    static constexpr std::uint32_t smc_drawsPerChunk = 128;
+    static constexpr std::uint32_t smc_noChunk       = std::numeric_limits<std::uint32_t>::max();
+
+    Magnum::GL::Buffer  projection      {Corrade::NoCreate};
+    Magnum::GL::Buffer  light           {Corrade::NoCreate};
+    Magnum::GL::Buffer  transformation  {Corrade::NoCreate};
+    Magnum::GL::Buffer  draw            {Corrade::NoCreate};
+    Magnum::GL::Buffer  material        {Corrade::NoCreate};
+
+    std::uint32_t       boundChunk      {smc_noChunk};
+};
+
 /**
  * @brief Stores per-scene data needed for Phong shaders to draw
  */
@@ -41,33 +69,64 @@ struct ACtxDrawPhong
     PhongGL                     shaderUntextured    {Corrade::NoCreate};
     PhongGL                     shaderDiffuse       {Corrade::NoCreate};
 
-    osp::draw::DrawTransforms_t    *pDrawTf         {nullptr};
-    osp::draw::DrawEntColors_t     *pColor          {nullptr};
-    osp::draw::TexGlEntStorage_t   *pDiffuseTexId   {nullptr};
-    osp::draw::MeshGlEntStorage_t  *pMeshId         {nullptr};
+    // Same as above, with InstancedTransformation and VertexColor flags
+    PhongGL                     shaderUntexturedInstanced   {Corrade::NoCreate};
+    PhongGL                     shaderDiffuseInstanced      {Corrade::NoCreate};
+
+    // Uniform buffers of shaderUntextured and shaderDiffuse
+    PhongUniformBuffers         buffersUntextured;
+    PhongUniformBuffers         buffersDiffuse;
+
+    // Index into the per-draw uniform buffers of each entity, assigned by prepare_ent_phong
+    osp::KeyedVec<osp::draw::DrawEnt, std::uint32_t>        drawIndex;
+
+    // Reused each frame to fill the per-draw uniform buffers
+    std::vector<Magnum::Shaders::TransformationUniform3D>   transformUniforms;
+    std::vector<Magnum::Shaders::PhongDrawUniform>          drawUniforms;
+    std::vector<Magnum::Shaders::PhongMaterialUniform>      materialUniforms;
 
-    osp::draw::TexGlStorage_t      *pTexGl          {nullptr};
-    osp::draw::MeshGlStorage_t     *pMeshGl         {nullptr};
+    osp::draw::DrawTransforms_t        *pDrawTf         {nullptr};
+    osp::draw::DrawEntColors_t         *pColor          {nullptr};
+    osp::draw::TexGlEntStorage_t       *pDiffuseTexId   {nullptr};
+    osp::draw::MeshGlEntStorage_t      *pMeshId         {nullptr};
+
+    osp::draw::TexGlStorage_t          *pTexGl          {nullptr};
+    osp::draw::MeshGlStorage_t         *pMeshGl         {nullptr};
+    osp::draw::InstanceBufGlStorage_t  *pInstanceBufGl  {nullptr};
 
     osp::draw::MaterialId materialId { lgrn::id_null<osp::draw::MaterialId>() };
 
-    constexpr void assign_pointers(osp::draw::ACtxSceneRender&   rScnRender,
+    constexpr void assign_pointers(osp::draw::RenderFrame&       rFrame,
                                    osp::draw::ACtxSceneRenderGL& rScnRenderGl,
                                    osp::draw::RenderGL&          rRenderGl) noexcept
     {
-        pDrawTf         = &rScnRender   .m_drawTransform;
-        pColor          = &rScnRender   .m_color;
+        pDrawTf         = &rFrame       .drawTransform;
+        pColor          = &rFrame       .color;
         pDiffuseTexId   = &rScnRenderGl .m_diffuseTexId;
         pMeshId         = &rScnRenderGl .m_meshId;
         pTexGl          = &rRenderGl    .m_texGl;
         pMeshGl         = &rRenderGl    .m_meshGl;
+        pInstanceBufGl  = &rRenderGl    .m_instanceBufGl;
     }
 };
 
+void prepare_ent_phong(
+        osp::ArrayView<osp::draw::DrawEnt const>    ents,
+        osp::draw::ViewProjMatrix const&            viewProj,
+        osp::draw::EntityToDraw::UserData_t         userData) noexcept;
+
 void draw_ent_phong(
         osp::draw::DrawEnt                   ent,
         osp::draw::ViewProjMatrix const&     viewProj,
-        osp::draw::EntityToDraw::UserData_t  userData) noexcept;
+        osp::draw::EntityToDraw::UserData_t  userData,
+        osp::draw::RenderStateChanges        changed) noexcept;
+
+void draw_ent_phong_instanced(
+        osp::draw::DrawEnt                                  firstEnt,
+        osp::ArrayView<osp::draw::InstanceData const>       instances,
+        osp::draw::ViewProjMatrix const&                    viewProj,
+        osp::draw::EntityToDraw::UserData_t                 userData,
+        osp::draw::RenderStateChanges                       changed) noexcept;
 
 struct ArgsForSyncDrawEntPhong
 {
@@ -89,11 +148,17 @@ inline void sync_drawent_phong(osp::draw::DrawEnt ent, ArgsForSyncDrawEntPhong c
     PhongGL *pShader = hasTexture
                      ? &args.rData.shaderDiffuse
                      : &args.rData.shaderUntextured;
+    PhongGL *pShaderInstanced = hasTexture
+                              ? &args.rData.shaderDiffuseInstanced
+                              : &args.rData.shaderUntexturedInstanced;
+    PhongUniformBuffers *pBuffers = hasTexture
+                                  ? &args.rData.buffersDiffuse
+                                  : &args.rData.buffersUntextured;
 
     if (args.pStorageTransparent != nullptr)
     {
         auto value = (hasMaterial && args.transparent.contains(ent))
-                   ? std::make_optional(osp::draw::EntityToDraw{&draw_ent_phong, {&args.rData, pShader}})
+                   ? std::make_optional(osp::draw::EntityToDraw{&draw_ent_phong, {&args.rData, pShader, pShaderInstanced, pBuffers}, &draw_ent_phong_instanced, &prepare_ent_phong})
                    : std::nullopt;
 
         osp::storage_assign(*args.pStorageTransparent, ent, std::move(value));
@@ -102,7 +167,7 @@ inline void sync_drawent_phong(osp::draw::DrawEnt ent, ArgsForSyncDrawEntPhong c
     if (args.pStorageOpaque != nullptr)
     {
         auto value = (hasMaterial && args.opaque.contains(ent))
-                   ? std::make_optional(osp::draw::EntityToDraw{&draw_ent_phong, {&args.rData, pShader}})
+                   ? std::make_optional(osp::draw::EntityToDraw{&draw_ent_phong, {&args.rData, pShader, pShaderInstanced, pBuffers}, &draw_ent_phong_instanced, &prepare_ent_phong})
                    : std::nullopt;
 
         osp::storage_assign(*args.pStorageOpaque, ent, std::move(value));
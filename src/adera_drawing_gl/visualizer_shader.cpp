@@ -37,7 +37,8 @@ using namespace osp::draw;
 void adera::shader::draw_ent_visualizer(
         DrawEnt                     ent,
         ViewProjMatrix const&       viewProj,
-        EntityToDraw::UserData_t    userData) noexcept
+        EntityToDraw::UserData_t    userData,
+        RenderStateChanges          changed) noexcept
 {
     using Magnum::Shaders::MeshVisualizerGL3D;
 
@@ -64,10 +65,15 @@ void adera::shader::draw_ent_visualizer(
     MeshGlId const      meshId = (*rData.m_pMeshId)[ent].m_glId;
     Magnum::GL::Mesh    &rMesh = rData.m_pMeshGl->get(meshId);
 
+    if (changed & RenderStateChange::Shader)
+    {
+        rShader
+            .setViewportSize(Vector2{Magnum::GL::defaultFramebuffer.viewport().size()})
+            .setProjectionMatrix(viewProj.m_proj);
+    }
+
     rShader
-        .setViewportSize(Vector2{Magnum::GL::defaultFramebuffer.viewport().size()})
         .setTransformationMatrix(entRelative)
-        .setProjectionMatrix(viewProj.m_proj)
         .draw(rMesh);
 
     if (rData.m_wireframeOnly)
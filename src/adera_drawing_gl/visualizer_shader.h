@@ -45,11 +45,11 @@ struct ACtxDrawMeshVisualizer
 
     bool m_wireframeOnly{false};
 
-constexpr void assign_pointers(osp::draw::ACtxSceneRender&      rScnRender,
+constexpr void assign_pointers(osp::draw::RenderFrame&          rFrame,
                                osp::draw::ACtxSceneRenderGL&    rScnRenderGl,
                                osp::draw::RenderGL&             rRenderGl) noexcept
     {
-        m_pDrawTf   = &rScnRender.m_drawTransform;
+        m_pDrawTf   = &rFrame.drawTransform;
         m_pMeshId   = &rScnRenderGl.m_meshId;
         m_pMeshGl   = &rRenderGl.m_meshGl;
     }
@@ -58,7 +58,8 @@ constexpr void assign_pointers(osp::draw::ACtxSceneRender&      rScnRender,
 void draw_ent_visualizer(
         osp::draw::DrawEnt                  ent,
         osp::draw::ViewProjMatrix const&    viewProj,
-        osp::draw::EntityToDraw::UserData_t userData) noexcept;
+        osp::draw::EntityToDraw::UserData_t userData,
+        osp::draw::RenderStateChanges       changed) noexcept;
 
 inline void sync_drawent_visualizer(
         osp::draw::DrawEnt const            ent,
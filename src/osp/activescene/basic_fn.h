@@ -167,6 +167,16 @@ public:
     template<typename ITA_T, typename ITB_T>
     static void queue_delete_entities(ACtxSceneGraph& rScnGraph, ActiveEntVec_t &rDelete, ITA_T const& first, ITB_T const& last);
 
+    /**
+     * @brief Sort a component storage into scene graph (depth-first) order
+     *
+     * Systems that scan the tree linearly, such as SysRender::update_draw_transforms, then read
+     * components in memory order. Does nothing if the storage is already sorted, which is the
+     * case unless the hierarchy changed. Entities not in the scene graph go last.
+     */
+    template<typename STORAGE_T>
+    static void sort_by_tree(ACtxSceneGraph const& rScnGraph, STORAGE_T& rStorage);
+
 private:
 
     static void do_delete(ACtxSceneGraph& rScnGraph);
@@ -208,5 +218,22 @@ void SysSceneGraph::queue_delete_entities(ACtxSceneGraph& rScnGraph, ActiveEntVe
     SysSceneGraph::cut(rScnGraph, first, last);
 }
 
+template<typename STORAGE_T>
+void SysSceneGraph::sort_by_tree(ACtxSceneGraph const& rScnGraph, STORAGE_T& rStorage)
+{
+    auto const byTreePos = [&entToTreePos = rScnGraph.m_entToTreePos] (ActiveEnt const lhs, ActiveEnt const rhs) noexcept
+    {
+        return entToTreePos[lhs] < entToTreePos[rhs];
+    };
+
+    // Entities only, not components
+    auto const &entities = static_cast<typename STORAGE_T::base_type const&>(rStorage);
+
+    if ( ! std::is_sorted(entities.begin(), entities.end(), byTreePos) )
+    {
+        rStorage.sort(byTreePos);
+    }
+}
+
 } // namespace osp::active
 
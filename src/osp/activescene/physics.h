@@ -42,6 +42,22 @@ struct ACompMass
     float   m_mass;
 };
 
+/**
+ * @brief Cached mass properties of an entity's descendants, in the entity's local space
+ *
+ * Inertia is about the entity's origin rather than the center of mass, so parts can be merged
+ * in and taken out again by plain addition and subtraction (parallel axis theorem).
+ */
+struct ACompSubtreeMass
+{
+    Matrix3 m_inertia{0.0f};
+
+    /// Sum of mass times position of each part, divide by m_mass for the center of mass
+    Vector3 m_moment{0.0f};
+
+    float   m_mass{0.0f};
+};
+
 /**
  * @brief Physics components and other data needed to support physics in a scene
  */
@@ -50,9 +66,21 @@ struct ACtxPhysics
     KeyedVec<ActiveEnt, EShape>     m_shape;
     ActiveEntSet_t                  m_hasColliders;
     Storage_t<ActiveEnt, ACompMass> m_mass;
+
+    /// Calculated on demand by SysPhysics::subtree_mass, for entities with colliders only
+    Storage_t<ActiveEnt, ACompSubtreeMass> m_subtreeMass;
+
     Vector3                         m_originTranslate;
+
+    /// Entities given new colliders or mass. The cached subtree masses of these and their
+    /// ancestors are dropped before physics bodies are made from them.
     ActiveEntVec_t                  m_colliderDirty;
 
+    /// Entities of rigid bodies moved by the last physics step, plus bodies added since.
+    /// Sleeping bodies are left out, so systems that only care about motion can skip resting
+    /// bodies entirely. Rewritten by the physics integration every step.
+    ActiveEntSet_t                  m_moved;
+
     std::vector< std::pair<ActiveEnt, Vector3> > m_setVelocity;
 
 }; // struct ACtxPhysics
@@ -25,72 +25,170 @@
 #include "physics_fn.h"
 #include "basic_fn.h"
 
+#include <optional>
+
 using namespace osp;
 using namespace osp::active;
 
-void SysPhysics::calculate_subtree_mass_center(
-        ACompTransformStorage_t const&          rTf,
-        ACtxPhysics&                            rCtxPhys,
-        ACtxSceneGraph&                         rScnGraph,
-        ActiveEnt                               root,
-        Vector3&                                rMassPos,
-        float&                                  rTotalMass,
-        Matrix4 const&                          currentTf)
+namespace
 {
-    for (ActiveEnt const child : SysSceneGraph::children(rScnGraph, root))
+
+/**
+ * @brief Inertia added by moving a point mass away from the axes, by the parallel axis theorem
+ */
+Matrix3 point_mass_inertia(float const mass, Vector3 const pos) noexcept
+{
+    return transform_inertia_tensor(Matrix3{0.0f}, mass, pos, Matrix3{});
+}
+
+/**
+ * @brief Mass properties of a single entity and its (optionally cached) subtree, as seen from
+ *        a space where the entity has transform tf
+ */
+ACompSubtreeMass contribution(
+        ACompMass const*        pMass,
+        ACompSubtreeMass const* pSubtree,
+        Matrix4 const&          tf) noexcept
+{
+    ACompSubtreeMass out;
+    Matrix3 const rotation = tf.rotation();
+
+    if (pMass != nullptr)
     {
-        Matrix4 const childTf = currentTf * rTf.get(child).m_transform;
+        Matrix3 inertiaTensor{0.0f};
+        inertiaTensor[0][0] = pMass->m_inertia.x();
+        inertiaTensor[1][1] = pMass->m_inertia.y();
+        inertiaTensor[2][2] = pMass->m_inertia.z();
 
-        if (rCtxPhys.m_mass.contains(child))
-        {
-            ACompMass const& childMass = rCtxPhys.m_mass.get(child);
+        Vector3 const pos = tf.translation() + pMass->m_offset * tf.scaling();
 
-            Matrix3 inertiaTensor{};
-            inertiaTensor[0][0] = childMass.m_inertia.x();
-            inertiaTensor[1][1] = childMass.m_inertia.y();
-            inertiaTensor[2][2] = childMass.m_inertia.z();
+        out.m_inertia += transform_inertia_tensor(inertiaTensor, pMass->m_mass, pos, rotation);
+        out.m_moment  += pos * pMass->m_mass;
+        out.m_mass    += pMass->m_mass;
+    }
+
+    if (pSubtree != nullptr && pSubtree->m_mass != 0.0f)
+    {
+        Vector3 const center = SysPhysics::subtree_center(*pSubtree);
+        Vector3 const pos    = tf.transformPoint(center);
+
+        out.m_inertia += transform_inertia_tensor(SysPhysics::subtree_inertia_about_center(*pSubtree),
+                                                  pSubtree->m_mass, pos, rotation);
+        out.m_moment  += pos * pSubtree->m_mass;
+        out.m_mass    += pSubtree->m_mass;
+    }
+
+    return out;
+}
+
+void subtree_mass_merge(
+        ACompTransformStorage_t const&  rTf,
+        ACtxPhysics&                    rCtxPhys,
+        ACtxSceneGraph const&           rScnGraph,
+        ActiveEnt const                 ent,
+        float const                     sign)
+{
+    ACompMass const* pMass = rCtxPhys.m_mass.contains(ent) ? &rCtxPhys.m_mass.get(ent) : nullptr;
+
+    std::optional<ACompSubtreeMass> subtree;
+    if (rCtxPhys.m_hasColliders.contains(ent))
+    {
+        subtree = SysPhysics::subtree_mass(rTf, rCtxPhys, rScnGraph, ent);
+    }
+
+    Matrix4   toAncestor = rTf.get(ent).m_transform;
+    ActiveEnt ancestor   = rScnGraph.m_entParent[ent];
+
+    while (ancestor != lgrn::id_null<ActiveEnt>())
+    {
+        if (rCtxPhys.m_subtreeMass.contains(ancestor))
+        {
+            ACompSubtreeMass const add = contribution(pMass, subtree ? &*subtree : nullptr, toAncestor);
+            ACompSubtreeMass &rCached  = rCtxPhys.m_subtreeMass.get(ancestor);
 
-            rTotalMass  += childMass.m_mass;
-            rMassPos    += childTf.translation() * childMass.m_mass;
+            rCached.m_inertia += add.m_inertia * sign;
+            rCached.m_moment  += add.m_moment  * sign;
+            rCached.m_mass    += add.m_mass    * sign;
         }
 
-        if (rCtxPhys.m_hasColliders.contains(child))
+        // subtree_mass only recurses through entities with colliders
+        if ( ! rCtxPhys.m_hasColliders.contains(ancestor) )
         {
-            calculate_subtree_mass_center(rTf, rCtxPhys, rScnGraph, child, rMassPos, rTotalMass, childTf);
+            break;
         }
+
+        toAncestor = rTf.get(ancestor).m_transform * toAncestor;
+        ancestor   = rScnGraph.m_entParent[ancestor];
     }
 }
 
+} // namespace
 
-void SysPhysics::calculate_subtree_mass_inertia(
+ACompSubtreeMass const& SysPhysics::subtree_mass(
         ACompTransformStorage_t const&          rTf,
         ACtxPhysics&                            rCtxPhys,
-        ACtxSceneGraph&                         rScnGraph,
-        ActiveEnt                               root,
-        Matrix3&                                rInertiaTensor,
-        Matrix4 const&                          currentTf)
+        ACtxSceneGraph const&                   rScnGraph,
+        ActiveEnt                               root)
 {
+    if (rCtxPhys.m_subtreeMass.contains(root))
+    {
+        return rCtxPhys.m_subtreeMass.get(root);
+    }
+
+    ACompSubtreeMass out;
+
     for (ActiveEnt const child : SysSceneGraph::children(rScnGraph, root))
     {
-        Matrix4 const childTf = currentTf * rTf.get(child).m_transform;
+        ACompMass const* pMass = rCtxPhys.m_mass.contains(child) ? &rCtxPhys.m_mass.get(child) : nullptr;
 
-        if (rCtxPhys.m_mass.contains(child))
+        // Copied, as caching the child's subtree may move other cached values
+        std::optional<ACompSubtreeMass> childSubtree;
+        if (rCtxPhys.m_hasColliders.contains(child))
         {
-            ACompMass const& childMass = rCtxPhys.m_mass.get(child);
+            childSubtree = subtree_mass(rTf, rCtxPhys, rScnGraph, child);
+        }
 
-            Matrix3 inertiaTensor{};
-            inertiaTensor[0][0] = childMass.m_inertia.x();
-            inertiaTensor[1][1] = childMass.m_inertia.y();
-            inertiaTensor[2][2] = childMass.m_inertia.z();
+        ACompSubtreeMass const add = contribution(pMass, childSubtree ? &*childSubtree : nullptr,
+                                                  rTf.get(child).m_transform);
+        out.m_inertia += add.m_inertia;
+        out.m_moment  += add.m_moment;
+        out.m_mass    += add.m_mass;
+    }
 
-            Vector3 const offset = childTf.translation() + childMass.m_offset * childTf.scaling();
+    return rCtxPhys.m_subtreeMass.emplace(root, out);
+}
 
-            rInertiaTensor += transform_inertia_tensor(inertiaTensor, childMass.m_mass, offset, childTf.rotation());
-        }
+void SysPhysics::subtree_mass_add(
+        ACompTransformStorage_t const&          rTf,
+        ACtxPhysics&                            rCtxPhys,
+        ACtxSceneGraph const&                   rScnGraph,
+        ActiveEnt                               ent)
+{
+    subtree_mass_merge(rTf, rCtxPhys, rScnGraph, ent, 1.0f);
+}
 
-        if (rCtxPhys.m_hasColliders.contains(child))
-        {
-            calculate_subtree_mass_inertia(rTf, rCtxPhys, rScnGraph, child, rInertiaTensor, childTf);
-        }
+void SysPhysics::subtree_mass_remove(
+        ACompTransformStorage_t const&          rTf,
+        ACtxPhysics&                            rCtxPhys,
+        ACtxSceneGraph const&                   rScnGraph,
+        ActiveEnt                               ent)
+{
+    subtree_mass_merge(rTf, rCtxPhys, rScnGraph, ent, -1.0f);
+}
+
+void SysPhysics::subtree_mass_invalidate(
+        ACtxPhysics&                            rCtxPhys,
+        ACtxSceneGraph const&                   rScnGraph,
+        ActiveEnt                               ent)
+{
+    while (ent != lgrn::id_null<ActiveEnt>())
+    {
+        rCtxPhys.m_subtreeMass.remove(ent);
+        ent = rScnGraph.m_entParent[ent];
     }
 }
+
+Matrix3 SysPhysics::subtree_inertia_about_center(ACompSubtreeMass const& subtree) noexcept
+{
+    return subtree.m_inertia - point_mass_inertia(subtree.m_mass, subtree_center(subtree));
+}
@@ -36,22 +36,57 @@ class SysPhysics
 {
 public:
 
-    static void calculate_subtree_mass_center(
+    /**
+     * @brief Get the mass properties of root's descendants, calculating them if not cached
+     *
+     * Descendants are only recursed into if they have colliders, and each of these caches its
+     * own subtree too. After a part changes, only its ancestors need to be recalculated.
+     */
+    static ACompSubtreeMass const& subtree_mass(
             ACompTransformStorage_t const&          rTf,
             ACtxPhysics&                            rCtxPhys,
-            ACtxSceneGraph&                         rScnGraph,
-            ActiveEnt                               root,
-            Vector3&                                rMassPos,
-            float&                                  rTotalMass,
-            Matrix4 const&                          currentTf = {});
+            ACtxSceneGraph const&                   rScnGraph,
+            ActiveEnt                               root);
 
-    static void calculate_subtree_mass_inertia(
+    /**
+     * @brief Merge ent's mass and subtree into the cached subtree masses of its ancestors
+     *
+     * Call after ent is given an ACompMass or is attached to a cached subtree.
+     */
+    static void subtree_mass_add(
             ACompTransformStorage_t const&          rTf,
             ACtxPhysics&                            rCtxPhys,
-            ACtxSceneGraph&                         rScnGraph,
-            ActiveEnt                               root,
-            Matrix3&                                rInertiaTensor,
-            Matrix4 const&                          currentTf = {});
+            ACtxSceneGraph const&                   rScnGraph,
+            ActiveEnt                               ent);
+
+    /**
+     * @brief Take ent's mass and subtree out of the cached subtree masses of its ancestors
+     *
+     * Call before ent's ACompMass is removed or ent is detached or deleted.
+     */
+    static void subtree_mass_remove(
+            ACompTransformStorage_t const&          rTf,
+            ACtxPhysics&                            rCtxPhys,
+            ACtxSceneGraph const&                   rScnGraph,
+            ActiveEnt                               ent);
+
+    /**
+     * @brief Drop the cached subtree masses of ent and its ancestors, eg. after ent moved
+     */
+    static void subtree_mass_invalidate(
+            ACtxPhysics&                            rCtxPhys,
+            ACtxSceneGraph const&                   rScnGraph,
+            ActiveEnt                               ent);
+
+    static Vector3 subtree_center(ACompSubtreeMass const& subtree) noexcept
+    {
+        return (subtree.m_mass != 0.0f) ? (subtree.m_moment / subtree.m_mass) : Vector3{0.0f};
+    }
+
+    /**
+     * @return Inertia tensor of the subtree about its center of mass
+     */
+    static Matrix3 subtree_inertia_about_center(ACompSubtreeMass const& subtree) noexcept;
 
     template<typename IT_T, typename ITB_T>
     static void update_delete_phys(ACtxPhysics& rCtxPhys, IT_T const& first, ITB_T const& last);
@@ -62,6 +97,12 @@ template<typename IT_T, typename ITB_T>
 void SysPhysics::update_delete_phys(ACtxPhysics& rCtxPhys, IT_T const& first, ITB_T const& last)
 {
     rCtxPhys.m_mass.remove(first, last);
+    rCtxPhys.m_subtreeMass.remove(first, last);
+
+    for (auto it = first; it != last; std::advance(it, 1))
+    {
+        rCtxPhys.m_moved.erase(*it);
+    }
 }
 
 
@@ -259,6 +259,7 @@ void SysPrefabInit::init_physics(
             if ( (mass != 0.0f) || (shape != EShape::None) )
             {
                 assign_collider_recurse(assign_collider_recurse, objectId, ent);
+                rCtxPhys.m_colliderDirty.push_back(ent);
             }
         }
 
@@ -27,6 +27,8 @@
 // IWYU pragma: begin_exports
 #include <Magnum/Types.h>
 
+#include <Magnum/Math/Half.h>
+
 #include <Magnum/Math/Matrix.h>
 #include <Magnum/Math/Matrix4.h>
 #include <Magnum/Math/Matrix3.h>
@@ -46,6 +48,8 @@ using Matrix3       = Magnum::Math::Matrix3<Magnum::Float>;
 using Matrix4       = Magnum::Math::Matrix4<Magnum::Float>;
 
 using Vector2i      = Magnum::Math::Vector2<Magnum::Int>;
+using Vector2b      = Magnum::Math::Vector2<Magnum::Byte>;
+using Vector2s      = Magnum::Math::Vector2<Magnum::Short>;
 
 using Vector3u      = Magnum::Math::Vector3<Magnum::UnsignedInt>;
 
@@ -57,6 +61,8 @@ using Vector4       = Magnum::Math::Vector4<Magnum::Float>;
 
 using Vector3d      = Magnum::Math::Vector3<Magnum::Double>;
 
+using Vector3h      = Magnum::Math::Vector3<Magnum::Math::Half>;
+
 using Quaternion    = Magnum::Math::Quaternion<Magnum::Float>;
 using Quaterniond   = Magnum::Math::Quaternion<Magnum::Double>;
 
@@ -0,0 +1,297 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "culling.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace osp;
+using namespace osp::draw;
+
+namespace
+{
+
+/**
+ * @brief Spread the lower 4 bits of a value to every third bit, for 12-bit Morton codes
+ */
+constexpr std::uint32_t spread_bits4(std::uint32_t v) noexcept
+{
+    v &= 0xF;
+    v = (v | (v << 4)) & 0x0C3;
+    v = (v | (v << 2)) & 0x249;
+    return v;
+}
+
+bool aabb_in_frustum(Vector3 const& min, Vector3 const& max, Frustum const& frustum) noexcept
+{
+    for (Vector4 const& plane : frustum.planes)
+    {
+        // Corner furthest along the plane's normal
+        Vector3 const corner{ plane.x() >= 0.0f ? max.x() : min.x(),
+                              plane.y() >= 0.0f ? max.y() : min.y(),
+                              plane.z() >= 0.0f ? max.z() : min.z() };
+
+        if (Magnum::Math::dot(plane.xyz(), corner) + plane.w() < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+Frustum SysCulling::make_frustum(Matrix4 const& viewProj) noexcept
+{
+    // Gribb-Hartmann plane extraction, for OpenGL clip space (-w <= x, y, z <= w)
+    Vector4 const r0 = viewProj.row(0);
+    Vector4 const r1 = viewProj.row(1);
+    Vector4 const r2 = viewProj.row(2);
+    Vector4 const r3 = viewProj.row(3);
+
+    Frustum out{{ r3 + r0, r3 - r0, r3 + r1, r3 - r1, r3 + r2, r3 - r2 }};
+
+    for (Vector4 &rPlane : out.planes)
+    {
+        rPlane /= rPlane.xyz().length();
+    }
+    return out;
+}
+
+BoundingSphere SysCulling::sphere_around(ArrayView<Vector3 const> points) noexcept
+{
+    if (points.isEmpty())
+    {
+        return {.center = Vector3{0.0f}, .radius = 0.0f};
+    }
+
+    Vector3 min = points.front();
+    Vector3 max = points.front();
+    for (Vector3 const& point : points)
+    {
+        min = Magnum::Math::min(min, point);
+        max = Magnum::Math::max(max, point);
+    }
+
+    Vector3 const center = (min + max) * 0.5f;
+
+    float radiusSqr = 0.0f;
+    for (Vector3 const& point : points)
+    {
+        radiusSqr = std::max(radiusSqr, (point - center).dot());
+    }
+
+    return {.center = center, .radius = std::sqrt(radiusSqr)};
+}
+
+void SysCulling::gather(ACtxCulling& rCull, RenderFrame const& frame, ACtxSceneRender const& scnRender, ACtxDrawing const& drawing)
+{
+    rCull.visible.clear();
+    rCull.visible.resize(scnRender.m_drawIds.capacity());
+
+    rCull.x     .clear();
+    rCull.y     .clear();
+    rCull.z     .clear();
+    rCull.radius.clear();
+    rCull.ents  .clear();
+
+    for (DrawEnt const ent : frame.visible)
+    {
+        MeshIdOwner_t const &mesh = scnRender.m_mesh[ent];
+        if ( ! mesh.has_value() )
+        {
+            rCull.visible.insert(ent);
+            continue;
+        }
+
+        MeshId const meshId = mesh.value();
+        if (   std::size_t(meshId) >= drawing.m_meshBounds.size()
+            || std::isinf(drawing.m_meshBounds[meshId].radius) )
+        {
+            rCull.visible.insert(ent);
+            continue;
+        }
+
+        BoundingSphere const &bounds = drawing.m_meshBounds[meshId];
+        Matrix4 const        &drawTf = frame.drawTransform[ent];
+
+        // Largest axis scale keeps the sphere conservative for non-uniform scaling
+        float const scaleSqr = std::max({drawTf[0].xyz().dot(), drawTf[1].xyz().dot(), drawTf[2].xyz().dot()});
+        Vector3 const center = drawTf.transformPoint(bounds.center);
+
+        rCull.x     .push_back(center.x());
+        rCull.y     .push_back(center.y());
+        rCull.z     .push_back(center.z());
+        rCull.radius.push_back(bounds.radius * std::sqrt(scaleSqr));
+        rCull.ents  .push_back(ent);
+    }
+
+    rCull.count     = rCull.ents.size();
+    rCull.useBlocks = rCull.count > smc_blockSortThreshold;
+
+    if (rCull.useBlocks)
+    {
+        sort_into_blocks(rCull);
+    }
+
+    // Pad to whole blocks. Padding lanes are never output, values don't matter.
+    std::size_t const padded = (rCull.count + smc_lanes - 1) / smc_lanes * smc_lanes;
+    rCull.x     .resize(padded, 0.0f);
+    rCull.y     .resize(padded, 0.0f);
+    rCull.z     .resize(padded, 0.0f);
+    rCull.radius.resize(padded, 0.0f);
+    rCull.ents  .resize(padded, lgrn::id_null<DrawEnt>());
+
+    if (rCull.useBlocks)
+    {
+        std::size_t const blockCount = padded / smc_lanes;
+        rCull.blockMin.resize(blockCount);
+        rCull.blockMax.resize(blockCount);
+
+        for (std::size_t block = 0; block < blockCount; ++block)
+        {
+            Vector3 min{std::numeric_limits<float>::infinity()};
+            Vector3 max{-std::numeric_limits<float>::infinity()};
+
+            std::size_t const first = block * smc_lanes;
+            std::size_t const last  = std::min(first + smc_lanes, rCull.count);
+            for (std::size_t i = first; i < last; ++i)
+            {
+                Vector3 const center{rCull.x[i], rCull.y[i], rCull.z[i]};
+                min = Magnum::Math::min(min, center - Vector3{rCull.radius[i]});
+                max = Magnum::Math::max(max, center + Vector3{rCull.radius[i]});
+            }
+
+            rCull.blockMin[block] = min;
+            rCull.blockMax[block] = max;
+        }
+    }
+}
+
+void SysCulling::sort_into_blocks(ACtxCulling& rCull)
+{
+    // Counting sort by a 12-bit Morton code of each sphere's cell in a 16x16x16 grid spanning
+    // all centers. Nearby spheres end up in the same blocks, and it's O(n) unlike a full BVH
+    // build, so it's fine to redo every frame.
+
+    std::size_t const count = rCull.count;
+
+    Vector3 min{std::numeric_limits<float>::infinity()};
+    Vector3 max{-std::numeric_limits<float>::infinity()};
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        Vector3 const center{rCull.x[i], rCull.y[i], rCull.z[i]};
+        min = Magnum::Math::min(min, center);
+        max = Magnum::Math::max(max, center);
+    }
+
+    Vector3 const toCell = Vector3{15.999f} / Magnum::Math::max(max - min, Vector3{1.0e-6f});
+
+    std::vector<std::uint16_t> codes(count);
+    std::array<std::uint32_t, 4096> offsets{};
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        Vector3 const cell = (Vector3{rCull.x[i], rCull.y[i], rCull.z[i]} - min) * toCell;
+        std::uint32_t const code =   spread_bits4(std::uint32_t(cell.x()))
+                                   | spread_bits4(std::uint32_t(cell.y())) << 1
+                                   | spread_bits4(std::uint32_t(cell.z())) << 2;
+        codes[i] = std::uint16_t(code);
+        ++offsets[code];
+    }
+
+    std::uint32_t offset = 0;
+    for (std::uint32_t &rOffset : offsets)
+    {
+        std::uint32_t const cellCount = rOffset;
+        rOffset = offset;
+        offset += cellCount;
+    }
+
+    std::vector<std::uint32_t> order(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        order[offsets[codes[i]]++] = std::uint32_t(i);
+    }
+
+    auto const reorder = [&order, count] (auto &rVec)
+    {
+        auto sorted = rVec;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            sorted[i] = rVec[order[i]];
+        }
+        rVec = std::move(sorted);
+    };
+
+    reorder(rCull.x);
+    reorder(rCull.y);
+    reorder(rCull.z);
+    reorder(rCull.radius);
+    reorder(rCull.ents);
+}
+
+void SysCulling::cull(ACtxCulling& rCull, Frustum const& frustum)
+{
+    for (std::size_t first = 0; first < rCull.count; first += smc_lanes)
+    {
+        if (   rCull.useBlocks
+            && ! aabb_in_frustum(rCull.blockMin[first / smc_lanes], rCull.blockMax[first / smc_lanes], frustum) )
+        {
+            continue;
+        }
+
+        float const *pX = &rCull.x[first];
+        float const *pY = &rCull.y[first];
+        float const *pZ = &rCull.z[first];
+        float const *pR = &rCull.radius[first];
+
+        // Fixed-size inner loops over plain arrays, which compilers turn into SIMD
+        std::array<std::int32_t, smc_lanes> inside;
+        inside.fill(1);
+
+        for (Vector4 const& plane : frustum.planes)
+        {
+            float const nx = plane.x();
+            float const ny = plane.y();
+            float const nz = plane.z();
+            float const d  = plane.w();
+
+            for (std::size_t lane = 0; lane < smc_lanes; ++lane)
+            {
+                float const dist = nx * pX[lane] + ny * pY[lane] + nz * pZ[lane] + d;
+                inside[lane] &= std::int32_t(dist >= -pR[lane]);
+            }
+        }
+
+        std::size_t const lanes = std::min(smc_lanes, rCull.count - first);
+        for (std::size_t lane = 0; lane < lanes; ++lane)
+        {
+            if (inside[lane] != 0)
+            {
+                rCull.visible.insert(rCull.ents[first + lane]);
+            }
+        }
+    }
+}
@@ -0,0 +1,125 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "drawing.h"
+#include "render_snapshot.h"
+
+#include "../core/array_view.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace osp::draw
+{
+
+/**
+ * @brief Six planes of a view frustum, pointing inwards
+ *
+ * A point p is inside a plane if dot(plane.xyz(), p) + plane.w() >= 0.
+ */
+struct Frustum
+{
+    std::array<Vector4, 6> planes;
+};
+
+/**
+ * @brief Per-view frustum culling state and output
+ *
+ * World-space spheres are stored as structure-of-arrays in blocks of SysCulling::smc_lanes, so
+ * the culling kernel tests a whole block per iteration.
+ */
+struct ACtxCulling
+{
+    std::vector<float>      x;
+    std::vector<float>      y;
+    std::vector<float>      z;
+    std::vector<float>      radius;
+    std::vector<DrawEnt>    ents;
+    std::size_t             count       {0};    ///< Spheres in use, the rest is padding
+
+    /// World-space AABB of each block, only used if blocks are spatially sorted
+    std::vector<Vector3>    blockMin;
+    std::vector<Vector3>    blockMax;
+    bool                    useBlocks   {false};
+
+    /// Output: entities of RenderFrame::visible that are in view
+    DrawEntSet_t            visible;
+};
+
+class SysCulling
+{
+public:
+
+    /// Spheres tested per iteration of the culling kernel
+    static constexpr std::size_t smc_lanes = 8;
+
+    /// Above this many spheres, blocks are spatially sorted so whole blocks can be rejected
+    static constexpr std::size_t smc_blockSortThreshold = 50000;
+
+    /**
+     * @brief Extract frustum planes from a view-projection matrix
+     */
+    static Frustum make_frustum(Matrix4 const& viewProj) noexcept;
+
+    /**
+     * @brief Calculate a sphere around points, such as a mesh's vertex positions
+     */
+    static BoundingSphere sphere_around(ArrayView<Vector3 const> points) noexcept;
+
+    /**
+     * @brief Calculate world-space spheres of visible entities with mesh bounds
+     *
+     * Entities without a mesh or with unknown bounds are added straight to the output.
+     *
+     * @param rCull     [ref] Culling state to refill
+     * @param frame     [in] Visible entities and their draw transforms
+     * @param scnRender [in] Meshes of entities
+     * @param drawing   [in] Mesh bounds
+     */
+    static void gather(ACtxCulling& rCull, RenderFrame const& frame, ACtxSceneRender const& scnRender, ACtxDrawing const& drawing);
+
+    /**
+     * @brief Test gathered spheres against a frustum, adding those in view to ACtxCulling::visible
+     */
+    static void cull(ACtxCulling& rCull, Frustum const& frustum);
+
+    /**
+     * @brief Fill ACtxCulling::visible with entities in view of a camera
+     */
+    static void update(ACtxCulling& rCull, RenderFrame const& frame, ACtxSceneRender const& scnRender, ACtxDrawing const& drawing, Matrix4 const& viewProj)
+    {
+        gather(rCull, frame, scnRender, drawing);
+        cull(rCull, make_frustum(viewProj));
+    }
+
+private:
+
+    static void sort_into_blocks(ACtxCulling& rCull);
+
+}; // class SysCulling
+
+} // namespace osp::draw
@@ -44,16 +44,98 @@
 #include <longeron/id_management/registry_stl.hpp>
 #include <longeron/id_management/id_set_stl.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
 namespace osp::draw
 {
 
 using DrawEntVec_t  = std::vector<DrawEnt>;
 using DrawEntSet_t  = lgrn::IdSetStl<DrawEnt>;
 
+/**
+ * @brief DrawEnts with a changed component, each listed once until cleared
+ *
+ * Each DrawEnt is stamped with the generation it was last marked in. Marking and lookup are O(1),
+ * and clear() only bumps the generation instead of resetting a bit for each DrawEnt.
+ *
+ * Renderers iterate the list to sync only what changed. To resync everything, mark all DrawEnts;
+ * duplicates with other marks are ignored.
+ */
+class DrawEntDirty
+{
+public:
+
+    DrawEntDirty() = default;
+
+    /// Start from a given generation instead of 1, such as to test wrapping around in clear()
+    explicit DrawEntDirty(std::uint32_t const generation)
+     : m_generation{std::max(generation, 1u)}
+    { }
+
+    void mark(DrawEnt const ent)
+    {
+        if (std::size_t(ent) >= m_stamps.size())
+        {
+            m_stamps.resize(std::size_t(ent) + 1, 0u);
+        }
+
+        if (m_stamps[ent] != m_generation)
+        {
+            m_stamps[ent] = m_generation;
+            m_ents.push_back(ent);
+        }
+    }
+
+    template <typename IT_T, typename ITB_T>
+    void mark(IT_T first, ITB_T const& last)
+    {
+        for (; first != last; ++first)
+        {
+            mark(*first);
+        }
+    }
+
+    [[nodiscard]] bool contains(DrawEnt const ent) const noexcept
+    {
+        return std::size_t(ent) < m_stamps.size() && m_stamps[ent] == m_generation;
+    }
+
+    void clear()
+    {
+        m_ents.clear();
+
+        // Stamps from 2^32 clears ago would match again, start over
+        if (++m_generation == 0u)
+        {
+            std::fill(m_stamps.begin(), m_stamps.end(), 0u);
+            m_generation = 1u;
+        }
+    }
+
+    /// Reserve stamps for DrawEnt Ids below size, optional as mark() grows them too
+    void resize(std::size_t const size)
+    {
+        m_stamps.resize(std::max(size, m_stamps.size()), 0u);
+    }
+
+    [[nodiscard]] std::uint32_t generation()  const noexcept { return m_generation; }
+    [[nodiscard]] std::size_t   size()        const noexcept { return m_ents.size(); }
+    [[nodiscard]] bool          empty()       const noexcept { return m_ents.empty(); }
+    [[nodiscard]] auto          begin()       const noexcept { return m_ents.cbegin(); }
+    [[nodiscard]] auto          end()         const noexcept { return m_ents.cend(); }
+
+private:
+    DrawEntVec_t                        m_ents;
+    KeyedVec<DrawEnt, std::uint32_t>    m_stamps;
+    std::uint32_t                       m_generation{1u};
+};
+
 struct Material
 {
     DrawEntSet_t m_ents;
-    DrawEntVec_t m_dirty;
+    DrawEntDirty m_dirty;
 };
 
 /**
@@ -71,6 +153,17 @@ enum class MeshId : uint32_t { };
 enum class TexId : uint32_t { };
 
 
+/**
+ * @brief Sphere enclosing a mesh in its local space, used for culling
+ *
+ * Default-initialized to infinitely large, which is never culled.
+ */
+struct BoundingSphere
+{
+    Vector3     center  {0.0f};
+    float       radius  {std::numeric_limits<float>::infinity()};
+};
+
 using MeshRefCount_t    = lgrn::IdRefCount<MeshId>;
 using MeshIdOwner_t     = MeshRefCount_t::Owner_t;
 
@@ -86,6 +179,9 @@ struct ACtxDrawing
     lgrn::IdRegistryStl<MeshId>             m_meshIds;
     MeshRefCount_t                          m_meshRefCounts;
 
+    /// Local bounds of meshes loaded from resources. Meshes past the end are never culled.
+    KeyedVec<MeshId, BoundingSphere>        m_meshBounds;
+
     // Scene-space Textures
     lgrn::IdRegistryStl<TexId>              m_texIds;
     TexRefCount_t                           m_texRefCounts;
@@ -133,15 +229,25 @@ struct ACtxSceneRender
         m_diffuseTex    .resize(size);
         m_mesh          .resize(size);
 
+        m_colorDirty    .resize(size);
+        m_drawTfDirty   .resize(size);
+        m_diffuseDirty  .resize(size);
+        m_meshDirty     .resize(size);
+
         for (MaterialId matId : m_materialIds)
         {
             m_materials[matId].m_ents.resize(size);
+            m_materials[matId].m_dirty.resize(size);
         }
     }
 
     void resize_active(std::size_t const size)
     {
         m_needDrawTf.resize(size);
+        m_drawTfObserved    .resize(size);
+        m_drawTfUnchanged   .resize(size);
+        m_drawTfValid       .resize(size);
+        m_drawTfMoved       .resize(size);
         m_activeToDraw      .resize(size, lgrn::id_null<DrawEnt>());
         drawTfObserverEnable.resize(size, 0);
     }
@@ -153,18 +259,41 @@ struct ACtxSceneRender
     DrawEntSet_t                            m_visible;
     DrawEntColors_t                         m_color;
 
+    /// DrawEnts with m_color changed this frame, consumed by SysRenderSnapshot::publish
+    DrawEntDirty                            m_colorDirty;
+
     active::ActiveEntSet_t                  m_needDrawTf;
     KeyedVec<active::ActiveEnt, DrawEnt>    m_activeToDraw;
 
     KeyedVec<active::ActiveEnt, uint16_t>   drawTfObserverEnable;
+
+    /// Entities with drawTfObserverEnable set somewhere in their subtree, see
+    /// SysRender::needs_draw_transforms. Their observers may need to run even if they don't move.
+    active::ActiveEntSet_t                  m_drawTfObserved;
+
+    /// Root entities whose subtrees haven't moved since their draw transforms were last
+    /// calculated, e.g. sleeping physics bodies. Skipped by SysRender::update_draw_transforms.
+    active::ActiveEntSet_t                  m_drawTfUnchanged;
+
+    /// Root entities with draw transforms calculated by this renderer at least once; only
+    /// these can be added to m_drawTfUnchanged
+    active::ActiveEntSet_t                  m_drawTfValid;
+
+    /// Root entities moved since draw transforms were last calculated. Physics may step several
+    /// times per frame, so this accumulates until the renderer consumes and clears it.
+    active::ActiveEntSet_t                  m_drawTfMoved;
     DrawTransforms_t                        m_drawTransform;
 
+    /// DrawEnts with m_drawTransform changed this frame, consumed by SysRenderSnapshot::publish.
+    /// Anything that writes m_drawTransform must add to this.
+    DrawEntDirty                            m_drawTfDirty;
+
     // Meshes and textures assigned to DrawEnts
     KeyedVec<DrawEnt, TexIdOwner_t>         m_diffuseTex;
-    DrawEntVec_t                            m_diffuseDirty;
+    DrawEntDirty                            m_diffuseDirty;
 
     KeyedVec<DrawEnt, MeshIdOwner_t>        m_mesh;
-    DrawEntVec_t                            m_meshDirty;
+    DrawEntDirty                            m_meshDirty;
 
     lgrn::IdRegistryStl<MaterialId>         m_materialIds;
     KeyedVec<MaterialId, Material>          m_materials;
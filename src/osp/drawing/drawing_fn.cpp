@@ -23,10 +23,13 @@
  * SOFTWARE.
  */
 #include "drawing_fn.h"
+#include "culling.h"
 #include "own_restypes.h"
 
 #include "../core/Resources.h"
 
+#include <Magnum/Trade/MeshData.h>
+
 using namespace osp;
 using namespace osp::active;
 using namespace osp::draw;
@@ -40,6 +43,19 @@ MeshId SysRender::own_mesh_resource(ACtxDrawing& rCtxDrawing, ACtxDrawingRes& rC
         MeshId const meshId = rCtxDrawing.m_meshIds.create();
         rCtxDrawingRes.m_meshToRes.emplace(meshId, std::move(owner));
         it->second = meshId;
+
+        // Record bounds for culling, if the mesh is loaded
+        rCtxDrawing.m_meshBounds.resize(rCtxDrawing.m_meshIds.capacity());
+        auto const *pMeshData = rResources.data_try_get<Magnum::Trade::MeshData>(restypes::gc_mesh, resId);
+        if (pMeshData != nullptr && pMeshData->hasAttribute(Magnum::Trade::MeshAttribute::Position))
+        {
+            auto const positions = pMeshData->positions3DAsArray();
+            rCtxDrawing.m_meshBounds[meshId] = SysCulling::sphere_around(positions);
+        }
+        else
+        {
+            rCtxDrawing.m_meshBounds[meshId] = {};
+        }
         return meshId;
     }
     return it->second;
@@ -78,6 +94,23 @@ void SysRender::clear_owners(ACtxSceneRender& rCtxScnRdr, ACtxDrawing& rCtxDrawi
     }
 }
 
+void SysRender::mark_all_dirty(ACtxSceneRender& rCtxScnRdr)
+{
+    for (DrawEnt const drawEnt : rCtxScnRdr.m_drawIds)
+    {
+        rCtxScnRdr.m_drawTfDirty .mark(drawEnt);
+        rCtxScnRdr.m_colorDirty  .mark(drawEnt);
+        rCtxScnRdr.m_diffuseDirty.mark(drawEnt);
+        rCtxScnRdr.m_meshDirty   .mark(drawEnt);
+    }
+
+    for (MaterialId const matId : rCtxScnRdr.m_materialIds)
+    {
+        Material &rMat = rCtxScnRdr.m_materials[matId];
+        rMat.m_dirty.mark(rMat.m_ents.begin(), rMat.m_ents.end());
+    }
+}
+
 void SysRender::clear_resource_owners(ACtxDrawingRes& rCtxDrawingRes, Resources &rResources)
 {
     for ([[maybe_unused]] auto && [_, rOwner] : std::exchange(rCtxDrawingRes.m_texToRes, {}))
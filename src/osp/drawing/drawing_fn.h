@@ -29,6 +29,12 @@
 #include "../activescene/basic.h"
 #include "../activescene/basic_fn.h"
 
+#include "../core/array_view.h"
+
+#include <Corrade/Containers/EnumSet.h>
+
+#include <vector>
+
 namespace osp::draw
 {
 
@@ -78,6 +84,28 @@ struct ViewProjMatrix
     Matrix4 m_proj;
 };
 
+/**
+ * @brief Render state that differs from the previously drawn entity
+ *
+ * Set by the RenderQueue so draw functions can skip redundant uniform, texture, and mesh binds.
+ * A change of shader sets all other flags too.
+ */
+enum class RenderStateChange : std::uint8_t
+{
+    Shader      = 1 << 0,
+    Material    = 1 << 1,
+    Texture     = 1 << 2,
+    Mesh        = 1 << 3
+};
+
+using RenderStateChanges = Corrade::Containers::EnumSet<RenderStateChange>;
+CORRADE_ENUMSET_OPERATORS(RenderStateChanges)
+
+inline constexpr RenderStateChanges gc_renderStateAll
+        = RenderStateChange::Shader | RenderStateChange::Material | RenderStateChange::Texture | RenderStateChange::Mesh;
+
+struct InstanceData;
+
 /**
  * @brief Stores a draw function and user data needed to draw a single entity
  */
@@ -88,18 +116,48 @@ struct EntityToDraw
     /**
      * @brief A function pointer to a Shader's draw() function
      *
-     * @param ActiveEnt         [in] The entity being drawn
-     * @param ViewProjMatrix    [in] View and projection matrix
-     * @param UserData_t        [in] Non-owning user data
+     * @param ActiveEnt             [in] The entity being drawn
+     * @param ViewProjMatrix        [in] View and projection matrix
+     * @param UserData_t            [in] Non-owning user data
+     * @param RenderStateChanges    [in] State that changed since the previous draw
      */
     using ShaderDrawFnc_t = void (*)(
-            DrawEnt, ViewProjMatrix const&, UserData_t) noexcept;
+            DrawEnt, ViewProjMatrix const&, UserData_t, RenderStateChanges) noexcept;
+
+    /**
+     * @brief A function pointer to a Shader's instanced draw() function
+     *
+     * @param DrawEnt               [in] First entity of the batch, all share mesh and texture
+     * @param ArrayView             [in] Per-instance transforms and colors of the batch
+     * @param ViewProjMatrix        [in] View and projection matrix
+     * @param UserData_t            [in] Non-owning user data
+     * @param RenderStateChanges    [in] State that changed since the previous draw
+     */
+    using ShaderDrawInstancedFnc_t = void (*)(
+            DrawEnt, ArrayView<InstanceData const>, ViewProjMatrix const&, UserData_t, RenderStateChanges) noexcept;
+
+    /**
+     * @brief A function pointer to a Shader's prepare() function, called once per frame
+     *        before any of its entities are drawn
+     *
+     * @param ArrayView             [in] Entities that will be passed to draw(), in draw order
+     * @param ViewProjMatrix        [in] View and projection matrix
+     * @param UserData_t            [in] Non-owning user data
+     */
+    using ShaderPrepareFnc_t = void (*)(
+            ArrayView<DrawEnt const>, ViewProjMatrix const&, UserData_t) noexcept;
 
     ShaderDrawFnc_t draw;
 
     // Non-owning user data passed to draw function, such as the shader
     UserData_t data;
 
+    /// Optional, draws batches of entities sharing a mesh, texture, and material in one call
+    ShaderDrawInstancedFnc_t drawInstanced{nullptr};
+
+    /// Optional, uploads per-frame and per-draw data such as uniform buffers ahead of draw()
+    ShaderPrepareFnc_t prepare{nullptr};
+
 }; // struct EntityToDraw
 
 /**
@@ -154,6 +212,14 @@ public:
      */
     static void clear_owners(ACtxSceneRender& rCtxScnRdr, ACtxDrawing& rCtxDrawing);
 
+    /**
+     * @brief Mark every component of every DrawEnt as dirty, used when a renderer resyncs
+     *
+     * Renderers then pick everything up through the same dirty lists they consume each frame,
+     * instead of rescanning all DrawEnts themselves.
+     */
+    static void mark_all_dirty(ACtxSceneRender& rCtxScnRdr);
+
     /**
      * @brief Dissociate resources from the scene's meshes and textures
      *
@@ -176,8 +242,28 @@ public:
         KeyedVec<active::ActiveEnt, DrawEnt> const& activeToDraw;
         active::ActiveEntSet_t const&               needDrawTf;
         DrawTransforms_t&                           rDrawTf;
+
+        /// Optional root entities to skip, see ACtxSceneRender::m_drawTfUnchanged
+        active::ActiveEntSet_t const*               pUnchanged{nullptr};
+
+        /// Optional, DrawEnts with calculated transforms are added to this, see
+        /// ACtxSceneRender::m_drawTfDirty
+        DrawEntDirty*                               pDirty{nullptr};
     };
 
+    /**
+     * @brief Calculate draw transforms of entities that need them, within subtrees of the given roots
+     *
+     * Scans each root's subtree linearly in ACtxSceneGraph's depth-first order, keeping a small
+     * stack of parent matrices instead of recursing. Subtrees that don't need draw transforms are
+     * skipped over as a whole. Keep transforms sorted with SysSceneGraph::sort_by_tree so reads
+     * are in memory order too.
+     *
+     * Subtrees of different roots are independent, so a range of roots can be split between
+     * threads as long as func is safe to call concurrently.
+     *
+     * @param func  Called as func(drawTf, ent, depth) for each entity; depth is 1 for roots
+     */
     template<typename IT_T, typename ITB_T, typename FUNC_T = UpdDrawTransformNoOp>
     static void update_draw_transforms(
             ArgsForUpdDrawTransform     args,
@@ -193,16 +279,6 @@ public:
 
     static constexpr decltype(auto) gen_drawable_mesh_adder(ACtxDrawing& rDrawing, ACtxDrawingRes& rDrawingRes, Resources& rResources, PkgId const pkg);
 
-private:
-
-    template<typename FUNC_T>
-    static void update_draw_transforms_recurse(
-            ArgsForUpdDrawTransform     args,
-            active::ActiveEnt           ent,
-            Matrix4 const&              parentTf,
-            int                         depth,
-            FUNC_T&                     func);
-
 }; // class SysRender
 
 void SysRender::needs_draw_transforms(
@@ -228,47 +304,75 @@ void SysRender::update_draw_transforms(
         ITB_T const&                last,
         FUNC_T                      func)
 {
-    static constexpr Matrix4 const identity{};
+    using namespace osp::active;
 
-    while (first != last)
+    struct Parent
     {
-        active::ActiveEnt const ent = *first;
+        TreePos_t   end;    ///< One past the parent's last descendant
+        Matrix4     drawTf;
+    };
 
-        if (args.needDrawTf.contains(ent))
-        {
-            update_draw_transforms_recurse(args, ent, identity, true, func);
-        }
+    ACtxSceneGraph const &scnGraph = args.scnGraph;
 
-        std::advance(first, 1);
-    }
-}
+    // Deep vehicle hierarchies rarely go past a few dozen levels
+    std::vector<Parent> parents;
+    parents.reserve(32);
 
-template<typename FUNC_T>
-void SysRender::update_draw_transforms_recurse(
-        ArgsForUpdDrawTransform     args,
-        active::ActiveEnt           ent,
-        Matrix4 const&              parentTf,
-        int                         depth,
-        FUNC_T&                     func)
-{
-    using namespace osp::active;
+    while (first != last)
+    {
+        ActiveEnt const root = *first;
+        std::advance(first, 1);
 
-    Matrix4 const& entTf        = args.transforms.get(ent).m_transform;
-    Matrix4 const& entDrawTf    = (depth == 0) ? (entTf) : (parentTf * entTf);
+        if (   ! args.needDrawTf.contains(root)
+            || (args.pUnchanged != nullptr && args.pUnchanged->contains(root)) )
+        {
+            continue;
+        }
 
-    func(entDrawTf, ent, depth);
+        TreePos_t const rootPos = scnGraph.m_entToTreePos[root];
+        TreePos_t const rootEnd = rootPos + 1 + scnGraph.m_treeDescendants[rootPos];
 
-    DrawEnt const drawEnt = args.activeToDraw[ent];
-    if (drawEnt != lgrn::id_null<DrawEnt>())
-    {
-        args.rDrawTf[drawEnt] = entDrawTf;
-    }
+        parents.clear();
 
-    for (ActiveEnt entChild : SysSceneGraph::children(args.scnGraph, ent))
-    {
-        if (args.needDrawTf.contains(entChild))
+        TreePos_t pos = rootPos;
+        while (pos != rootEnd)
         {
-            update_draw_transforms_recurse(args, entChild, entDrawTf, depth + 1, func);
+            ActiveEnt const ent         = scnGraph.m_treeToEnt[pos];
+            TreePos_t const descendants = scnGraph.m_treeDescendants[pos];
+
+            while ( ! parents.empty() && parents.back().end <= pos )
+            {
+                parents.pop_back();
+            }
+
+            if ( ! args.needDrawTf.contains(ent) )
+            {
+                pos += 1 + descendants; // Skip whole subtree
+                continue;
+            }
+
+            Matrix4 const& entTf     = args.transforms.get(ent).m_transform;
+            Matrix4 const  entDrawTf = parents.empty() ? entTf : (parents.back().drawTf * entTf);
+
+            func(entDrawTf, ent, int(parents.size()) + 1);
+
+            DrawEnt const drawEnt = args.activeToDraw[ent];
+            if (drawEnt != lgrn::id_null<DrawEnt>())
+            {
+                args.rDrawTf[drawEnt] = entDrawTf;
+
+                if (args.pDirty != nullptr)
+                {
+                    args.pDirty->mark(drawEnt);
+                }
+            }
+
+            if (descendants != 0)
+            {
+                parents.push_back({pos + 1 + descendants, entDrawTf});
+            }
+
+            ++pos;
         }
     }
 }
@@ -0,0 +1,151 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "instancing.h"
+
+#include <Corrade/Containers/ArrayViewStl.h>
+
+using namespace osp;
+using namespace osp::draw;
+
+void SysInstancing::build(
+        DrawBatches&                rOut,
+        RenderQueue const&          queue,
+        DrawTransforms_t const&     drawTf,
+        DrawEntColors_t const*      pColors,
+        std::uint32_t               minInstances)
+{
+    rOut.clear();
+    rOut.shaderEnts.resize(queue.shaders.size());
+
+    auto const      count   = std::uint32_t(queue.items.size());
+    bool            prevInstanced = false;
+    std::uint32_t   runFirst = 0;
+
+    while (runFirst != count)
+    {
+        RenderQueueEnt const &first = queue.ents[queue.items[runFirst].index];
+
+        // Find end of run of equal render state. Commands are in the same order as items.
+        std::uint32_t runLast = runFirst + 1;
+        while (   runLast != count
+               && queue.ents[queue.items[runLast].index].shader == first.shader
+               && queue.ents[queue.items[runLast].index].parts  == first.parts)
+        {
+            ++runLast;
+        }
+
+        std::uint32_t const runSize   = runLast - runFirst;
+        bool const          instanced =    runSize >= minInstances
+                                        && queue.shaders[first.shader].drawInstanced != nullptr;
+
+        RenderStateChanges changed = queue.commands[runFirst].changed;
+        if (instanced != prevInstanced && runFirst != 0)
+        {
+            changed = gc_renderStateAll;
+        }
+
+        if (instanced)
+        {
+            rOut.batches.push_back({
+                .cmdFirst  = runFirst,
+                .count     = runSize,
+                .instFirst = std::uint32_t(rOut.instances.size()),
+                .changed   = changed });
+
+            for (std::uint32_t i = runFirst; i != runLast; ++i)
+            {
+                DrawEnt const  ent = queue.commands[i].ent;
+                Matrix4 const& tf  = drawTf[ent];
+                rOut.instances.push_back({
+                    .transform = tf,
+                    .normal    = tf.normalMatrix(),
+                    .color     = (pColors != nullptr) ? (*pColors)[ent] : Magnum::Color4{1.0f} });
+            }
+        }
+        else
+        {
+            if ( ! rOut.batches.empty() && ! rOut.batches.back().instanced() )
+            {
+                // Extend previous non-instanced batch, commands already know their own state changes
+                rOut.batches.back().count += runSize;
+            }
+            else
+            {
+                rOut.batches.push_back({
+                    .cmdFirst  = runFirst,
+                    .count     = runSize,
+                    .changed   = changed });
+            }
+
+            std::vector<DrawEnt> &rEnts = rOut.shaderEnts[first.shader];
+            for (std::uint32_t i = runFirst; i != runLast; ++i)
+            {
+                rEnts.push_back(queue.commands[i].ent);
+            }
+        }
+
+        prevInstanced = instanced;
+        runFirst      = runLast;
+    }
+}
+
+void SysInstancing::draw(
+        RenderQueue const&          queue,
+        DrawBatches const&          batches,
+        ViewProjMatrix const&       viewProj)
+{
+    // Shaders upload per-frame data once, before any of their draws
+    for (std::size_t i = 0; i < batches.shaderEnts.size(); ++i)
+    {
+        EntityToDraw const          &toDraw = queue.shaders[i];
+        std::vector<DrawEnt> const  &ents   = batches.shaderEnts[i];
+
+        if (toDraw.prepare != nullptr && ! ents.empty())
+        {
+            toDraw.prepare(arrayView(ents), viewProj, toDraw.data);
+        }
+    }
+
+    for (DrawBatch const& batch : batches.batches)
+    {
+        RenderCmd const     &first  = queue.commands[batch.cmdFirst];
+        EntityToDraw const  &toDraw = queue.shaders[first.shader];
+
+        if (batch.instanced())
+        {
+            auto const instances = arrayView(batches.instances).sliceSize(batch.instFirst, batch.count);
+            toDraw.drawInstanced(first.ent, instances, viewProj, toDraw.data, batch.changed);
+            continue;
+        }
+
+        toDraw.draw(first.ent, viewProj, toDraw.data, batch.changed);
+
+        for (RenderCmd const& cmd : arrayView(queue.commands).sliceSize(batch.cmdFirst + 1, batch.count - 1))
+        {
+            EntityToDraw const &cmdToDraw = queue.shaders[cmd.shader];
+            cmdToDraw.draw(cmd.ent, viewProj, cmdToDraw.data, cmd.changed);
+        }
+    }
+}
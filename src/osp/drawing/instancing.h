@@ -0,0 +1,141 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "render_queue.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace osp::draw
+{
+
+/**
+ * @brief Per-instance attributes of an instanced draw
+ *
+ * Layout matches Magnum's generic TransformationMatrix, NormalMatrix, and Color4 shader
+ * attributes, so a single buffer works with both Phong and Flat shaders.
+ */
+struct InstanceData
+{
+    Matrix4             transform;
+    Matrix3             normal;
+    Magnum::Color4      color;
+};
+
+static_assert(sizeof(InstanceData) == (16 + 9 + 4) * sizeof(float), "InstanceData must be tightly packed");
+
+/**
+ * @brief A range of RenderQueue commands, drawn either one at a time or as one instanced draw
+ */
+struct DrawBatch
+{
+    static constexpr std::uint32_t smc_notInstanced = std::numeric_limits<std::uint32_t>::max();
+
+    std::uint32_t       cmdFirst;   ///< Index of first command in RenderQueue::commands
+    std::uint32_t       count;
+
+    /// Index of first instance in DrawBatches::instances, or smc_notInstanced
+    std::uint32_t       instFirst   {smc_notInstanced};
+
+    /// State changes for the first draw of the batch. Switching between instanced and
+    /// non-instanced drawing changes shader program, so this may differ from the command's.
+    RenderStateChanges  changed;
+
+    constexpr bool instanced() const noexcept
+    {
+        return instFirst != smc_notInstanced;
+    }
+};
+
+/**
+ * @brief Draw batches of a RenderQueue, rebuilt every frame
+ */
+struct DrawBatches
+{
+    std::vector<DrawBatch>      batches;
+    std::vector<InstanceData>   instances;
+
+    /// Entities drawn without instancing for each of RenderQueue::shaders, in draw order.
+    /// Passed to EntityToDraw::prepare.
+    std::vector< std::vector<DrawEnt> > shaderEnts;
+
+    void clear() noexcept
+    {
+        batches  .clear();
+        instances.clear();
+
+        // Keep the inner vectors' capacity around for the next frame
+        for (std::vector<DrawEnt> &rEnts : shaderEnts)
+        {
+            rEnts.clear();
+        }
+    }
+};
+
+class SysInstancing
+{
+public:
+
+    /**
+     * @brief Split a sorted RenderQueue into batches, packing runs of entities with equal shader,
+     *        material, texture, and mesh into instances
+     *
+     * Runs are only instanced if their shader has EntityToDraw::drawInstanced, and they have at
+     * least minInstances entities. Other commands are merged into non-instanced batches, and
+     * their entities are listed per shader in DrawBatches::shaderEnts.
+     *
+     * @param rOut          [out] Batches to rebuild
+     * @param queue         [in] RenderQueue after SysRenderQueue::build
+     * @param drawTf        [in] Draw transforms of entities
+     * @param pColors       [in] Optional colors of entities, white if nullptr
+     * @param minInstances  [in] Smallest run to draw instanced
+     */
+    static void build(
+            DrawBatches&                rOut,
+            RenderQueue const&          queue,
+            DrawTransforms_t const&     drawTf,
+            DrawEntColors_t const*      pColors,
+            std::uint32_t               minInstances);
+
+    /**
+     * @brief Call draw functions of each batch in order
+     *
+     * Each shader's EntityToDraw::prepare is called first with its non-instanced entities. This
+     * only dispatches to the shaders, so it's shared by all render backends.
+     *
+     * @param queue     [in] RenderQueue after SysRenderQueue::build
+     * @param batches   [in] Batches of the RenderQueue
+     * @param viewProj  [in] View and projection matrix
+     */
+    static void draw(
+            RenderQueue const&          queue,
+            DrawBatches const&          batches,
+            ViewProjMatrix const&       viewProj);
+
+}; // class SysInstancing
+
+} // namespace osp::draw
@@ -0,0 +1,112 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "mesh_lod.h"
+#include "mesh_simplify.h"
+#include "own_restypes.h"
+
+#include "../core/Resources.h"
+
+#include <Magnum/Trade/MeshData.h>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace osp;
+using namespace osp::draw;
+
+using Magnum::Trade::MeshData;
+
+std::size_t SysMeshLod::create_lods(Resources& rResources, ResId const meshRes, PkgId const pkg)
+{
+    std::vector<MeshData> simplifiedLevels;
+
+    {
+        // Reference is invalidated by adding new mesh data below
+        auto const &mesh = rResources.data_get<MeshData>(restypes::gc_mesh, meshRes);
+
+        std::size_t const originalTris = mesh.isIndexed() ? mesh.indexCount() / 3 : mesh.vertexCount() / 3;
+        if (originalTris < smc_minTriangles)
+        {
+            return 0;
+        }
+
+        std::size_t prevTris = originalTris;
+
+        for (float const ratio : smc_ratios)
+        {
+            // Simplify from the original each time, errors don't accumulate across levels
+            auto simplified = SysMeshSimplify::simplify_mesh(mesh, ratio, smc_targetError);
+            if ( ! simplified )
+            {
+                break;
+            }
+
+            // Stop if the error limit or locked seams prevent removing at least a quarter of the
+            // previous level's triangles
+            std::size_t const tris = simplified->indexCount() / 3;
+            if (tris * 4 > prevTris * 3)
+            {
+                break;
+            }
+            prevTris = tris;
+
+            simplifiedLevels.push_back(std::move(*simplified));
+        }
+    }
+
+    if (simplifiedLevels.empty())
+    {
+        return 0;
+    }
+
+    MeshLods lods;
+    for (std::size_t i = 0; i < simplifiedLevels.size(); ++i)
+    {
+        ResId const lodRes = rResources.create(restypes::gc_mesh, pkg,
+                SharedString::create_from_parts(rResources.name(restypes::gc_mesh, meshRes), ":lod", std::to_string(i + 1)));
+        rResources.data_add<MeshData>(restypes::gc_mesh, lodRes, std::move(simplifiedLevels[i]));
+
+        lods.levels       .push_back(rResources.owner_create(restypes::gc_mesh, lodRes));
+        lods.maxScreenSize.push_back(smc_maxScreenSize[i]);
+    }
+
+    rResources.data_add<MeshLods>(restypes::gc_mesh, meshRes, std::move(lods));
+    return simplifiedLevels.size();
+}
+
+float SysMeshLod::projected_size(Vector3 const center, float const radius, Matrix4 const& view, Matrix4 const& proj) noexcept
+{
+    // Camera looks down -Z
+    float const distance = -view.transformPoint(center).z();
+    if (distance <= radius)
+    {
+        return std::numeric_limits<float>::max();
+    }
+
+    // proj[1][1] is cot(fovY/2), turning view-space size at a distance into NDC, which is 2 units
+    // high. Diameter over 2 cancels out to the radius.
+    return radius * proj[1][1] / distance;
+}
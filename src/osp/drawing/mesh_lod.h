@@ -0,0 +1,94 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "../core/array_view.h"
+#include "../core/math_types.h"
+#include "../core/resourcetypes.h"
+
+#include <array>
+#include <cstddef>
+
+namespace osp { class Resources; }
+
+namespace osp::draw
+{
+
+/**
+ * @brief Generation and selection of mesh levels of detail (LODs)
+ */
+class SysMeshLod
+{
+public:
+
+    /// Fraction of the original triangles kept by each level
+    static constexpr std::array<float, 3> smc_ratios        {0.5f, 0.25f, 0.125f};
+
+    /// Default MeshLods::maxScreenSize of each level
+    static constexpr std::array<float, 3> smc_maxScreenSize {0.25f, 0.1f, 0.04f};
+
+    /// Largest allowed simplification error, relative to mesh size
+    static constexpr float smc_targetError = 0.02f;
+
+    /// Meshes with fewer triangles aren't simplified
+    static constexpr std::size_t smc_minTriangles = 64;
+
+    /**
+     * @brief Simplify a mesh resource and add the results as new mesh resources listed in
+     *        MeshLods data of the original
+     *
+     * Levels stop once simplification can't remove a meaningful number of triangles. Nothing is
+     * added if no level could be made. MeshLods must be registered to restypes::gc_mesh.
+     *
+     * @return Number of levels added
+     */
+    static std::size_t create_lods(Resources& rResources, ResId meshRes, PkgId pkg);
+
+    /**
+     * @brief Fraction of the screen's height covered by a sphere
+     *
+     * @return Size of the sphere's projected diameter, or a large value if the camera is inside
+     */
+    [[nodiscard]] static float projected_size(Vector3 center, float radius, Matrix4 const& view, Matrix4 const& proj) noexcept;
+
+    /**
+     * @brief Select a level of detail by projected size
+     *
+     * @param maxScreenSize [in] See MeshLods::maxScreenSize
+     *
+     * @return 0 for the original mesh, or 1 + index into MeshLods::levels
+     */
+    [[nodiscard]] static std::size_t select_level(ArrayView<float const> maxScreenSize, float size) noexcept
+    {
+        std::size_t level = 0;
+        while (level < maxScreenSize.size() && size < maxScreenSize[level])
+        {
+            ++level;
+        }
+        return level;
+    }
+};
+
+} // namespace osp::draw
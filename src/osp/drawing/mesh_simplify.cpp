@@ -0,0 +1,419 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "mesh_simplify.h"
+
+#include <Magnum/Math/Functions.h>
+#include <Magnum/MeshTools/Interleave.h>
+
+#include <Corrade/Containers/Array.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <numeric>
+
+using namespace osp;
+using namespace osp::draw;
+
+using Corrade::Containers::Array;
+using Corrade::Containers::Optional;
+using Magnum::Trade::MeshAttributeData;
+using Magnum::Trade::MeshData;
+using Magnum::Trade::MeshIndexData;
+
+namespace
+{
+
+/**
+ * @brief Symmetric 4x4 matrix summing squared distances to weighted planes
+ */
+struct Quadric
+{
+    double a2{0}, ab{0}, ac{0}, ad{0};
+    double        b2{0}, bc{0}, bd{0};
+    double               c2{0}, cd{0};
+    double                      d2{0};
+    double weight{0};
+
+    static Quadric from_plane(Vector3d n, double d, double w) noexcept
+    {
+        return { w * n.x() * n.x(), w * n.x() * n.y(), w * n.x() * n.z(), w * n.x() * d,
+                                    w * n.y() * n.y(), w * n.y() * n.z(), w * n.y() * d,
+                                                       w * n.z() * n.z(), w * n.z() * d,
+                                                                          w * d * d,
+                 w };
+    }
+
+    Quadric& operator+=(Quadric const& rhs) noexcept
+    {
+        a2 += rhs.a2; ab += rhs.ab; ac += rhs.ac; ad += rhs.ad;
+                      b2 += rhs.b2; bc += rhs.bc; bd += rhs.bd;
+                                    c2 += rhs.c2; cd += rhs.cd;
+                                                  d2 += rhs.d2;
+        weight += rhs.weight;
+        return *this;
+    }
+
+    /// Weighted average of squared distances from p to the planes
+    double error(Vector3d p) const noexcept
+    {
+        double const x = p.x(), y = p.y(), z = p.z();
+        double const sum =   a2*x*x + 2.0*ab*x*y + 2.0*ac*x*z + 2.0*ad*x
+                           + b2*y*y + 2.0*bc*y*z + 2.0*bd*y
+                           + c2*z*z + 2.0*cd*z
+                           + d2;
+
+        // Rounding can make errors on the planes slightly negative
+        return (weight > 0.0) ? std::max(sum / weight, 0.0) : 0.0;
+    }
+};
+
+struct Collapse
+{
+    double          cost;
+    std::uint32_t   from;
+    std::uint32_t   to;
+};
+
+constexpr std::uint64_t edge_key(std::uint32_t a, std::uint32_t b) noexcept
+{
+    return (std::uint64_t(std::min(a, b)) << 32) | std::max(a, b);
+}
+
+/// Sorted edge keys of a triangle list, each edge once per triangle using it
+std::vector<std::uint64_t> triangle_edges(std::vector<std::uint32_t> const& indices)
+{
+    std::vector<std::uint64_t> edges;
+    edges.reserve(indices.size());
+    for (std::size_t i = 0; i < indices.size(); i += 3)
+    {
+        edges.push_back(edge_key(indices[i],     indices[i + 1]));
+        edges.push_back(edge_key(indices[i + 1], indices[i + 2]));
+        edges.push_back(edge_key(indices[i + 2], indices[i]));
+    }
+    std::sort(edges.begin(), edges.end());
+    return edges;
+}
+
+Vector3d triangle_normal(ArrayView<Vector3 const> positions, std::uint32_t a, std::uint32_t b, std::uint32_t c) noexcept
+{
+    Vector3d const pa{positions[a]};
+    return Magnum::Math::cross(Vector3d{positions[b]} - pa, Vector3d{positions[c]} - pa);
+}
+
+void remove_degenerate(std::vector<std::uint32_t>& rIndices)
+{
+    std::size_t out = 0;
+    for (std::size_t i = 0; i < rIndices.size(); i += 3)
+    {
+        std::uint32_t const a = rIndices[i], b = rIndices[i + 1], c = rIndices[i + 2];
+        if (a != b && b != c && c != a)
+        {
+            rIndices[out++] = a;
+            rIndices[out++] = b;
+            rIndices[out++] = c;
+        }
+    }
+    rIndices.resize(out);
+}
+
+} // namespace
+
+std::vector<std::uint32_t> SysMeshSimplify::simplify(
+        ArrayView<Vector3 const>        positions,
+        ArrayView<std::uint32_t const>  indices,
+        std::size_t const               targetIndexCount,
+        float const                     targetError)
+{
+    std::vector<std::uint32_t> out(indices.begin(), indices.end());
+    remove_degenerate(out);
+
+    std::size_t const vertexCount = positions.size();
+    if (out.size() <= targetIndexCount || vertexCount == 0)
+    {
+        return out;
+    }
+
+    // Error is relative to mesh size, and quadrics measure squared distance
+    Vector3 lower = positions[0];
+    Vector3 upper = positions[0];
+    for (Vector3 const& pos : positions)
+    {
+        lower = Magnum::Math::min(lower, pos);
+        upper = Magnum::Math::max(upper, pos);
+    }
+    double const maxDistance = double(targetError) * double((upper - lower).length());
+    double const maxCost     = maxDistance * maxDistance;
+
+    // Quadrics from planes of triangles around each vertex, weighted by area
+    std::vector<Quadric> quadrics(vertexCount);
+    for (std::size_t i = 0; i < out.size(); i += 3)
+    {
+        Vector3d const normal = triangle_normal(positions, out[i], out[i + 1], out[i + 2]);
+        double const   length = normal.length();
+        if (length == 0.0)
+        {
+            continue;
+        }
+        Vector3d const unit = normal / length;
+        Quadric const  q    = Quadric::from_plane(unit, -Magnum::Math::dot(unit, Vector3d{positions[out[i]]}), length * 0.5);
+        quadrics[out[i]]     += q;
+        quadrics[out[i + 1]] += q;
+        quadrics[out[i + 2]] += q;
+    }
+
+    // Lock vertices on edges used by only one triangle
+    std::vector<char> locked(vertexCount, 0);
+    {
+        std::vector<std::uint64_t> const edges = triangle_edges(out);
+        for (std::size_t i = 0; i < edges.size(); )
+        {
+            std::size_t j = i + 1;
+            while (j < edges.size() && edges[j] == edges[i])
+            {
+                ++j;
+            }
+            if (j - i == 1)
+            {
+                locked[edges[i] >> 32]         = 1;
+                locked[edges[i] & 0xFFFFFFFFu] = 1;
+            }
+            i = j;
+        }
+    }
+
+    std::vector<Collapse>       candidates;
+    std::vector<std::uint32_t>  adjOffsets;
+    std::vector<std::uint32_t>  adjTris;
+    std::vector<std::uint32_t>  remap(vertexCount);
+    std::vector<char>           touched(vertexCount);
+
+    // Each pass collapses the cheapest edges that don't share a neighbourhood, so the checks
+    // below stay valid without updating adjacency after every collapse
+    while (out.size() > targetIndexCount)
+    {
+        std::vector<std::uint64_t> edges = triangle_edges(out);
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        candidates.clear();
+        for (std::uint64_t const edge : edges)
+        {
+            auto const a = std::uint32_t(edge >> 32);
+            auto const b = std::uint32_t(edge & 0xFFFFFFFFu);
+
+            Quadric sum = quadrics[a];
+            sum += quadrics[b];
+
+            if (locked[a] && locked[b])
+            {
+                continue;
+            }
+
+            double const costAtoB = locked[a] ? 0.0 : sum.error(Vector3d{positions[b]});
+            double const costBtoA = locked[b] ? 0.0 : sum.error(Vector3d{positions[a]});
+
+            if ( ! locked[a] && (locked[b] || costAtoB <= costBtoA) )
+            {
+                candidates.push_back({costAtoB, a, b});
+            }
+            else
+            {
+                candidates.push_back({costBtoA, b, a});
+            }
+        }
+
+        std::erase_if(candidates, [maxCost] (Collapse const& c) { return c.cost > maxCost; });
+        if (candidates.empty())
+        {
+            break;
+        }
+        std::sort(candidates.begin(), candidates.end(),
+                  [] (Collapse const& lhs, Collapse const& rhs) { return lhs.cost < rhs.cost; });
+
+        // Triangles around each vertex
+        adjOffsets.assign(vertexCount + 1, 0);
+        for (std::uint32_t const index : out)
+        {
+            ++adjOffsets[index + 1];
+        }
+        std::partial_sum(adjOffsets.begin(), adjOffsets.end(), adjOffsets.begin());
+        adjTris.resize(out.size());
+        {
+            std::vector<std::uint32_t> fill(adjOffsets.begin(), adjOffsets.end() - 1);
+            for (std::size_t i = 0; i < out.size(); ++i)
+            {
+                adjTris[fill[out[i]]++] = std::uint32_t(i / 3);
+            }
+        }
+
+        std::iota(remap.begin(), remap.end(), 0u);
+        std::fill(touched.begin(), touched.end(), 0);
+
+        std::size_t const trisToRemove = (out.size() - targetIndexCount + 2) / 3;
+        std::size_t       trisRemoved  = 0;
+
+        for (Collapse const& collapse : candidates)
+        {
+            if (touched[collapse.from] || touched[collapse.to])
+            {
+                continue;
+            }
+
+            auto const around = ArrayView<std::uint32_t const>{adjTris.data() + adjOffsets[collapse.from],
+                                                               adjOffsets[collapse.from + 1] - adjOffsets[collapse.from]};
+
+            // Reject collapses that flip a remaining triangle
+            bool        flips   = false;
+            std::size_t removed = 0;
+            for (std::uint32_t const tri : around)
+            {
+                std::uint32_t const *pTri = &out[tri * 3];
+                if (pTri[0] == collapse.to || pTri[1] == collapse.to || pTri[2] == collapse.to)
+                {
+                    ++removed;
+                    continue;
+                }
+
+                std::array<std::uint32_t, 3> moved{pTri[0], pTri[1], pTri[2]};
+                std::replace(moved.begin(), moved.end(), collapse.from, collapse.to);
+
+                Vector3d const before = triangle_normal(positions, pTri[0], pTri[1], pTri[2]);
+                Vector3d const after  = triangle_normal(positions, moved[0], moved[1], moved[2]);
+                if (before.dot() != 0.0 && Magnum::Math::dot(before, after) <= 0.0)
+                {
+                    flips = true;
+                    break;
+                }
+            }
+            if (flips)
+            {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+
+            // Lock the neighbourhood for the rest of the pass
+            for (std::uint32_t const tri : around)
+            {
+                touched[out[tri * 3]]     = 1;
+                touched[out[tri * 3 + 1]] = 1;
+                touched[out[tri * 3 + 2]] = 1;
+            }
+
+            trisRemoved += removed;
+            if (trisRemoved >= trisToRemove)
+            {
+                break;
+            }
+        }
+
+        if (trisRemoved == 0)
+        {
+            break;
+        }
+
+        for (std::uint32_t &rIndex : out)
+        {
+            rIndex = remap[rIndex];
+        }
+        remove_degenerate(out);
+    }
+
+    return out;
+}
+
+Optional<MeshData> SysMeshSimplify::simplify_mesh(MeshData const& mesh, float const ratio, float const targetError)
+{
+    using Magnum::MeshAttribute;
+    using Magnum::MeshIndexType;
+    using Magnum::MeshPrimitive;
+
+    if (mesh.primitive() != MeshPrimitive::Triangles || ! mesh.hasAttribute(MeshAttribute::Position))
+    {
+        return {};
+    }
+
+    Array<Vector3> const positions = mesh.positions3DAsArray();
+
+    std::vector<std::uint32_t> indices;
+    if (mesh.isIndexed())
+    {
+        Array<Magnum::UnsignedInt> const meshIndices = mesh.indicesAsArray();
+        indices.assign(meshIndices.begin(), meshIndices.end());
+    }
+    else
+    {
+        indices.resize(mesh.vertexCount());
+        std::iota(indices.begin(), indices.end(), 0u);
+    }
+
+    std::size_t const target = std::size_t(float(indices.size() / 3) * ratio) * 3;
+    std::vector<std::uint32_t> simplified = simplify(positions, arrayView(indices), target, targetError);
+
+    // Interleaving puts each vertex's attributes in one contiguous stride, so used vertices can
+    // be copied as whole strides
+    MeshData const interleaved = Magnum::MeshTools::interleave(mesh);
+    std::size_t const stride = interleaved.attributeCount() != 0 ? std::size_t(interleaved.attributeStride(0)) : 0;
+
+    constexpr std::uint32_t c_unused = ~std::uint32_t(0);
+    std::vector<std::uint32_t> newIndexOf(interleaved.vertexCount(), c_unused);
+    std::uint32_t newVertexCount = 0;
+    for (std::uint32_t &rIndex : simplified)
+    {
+        std::uint32_t &rNew = newIndexOf[rIndex];
+        if (rNew == c_unused)
+        {
+            rNew = newVertexCount++;
+        }
+        rIndex = rNew;
+    }
+
+    Array<char> vertexData{Corrade::NoInit, std::size_t(newVertexCount) * stride};
+    auto const oldVertexData = interleaved.vertexData();
+    for (std::size_t oldIndex = 0; oldIndex < newIndexOf.size(); ++oldIndex)
+    {
+        if (newIndexOf[oldIndex] != c_unused)
+        {
+            std::memcpy(vertexData.data() + std::size_t(newIndexOf[oldIndex]) * stride,
+                        oldVertexData.data() + oldIndex * stride, stride);
+        }
+    }
+
+    Array<char> indexData{Corrade::NoInit, simplified.size() * sizeof(std::uint32_t)};
+    std::memcpy(indexData.data(), simplified.data(), indexData.size());
+    MeshIndexData const indexView{MeshIndexType::UnsignedInt, indexData};
+
+    Array<MeshAttributeData> attributes{interleaved.attributeCount()};
+    for (Magnum::UnsignedInt i = 0; i < interleaved.attributeCount(); ++i)
+    {
+        attributes[i] = MeshAttributeData{interleaved.attributeName(i), interleaved.attributeFormat(i),
+                                          interleaved.attributeOffset(i), newVertexCount,
+                                          interleaved.attributeStride(i), interleaved.attributeArraySize(i)};
+    }
+
+    return MeshData{MeshPrimitive::Triangles, std::move(indexData), indexView,
+                    std::move(vertexData), std::move(attributes), newVertexCount};
+}
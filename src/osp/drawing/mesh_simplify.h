@@ -0,0 +1,87 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "../core/array_view.h"
+#include "../core/math_types.h"
+
+#include <Magnum/Trade/MeshData.h>
+
+#include <Corrade/Containers/Optional.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace osp::draw
+{
+
+/**
+ * @brief CPU mesh simplification by quadric error edge collapse
+ *
+ * Edges collapse onto one of their existing vertices, so simplified index lists keep referring
+ * to the original vertices and all of their attributes. Vertices on open borders, including
+ * UV and normal seams that split vertices, are locked in place.
+ */
+class SysMeshSimplify
+{
+public:
+
+    /**
+     * @brief Simplify an indexed triangle list
+     *
+     * Collapses stop once the index count is at or below targetIndexCount, or once every
+     * remaining collapse would move the surface further than targetError.
+     *
+     * @param positions         [in] Vertex positions
+     * @param indices           [in] Triangle list indices into positions
+     * @param targetIndexCount  [in] Index count to reduce to
+     * @param targetError       [in] Largest allowed error, relative to the mesh's bounding box
+     *                               diagonal
+     *
+     * @return New triangle list indices into positions, without degenerate triangles
+     */
+    [[nodiscard]] static std::vector<std::uint32_t> simplify(
+            ArrayView<Vector3 const>        positions,
+            ArrayView<std::uint32_t const>  indices,
+            std::size_t                     targetIndexCount,
+            float                           targetError);
+
+    /**
+     * @brief Simplify a triangle mesh, keeping only the vertices still in use
+     *
+     * @param mesh          [in] Triangle mesh with 3D positions, indexed or not
+     * @param ratio         [in] Fraction of triangles to keep
+     * @param targetError   [in] See simplify()
+     *
+     * @return Owned, interleaved mesh with 32-bit indices, or NullOpt if the mesh isn't made of
+     *         triangles or has no positions
+     */
+    [[nodiscard]] static Corrade::Containers::Optional<Magnum::Trade::MeshData> simplify_mesh(
+            Magnum::Trade::MeshData const&  mesh,
+            float                           ratio,
+            float                           targetError);
+};
+
+} // namespace osp::draw
@@ -26,6 +26,8 @@
 
 #include "../core/resourcetypes.h"
 
+#include <vector>
+
 namespace osp
 {
 
@@ -40,4 +42,18 @@ inline ResTypeId const gc_mesh          = ResTypeIdReg_t::create();
 
 struct TextureImgSource : public ResIdOwner_t { };
 
+/**
+ * @brief Simplified versions of a mesh resource, added to the gc_mesh resource they're made from
+ *
+ * See SysMeshLod::create_lods
+ */
+struct MeshLods
+{
+    /// Mesh resources from most to least detailed, not including the original
+    std::vector<ResIdOwner_t>   levels;
+
+    /// Each level is drawn if the mesh covers less than this fraction of the screen's height
+    std::vector<float>          maxScreenSize;
+};
+
 } // namespace osp
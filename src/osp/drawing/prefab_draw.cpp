@@ -156,7 +156,7 @@ void SysPrefabDraw::init_mesh_texture_material(
             osp::ResId const meshRes = rImportData.m_meshes[meshImportId];
             MeshId const meshId = SysRender::own_mesh_resource(rDrawing, rDrawingRes, rResources, meshRes);
             rScnRender.m_mesh[drawEnt] = rDrawing.m_meshRefCounts.ref_add(meshId);
-            rScnRender.m_meshDirty.push_back(drawEnt);
+            rScnRender.m_meshDirty.mark(drawEnt);
 
             int const matImportId = rImportData.m_objMaterials[objects[i]];
 
@@ -170,7 +170,7 @@ void SysPrefabDraw::init_mesh_texture_material(
                     osp::ResId const texRes = rImportData.m_textures[baseColor];
                     TexId const texId = SysRender::own_texture_resource(rDrawing, rDrawingRes, rResources, texRes);
                     rScnRender.m_diffuseTex[drawEnt] = rDrawing.m_texRefCounts.ref_add(texId);
-                    rScnRender.m_diffuseDirty.push_back(drawEnt);
+                    rScnRender.m_diffuseDirty.mark(drawEnt);
                 }
             }
 
@@ -179,7 +179,7 @@ void SysPrefabDraw::init_mesh_texture_material(
 
             if (material != lgrn::id_null<MaterialId>())
             {
-                rScnRender.m_materials[material].m_dirty.push_back(drawEnt);
+                rScnRender.m_materials[material].m_dirty.mark(drawEnt);
                 rScnRender.m_materials[material].m_ents.insert(drawEnt);
             }
         }
@@ -226,7 +226,6 @@ void SysPrefabDraw::resync_mesh_texture_material(
             osp::ResId const meshRes = rImportData.m_meshes[meshImportId];
             MeshId const meshId = SysRender::own_mesh_resource(rDrawing, rDrawingRes, rResources, meshRes);
             rScnRender.m_mesh[drawEnt] = rDrawing.m_meshRefCounts.ref_add(meshId);
-            rScnRender.m_meshDirty.push_back(drawEnt);
 
             int const matImportId = rImportData.m_objMaterials[objects[rPrefabs.instanceInfo[ent].obj]];
 
@@ -240,7 +239,6 @@ void SysPrefabDraw::resync_mesh_texture_material(
                     osp::ResId const texRes = rImportData.m_textures[baseColor];
                     TexId const texId = SysRender::own_texture_resource(rDrawing, rDrawingRes, rResources, texRes);
                     rScnRender.m_diffuseTex[drawEnt] = rDrawing.m_texRefCounts.ref_add(texId);
-                    rScnRender.m_diffuseDirty.push_back(drawEnt);
                 }
             }
 
@@ -249,7 +247,6 @@ void SysPrefabDraw::resync_mesh_texture_material(
 
             if (material != lgrn::id_null<MaterialId>())
             {
-                rScnRender.m_materials[material].m_dirty.push_back(drawEnt);
                 rScnRender.m_materials[material].m_ents.insert(drawEnt);
             }
         }
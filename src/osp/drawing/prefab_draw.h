@@ -62,6 +62,12 @@ public:
             ACtxSceneRender&            rScnRender,
             MaterialId                  material = lgrn::id_null<MaterialId>());
 
+    /**
+     * @brief Assign components to DrawEnts of all existing prefabs, for a new renderer
+     *
+     * Unlike init_mesh_texture_material, dirty lists are left alone, as everything is marked
+     * dirty by SysRender::mark_all_dirty afterwards.
+     */
     static void resync_mesh_texture_material(
             ACtxPrefabs&                rPrefabs,
             Resources&                  rResources,
@@ -0,0 +1,146 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "render_queue.h"
+
+#include <algorithm>
+#include <array>
+
+using namespace osp;
+using namespace osp::draw;
+
+void SysRenderQueue::sort(RenderQueue& rQueue)
+{
+    std::vector<RenderQueueItem> &rItems   = rQueue.items;
+    std::vector<RenderQueueItem> &rScratch = rQueue.scratch;
+
+    std::size_t const count = rItems.size();
+
+    // Radix sort has a fixed cost per pass that isn't worth it for a handful of draws
+    if (count < 64)
+    {
+        std::stable_sort(rItems.begin(), rItems.end(), [] (RenderQueueItem const& lhs, RenderQueueItem const& rhs) noexcept
+        {
+            return lhs.key < rhs.key;
+        });
+        return;
+    }
+
+    // Count all 8 byte digits in one pass over the keys
+    std::array<std::array<std::uint32_t, 256>, 8> counts{};
+    for (RenderQueueItem const& item : rItems)
+    {
+        for (int pass = 0; pass < 8; ++pass)
+        {
+            ++counts[pass][(item.key >> (pass * 8)) & 0xFF];
+        }
+    }
+
+    rScratch.resize(count);
+
+    for (int pass = 0; pass < 8; ++pass)
+    {
+        std::array<std::uint32_t, 256> &rCount = counts[pass];
+
+        // All keys have the same digit, order wouldn't change
+        if (rCount[(rItems.front().key >> (pass * 8)) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        // Counts to starting offsets
+        std::uint32_t offset = 0;
+        for (std::uint32_t &rDigitCount : rCount)
+        {
+            std::uint32_t const digitCount = rDigitCount;
+            rDigitCount = offset;
+            offset += digitCount;
+        }
+
+        for (RenderQueueItem const& item : rItems)
+        {
+            rScratch[rCount[(item.key >> (pass * 8)) & 0xFF]++] = item;
+        }
+
+        std::swap(rItems, rScratch);
+    }
+}
+
+void SysRenderQueue::make_commands(RenderQueue& rQueue)
+{
+    rQueue.commands.clear();
+    rQueue.commands.reserve(rQueue.items.size());
+
+    RenderQueueEnt const *pPrev = nullptr;
+
+    for (RenderQueueItem const& item : rQueue.items)
+    {
+        RenderQueueEnt const &rEnt = rQueue.ents[item.index];
+
+        RenderStateChanges changed;
+        if (pPrev == nullptr || pPrev->shader != rEnt.shader)
+        {
+            changed = gc_renderStateAll;
+        }
+        else
+        {
+            if (pPrev->parts.material != rEnt.parts.material)
+            {
+                changed |= RenderStateChange::Material;
+            }
+            if (pPrev->parts.texture != rEnt.parts.texture)
+            {
+                changed |= RenderStateChange::Texture;
+            }
+            if (pPrev->parts.mesh != rEnt.parts.mesh)
+            {
+                changed |= RenderStateChange::Mesh;
+            }
+        }
+
+        rQueue.commands.push_back({rEnt.ent, rEnt.shader, changed});
+        pPrev = &rEnt;
+    }
+}
+
+std::uint32_t SysRenderQueue::shader_index(RenderQueue& rQueue, EntityToDraw const& toDraw)
+{
+    // Only a few shaders are expected per RenderGroup, linear search is fine
+    auto const found = std::find_if(rQueue.shaders.begin(), rQueue.shaders.end(),
+                                    [&toDraw] (EntityToDraw const& shader) noexcept
+    {
+        return    shader.draw          == toDraw.draw
+               && shader.data          == toDraw.data
+               && shader.drawInstanced == toDraw.drawInstanced
+               && shader.prepare       == toDraw.prepare;
+    });
+
+    if (found != rQueue.shaders.end())
+    {
+        return std::uint32_t(std::distance(rQueue.shaders.begin(), found));
+    }
+
+    rQueue.shaders.push_back(toDraw);
+    return std::uint32_t(rQueue.shaders.size() - 1);
+}
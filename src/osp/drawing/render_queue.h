@@ -0,0 +1,259 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "drawing_fn.h"
+
+#include <cstdint>
+#include <bit>
+#include <vector>
+
+namespace osp::draw
+{
+
+/**
+ * @brief 64-bit key that orders draws to minimize render state changes
+ *
+ * Opaque (front-to-back), most significant first:
+ * | shader 8 | material 8 | texture 14 | mesh 16 | depth 18 |
+ *
+ * Transparent (back-to-front), depth is inverted and moved to the top:
+ * | depth 18 | shader 8 | material 8 | texture 14 | mesh 16 |
+ *
+ * Ids wider than their field are truncated. This only affects sort order, as state changes are
+ * detected from the full Ids.
+ */
+using RenderKey_t = std::uint64_t;
+
+/**
+ * @brief Order of draws in a RenderQueue
+ */
+enum class ERenderOrder : std::uint8_t
+{
+    /// Sort by render state, then front-to-back. For opaque objects.
+    StateFirst,
+
+    /// Sort back-to-front, then by render state. For transparent objects.
+    BackToFront
+};
+
+/**
+ * @brief Render state of a single DrawEnt, provided by the renderer
+ *
+ * Meant for renderer-specific Ids (such as GL mesh and texture Ids) cast to integers. The
+ * shader is not included, as it is determined from the RenderGroup's EntityToDraw.
+ */
+struct RenderKeyParts
+{
+    std::uint32_t material  {0};
+    std::uint32_t texture   {0};
+    std::uint32_t mesh      {0};
+
+    friend constexpr bool operator==(RenderKeyParts const& lhs, RenderKeyParts const& rhs) noexcept = default;
+};
+
+/**
+ * @brief Entry of a RenderQueue, sorted by key
+ */
+struct RenderQueueItem
+{
+    RenderKey_t     key;
+    std::uint32_t   index;  ///< Index into RenderQueue::ents
+};
+
+/**
+ * @brief Visible DrawEnt gathered into a RenderQueue
+ */
+struct RenderQueueEnt
+{
+    DrawEnt         ent;
+    std::uint32_t   shader; ///< Index into RenderQueue::shaders
+    RenderKeyParts  parts;
+};
+
+/**
+ * @brief A single draw in state-sorted order
+ */
+struct RenderCmd
+{
+    DrawEnt             ent;
+    std::uint32_t       shader;  ///< Index into RenderQueue::shaders
+    RenderStateChanges  changed;
+};
+
+/**
+ * @brief Per-frame list of draws sorted to minimize render state changes
+ *
+ * Built from a RenderGroup by SysRenderQueue::build. Vectors are kept between frames to avoid
+ * reallocating.
+ */
+struct RenderQueue
+{
+    /// Unique draw functions and user data in the RenderGroup, one per shader
+    std::vector<EntityToDraw>       shaders;
+
+    std::vector<RenderQueueEnt>     ents;
+    std::vector<RenderQueueItem>    items;
+    std::vector<RenderQueueItem>    scratch;
+
+    /// Output: draws in order, with render state changes since the previous draw
+    std::vector<RenderCmd>          commands;
+
+    void clear() noexcept
+    {
+        shaders .clear();
+        ents    .clear();
+        items   .clear();
+        commands.clear();
+    }
+};
+
+struct ArgsForBuildRenderQueue
+{
+    RenderGroup const&          group;
+    DrawEntSet_t const&         visible;
+    DrawTransforms_t const&     drawTf;
+    Matrix4 const&              view;
+    ERenderOrder                order {ERenderOrder::StateFirst};
+
+    /// Optional entities to leave out even if visible, such as ones waiting for GPU data
+    DrawEntSet_t const*         pSkip {nullptr};
+};
+
+class SysRenderQueue
+{
+public:
+
+    static constexpr int smc_shaderBits     = 8;
+    static constexpr int smc_materialBits   = 8;
+    static constexpr int smc_textureBits    = 14;
+    static constexpr int smc_meshBits       = 16;
+    static constexpr int smc_depthBits      = 18;
+
+    static_assert(smc_shaderBits + smc_materialBits + smc_textureBits + smc_meshBits + smc_depthBits == 64);
+
+    /**
+     * @brief Quantize a view-space distance to smc_depthBits, preserving order
+     *
+     * Uses the exponent and top mantissa bits of the float, so precision is relative to the
+     * distance and no near/far range is needed. Negative distances (behind camera) become 0.
+     */
+    static constexpr std::uint32_t quantize_depth(float distance) noexcept
+    {
+        float const positive = (distance > 0.0f) ? distance : 0.0f;
+        return std::bit_cast<std::uint32_t>(positive) >> (31 - smc_depthBits);
+    }
+
+    /**
+     * @brief Pack a RenderKey_t, see RenderKey_t for layout
+     */
+    static constexpr RenderKey_t make_key(
+            std::uint32_t shader, RenderKeyParts const& parts, float distance, ERenderOrder order) noexcept
+    {
+        RenderKey_t state = field(shader, smc_shaderBits);
+        state = (state << smc_materialBits) | field(parts.material, smc_materialBits);
+        state = (state << smc_textureBits)  | field(parts.texture,  smc_textureBits);
+        state = (state << smc_meshBits)     | field(parts.mesh,     smc_meshBits);
+
+        std::uint32_t const depth = quantize_depth(distance);
+
+        if (order == ERenderOrder::StateFirst)
+        {
+            return (state << smc_depthBits) | depth;
+        }
+        else
+        {
+            RenderKey_t const inverted = field(~depth, smc_depthBits);
+            return (inverted << (64 - smc_depthBits)) | state;
+        }
+    }
+
+    /**
+     * @brief Gather visible entities of a RenderGroup into a RenderQueue, then sort it and
+     *        generate commands
+     *
+     * @param getParts  Called as getParts(DrawEnt) -> RenderKeyParts
+     */
+    template <typename FUNC_T>
+    static void build(RenderQueue& rQueue, ArgsForBuildRenderQueue const& args, FUNC_T&& getParts);
+
+    /**
+     * @brief Sort RenderQueue::items by key with a stable LSD radix sort
+     *
+     * Byte passes where every key has the same digit are skipped, which is common for the
+     * shader and material bytes.
+     */
+    static void sort(RenderQueue& rQueue);
+
+    /**
+     * @brief Fill RenderQueue::commands from sorted RenderQueue::items
+     */
+    static void make_commands(RenderQueue& rQueue);
+
+    /**
+     * @brief Find or add a shader (draw function and user data) to RenderQueue::shaders
+     */
+    static std::uint32_t shader_index(RenderQueue& rQueue, EntityToDraw const& toDraw);
+
+private:
+
+    static constexpr RenderKey_t field(std::uint32_t value, int bits) noexcept
+    {
+        return RenderKey_t(value) & ((RenderKey_t(1) << bits) - 1);
+    }
+
+}; // class SysRenderQueue
+
+template <typename FUNC_T>
+void SysRenderQueue::build(RenderQueue& rQueue, ArgsForBuildRenderQueue const& args, FUNC_T&& getParts)
+{
+    rQueue.clear();
+
+    Vector3 const viewZ     = args.view.row(2).xyz();
+    float const   viewZOffs = args.view[3][2];
+
+    for (auto const& [ent, toDraw] : entt::basic_view{args.group.entities}.each())
+    {
+        if ( ! args.visible.contains(ent) || (args.pSkip != nullptr && args.pSkip->contains(ent)) )
+        {
+            continue;
+        }
+
+        std::uint32_t const     shader   = shader_index(rQueue, toDraw);
+        RenderKeyParts const    parts    = getParts(ent);
+
+        // Camera looks down -Z, so distance is the negated view-space Z
+        float const distance = -(Magnum::Math::dot(viewZ, args.drawTf[ent].translation()) + viewZOffs);
+
+        auto const index = std::uint32_t(rQueue.ents.size());
+        rQueue.ents .push_back({ent, shader, parts});
+        rQueue.items.push_back({make_key(shader, parts, distance, args.order), index});
+    }
+
+    sort(rQueue);
+    make_commands(rQueue);
+}
+
+} // namespace osp::draw
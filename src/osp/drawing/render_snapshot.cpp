@@ -0,0 +1,159 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "render_snapshot.h"
+
+using namespace osp;
+using namespace osp::draw;
+
+namespace
+{
+
+template <typename KEYEDVEC_T, typename ENTS_T>
+void copy_ents(KEYEDVEC_T& rDst, KEYEDVEC_T const& src, ENTS_T const& ents)
+{
+    for (DrawEnt const ent : ents)
+    {
+        rDst[ent] = src[ent];
+    }
+}
+
+template <typename ENTS_T>
+void append(DrawEntVec_t& rDst, ENTS_T const& src)
+{
+    rDst.insert(rDst.end(), src.begin(), src.end());
+}
+
+} // namespace
+
+void SysRenderSnapshot::publish(ACtxRenderSnapshots& rSnapshots, ACtxSceneRender& rScnRender)
+{
+    std::uint32_t const writeIdx = rSnapshots.published % ACtxRenderSnapshots::smc_count;
+    RenderSnapshot &rSnap = rSnapshots.snapshots[writeIdx];
+
+    // Transforms interpolated from the current latest snapshot must be reset once it's replaced
+    if (rSnapshots.published != 0)
+    {
+        append(rSnapshots.framePendingTf, rSnapshots.latest().changedTf);
+    }
+
+    // Dirty lists only cover changed entities, copy everything if containers were resized
+    rSnap.resized =    rSnap.drawTransform.size() != rScnRender.m_drawTransform.size()
+                    || rSnap.color        .size() != rScnRender.m_color        .size();
+    if (rSnap.resized)
+    {
+        rSnap.drawTransform = rScnRender.m_drawTransform;
+        rSnap.color         = rScnRender.m_color;
+    }
+    else
+    {
+        copy_ents(rSnap.drawTransform, rScnRender.m_drawTransform, rSnap.pendingTf);
+        copy_ents(rSnap.drawTransform, rScnRender.m_drawTransform, rScnRender.m_drawTfDirty);
+        copy_ents(rSnap.color,         rScnRender.m_color,         rSnap.pendingColor);
+        copy_ents(rSnap.color,         rScnRender.m_color,         rScnRender.m_colorDirty);
+    }
+    rSnap.pendingTf     .clear();
+    rSnap.pendingColor  .clear();
+
+    rSnap.visible = rScnRender.m_visible;
+    rSnap.changedTf.assign(rScnRender.m_drawTfDirty.begin(), rScnRender.m_drawTfDirty.end());
+
+    // Other snapshots are still being read, and catch up when they're written next
+    for (std::uint32_t i = 0; i < ACtxRenderSnapshots::smc_count; ++i)
+    {
+        if (i != writeIdx)
+        {
+            append(rSnapshots.snapshots[i].pendingTf,    rScnRender.m_drawTfDirty);
+            append(rSnapshots.snapshots[i].pendingColor, rScnRender.m_colorDirty);
+        }
+    }
+    append(rSnapshots.framePendingTf,    rScnRender.m_drawTfDirty);
+    append(rSnapshots.framePendingColor, rScnRender.m_colorDirty);
+
+    rScnRender.m_drawTfDirty.clear();
+    rScnRender.m_colorDirty .clear();
+
+    ++rSnapshots.published;
+}
+
+void SysRenderSnapshot::interpolate(ACtxRenderSnapshots& rSnapshots, float alpha)
+{
+    if (rSnapshots.published == 0)
+    {
+        return;
+    }
+
+    RenderSnapshot const    &latest = rSnapshots.latest();
+    RenderFrame             &rFrame = rSnapshots.frame;
+
+    if (   rFrame.drawTransform.size() != latest.drawTransform.size()
+        || rFrame.color        .size() != latest.color        .size())
+    {
+        rFrame.drawTransform = latest.drawTransform;
+        rFrame.color         = latest.color;
+    }
+    else
+    {
+        copy_ents(rFrame.drawTransform, latest.drawTransform, rSnapshots.framePendingTf);
+        copy_ents(rFrame.color,         latest.color,         rSnapshots.framePendingColor);
+    }
+    rSnapshots.framePendingTf   .clear();
+    rSnapshots.framePendingColor.clear();
+
+    rFrame.visible = latest.visible;
+
+    // Only entities that moved between the two snapshots need interpolating. These are written
+    // every call, since an earlier call may have used a different alpha.
+    bool const canInterpolate =    alpha < 1.0f
+                                && rSnapshots.published >= 2
+                                && rSnapshots.previous().drawTransform.size() == latest.drawTransform.size();
+
+    for (DrawEnt const ent : latest.changedTf)
+    {
+        rFrame.drawTransform[ent] = canInterpolate
+                                  ? interpolate_transform(rSnapshots.previous().drawTransform[ent], latest.drawTransform[ent], alpha)
+                                  : latest.drawTransform[ent];
+    }
+}
+
+Matrix4 SysRenderSnapshot::interpolate_transform(Matrix4 const& a, Matrix4 const& b, float alpha) noexcept
+{
+    using Magnum::Math::lerp;
+
+    Vector3 const scaleA = a.scaling();
+    Vector3 const scaleB = b.scaling();
+
+    // Rotation can't be recovered from a zero scale axis
+    if (scaleA.min() == 0.0f || scaleB.min() == 0.0f)
+    {
+        return (alpha < 0.5f) ? a : b;
+    }
+
+    Quaternion const rotation = Magnum::Math::slerpShortestPath(Quaternion::fromMatrix(a.rotation()),
+                                                                Quaternion::fromMatrix(b.rotation()),
+                                                                alpha);
+
+    return Matrix4::from(rotation.toMatrix() * Magnum::Math::Matrix3x3<float>::fromDiagonal(lerp(scaleA, scaleB, alpha)),
+                         lerp(a.translation(), b.translation(), alpha));
+}
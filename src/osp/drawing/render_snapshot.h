@@ -0,0 +1,131 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "drawing.h"
+
+#include <array>
+#include <cstdint>
+
+namespace osp::draw
+{
+
+/**
+ * @brief Immutable copy of the draw state of one scene update, read by renderers
+ */
+struct RenderSnapshot
+{
+    DrawTransforms_t    drawTransform;
+    DrawEntColors_t     color;
+    DrawEntSet_t        visible;
+
+    /// Entities whose transforms differ from the previous snapshot, used for interpolation
+    DrawEntVec_t        changedTf;
+
+    /// Entities changed by publishes since this snapshot was last written
+    DrawEntVec_t        pendingTf;
+    DrawEntVec_t        pendingColor;
+
+    /// True if containers were resized and everything was copied
+    bool                resized     {true};
+};
+
+/**
+ * @brief Draw state that renderers read, separate from the ACtxSceneRender that scene update
+ *        modifies
+ */
+struct RenderFrame
+{
+    DrawTransforms_t    drawTransform;
+    DrawEntColors_t     color;
+    DrawEntSet_t        visible;
+};
+
+/**
+ * @brief Ring of render snapshots published by scene update
+ *
+ * Scene update writes the oldest snapshot while renderers read the two newest, interpolating
+ * transforms between them into the RenderFrame. Only entities in the dirty lists of
+ * ACtxSceneRender are copied.
+ */
+struct ACtxRenderSnapshots
+{
+    static constexpr std::uint32_t smc_count = 3;
+
+    std::array<RenderSnapshot, smc_count>   snapshots;
+    std::uint64_t                           published       {0};
+
+    /// Output of SysRenderSnapshot::interpolate
+    RenderFrame                             frame;
+
+    /// Entities of frame that need to be copied from the latest snapshot
+    DrawEntVec_t                            framePendingTf;
+    DrawEntVec_t                            framePendingColor;
+
+    [[nodiscard]] RenderSnapshot const& latest() const noexcept
+    {
+        return snapshots[(published - 1) % smc_count];
+    }
+
+    [[nodiscard]] RenderSnapshot const& previous() const noexcept
+    {
+        return snapshots[(published - 2) % smc_count];
+    }
+};
+
+class SysRenderSnapshot
+{
+public:
+
+    /**
+     * @brief Copy changed draw state into the next snapshot, and clear the dirty lists
+     *
+     * Call once at the end of each scene update, after all draw transforms are written.
+     *
+     * @param rSnapshots    [ref] Snapshots to publish to
+     * @param rScnRender    [ref] Scene render data; m_drawTfDirty and m_colorDirty are cleared
+     */
+    static void publish(ACtxRenderSnapshots& rSnapshots, ACtxSceneRender& rScnRender);
+
+    /**
+     * @brief Update ACtxRenderSnapshots::frame from the two latest snapshots
+     *
+     * May be called any number of times between publishes, such as once per rendered frame.
+     *
+     * @param rSnapshots    [ref] Snapshots to read, and frame to write
+     * @param alpha         [in] Position between the previous (0.0) and latest (1.0) snapshot
+     */
+    static void interpolate(ACtxRenderSnapshots& rSnapshots, float alpha);
+
+    /**
+     * @brief Interpolate translation, rotation, and scale of two transforms
+     *
+     * Transforms must not have shear.
+     */
+    [[nodiscard]] static Matrix4 interpolate_transform(Matrix4 const& a, Matrix4 const& b, float alpha) noexcept;
+
+}; // class SysRenderSnapshot
+
+} // namespace osp::draw
@@ -0,0 +1,283 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "upload_prep.h"
+
+#include <Magnum/MeshTools/Interleave.h>
+#include <Magnum/PixelFormat.h>
+
+#include <Corrade/Containers/StridedArrayView.h>
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+using namespace osp;
+using namespace osp::draw;
+
+using Magnum::PixelFormat;
+using Magnum::Vector2i;
+using Magnum::Trade::MeshData;
+
+namespace
+{
+
+/**
+ * @return Channels of a format with one normalized byte per channel, or 0 if it can't be
+ *         box filtered
+ */
+constexpr int filterable_channels(PixelFormat format) noexcept
+{
+    switch (format)
+    {
+    case PixelFormat::R8Unorm:
+    case PixelFormat::R8Srgb:
+        return 1;
+    case PixelFormat::RG8Unorm:
+    case PixelFormat::RG8Srgb:
+        return 2;
+    case PixelFormat::RGB8Unorm:
+    case PixelFormat::RGB8Srgb:
+        return 3;
+    case PixelFormat::RGBA8Unorm:
+    case PixelFormat::RGBA8Srgb:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+void downsample(
+        unsigned char const*    src,
+        Vector2i                srcSize,
+        unsigned char*          dst,
+        Vector2i                dstSize,
+        int                     channels) noexcept
+{
+    for (int y = 0; y < dstSize.y(); ++y)
+    {
+        // Odd sizes clamp to the last row or column
+        int const y0 = std::min(y * 2,     srcSize.y() - 1);
+        int const y1 = std::min(y * 2 + 1, srcSize.y() - 1);
+
+        for (int x = 0; x < dstSize.x(); ++x)
+        {
+            int const x0 = std::min(x * 2,     srcSize.x() - 1);
+            int const x1 = std::min(x * 2 + 1, srcSize.x() - 1);
+
+            for (int c = 0; c < channels; ++c)
+            {
+                auto const texel = [&] (int tx, int ty) -> unsigned int
+                {
+                    return src[(std::size_t(ty) * srcSize.x() + tx) * channels + c];
+                };
+
+                unsigned int const sum = texel(x0, y0) + texel(x1, y0) + texel(x0, y1) + texel(x1, y1);
+                dst[(std::size_t(y) * dstSize.x() + x) * channels + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+} // namespace
+
+MeshData SysUploadPrep::prepare_mesh(MeshData const& mesh)
+{
+    // Always returns a copy that owns its data, even if the input is already interleaved
+    return Magnum::MeshTools::interleave(mesh);
+}
+
+int SysUploadPrep::mip_count(Vector2i const size) noexcept
+{
+    auto const largest = std::uint32_t(std::max({size.x(), size.y(), 1}));
+    return int(std::bit_width(largest));
+}
+
+MipChain SysUploadPrep::build_mip_chain(Magnum::ImageView2D const& image, bool const mipmaps)
+{
+    MipChain out;
+    out.format = image.format();
+
+    int const channels   = filterable_channels(image.format());
+    int const levelCount = (mipmaps && channels != 0) ? mip_count(image.size()) : 1;
+
+    std::size_t const pixelSize = image.pixelSize();
+
+    out.sizes  .resize(levelCount);
+    out.offsets.resize(levelCount);
+
+    std::size_t total = 0;
+    Vector2i size = image.size();
+    for (int level = 0; level < levelCount; ++level)
+    {
+        out.sizes[level]   = size;
+        out.offsets[level] = total;
+        total += std::size_t(size.x()) * size.y() * pixelSize;
+        size = Magnum::Math::max(size / 2, Vector2i{1});
+    }
+    out.data.resize(total);
+
+    // Copy level 0 row by row, source rows may be padded
+    Corrade::Containers::StridedArrayView3D<char const> const pixels = image.pixels();
+    std::size_t const rowBytes = std::size_t(image.size().x()) * pixelSize;
+    for (int y = 0; y < image.size().y(); ++y)
+    {
+        auto const row = pixels[std::size_t(y)];
+        char *pDst = out.data.data() + y * rowBytes;
+        if (row.isContiguous())
+        {
+            std::copy_n(static_cast<char const*>(row.data()), rowBytes, pDst);
+        }
+        else
+        {
+            for (std::size_t x = 0; x < row.size()[0]; ++x)
+            {
+                for (std::size_t b = 0; b < pixelSize; ++b)
+                {
+                    *pDst++ = row[x][b];
+                }
+            }
+        }
+    }
+
+    for (int level = 1; level < levelCount; ++level)
+    {
+        auto *pData = reinterpret_cast<unsigned char*>(out.data.data());
+        downsample(pData + out.offsets[level - 1], out.sizes[level - 1],
+                   pData + out.offsets[level],     out.sizes[level],
+                   channels);
+    }
+
+    return out;
+}
+
+ResourcePrepWorker::ResourcePrepWorker()
+ : m_thread{[this] { run(); }}
+{ }
+
+ResourcePrepWorker::~ResourcePrepWorker()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+}
+
+void ResourcePrepWorker::submit_mesh(ResId const res, MeshData&& mesh)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_meshJobs.push_back({res, std::move(mesh)});
+    }
+    m_wake.notify_one();
+}
+
+void ResourcePrepWorker::submit_texture(ResId const res, Magnum::ImageView2D const& image, bool const mipmaps)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_textureJobs.push_back({res, image, mipmaps});
+    }
+    m_wake.notify_one();
+}
+
+std::vector<PreparedMesh> ResourcePrepWorker::take_meshes()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return std::exchange(m_meshesDone, {});
+}
+
+std::vector<PreparedTexture> ResourcePrepWorker::take_textures()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return std::exchange(m_texturesDone, {});
+}
+
+void ResourcePrepWorker::wait_idle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]
+    {
+        return ! m_busy && m_meshJobs.empty() && m_textureJobs.empty();
+    });
+}
+
+void ResourcePrepWorker::clear()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_meshJobs   .clear();
+    m_textureJobs.clear();
+    m_idle.wait(lock, [this] { return ! m_busy; });
+    m_meshesDone  .clear();
+    m_texturesDone.clear();
+}
+
+void ResourcePrepWorker::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        m_wake.wait(lock, [this]
+        {
+            return m_stop || ! m_meshJobs.empty() || ! m_textureJobs.empty();
+        });
+
+        if (m_stop)
+        {
+            return;
+        }
+
+        m_busy = true;
+
+        // Prepare without holding the lock, so the render thread can keep submitting
+        if ( ! m_meshJobs.empty() )
+        {
+            MeshJob job = std::move(m_meshJobs.front());
+            m_meshJobs.pop_front();
+
+            lock.unlock();
+            PreparedMesh prepared{job.res, SysUploadPrep::prepare_mesh(job.mesh)};
+            lock.lock();
+
+            m_meshesDone.push_back(std::move(prepared));
+        }
+        else
+        {
+            TextureJob const job = m_textureJobs.front();
+            m_textureJobs.pop_front();
+
+            lock.unlock();
+            PreparedTexture prepared{job.res, SysUploadPrep::build_mip_chain(job.image, job.mipmaps)};
+            lock.lock();
+
+            m_texturesDone.push_back(std::move(prepared));
+        }
+
+        m_busy = false;
+        m_idle.notify_all();
+    }
+}
@@ -0,0 +1,185 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "../core/resourcetypes.h"
+
+#include <Magnum/ImageView.h>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/Trade/MeshData.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace osp::draw
+{
+
+/**
+ * @brief Mip levels of an image packed one after another, with rows aligned to 1 byte
+ */
+struct MipChain
+{
+    Magnum::PixelFormat             format      {Magnum::PixelFormat::RGBA8Unorm};
+    std::vector<Magnum::Vector2i>   sizes;
+    std::vector<std::size_t>        offsets;
+    std::vector<char>               data;
+
+    [[nodiscard]] int level_count() const noexcept { return int(sizes.size()); }
+
+    [[nodiscard]] std::size_t level_bytes(int index) const noexcept
+    {
+        std::size_t const end = (index + 1 < level_count()) ? offsets[index + 1] : data.size();
+        return end - offsets[index];
+    }
+
+    /// View of one level, for uploading with Texture2D::setSubImage
+    [[nodiscard]] Magnum::ImageView2D level(int index) const noexcept
+    {
+        return {Magnum::PixelStorage{}.setAlignment(1), format, sizes[index],
+                {data.data() + offsets[index], level_bytes(index)}};
+    }
+};
+
+/**
+ * @brief Mesh ready to be copied to the GPU as-is, see SysUploadPrep::prepare_mesh
+ */
+struct PreparedMesh
+{
+    ResId                   res;
+    Magnum::Trade::MeshData mesh;
+};
+
+struct PreparedTexture
+{
+    ResId                   res;
+    MipChain                mips;
+};
+
+/**
+ * @brief CPU-side preparation of mesh and image resources for upload, independent of any
+ *        graphics API
+ */
+class SysUploadPrep
+{
+public:
+
+    /**
+     * @brief Copy a mesh into a single interleaved vertex buffer and an index buffer
+     *
+     * Attribute offsets of the result refer to its own vertex data, so vertex and index data can
+     * be uploaded as two contiguous blobs.
+     */
+    [[nodiscard]] static Magnum::Trade::MeshData prepare_mesh(Magnum::Trade::MeshData const& mesh);
+
+    /**
+     * @brief Number of mip levels down to 1x1
+     */
+    [[nodiscard]] static int mip_count(Magnum::Vector2i size) noexcept;
+
+    /**
+     * @brief Copy an image and generate its mip levels with a 2x2 box filter
+     *
+     * Only formats with 8-bit normalized channels are filtered. Other formats, or if mipmaps is
+     * false, produce a single level.
+     */
+    [[nodiscard]] static MipChain build_mip_chain(Magnum::ImageView2D const& image, bool mipmaps);
+};
+
+/**
+ * @brief Worker thread running SysUploadPrep on submitted resources
+ *
+ * Submitted data is not copied. The caller must keep it alive and unchanged until it is taken
+ * back out as a PreparedMesh or PreparedTexture, or clear() is called. Holding a resource owner
+ * is enough, as resource data is never modified after it's loaded.
+ */
+class ResourcePrepWorker
+{
+public:
+
+    ResourcePrepWorker();
+    ~ResourcePrepWorker();
+
+    ResourcePrepWorker(ResourcePrepWorker const& copy) = delete;
+    ResourcePrepWorker(ResourcePrepWorker&& move) = delete;
+    ResourcePrepWorker& operator=(ResourcePrepWorker const& copy) = delete;
+    ResourcePrepWorker& operator=(ResourcePrepWorker&& move) = delete;
+
+    /**
+     * @param mesh  [in] Usually a non-owning view from MeshTools::reference
+     */
+    void submit_mesh(ResId res, Magnum::Trade::MeshData&& mesh);
+
+    void submit_texture(ResId res, Magnum::ImageView2D const& image, bool mipmaps);
+
+    /// Take meshes finished since the last call
+    [[nodiscard]] std::vector<PreparedMesh> take_meshes();
+
+    /// Take textures finished since the last call
+    [[nodiscard]] std::vector<PreparedTexture> take_textures();
+
+    /// Block until all submitted jobs are prepared
+    void wait_idle();
+
+    /// Drop all queued and finished jobs, waiting for the one in progress
+    void clear();
+
+private:
+
+    struct MeshJob
+    {
+        ResId                   res;
+        Magnum::Trade::MeshData mesh;
+    };
+
+    struct TextureJob
+    {
+        ResId                   res;
+        Magnum::ImageView2D     image;
+        bool                    mipmaps;
+    };
+
+    void run();
+
+    std::mutex                      m_mutex;
+    std::condition_variable         m_wake;
+    std::condition_variable         m_idle;
+
+    std::deque<MeshJob>             m_meshJobs;
+    std::deque<TextureJob>          m_textureJobs;
+    std::vector<PreparedMesh>       m_meshesDone;
+    std::vector<PreparedTexture>    m_texturesDone;
+
+    bool                            m_busy      {false};
+    bool                            m_stop      {false};
+
+    // Started last, after everything it uses is constructed
+    std::thread                     m_thread;
+};
+
+} // namespace osp::draw
@@ -0,0 +1,114 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "shapes.h"
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief Content key for sharing identical collision shapes between physics bodies
+ *
+ * A flat list of quantized integers describing a shape; physics integrations append the
+ * primitive type, scale, and the layout of compound children. Quantization lets parts that are
+ * only off by float rounding (e.g. the same prefab spawned at different places) share a shape.
+ *
+ * Shapes referenced through add_ptr must outlive the key, normally by being held by the same
+ * cache that holds the key.
+ */
+struct ShapeKey
+{
+    /// Scale and position quantum in meters
+    static constexpr float smc_lengthQuantum    = 1.0f / 1024.0f;
+
+    /// Quaternion component quantum
+    static constexpr float smc_rotationQuantum  = 1.0f / 16384.0f;
+
+    ShapeKey& add(std::int32_t value)
+    {
+        m_data.push_back(value);
+        return *this;
+    }
+
+    ShapeKey& add(EShape shape)
+    {
+        return add(std::int32_t(shape));
+    }
+
+    ShapeKey& add_length(float value)
+    {
+        return add(std::int32_t(std::lround(value / smc_lengthQuantum)));
+    }
+
+    ShapeKey& add_lengths(Vector3 const& value)
+    {
+        return add_length(value.x()).add_length(value.y()).add_length(value.z());
+    }
+
+    ShapeKey& add_rotation(Quaternion const& value)
+    {
+        // q and -q are the same rotation, pick the one with non-negative scalar
+        Quaternion const q = (value.scalar() < 0.0f) ? -value : value;
+        auto const quantize = [] (float x) { return std::int32_t(std::lround(x / smc_rotationQuantum)); };
+        return add(quantize(q.vector().x())).add(quantize(q.vector().y()))
+              .add(quantize(q.vector().z())).add(quantize(q.scalar()));
+    }
+
+    /// Add an already-cached shape by identity
+    ShapeKey& add_ptr(void const* ptr)
+    {
+        auto const bits = reinterpret_cast<std::uintptr_t>(ptr);
+        return add(std::int32_t(std::uint32_t(bits))).add(std::int32_t(std::uint64_t(bits) >> 32));
+    }
+
+    bool operator==(ShapeKey const& rhs) const noexcept = default;
+
+    std::vector<std::int32_t> m_data;
+};
+
+} // namespace osp
+
+// std::hash support for unordered containers
+template <>
+struct std::hash<osp::ShapeKey>
+{
+    std::size_t operator() (osp::ShapeKey const& key) const noexcept
+    {
+        // FNV-1a over the quantized values
+        std::uint64_t hash = 14695981039346656037ull;
+        for (std::int32_t const value : key.m_data)
+        {
+            hash ^= std::uint32_t(value);
+            hash *= 1099511628211ull;
+        }
+        return std::size_t(hash);
+    }
+};
@@ -27,6 +27,7 @@
 #include "ImporterData.h"
 
 #include "../core/Resources.h"
+#include "../drawing/mesh_lod.h"
 #include "../drawing/own_restypes.h"
 #include "../util/logging.h"
 
@@ -176,6 +177,9 @@ static void load_gltf(TinyGltfImporter &rImporter, ResId res, std::string_view n
         ResId const meshRes = rResources.create(gc_mesh, pkg, format_name(rImporter.meshName(i), i));
         rResources.data_add<MeshData>(gc_mesh, meshRes, std::move(*mesh));
         rImportData.m_meshes[i] = rResources.owner_create(gc_mesh, meshRes);
+
+        // Simplified levels of detail are made once here instead of while rendering
+        draw::SysMeshLod::create_lods(rResources, meshRes, pkg);
     }
 
     // Store materials
@@ -27,15 +27,19 @@
 #include "FullscreenTriShader.h"
 
 #include <osp/core/Resources.h>
+#include <osp/drawing/mesh_lod.h>
 #include <osp/drawing/own_restypes.h>
 #include <osp/util/logging.h>
 
 #include <Magnum/ImageView.h>
 
 #include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/BufferImage.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
+#include <Magnum/GL/PixelFormat.h>
 #include <Magnum/GL/Renderer.h>
 #include <Magnum/GL/TextureFormat.h>
+#include <Magnum/Shaders/GenericGL.h>
 #include <Magnum/GL/RenderbufferFormat.h>
 
 #include <Corrade/Containers/ArrayViewStl.h>
@@ -46,11 +50,16 @@
 
 #include <Magnum/Mesh.h>
 #include <Magnum/MeshTools/Compile.h>
+#include <Magnum/MeshTools/Reference.h>
+
+#include <algorithm>
+#include <cassert>
 
 using Magnum::Trade::MeshData;
 using Magnum::Trade::TextureData;
 using Magnum::Trade::ImageData2D;
 
+using Magnum::GL::Buffer;
 using Magnum::GL::Mesh;
 using Magnum::GL::Texture2D;
 
@@ -58,6 +67,12 @@ using osp::ResId;
 
 using osp::draw::SysRenderGL;
 using osp::draw::RenderGL;
+using osp::draw::ACtxSceneRenderGL;
+using osp::draw::MeshGlLods;
+using osp::draw::MeshUploadGl;
+using osp::draw::TexUploadGl;
+using osp::draw::PreparedMesh;
+using osp::draw::PreparedTexture;
 
 using osp::draw::TexGlId;
 using osp::draw::MeshGlId;
@@ -107,6 +122,16 @@ void SysRenderGL::setup_context(RenderGL& rCtxGl)
         rCtxGl.m_fbo.attachTexture(GL::Framebuffer::ColorAttachment{0}, rFboColor, 0);
         rCtxGl.m_fbo.attachRenderbuffer(GL::Framebuffer::BufferAttachment::DepthStencil, rCtxGl.m_fboDepthStencil);
     }
+
+    /* Staging buffers and worker thread for resource uploads */
+    {
+        rCtxGl.m_staging = GL::Buffer{GL::Buffer::TargetHint::CopyRead};
+        rCtxGl.m_staging.setData({nullptr, rCtxGl.m_uploadBudget}, GL::BufferUsage::StreamDraw);
+
+        rCtxGl.m_stagingImage = GL::BufferImage2D{GL::PixelFormat::RGBA, GL::PixelType::UnsignedByte};
+
+        rCtxGl.m_prepWorker = std::make_unique<ResourcePrepWorker>();
+    }
 }
 
 void SysRenderGL::compile_resource_textures(
@@ -157,13 +182,16 @@ void SysRenderGL::compile_resource_textures(
             continue;
         }
 
-        rRenderGl.m_texGl.emplace(newId)
+        // Storage is allocated once mip levels are prepared, see upload_resources
+        TexUploadGl &rUpload = rRenderGl.m_texUploads.emplace_back(TexUploadGl{.id = newId});
+        rUpload.texture
                 .setMinificationFilter(texData.minificationFilter(),
                                        texData.mipmapFilter())
                 .setMagnificationFilter(texData.magnificationFilter())
-                .setWrapping(texData.wrapping().xy())
-                .setStorage(1, textureFormat(imgData.format()), imgData.size())
-                .setSubImage(0, {}, imgData);
+                .setWrapping(texData.wrapping().xy());
+
+        bool const mipmaps = texData.mipmapFilter() != Magnum::SamplerMipmap::Base;
+        rRenderGl.m_prepWorker->submit_texture(texRes, imgData, mipmaps);
     }
 }
 
@@ -174,15 +202,14 @@ void SysRenderGL::compile_resource_meshes(
 {
     // TODO: Eventually have dirty flags instead of checking every entry.
 
-    for ([[maybe_unused]] auto const & [_, scnOwner] : rCtxDrawRes.m_meshToRes)
+    // Returns null if the resource was already registered
+    auto const register_mesh = [&rResources, &rRenderGl] (ResId const meshRes) -> MeshGlId
     {
-        ResId const meshRes = scnOwner.value();
-
         // New element will be emplaced if it isn't present yet
         auto const [it, success] = rRenderGl.m_resToMesh.try_emplace(meshRes);
         if ( ! success)
         {
-            continue;
+            return lgrn::id_null<MeshGlId>();
         }
 
         // New element emplaced, this means we've just found a resource that
@@ -202,8 +229,221 @@ void SysRenderGL::compile_resource_meshes(
         // Get mesh data
         auto const &meshData = rResources.data_get<MeshData>(restypes::gc_mesh, meshRes);
 
-        // Compile and store mesh
-        rRenderGl.m_meshGl.emplace(newId, Magnum::MeshTools::compile(meshData));
+        // Worker reads the resource's data directly, renderOwner keeps it alive until uploaded
+        rRenderGl.m_prepWorker->submit_mesh(meshRes, Magnum::MeshTools::reference(meshData));
+
+        return newId;
+    };
+
+    for ([[maybe_unused]] auto const & [_, scnOwner] : rCtxDrawRes.m_meshToRes)
+    {
+        ResId const meshRes = scnOwner.value();
+
+        MeshGlId const newId = register_mesh(meshRes);
+        if (newId == lgrn::id_null<MeshGlId>())
+        {
+            continue;
+        }
+
+        // Levels of detail are uploaded along with the original, so switching levels never
+        // waits for an upload
+        auto const *pLods = rResources.data_try_get<MeshLods>(restypes::gc_mesh, meshRes);
+        if (pLods == nullptr)
+        {
+            continue;
+        }
+
+        MeshGlLods &rGlLods = rRenderGl.m_meshLods[newId];
+        rGlLods.maxScreenSize = pLods->maxScreenSize;
+        for (ResIdOwner_t const& levelOwner : pLods->levels)
+        {
+            ResId const levelRes = levelOwner.value();
+            MeshGlId const levelId = register_mesh(levelRes);
+            rGlLods.levels.push_back( (levelId != lgrn::id_null<MeshGlId>())
+                                      ? levelId : rRenderGl.m_resToMesh.at(levelRes) );
+        }
+    }
+}
+
+void SysRenderGL::select_lods(
+        ACtxSceneRenderGL&      rScnRenderGl,
+        RenderGL const&         renderGl,
+        ACtxCulling const&      cull,
+        ViewProjMatrix const&   viewProj)
+{
+    if (renderGl.m_meshLods.empty())
+    {
+        return;
+    }
+
+    for (std::size_t i = 0; i < cull.count; ++i)
+    {
+        DrawEnt const ent = cull.ents[i];
+        if ( ! cull.visible.contains(ent) )
+        {
+            continue;
+        }
+
+        ACompMeshGl &rMeshGl = rScnRenderGl.m_meshId[ent];
+        auto const found = renderGl.m_meshLods.find(rMeshGl.m_baseGlId);
+        if (found == renderGl.m_meshLods.end())
+        {
+            continue;
+        }
+        MeshGlLods const &lods = found->second;
+
+        float const size = SysMeshLod::projected_size({cull.x[i], cull.y[i], cull.z[i]}, cull.radius[i],
+                                                      viewProj.m_view, viewProj.m_proj);
+
+        // Fall back to more detailed levels if the selected one isn't uploaded yet
+        std::size_t level = SysMeshLod::select_level(arrayView(lods.maxScreenSize), size);
+        while (level != 0 && ! renderGl.m_meshGl.contains(lods.levels[level - 1]))
+        {
+            --level;
+        }
+
+        rMeshGl.m_glId = (level == 0) ? rMeshGl.m_baseGlId : lods.levels[level - 1];
+    }
+}
+
+void SysRenderGL::upload_resources(RenderGL& rRenderGl)
+{
+    using Magnum::GL::BufferUsage;
+    using Magnum::GL::textureFormat;
+
+    ResourcePrepWorker &rWorker = *rRenderGl.m_prepWorker;
+
+    // Allocate GL storage for data that finished preparing
+    for (PreparedMesh &rPrepared : rWorker.take_meshes())
+    {
+        MeshUploadGl &rUpload = rRenderGl.m_meshUploads.emplace_back(MeshUploadGl{
+                .id   = rRenderGl.m_resToMesh.at(rPrepared.res),
+                .mesh = std::move(rPrepared.mesh) });
+
+        rUpload.vertices = Buffer{Buffer::TargetHint::Array};
+        rUpload.vertices.setData({nullptr, rUpload.mesh.vertexData().size()}, BufferUsage::StaticDraw);
+
+        if (rUpload.mesh.isIndexed())
+        {
+            rUpload.indices = Buffer{Buffer::TargetHint::ElementArray};
+            rUpload.indices.setData({nullptr, rUpload.mesh.indexData().size()}, BufferUsage::StaticDraw);
+        }
+    }
+
+    for (PreparedTexture &rPrepared : rWorker.take_textures())
+    {
+        TexGlId const texId = rRenderGl.m_resToTex.at(rPrepared.res);
+        auto const found = std::find_if(rRenderGl.m_texUploads.begin(), rRenderGl.m_texUploads.end(),
+                                        [texId] (TexUploadGl const& upload) { return upload.id == texId; });
+        assert(found != rRenderGl.m_texUploads.end());
+
+        found->mips     = std::move(rPrepared.mips);
+        found->prepared = true;
+        found->texture.setStorage(found->mips.level_count(), textureFormat(found->mips.format), found->mips.sizes[0]);
+    }
+
+    std::size_t const budget = rRenderGl.m_uploadBudget;
+    std::size_t used = 0;
+
+    // Textures first, so the at-least-one-level rule can't be starved by meshes
+    for (TexUploadGl &rUpload : rRenderGl.m_texUploads)
+    {
+        if ( ! rUpload.prepared )
+        {
+            continue;
+        }
+
+        while (rUpload.levelsDone < rUpload.mips.level_count())
+        {
+            std::size_t const bytes = rUpload.mips.level_bytes(rUpload.levelsDone);
+            if (used != 0 && used + bytes > budget)
+            {
+                break;
+            }
+
+            Magnum::ImageView2D const level = rUpload.mips.level(rUpload.levelsDone);
+            rRenderGl.m_stagingImage.setData(level.storage(), level.format(), level.size(),
+                                             level.data(), BufferUsage::StreamDraw);
+            rUpload.texture.setSubImage(rUpload.levelsDone, {}, rRenderGl.m_stagingImage);
+
+            ++rUpload.levelsDone;
+            used += bytes;
+        }
+
+        if (rUpload.levelsDone == rUpload.mips.level_count())
+        {
+            rRenderGl.m_texGl.emplace(rUpload.id, std::move(rUpload.texture));
+        }
+    }
+
+    // Meshes are copied in chunks through separate ranges of the staging buffer, so no range is
+    // overwritten while the GPU may still be reading it this frame
+    auto const copy_chunks = [&rRenderGl, &used, budget]
+            (Corrade::Containers::ArrayView<char const> src, Buffer &rDst, std::size_t &rDone)
+    {
+        std::size_t const size = std::min(src.size() - rDone, budget - std::min(used, budget));
+        if (size == 0)
+        {
+            return;
+        }
+
+        rRenderGl.m_staging.setSubData(used, src.sliceSize(rDone, size));
+        Buffer::copy(rRenderGl.m_staging, rDst, used, rDone, size);
+
+        rDone += size;
+        used  += size;
+    };
+
+    if ( ! rRenderGl.m_meshUploads.empty() )
+    {
+        // Orphan contents from the previous call instead of waiting for the GPU to finish them
+        rRenderGl.m_staging.invalidateData();
+    }
+
+    for (MeshUploadGl &rUpload : rRenderGl.m_meshUploads)
+    {
+        copy_chunks(rUpload.mesh.vertexData(), rUpload.vertices, rUpload.vertexDone);
+        copy_chunks(rUpload.mesh.indexData(),  rUpload.indices,  rUpload.indexDone);
+
+        if (   rUpload.vertexDone == rUpload.mesh.vertexData().size()
+            && rUpload.indexDone  == rUpload.mesh.indexData().size() )
+        {
+            // Attribute offsets of the interleaved mesh match the uploaded buffers
+            rRenderGl.m_meshGl.emplace(rUpload.id, Magnum::MeshTools::compile(
+                    rUpload.mesh, std::move(rUpload.indices), std::move(rUpload.vertices)));
+        }
+    }
+
+    std::erase_if(rRenderGl.m_texUploads, [&rRenderGl] (TexUploadGl const& upload)
+    {
+        return rRenderGl.m_texGl.contains(upload.id);
+    });
+    std::erase_if(rRenderGl.m_meshUploads, [&rRenderGl] (MeshUploadGl const& upload)
+    {
+        return rRenderGl.m_meshGl.contains(upload.id);
+    });
+}
+
+void SysRenderGL::update_pending(ACtxSceneRenderGL& rScnRenderGl, RenderGL const& renderGl)
+{
+    std::vector<DrawEnt> live;
+
+    for (DrawEnt const ent : rScnRenderGl.m_pending)
+    {
+        MeshGlId const meshId = rScnRenderGl.m_meshId[ent].m_glId;
+        TexGlId  const texId  = rScnRenderGl.m_diffuseTexId[ent].m_glId;
+
+        // Null Ids are fine, the mesh or texture was removed since the entity was added
+        if (   (meshId == lgrn::id_null<MeshGlId>() || renderGl.m_meshGl.contains(meshId))
+            && (texId  == lgrn::id_null<TexGlId>()  || renderGl.m_texGl .contains(texId)) )
+        {
+            live.push_back(ent);
+        }
+    }
+
+    for (DrawEnt const ent : live)
+    {
+        rScnRenderGl.m_pending.erase(ent);
     }
 }
 
@@ -212,6 +452,7 @@ void SysRenderGL::sync_drawent_mesh(
         KeyedVec<DrawEnt, MeshIdOwner_t> const&     cmpMeshIds,
         IdMap_t<MeshId, ResIdOwner_t> const&        meshToRes,
         MeshGlEntStorage_t&                         rCmpMeshGl,
+        DrawEntSet_t&                               rPending,
         RenderGL&                                   rRenderGl)
 {
     ACompMeshGl &rEntMeshGl = rCmpMeshGl[ent];
@@ -234,8 +475,16 @@ void SysRenderGL::sync_drawent_mesh(
         {
             ResId const meshResId = foundIt->second;
 
-            // Mesh should have been loaded beforehand, assign it!
-            rEntMeshGl.m_glId = rRenderGl.m_resToMesh.at(meshResId);
+            // Mesh should have been registered beforehand, assign it! select_lods may swap
+            // m_glId for a less detailed level later.
+            rEntMeshGl.m_baseGlId = rRenderGl.m_resToMesh.at(meshResId);
+            rEntMeshGl.m_glId     = rEntMeshGl.m_baseGlId;
+
+            // Skip drawing until the mesh is uploaded, see update_pending
+            if ( ! rRenderGl.m_meshGl.contains(rEntMeshGl.m_glId) )
+            {
+                rPending.insert(ent);
+            }
         }
         else
         {
@@ -262,6 +511,7 @@ void SysRenderGL::sync_drawent_texture(
         KeyedVec<DrawEnt, TexIdOwner_t> const&      cmpTexIds,
         IdMap_t<TexId, ResIdOwner_t> const&         texToRes,
         TexGlEntStorage_t&                          rCmpTexGl,
+        DrawEntSet_t&                               rPending,
         RenderGL&                                   rRenderGl)
 {
     ACompTexGl &rEntTexGl = rCmpTexGl[ent];
@@ -284,8 +534,14 @@ void SysRenderGL::sync_drawent_texture(
         {
             ResId const texResId = foundIt->second;
 
-            // Mesh should have been loaded beforehand, assign it!
+            // Texture should have been registered beforehand, assign it!
             rEntTexGl.m_glId = rRenderGl.m_resToTex.at(texResId);
+
+            // Skip drawing until the texture is uploaded, see update_pending
+            if ( ! rRenderGl.m_texGl.contains(rEntTexGl.m_glId) )
+            {
+                rPending.insert(ent);
+            }
         }
         else
         {
@@ -329,6 +585,14 @@ void SysRenderGL::display_texture(
 
 void SysRenderGL::clear_resource_owners(RenderGL& rRenderGl, Resources& rResources)
 {
+    // Jobs in the worker read resource data directly, stop them before releasing owners
+    if (rRenderGl.m_prepWorker != nullptr)
+    {
+        rRenderGl.m_prepWorker->clear();
+    }
+    rRenderGl.m_meshUploads.clear();
+    rRenderGl.m_texUploads.clear();
+
     for ([[maybe_unused]] auto && [_, rOwner] : std::exchange(rRenderGl.m_texToRes, {}))
     {
         rResources.owner_destroy(restypes::gc_texture, std::move(rOwner));
@@ -340,11 +604,62 @@ void SysRenderGL::clear_resource_owners(RenderGL& rRenderGl, Resources& rResourc
         rResources.owner_destroy(restypes::gc_mesh, std::move(rOwner));
     }
     rRenderGl.m_resToMesh.clear();
+    rRenderGl.m_meshLods.clear();
 }
 
-void SysRenderGL::render_opaque(
+void SysRenderGL::build_render_queue(
+        RenderQueue& rQueue,
+        DrawBatches& rBatches,
         RenderGroup const& group,
         DrawEntSet_t const& visible,
+        RenderFrame const& frame,
+        ACtxSceneRender const& scnRender,
+        ACtxSceneRenderGL const& scnRenderGl,
+        ViewProjMatrix const& viewProj,
+        ERenderOrder order)
+{
+    auto const parts = [&scnRender, &scnRenderGl] (DrawEnt const ent) noexcept
+    {
+        RenderKeyParts out;
+
+        // Materials are few, and each entity is in at most one
+        for (MaterialId const matId : scnRender.m_materialIds)
+        {
+            if (scnRender.m_materials[matId].m_ents.contains(ent))
+            {
+                out.material = std::uint32_t(matId);
+                break;
+            }
+        }
+
+        if (std::size_t(ent) < scnRenderGl.m_diffuseTexId.size())
+        {
+            out.texture = std::uint32_t(scnRenderGl.m_diffuseTexId[ent].m_glId);
+        }
+        if (std::size_t(ent) < scnRenderGl.m_meshId.size())
+        {
+            out.mesh    = std::uint32_t(scnRenderGl.m_meshId[ent].m_glId);
+        }
+        return out;
+    };
+
+    SysRenderQueue::build(rQueue,
+                          {
+                              .group   = group,
+                              .visible = visible,
+                              .drawTf  = frame.drawTransform,
+                              .view    = viewProj.m_view,
+                              .order   = order,
+                              .pSkip   = &scnRenderGl.m_pending
+                          },
+                          parts);
+
+    SysInstancing::build(rBatches, rQueue, frame.drawTransform, &frame.color, smc_minInstances);
+}
+
+void SysRenderGL::render_opaque(
+        RenderQueue const& queue,
+        DrawBatches const& batches,
         ViewProjMatrix const& viewProj)
 {
     using Magnum::GL::Renderer;
@@ -354,12 +669,12 @@ void SysRenderGL::render_opaque(
     Renderer::disable(Renderer::Feature::Blending);
     Renderer::setDepthMask(GL_TRUE);
 
-    draw_group(group, visible, viewProj);
+    draw_batches(queue, batches, viewProj);
 }
 
 void SysRenderGL::render_transparent(
-        RenderGroup const& group,
-        DrawEntSet_t const& visible,
+        RenderQueue const& queue,
+        DrawBatches const& batches,
         ViewProjMatrix const& viewProj)
 {
     using Magnum::GL::Renderer;
@@ -375,19 +690,38 @@ void SysRenderGL::render_transparent(
     //            can mess up other transparent objects once added
     //Renderer::setDepthMask(GL_FALSE);
 
-    draw_group(group, visible, viewProj);
+    draw_batches(queue, batches, viewProj);
 }
 
-void SysRenderGL::draw_group(
-        RenderGroup const& group,
-        DrawEntSet_t const& visible,
+void SysRenderGL::draw_batches(
+        RenderQueue const& queue,
+        DrawBatches const& batches,
         ViewProjMatrix const& viewProj)
 {
-    for (auto const& [ent, toDraw] : entt::basic_view{group.entities}.each())
+    SysInstancing::draw(queue, batches, viewProj);
+}
+
+Magnum::GL::Mesh& SysRenderGL::prepare_instanced(
+        MeshGlStorage_t& rMeshGl,
+        InstanceBufGlStorage_t& rInstanceBufGl,
+        MeshGlId meshId,
+        ArrayView<InstanceData const> instances)
+{
+    using Magnum::Shaders::GenericGL3D;
+
+    Magnum::GL::Mesh &rMesh = rMeshGl.get(meshId);
+
+    if ( ! rInstanceBufGl.contains(meshId) )
     {
-        if (visible.contains(ent))
-        {
-            toDraw.draw(ent, viewProj, toDraw.data);
-        }
+        Magnum::GL::Buffer &rBuffer = rInstanceBufGl.emplace(meshId);
+        rMesh.addVertexBufferInstanced(rBuffer, 1, 0,
+                                       GenericGL3D::TransformationMatrix{},
+                                       GenericGL3D::NormalMatrix{},
+                                       GenericGL3D::Color4{});
     }
+
+    rInstanceBufGl.get(meshId).setData(instances, Magnum::GL::BufferUsage::StreamDraw);
+    rMesh.setInstanceCount(Magnum::Int(instances.size()));
+
+    return rMesh;
 }
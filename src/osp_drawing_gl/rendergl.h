@@ -28,7 +28,14 @@
 
 #include <osp/core/strong_id.h>
 #include <osp/drawing/drawing_fn.h>
-
+#include <osp/drawing/culling.h>
+#include <osp/drawing/instancing.h>
+#include <osp/drawing/render_queue.h>
+#include <osp/drawing/render_snapshot.h>
+#include <osp/drawing/upload_prep.h>
+
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/BufferImage.h>
 #include <Magnum/GL/Mesh.h>
 #include <Magnum/GL/Texture.h>
 #include <Magnum/GL/Framebuffer.h>
@@ -39,6 +46,8 @@
 
 #include <longeron/id_management/registry_stl.hpp>
 
+#include <memory>
+
 namespace osp::draw
 {
 
@@ -48,6 +57,47 @@ using MeshGlId = osp::StrongId<std::uint32_t, struct DummyForMeshGlId>;
 using TexGlStorage_t    = Storage_t<TexGlId, Magnum::GL::Texture2D>;
 using MeshGlStorage_t   = Storage_t<MeshGlId, Magnum::GL::Mesh>;
 
+/// Per-instance attribute buffers, attached to meshes the first time they're drawn instanced
+using InstanceBufGlStorage_t = Storage_t<MeshGlId, Magnum::GL::Buffer>;
+
+/**
+ * @brief Mesh being copied to GL buffers over multiple frames
+ */
+struct MeshUploadGl
+{
+    MeshGlId                    id;
+
+    /// Interleaved by SysUploadPrep::prepare_mesh, buffers match its vertex and index data
+    Magnum::Trade::MeshData     mesh;
+    Magnum::GL::Buffer          vertices    {Corrade::NoCreate};
+    Magnum::GL::Buffer          indices     {Corrade::NoCreate};
+    std::size_t                 vertexDone  {0};
+    std::size_t                 indexDone   {0};
+};
+
+/**
+ * @brief Texture being copied to GL one mip level at a time
+ */
+struct TexUploadGl
+{
+    TexGlId                     id;
+
+    /// Sampler is set when registered, storage is allocated once mips are prepared
+    Magnum::GL::Texture2D       texture;
+    MipChain                    mips;
+    bool                        prepared    {false};
+    int                         levelsDone  {0};
+};
+
+/**
+ * @brief GL meshes of a mesh resource's MeshLods
+ */
+struct MeshGlLods
+{
+    std::vector<MeshGlId>       levels;
+    std::vector<float>          maxScreenSize;
+};
+
 /**
  * @brief Main renderer state and essential GL resources
  *
@@ -72,6 +122,7 @@ struct RenderGL
     // Renderer-space GL Meshes
     lgrn::IdRegistryStl<MeshGlId>       m_meshIds;
     MeshGlStorage_t                     m_meshGl;
+    InstanceBufGlStorage_t              m_instanceBufGl;
 
     // Associate GL Texture Ids with resources
     IdMap_t<ResId, TexGlId>             m_resToTex;
@@ -81,6 +132,22 @@ struct RenderGL
     IdMap_t<ResId, MeshGlId>            m_resToMesh;
     IdMap_t<MeshGlId, ResIdOwner_t>     m_meshToRes;
 
+    /// Levels of detail of meshes that have them, keyed by the original mesh
+    IdMap_t<MeshGlId, MeshGlLods>       m_meshLods;
+
+    // Resources registered but not yet live in m_meshGl or m_texGl, see
+    // SysRenderGL::upload_resources
+    std::unique_ptr<ResourcePrepWorker> m_prepWorker;
+    std::vector<MeshUploadGl>           m_meshUploads;
+    std::vector<TexUploadGl>            m_texUploads;
+
+    // Persistent staging buffers, reused every frame
+    Magnum::GL::Buffer                  m_staging{Corrade::NoCreate};
+    Magnum::GL::BufferImage2D           m_stagingImage{Corrade::NoCreate};
+
+    /// Bytes copied to the GPU per call to SysRenderGL::upload_resources
+    std::size_t                         m_uploadBudget{4u * 1024u * 1024u};
+
 };
 
 struct ACompTexGl
@@ -92,7 +159,12 @@ struct ACompTexGl
 struct ACompMeshGl
 {
     MeshId      m_scnId     {lgrn::id_null<MeshId>()};
+
+    /// Mesh to draw, either m_baseGlId or one of its levels of detail
     MeshGlId    m_glId      {lgrn::id_null<MeshGlId>()};
+
+    /// Full detail mesh of m_scnId
+    MeshGlId    m_baseGlId  {lgrn::id_null<MeshGlId>()};
 };
 
 using MeshGlEntStorage_t    = KeyedVec<DrawEnt, ACompMeshGl>;
@@ -105,6 +177,16 @@ struct ACtxSceneRenderGL
 {
     MeshGlEntStorage_t      m_meshId;
     TexGlEntStorage_t       m_diffuseTexId;
+
+    /// Entities with a mesh or texture not uploaded yet, left out of render queues
+    DrawEntSet_t            m_pending;
+
+    /// Entities in view of the camera, see SysCulling::update
+    ACtxCulling             m_culling;
+
+    /// Rebuilt for each RenderGroup drawn, see SysRenderGL::build_render_queue
+    RenderQueue             m_renderQueue;
+    DrawBatches             m_drawBatches;
 };
 
 /**
@@ -118,7 +200,8 @@ public:
     /**
      * @brief Setup essential GL resources
      *
-     * This sets up an offscreen framebuffer and a fullscreen triangle
+     * This sets up an offscreen framebuffer, a fullscreen triangle, staging buffers, and starts
+     * the resource preparation worker thread
      *
      * @param rRenderGl [ref] Fresh default-constructed renderer state
      */
@@ -133,10 +216,16 @@ public:
     static void display_texture(
             RenderGL& rRenderGl, Magnum::GL::Texture2D& rTex);
 
+    /**
+     * @brief Release resources held by the renderer, dropping uploads in progress
+     */
     static void clear_resource_owners(RenderGL& rRenderGl, Resources& rResources);
 
     /**
-     * @brief Compile GPU-side TexGlIds for textures loaded from a Resource (TexId + ResId)
+     * @brief Assign TexGlIds to textures loaded from a Resource (TexId + ResId), and queue their
+     *        images for mip generation on the worker thread
+     *
+     * Textures become live in RenderGL::m_texGl once uploaded by upload_resources.
      *
      * @param rCtxDrawRes   [in] Resources used by the scene
      * @param rResources    [ref] Application Resources shared with the scene. New resource owners may be created.
@@ -148,7 +237,11 @@ public:
             RenderGL& rRenderGl);
 
     /**
-     * @brief Compile GPU-side MeshGlIds for meshes loaded from a Resource (MeshId + ResId)
+     * @brief Assign MeshGlIds to meshes loaded from a Resource (MeshId + ResId), and queue their
+     *        data for interleaving on the worker thread
+     *
+     * Meshes become live in RenderGL::m_meshGl once uploaded by upload_resources. Levels of
+     * MeshLods resource data are registered too, see select_lods.
      *
      * @param rCtxDrawRes   [in] Resources used by the scene
      * @param rResources    [ref] Application Resources shared with the scene. New resource owners may be created.
@@ -159,6 +252,40 @@ public:
             Resources& rResources,
             RenderGL& rRenderGl);
 
+    /**
+     * @brief Copy prepared meshes and textures to the GPU, up to RenderGL::m_uploadBudget bytes
+     *
+     * Data goes through the persistent staging buffers into GL objects allocated up front. Meshes
+     * and textures are moved into m_meshGl and m_texGl once all of their data is copied. At least
+     * one mip level is copied per call even if it exceeds the budget.
+     *
+     * @param rRenderGl     [ref] Renderer state
+     */
+    static void upload_resources(RenderGL& rRenderGl);
+
+    /**
+     * @brief Remove entities from ACtxSceneRenderGL::m_pending once their mesh and texture
+     *        are live
+     */
+    static void update_pending(ACtxSceneRenderGL& rScnRenderGl, RenderGL const& renderGl);
+
+    /**
+     * @brief Select a level of detail for visible entities by the projected size of their
+     *        culling spheres
+     *
+     * Entities without culling spheres or without MeshLods keep the full detail mesh.
+     *
+     * @param rScnRenderGl  [ref] ACompMeshGl::m_glId is set for each selected entity
+     * @param renderGl      [in] Renderer state with MeshGlLods
+     * @param cull          [in] Culling spheres and visible entities, see SysCulling::update
+     * @param viewProj      [in] View and projection matrix
+     */
+    static void select_lods(
+            ACtxSceneRenderGL&      rScnRenderGl,
+            RenderGL const&         renderGl,
+            ACtxCulling const&      cull,
+            ViewProjMatrix const&   viewProj);
+
     /**
      * @brief Synchronize an entity's MeshId component to an ACompMeshGl
      *
@@ -166,6 +293,7 @@ public:
      * @param cmpMeshIds    [in] Scene Mesh Id component
      * @param meshToRes     [in] Scene's Mesh Id to Resource Id
      * @param rCmpMeshGl    [ref] Renderer-side ACompMeshGl components
+     * @param rPending      [out] Entity is added if its mesh is still uploading
      * @param rRenderGl     [ref] Renderer state
      */
     static void sync_drawent_mesh(
@@ -173,6 +301,7 @@ public:
             KeyedVec<DrawEnt, MeshIdOwner_t> const&     cmpMeshIds,
             IdMap_t<MeshId, ResIdOwner_t> const&        meshToRes,
             MeshGlEntStorage_t&                         rCmpMeshGl,
+            DrawEntSet_t&                               rPending,
             RenderGL&                                   rRenderGl);
 
     template <typename ITA_T, typename ITB_T>
@@ -182,11 +311,12 @@ public:
             KeyedVec<DrawEnt, MeshIdOwner_t> const&     cmpMeshIds,
             IdMap_t<MeshId, ResIdOwner_t> const&        meshToRes,
             MeshGlEntStorage_t&                         rCmpMeshGl,
+            DrawEntSet_t&                               rPending,
             RenderGL&                                   rRenderGl)
     {
         std::for_each(first, last, [&] (DrawEnt const ent)
         {
-            sync_drawent_mesh(ent, cmpMeshIds, meshToRes, rCmpMeshGl, rRenderGl);
+            sync_drawent_mesh(ent, cmpMeshIds, meshToRes, rCmpMeshGl, rPending, rRenderGl);
         });
     }
 
@@ -197,6 +327,7 @@ public:
      * @param meshToRes     [in] Scene's Texture Id to Resource Id
      * @param entsDirty     [in] Entities to synchronize
      * @param rCmpTexGl     [ref] Renderer-side ACompTexGl components
+     * @param rPending      [out] Entity is added if its texture is still uploading
      * @param rRenderGl     [ref] Renderer state
      */
     static void sync_drawent_texture(
@@ -204,6 +335,7 @@ public:
             KeyedVec<DrawEnt, TexIdOwner_t> const&      cmpTexIds,
             IdMap_t<TexId, ResIdOwner_t> const&         texToRes,
             TexGlEntStorage_t&                          rCmpTexGl,
+            DrawEntSet_t&                               rPending,
             RenderGL&                                   rRenderGl);
 
     template <typename ITA_T, typename ITB_T>
@@ -213,45 +345,88 @@ public:
             KeyedVec<DrawEnt, TexIdOwner_t> const&      cmpTexIds,
             IdMap_t<TexId, ResIdOwner_t> const&         texToRes,
             TexGlEntStorage_t&                          rCmpTexGl,
+            DrawEntSet_t&                               rPending,
             RenderGL&                                   rRenderGl)
     {
         std::for_each(first, last, [&] (DrawEnt const ent)
         {
-            sync_drawent_texture(ent, cmpTexIds, texToRes, rCmpTexGl, rRenderGl);
+            sync_drawent_texture(ent, cmpTexIds, texToRes, rCmpTexGl, rPending, rRenderGl);
         });
     }
 
     /**
-     * @brief Call draw functions of a RenderGroup of opaque objects
+     * @brief Smallest run of entities sharing shader, material, texture, and mesh to draw instanced
+     */
+    static constexpr std::uint32_t smc_minInstances = 4;
+
+    /**
+     * @brief Gather visible entities of a RenderGroup into a RenderQueue sorted by GL state, and
+     *        batch entities that can be drawn instanced
      *
-     * @param group     [in] RenderGroup to draw
-     * @param visible   [in] Storage for visible components
-     * @param viewProj  [in] View and projection matrix
+     * @param rQueue        [out] Queue to rebuild
+     * @param rBatches      [out] Batches to rebuild
+     * @param group         [in] RenderGroup to draw
+     * @param visible       [in] Entities to draw, such as ACtxCulling::visible
+     * @param frame         [in] Draw transforms and colors
+     * @param scnRender     [in] Materials of entities
+     * @param scnRenderGl   [in] GL mesh and texture Ids of entities, pending entities are skipped
+     * @param viewProj      [in] View and projection matrix
+     * @param order         [in] StateFirst for opaque, BackToFront for transparent objects
      */
-    static void render_opaque(
+    static void build_render_queue(
+            RenderQueue& rQueue,
+            DrawBatches& rBatches,
             RenderGroup const& group,
             DrawEntSet_t const& visible,
-            ViewProjMatrix const& viewProj);
+            RenderFrame const& frame,
+            ACtxSceneRender const& scnRender,
+            ACtxSceneRenderGL const& scnRenderGl,
+            ViewProjMatrix const& viewProj,
+            ERenderOrder order);
 
     /**
-     * @brief Call draw functions of a RenderGroup of transparent objects
+     * @brief Call draw functions of a RenderQueue of opaque objects
      *
-     * Consider sorting the render group for correct transparency
+     * @param queue     [in] RenderQueue built with ERenderOrder::StateFirst
+     * @param batches   [in] Batches of the RenderQueue
+     * @param viewProj  [in] View and projection matrix
+     */
+    static void render_opaque(
+            RenderQueue const& queue,
+            DrawBatches const& batches,
+            ViewProjMatrix const& viewProj);
+
+    /**
+     * @brief Call draw functions of a RenderQueue of transparent objects
      *
-     * @param group     [in] RenderGroup to draw
-     * @param visible   [in] Storage for visible components
+     * @param queue     [in] RenderQueue built with ERenderOrder::BackToFront
+     * @param batches   [in] Batches of the RenderQueue
      * @param viewProj  [in] View and projection matrix
      */
     static void render_transparent(
-            RenderGroup const& group,
-            DrawEntSet_t const& visible,
+            RenderQueue const& queue,
+            DrawBatches const& batches,
             ViewProjMatrix const& viewProj);
 
-    static void draw_group(
-            RenderGroup const& group,
-            DrawEntSet_t const& visible,
+    static void draw_batches(
+            RenderQueue const& queue,
+            DrawBatches const& batches,
             ViewProjMatrix const& viewProj);
 
+    /**
+     * @brief Upload instance data for a mesh, attaching its instance buffer on first use
+     *
+     * Instance attributes use the generic TransformationMatrix, NormalMatrix, and Color4
+     * locations. Meshes drawn instanced must not have their own per-vertex colors.
+     *
+     * @return Mesh with its instance count set. Reset it to 1 after drawing.
+     */
+    static Magnum::GL::Mesh& prepare_instanced(
+            MeshGlStorage_t& rMeshGl,
+            InstanceBufGlStorage_t& rInstanceBufGl,
+            MeshGlId meshId,
+            ArrayView<InstanceData const> instances);
+
 };
 
 } // namespace osp::draw
@@ -0,0 +1,347 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "rendernull.h"
+
+#include <osp/core/Resources.h>
+#include <osp/drawing/own_restypes.h>
+#include <osp/util/logging.h>
+
+#include <Magnum/Trade/ImageData.h>
+#include <Magnum/Trade/MeshData.h>
+
+#include <utility>
+
+using Magnum::Trade::MeshData;
+using Magnum::Trade::ImageData2D;
+
+using osp::ResId;
+
+using osp::draw::SysRenderNull;
+using osp::draw::RenderNull;
+using osp::draw::ACtxDrawNull;
+using osp::draw::ACompMeshNull;
+using osp::draw::ACompTexNull;
+using osp::draw::MeshNull;
+using osp::draw::TexNull;
+using osp::draw::NullCmd;
+using osp::draw::NullCmdBuffer;
+using osp::draw::NullCmdStats;
+using osp::draw::ENullCmd;
+using osp::draw::RenderStateChange;
+
+using osp::draw::TexNullId;
+using osp::draw::MeshNullId;
+
+void osp::draw::prepare_ent_null(
+        ArrayView<DrawEnt const>    ents,
+        ViewProjMatrix const&       viewProj,
+        EntityToDraw::UserData_t    userData) noexcept
+{
+    auto &rData = *reinterpret_cast<ACtxDrawNull*>(userData[0]);
+
+    rData.pCommands->commands.push_back({
+        .type       = ENullCmd::Prepare,
+        .material   = rData.materialId,
+        .count      = std::uint32_t(ents.size()) });
+}
+
+void osp::draw::draw_ent_null(
+        DrawEnt                     ent,
+        ViewProjMatrix const&       viewProj,
+        EntityToDraw::UserData_t    userData,
+        RenderStateChanges          changed) noexcept
+{
+    auto &rData = *reinterpret_cast<ACtxDrawNull*>(userData[0]);
+
+    // Same per-draw math as a GL shader's uniforms, so recorded frames cost about as much CPU
+    rData.pCommands->transformProj.push_back(viewProj.m_viewProj * (*rData.pDrawTf)[ent]);
+
+    rData.pCommands->commands.push_back({
+        .type       = ENullCmd::Draw,
+        .changed    = changed,
+        .material   = rData.materialId,
+        .ent        = ent,
+        .mesh       = (*rData.pMeshId)[ent].m_nullId,
+        .texture    = (*rData.pDiffuseTexId)[ent].m_nullId,
+        .count      = 1 });
+}
+
+void osp::draw::draw_ent_null_instanced(
+        DrawEnt                         firstEnt,
+        ArrayView<InstanceData const>   instances,
+        ViewProjMatrix const&           viewProj,
+        EntityToDraw::UserData_t        userData,
+        RenderStateChanges              changed) noexcept
+{
+    auto &rData = *reinterpret_cast<ACtxDrawNull*>(userData[0]);
+
+    rData.pCommands->commands.push_back({
+        .type       = ENullCmd::DrawInstanced,
+        .changed    = changed,
+        .material   = rData.materialId,
+        .ent        = firstEnt,
+        .mesh       = (*rData.pMeshId)[firstEnt].m_nullId,
+        .texture    = (*rData.pDiffuseTexId)[firstEnt].m_nullId,
+        .count      = std::uint32_t(instances.size()) });
+}
+
+void SysRenderNull::compile_resource_textures(
+        ACtxDrawingRes const&   rCtxDrawRes,
+        Resources&              rResources,
+        RenderNull&             rRenderNull)
+{
+    for ([[maybe_unused]] auto const & [_, scnOwner] : rCtxDrawRes.m_texToRes)
+    {
+        ResId const texRes = scnOwner.value();
+
+        // New element will be emplaced if it isn't present yet
+        auto const [it, success] = rRenderNull.m_resToTex.try_emplace(texRes);
+        if ( ! success)
+        {
+            continue;
+        }
+
+        TexNullId const newId = rRenderNull.m_texIds.create();
+
+        // Create owner, this adds to the resource's reference count
+        ResIdOwner_t renderOwner
+                = rResources.owner_create(restypes::gc_texture, texRes);
+
+        // Track with two-way map and store owner
+        rRenderNull.m_texToRes.emplace(newId, std::move(renderOwner));
+        it->second = newId;
+
+        ResId const imgRes = rResources.data_get<TextureImgSource>(restypes::gc_texture, texRes);
+        auto const &imgData = rResources.data_get<ImageData2D>(restypes::gc_image, imgRes);
+
+        rRenderNull.m_texNull.resize(rRenderNull.m_texIds.capacity());
+        rRenderNull.m_texNull[newId] = TexNull{ .size = imgData.size() };
+    }
+}
+
+void SysRenderNull::compile_resource_meshes(
+        ACtxDrawingRes const&   rCtxDrawRes,
+        Resources&              rResources,
+        RenderNull&             rRenderNull)
+{
+    for ([[maybe_unused]] auto const & [_, scnOwner] : rCtxDrawRes.m_meshToRes)
+    {
+        ResId const meshRes = scnOwner.value();
+
+        // New element will be emplaced if it isn't present yet
+        auto const [it, success] = rRenderNull.m_resToMesh.try_emplace(meshRes);
+        if ( ! success)
+        {
+            continue;
+        }
+
+        MeshNullId const newId = rRenderNull.m_meshIds.create();
+
+        // Create owner, this adds to the resource's reference count
+        ResIdOwner_t renderOwner
+                = rResources.owner_create(restypes::gc_mesh, meshRes);
+
+        // Track with two-way map and store owner
+        rRenderNull.m_meshToRes.emplace(newId, std::move(renderOwner));
+        it->second = newId;
+
+        auto const &meshData = rResources.data_get<MeshData>(restypes::gc_mesh, meshRes);
+
+        rRenderNull.m_meshNull.resize(rRenderNull.m_meshIds.capacity());
+        rRenderNull.m_meshNull[newId] = MeshNull{
+            .vertexCount = meshData.vertexCount(),
+            .indexCount  = meshData.isIndexed() ? meshData.indexCount() : 0u };
+    }
+}
+
+void SysRenderNull::sync_drawent_mesh(
+        DrawEnt const                               ent,
+        KeyedVec<DrawEnt, MeshIdOwner_t> const&     cmpMeshIds,
+        IdMap_t<MeshId, ResIdOwner_t> const&        meshToRes,
+        MeshNullEntStorage_t&                       rCmpMeshNull,
+        RenderNull const&                           renderNull)
+{
+    ACompMeshNull &rEntMeshNull = rCmpMeshNull[ent];
+    MeshIdOwner_t const& entMeshScnId = cmpMeshIds[ent];
+
+    if ( ! entMeshScnId.has_value() )
+    {
+        // ACompMesh removed, remove ACompMeshNull too
+        rEntMeshNull = {};
+        return;
+    }
+
+    if (rEntMeshNull.m_scnId == entMeshScnId)
+    {
+        return; // No changes needed
+    }
+
+    rEntMeshNull.m_scnId = entMeshScnId;
+
+    if (auto const& foundIt = meshToRes.find(entMeshScnId);
+        foundIt != meshToRes.end())
+    {
+        // Mesh should have been registered beforehand
+        rEntMeshNull.m_nullId = renderNull.m_resToMesh.at(foundIt->second);
+    }
+    else
+    {
+        OSP_LOG_WARN("No mesh data found for Mesh {} from Entity {}",
+                     std::size_t(entMeshScnId.value()), std::size_t(ent));
+    }
+}
+
+void SysRenderNull::sync_drawent_texture(
+        DrawEnt const                               ent,
+        KeyedVec<DrawEnt, TexIdOwner_t> const&      cmpTexIds,
+        IdMap_t<TexId, ResIdOwner_t> const&         texToRes,
+        TexNullEntStorage_t&                        rCmpTexNull,
+        RenderNull const&                           renderNull)
+{
+    ACompTexNull &rEntTexNull = rCmpTexNull[ent];
+    TexIdOwner_t const& entTexScnId = cmpTexIds[ent];
+
+    if ( ! entTexScnId.has_value() )
+    {
+        // Texture removed, remove ACompTexNull too
+        rEntTexNull = {};
+        return;
+    }
+
+    if (rEntTexNull.m_scnId == entTexScnId)
+    {
+        return; // No changes needed
+    }
+
+    rEntTexNull.m_scnId = entTexScnId;
+
+    if (auto const& foundIt = texToRes.find(entTexScnId);
+        foundIt != texToRes.end())
+    {
+        // Texture should have been registered beforehand
+        rEntTexNull.m_nullId = renderNull.m_resToTex.at(foundIt->second);
+    }
+    else
+    {
+        OSP_LOG_WARN("No texture data found for Texture {} from Entity {}",
+                     std::size_t(entTexScnId.value()), std::size_t(ent));
+    }
+}
+
+void SysRenderNull::clear_resource_owners(RenderNull& rRenderNull, Resources& rResources)
+{
+    for ([[maybe_unused]] auto && [_, rOwner] : std::exchange(rRenderNull.m_texToRes, {}))
+    {
+        rResources.owner_destroy(restypes::gc_texture, std::move(rOwner));
+    }
+    rRenderNull.m_resToTex.clear();
+
+    for ([[maybe_unused]] auto && [_, rOwner] : std::exchange(rRenderNull.m_meshToRes, {}))
+    {
+        rResources.owner_destroy(restypes::gc_mesh, std::move(rOwner));
+    }
+    rRenderNull.m_resToMesh.clear();
+}
+
+void SysRenderNull::build_render_queue(
+        RenderQueue& rQueue,
+        DrawBatches& rBatches,
+        RenderGroup const& group,
+        DrawEntSet_t const& visible,
+        RenderFrame const& frame,
+        ACtxSceneRender const& scnRender,
+        ACtxSceneRenderNull const& scnRenderNull,
+        ViewProjMatrix const& viewProj,
+        ERenderOrder order)
+{
+    auto const parts = [&scnRender, &scnRenderNull] (DrawEnt const ent) noexcept
+    {
+        RenderKeyParts out;
+
+        // Materials are few, and each entity is in at most one
+        for (MaterialId const matId : scnRender.m_materialIds)
+        {
+            if (scnRender.m_materials[matId].m_ents.contains(ent))
+            {
+                out.material = std::uint32_t(matId);
+                break;
+            }
+        }
+
+        if (std::size_t(ent) < scnRenderNull.m_diffuseTexId.size())
+        {
+            out.texture = std::uint32_t(scnRenderNull.m_diffuseTexId[ent].m_nullId);
+        }
+        if (std::size_t(ent) < scnRenderNull.m_meshId.size())
+        {
+            out.mesh    = std::uint32_t(scnRenderNull.m_meshId[ent].m_nullId);
+        }
+        return out;
+    };
+
+    SysRenderQueue::build(rQueue,
+                          {
+                              .group   = group,
+                              .visible = visible,
+                              .drawTf  = frame.drawTransform,
+                              .view    = viewProj.m_view,
+                              .order   = order
+                          },
+                          parts);
+
+    SysInstancing::build(rBatches, rQueue, frame.drawTransform, &frame.color, smc_minInstances);
+}
+
+void SysRenderNull::render(
+        RenderQueue const& queue,
+        DrawBatches const& batches,
+        ViewProjMatrix const& viewProj)
+{
+    SysInstancing::draw(queue, batches, viewProj);
+}
+
+NullCmdStats SysRenderNull::count(NullCmdBuffer const& buffer) noexcept
+{
+    NullCmdStats out;
+
+    for (NullCmd const& cmd : buffer.commands)
+    {
+        if (cmd.type == ENullCmd::Prepare)
+        {
+            continue;
+        }
+
+        ++out.drawCalls;
+        out.instancedCalls  += (cmd.type == ENullCmd::DrawInstanced) ? 1 : 0;
+        out.entsDrawn       += cmd.count;
+        out.shaderChanges   += (cmd.changed & RenderStateChange::Shader)   ? 1 : 0;
+        out.materialChanges += (cmd.changed & RenderStateChange::Material) ? 1 : 0;
+        out.textureChanges  += (cmd.changed & RenderStateChange::Texture)  ? 1 : 0;
+        out.meshChanges     += (cmd.changed & RenderStateChange::Mesh)     ? 1 : 0;
+    }
+
+    return out;
+}
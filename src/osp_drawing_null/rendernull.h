@@ -0,0 +1,419 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <osp/core/storage.h>
+#include <osp/core/strong_id.h>
+#include <osp/drawing/drawing_fn.h>
+#include <osp/drawing/culling.h>
+#include <osp/drawing/instancing.h>
+#include <osp/drawing/render_queue.h>
+#include <osp/drawing/render_snapshot.h>
+
+#include <longeron/id_management/registry_stl.hpp>
+
+#include <algorithm>
+#include <optional>
+#include <vector>
+
+namespace osp::draw
+{
+
+using TexNullId  = osp::StrongId<std::uint32_t, struct DummyForTexNullId>;
+using MeshNullId = osp::StrongId<std::uint32_t, struct DummyForMeshNullId>;
+
+/**
+ * @brief Sizes of a registered mesh, read from its MeshData instead of uploading it
+ */
+struct MeshNull
+{
+    std::uint32_t   vertexCount {0};
+    std::uint32_t   indexCount  {0};
+};
+
+/**
+ * @brief Size of a registered texture, read from its image instead of uploading it
+ */
+struct TexNull
+{
+    Vector2i        size;
+};
+
+/**
+ * @brief Main renderer state of the headless render backend
+ *
+ * Mirrors RenderGL's resource bookkeeping without a GL context. Resources are live as soon as
+ * they're registered, there is nothing to upload.
+ */
+struct RenderNull
+{
+    lgrn::IdRegistryStl<TexNullId>      m_texIds;
+    KeyedVec<TexNullId, TexNull>        m_texNull;
+
+    lgrn::IdRegistryStl<MeshNullId>     m_meshIds;
+    KeyedVec<MeshNullId, MeshNull>      m_meshNull;
+
+    // Associate Null Texture Ids with resources
+    IdMap_t<ResId, TexNullId>           m_resToTex;
+    IdMap_t<TexNullId, ResIdOwner_t>    m_texToRes;
+
+    // Associate Null Mesh Ids with resources
+    IdMap_t<ResId, MeshNullId>          m_resToMesh;
+    IdMap_t<MeshNullId, ResIdOwner_t>   m_meshToRes;
+};
+
+struct ACompTexNull
+{
+    TexId       m_scnId     {lgrn::id_null<TexId>()};
+    TexNullId   m_nullId    {lgrn::id_null<TexNullId>()};
+};
+
+struct ACompMeshNull
+{
+    MeshId      m_scnId     {lgrn::id_null<MeshId>()};
+    MeshNullId  m_nullId    {lgrn::id_null<MeshNullId>()};
+};
+
+using MeshNullEntStorage_t  = KeyedVec<DrawEnt, ACompMeshNull>;
+using TexNullEntStorage_t   = KeyedVec<DrawEnt, ACompTexNull>;
+
+enum class ENullCmd : std::uint8_t
+{
+    Prepare,
+    Draw,
+    DrawInstanced
+};
+
+/**
+ * @brief A call to one of the headless draw functions, recorded instead of calling GL
+ */
+struct NullCmd
+{
+    ENullCmd            type;
+    RenderStateChanges  changed;
+    MaterialId          material;
+
+    /// Entity drawn, or first entity of an instanced draw. Null for Prepare.
+    DrawEnt             ent         {lgrn::id_null<DrawEnt>()};
+    MeshNullId          mesh        {lgrn::id_null<MeshNullId>()};
+    TexNullId           texture     {lgrn::id_null<TexNullId>()};
+
+    /// Entities prepared for Prepare, instances for DrawInstanced, 1 for Draw
+    std::uint32_t       count       {0};
+};
+
+/**
+ * @brief Commands recorded by the headless draw functions, cleared each frame
+ */
+struct NullCmdBuffer
+{
+    std::vector<NullCmd>    commands;
+
+    /// Transformation-projection matrix of each Draw, as a GL shader would upload them
+    std::vector<Matrix4>    transformProj;
+
+    void clear() noexcept
+    {
+        commands     .clear();
+        transformProj.clear();
+    }
+};
+
+/**
+ * @brief Draw calls and state changes counted from a NullCmdBuffer
+ */
+struct NullCmdStats
+{
+    std::size_t drawCalls       {0};    ///< Draw + DrawInstanced
+    std::size_t instancedCalls  {0};
+    std::size_t entsDrawn       {0};
+    std::size_t shaderChanges   {0};
+    std::size_t materialChanges {0};
+    std::size_t textureChanges  {0};
+    std::size_t meshChanges     {0};
+};
+
+/**
+ * @brief Headless rendering components for rendering a scene, see ACtxSceneRenderGL
+ */
+struct ACtxSceneRenderNull
+{
+    MeshNullEntStorage_t    m_meshId;
+    TexNullEntStorage_t     m_diffuseTexId;
+
+    /// Entities in view of the camera, see SysCulling::update
+    ACtxCulling             m_culling;
+
+    /// Rebuilt for each RenderGroup drawn, see SysRenderNull::build_render_queue
+    RenderQueue             m_renderQueue;
+    DrawBatches             m_drawBatches;
+
+    NullCmdBuffer           m_commands;
+};
+
+/**
+ * @brief Headless stand-in for a shader, records calls into a NullCmdBuffer
+ *
+ * One is used per material, so materials show up as separate shaders in RenderQueues just like
+ * the GL renderer's Phong and Flat shaders.
+ */
+struct ACtxDrawNull
+{
+    DrawTransforms_t           *pDrawTf         {nullptr};
+    TexNullEntStorage_t        *pDiffuseTexId   {nullptr};
+    MeshNullEntStorage_t       *pMeshId         {nullptr};
+    NullCmdBuffer              *pCommands       {nullptr};
+
+    MaterialId materialId { lgrn::id_null<MaterialId>() };
+
+    constexpr void assign_pointers(RenderFrame&         rFrame,
+                                   ACtxSceneRenderNull& rScnRenderNull) noexcept
+    {
+        pDrawTf         = &rFrame           .drawTransform;
+        pDiffuseTexId   = &rScnRenderNull   .m_diffuseTexId;
+        pMeshId         = &rScnRenderNull   .m_meshId;
+        pCommands       = &rScnRenderNull   .m_commands;
+    }
+};
+
+void prepare_ent_null(
+        ArrayView<DrawEnt const>    ents,
+        ViewProjMatrix const&       viewProj,
+        EntityToDraw::UserData_t    userData) noexcept;
+
+void draw_ent_null(
+        DrawEnt                     ent,
+        ViewProjMatrix const&       viewProj,
+        EntityToDraw::UserData_t    userData,
+        RenderStateChanges          changed) noexcept;
+
+void draw_ent_null_instanced(
+        DrawEnt                         firstEnt,
+        ArrayView<InstanceData const>   instances,
+        ViewProjMatrix const&           viewProj,
+        EntityToDraw::UserData_t        userData,
+        RenderStateChanges              changed) noexcept;
+
+struct ArgsForSyncDrawEntNull
+{
+    DrawEntSet_t const&             hasMaterial;
+    RenderGroup::DrawEnts_t *const  pStorageOpaque;
+    RenderGroup::DrawEnts_t *const  pStorageTransparent;
+    DrawEntSet_t const&             opaque;
+    DrawEntSet_t const&             transparent;
+    ACtxDrawNull&                   rData;
+};
+
+inline void sync_drawent_null(DrawEnt ent, ArgsForSyncDrawEntNull const args)
+{
+    bool const hasMaterial = args.hasMaterial.contains(ent);
+
+    EntityToDraw const toDraw{&draw_ent_null, {&args.rData}, &draw_ent_null_instanced, &prepare_ent_null};
+
+    if (args.pStorageTransparent != nullptr)
+    {
+        auto value = (hasMaterial && args.transparent.contains(ent))
+                   ? std::make_optional(toDraw)
+                   : std::nullopt;
+
+        storage_assign(*args.pStorageTransparent, ent, std::move(value));
+    }
+
+    if (args.pStorageOpaque != nullptr)
+    {
+        auto value = (hasMaterial && args.opaque.contains(ent))
+                   ? std::make_optional(toDraw)
+                   : std::nullopt;
+
+        storage_assign(*args.pStorageOpaque, ent, std::move(value));
+    }
+}
+
+template<typename ITA_T, typename ITB_T>
+void sync_drawent_null(
+        ITA_T const&                    first,
+        ITB_T const&                    last,
+        ArgsForSyncDrawEntNull const    args)
+{
+    std::for_each(first, last, [&args] (DrawEnt const ent)
+    {
+        sync_drawent_null(ent, args);
+    });
+}
+
+/**
+ * @brief Headless rendering functions, same steps as SysRenderGL without calling GL
+ *
+ * Meant for measuring and testing the CPU side of drawing, such as material sync, render queue
+ * building, and per-draw cost, where no GL context is available.
+ */
+class SysRenderNull
+{
+
+public:
+
+    /**
+     * @brief Release resources held by the renderer
+     */
+    static void clear_resource_owners(RenderNull& rRenderNull, Resources& rResources);
+
+    /**
+     * @brief Assign TexNullIds to textures loaded from a Resource (TexId + ResId)
+     *
+     * @param rCtxDrawRes   [in] Resources used by the scene
+     * @param rResources    [ref] Application Resources shared with the scene. New resource owners may be created.
+     * @param rRenderNull   [ref] Renderer state
+     */
+    static void compile_resource_textures(
+            ACtxDrawingRes const& rCtxDrawRes,
+            Resources& rResources,
+            RenderNull& rRenderNull);
+
+    /**
+     * @brief Assign MeshNullIds to meshes loaded from a Resource (MeshId + ResId)
+     *
+     * Levels of detail are not registered, entities always draw the full detail mesh.
+     *
+     * @param rCtxDrawRes   [in] Resources used by the scene
+     * @param rResources    [ref] Application Resources shared with the scene. New resource owners may be created.
+     * @param rRenderNull   [ref] Renderer state
+     */
+    static void compile_resource_meshes(
+            ACtxDrawingRes const& rCtxDrawRes,
+            Resources& rResources,
+            RenderNull& rRenderNull);
+
+    /**
+     * @brief Synchronize an entity's MeshId component to an ACompMeshNull
+     *
+     * @param ent           [in] DrawEnt with mesh to synchronize
+     * @param cmpMeshIds    [in] Scene Mesh Id component
+     * @param meshToRes     [in] Scene's Mesh Id to Resource Id
+     * @param rCmpMeshNull  [ref] Renderer-side ACompMeshNull components
+     * @param renderNull    [in] Renderer state
+     */
+    static void sync_drawent_mesh(
+            DrawEnt                                     ent,
+            KeyedVec<DrawEnt, MeshIdOwner_t> const&     cmpMeshIds,
+            IdMap_t<MeshId, ResIdOwner_t> const&        meshToRes,
+            MeshNullEntStorage_t&                       rCmpMeshNull,
+            RenderNull const&                           renderNull);
+
+    template <typename ITA_T, typename ITB_T>
+    static void sync_drawent_mesh(
+            ITA_T const&                                first,
+            ITB_T const&                                last,
+            KeyedVec<DrawEnt, MeshIdOwner_t> const&     cmpMeshIds,
+            IdMap_t<MeshId, ResIdOwner_t> const&        meshToRes,
+            MeshNullEntStorage_t&                       rCmpMeshNull,
+            RenderNull const&                           renderNull)
+    {
+        std::for_each(first, last, [&] (DrawEnt const ent)
+        {
+            sync_drawent_mesh(ent, cmpMeshIds, meshToRes, rCmpMeshNull, renderNull);
+        });
+    }
+
+    /**
+     * @brief Synchronize an entity's TexId component to an ACompTexNull
+     *
+     * @param ent           [in] DrawEnt with texture to synchronize
+     * @param cmpTexIds     [in] Scene Texture Id component
+     * @param texToRes      [in] Scene's Texture Id to Resource Id
+     * @param rCmpTexNull   [ref] Renderer-side ACompTexNull components
+     * @param renderNull    [in] Renderer state
+     */
+    static void sync_drawent_texture(
+            DrawEnt                                     ent,
+            KeyedVec<DrawEnt, TexIdOwner_t> const&      cmpTexIds,
+            IdMap_t<TexId, ResIdOwner_t> const&         texToRes,
+            TexNullEntStorage_t&                        rCmpTexNull,
+            RenderNull const&                           renderNull);
+
+    template <typename ITA_T, typename ITB_T>
+    static void sync_drawent_texture(
+            ITA_T const&                                first,
+            ITB_T const&                                last,
+            KeyedVec<DrawEnt, TexIdOwner_t> const&      cmpTexIds,
+            IdMap_t<TexId, ResIdOwner_t> const&         texToRes,
+            TexNullEntStorage_t&                        rCmpTexNull,
+            RenderNull const&                           renderNull)
+    {
+        std::for_each(first, last, [&] (DrawEnt const ent)
+        {
+            sync_drawent_texture(ent, cmpTexIds, texToRes, rCmpTexNull, renderNull);
+        });
+    }
+
+    /**
+     * @brief Smallest run of entities to draw instanced, same as SysRenderGL::smc_minInstances
+     */
+    static constexpr std::uint32_t smc_minInstances = 4;
+
+    /**
+     * @brief Gather visible entities of a RenderGroup into a RenderQueue sorted by state, and
+     *        batch entities that can be drawn instanced
+     *
+     * @param rQueue        [out] Queue to rebuild
+     * @param rBatches      [out] Batches to rebuild
+     * @param group         [in] RenderGroup to draw
+     * @param visible       [in] Entities to draw, such as ACtxCulling::visible
+     * @param frame         [in] Draw transforms and colors
+     * @param scnRender     [in] Materials of entities
+     * @param scnRenderNull [in] Mesh and texture Ids of entities
+     * @param viewProj      [in] View and projection matrix
+     * @param order         [in] StateFirst for opaque, BackToFront for transparent objects
+     */
+    static void build_render_queue(
+            RenderQueue& rQueue,
+            DrawBatches& rBatches,
+            RenderGroup const& group,
+            DrawEntSet_t const& visible,
+            RenderFrame const& frame,
+            ACtxSceneRender const& scnRender,
+            ACtxSceneRenderNull const& scnRenderNull,
+            ViewProjMatrix const& viewProj,
+            ERenderOrder order);
+
+    /**
+     * @brief Call draw functions of a RenderQueue, recording them into NullCmdBuffers
+     *
+     * @param queue     [in] RenderQueue after build_render_queue
+     * @param batches   [in] Batches of the RenderQueue
+     * @param viewProj  [in] View and projection matrix
+     */
+    static void render(
+            RenderQueue const& queue,
+            DrawBatches const& batches,
+            ViewProjMatrix const& viewProj);
+
+    /**
+     * @brief Count draw calls and state changes of recorded commands
+     */
+    [[nodiscard]] static NullCmdStats count(NullCmdBuffer const& buffer) noexcept;
+
+};
+
+} // namespace osp::draw
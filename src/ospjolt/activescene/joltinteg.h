@@ -28,6 +28,8 @@
 
 #include <osp/activescene/basic.h>
 #include <osp/core/id_map.h>
+#include <osp/core/keyed_vector.h>
+#include <osp/scientific/shape_key.h>
 
 
 #include <Jolt/Jolt.h>
@@ -39,15 +41,19 @@ JPH_SUPPRESS_WARNINGS
 #include <Jolt/Core/Factory.h>
 #include <Jolt/Core/JobSystemThreadPool.h>
 #include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/Body/BodyLockMulti.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhase.h>
 #include <Jolt/Physics/Collision/Shape/BoxShape.h>
 #include <Jolt/Physics/Collision/Shape/SphereShape.h>
 #include <Jolt/Physics/Collision/Shape/CylinderShape.h>
+#include <Jolt/Physics/Collision/Shape/MeshShape.h>
 #include <Jolt/Physics/Collision/Shape/RotatedTranslatedShape.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
 #include <Jolt/Core/TempAllocator.h>
 #include <Jolt/Physics/Collision/Shape/CompoundShape.h>
 #include <Jolt/Physics/Collision/Shape/ScaledShape.h>
 #include <Jolt/Physics/Collision/Shape/MutableCompoundShape.h>
+#include <Jolt/Physics/Collision/Shape/StaticCompoundShape.h>
 #include <Jolt/Physics/PhysicsStepListener.h>
 
 JPH_SUPPRESS_WARNING_POP
@@ -61,6 +67,8 @@ JPH_SUPPRESS_WARNING_POP
 
 #include <iostream>
 #include <cstdarg>
+#include <unordered_map>
+#include <vector>
 #include <osp/util/logging.h>
 
 #include "osp/core/strong_id.h"
@@ -127,42 +135,97 @@ static void TraceImpl(const char *inFMT, ...)
 
 
 /**
- * @brief The different physics layers for the simulation
+ * @brief Object layers used by OSP features, see make_osp_layer_table
  */
 namespace Layers
 {
-    static constexpr ObjectLayer NON_MOVING = 0;
-    static constexpr ObjectLayer MOVING = 1;
-    static constexpr ObjectLayer NUM_LAYERS = 2;
+    static constexpr ObjectLayer NON_MOVING = 0; ///< Static structures
+    static constexpr ObjectLayer MOVING     = 1; ///< Dynamic bodies that fit no other layer
+    static constexpr ObjectLayer TERRAIN    = 2; ///< Static terrain chunks, added and removed often
+    static constexpr ObjectLayer DEBRIS     = 3; ///< Loose dynamic shapes, often many of them
+    static constexpr ObjectLayer VEHICLE    = 4; ///< Welded vehicle bodies
+    static constexpr ObjectLayer NUM_LAYERS = 5;
 };
+
 /**
- * @brief Class that determines if two object layers can collide
+ * @brief Broadphase layers used by OSP features, each is a separate tree in Jolt's broadphase
  */
-class ObjectLayerPairFilterImpl : public ObjectLayerPairFilter
+namespace BroadPhaseLayers
 {
-public:
-    bool ShouldCollide(ObjectLayer inObject1, ObjectLayer inObject2) const override
+    static constexpr BroadPhaseLayer NON_MOVING(0);
+    static constexpr BroadPhaseLayer TERRAIN(1);
+    static constexpr BroadPhaseLayer MOVING(2);
+    static constexpr BroadPhaseLayer DEBRIS(3);
+    static constexpr uint NUM_LAYERS(4);
+};
+
+/**
+ * @brief Object layers, which broadphase layer each is in, and which pairs of them collide
+ *
+ * Passed to ACtxJoltWorld on construction. Static layers that never collide with each other
+ * and separate broadphase trees for static, terrain and debris bodies keep the number of
+ * broadphase pairs down in dense scenes.
+ */
+struct JoltLayerTable
+{
+    /// Broadphase layer of each object layer, indexed by ObjectLayer
+    std::vector<BroadPhaseLayer>    m_objectToBroadPhase;
+
+    /// Names of each broadphase layer for Jolt's profiler, indexed by BroadPhaseLayer
+    std::vector<char const*>        m_broadPhaseNames;
+
+    /// Symmetric object layer collision matrix, see collides and set_collides
+    std::vector<bool>               m_collides;
+
+    [[nodiscard]] uint object_layer_count() const noexcept
     {
-        switch (inObject1)
-        {
-        case Layers::NON_MOVING:
-            return inObject2 == Layers::MOVING; // Non moving only collides with moving
-        case Layers::MOVING:
-            return true; // Moving collides with everything
-        default:
-            JPH_ASSERT(false);
-            return false;
-        }
+        return uint(m_objectToBroadPhase.size());
+    }
+
+    [[nodiscard]] uint broadphase_layer_count() const noexcept
+    {
+        return uint(m_broadPhaseNames.size());
+    }
+
+    [[nodiscard]] bool collides(ObjectLayer const a, ObjectLayer const b) const noexcept
+    {
+        std::size_t const index = std::size_t(a) * object_layer_count() + b;
+        return index < m_collides.size() && m_collides[index];
+    }
+
+    /// Call after m_objectToBroadPhase is filled in, as its size is the object layer count
+    void set_collides(ObjectLayer const a, ObjectLayer const b, bool const value = true)
+    {
+        m_collides.resize(std::size_t(object_layer_count()) * object_layer_count(), false);
+        m_collides[std::size_t(a) * object_layer_count() + b] = value;
+        m_collides[std::size_t(b) * object_layer_count() + a] = value;
     }
 };
+
 /**
- * @brief The different broad phase layers (currently identical to physics Layers, but might change in the future)
+ * @brief Create the layer table for the Layers and BroadPhaseLayers above
+ *
+ * Static layers (NON_MOVING, TERRAIN) only collide with dynamic ones, dynamic layers collide
+ * with everything. MOVING and VEHICLE share a broadphase layer.
  */
-namespace BroadPhaseLayers
+JoltLayerTable make_osp_layer_table();
+
+/**
+ * @brief Class that determines if two object layers can collide
+ */
+class ObjectLayerPairFilterImpl : public ObjectLayerPairFilter
 {
-    static constexpr BroadPhaseLayer NON_MOVING(0);
-    static constexpr BroadPhaseLayer MOVING(1);
-    static constexpr uint NUM_LAYERS(2);
+public:
+    ObjectLayerPairFilterImpl(JoltLayerTable const& layers) : m_layers(layers) { }
+
+    bool ShouldCollide(ObjectLayer inObject1, ObjectLayer inObject2) const override
+    {
+        JPH_ASSERT(inObject1 < m_layers.object_layer_count() && inObject2 < m_layers.object_layer_count());
+        return m_layers.collides(inObject1, inObject2);
+    }
+
+private:
+    JoltLayerTable const& m_layers;
 };
 
 /**
@@ -171,76 +234,101 @@ namespace BroadPhaseLayers
 class BPLayerInterfaceImpl final : public BroadPhaseLayerInterface
 {
 public:
-    BPLayerInterfaceImpl()
-    {
-        // Create a mapping table from object to broad phase layer
-        mObjectToBroadPhase[Layers::NON_MOVING] = BroadPhaseLayers::NON_MOVING;
-        mObjectToBroadPhase[Layers::MOVING] = BroadPhaseLayers::MOVING;
-    }
+    BPLayerInterfaceImpl(JoltLayerTable const& layers) : m_layers(layers) { }
 
     uint GetNumBroadPhaseLayers() const override
     {
-        return BroadPhaseLayers::NUM_LAYERS;
+        return m_layers.broadphase_layer_count();
     }
 
     BroadPhaseLayer GetBroadPhaseLayer(ObjectLayer inLayer) const override
     {
-        JPH_ASSERT(inLayer < Layers::NUM_LAYERS);
-        return mObjectToBroadPhase[inLayer];
+        JPH_ASSERT(inLayer < m_layers.object_layer_count());
+        return m_layers.m_objectToBroadPhase[inLayer];
     }
 
 #if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
     /// Get the user readable name of a broadphase layer (debugging purposes)
     const char * GetBroadPhaseLayerName(BroadPhaseLayer inLayer) const override
     {
-        if (inLayer == BroadPhaseLayers::NON_MOVING) {
-            return "NON_MOVING";
-        }
-        else {
-            return "MOVING";
-        }
+        return m_layers.m_broadPhaseNames[BroadPhaseLayer::Type(inLayer)];
     }
 #endif // JPH_EXTERNAL_PROFILE || JPH_PROFILE_ENABLED
 
 private:
-    BroadPhaseLayer					mObjectToBroadPhase[Layers::NUM_LAYERS];
+    JoltLayerTable const& m_layers;
 };
+
 /**
  * @brief Class that determines if an object layer can collide with a broadphase layer
+ *
+ * An object layer collides with a broadphase layer if it collides with any object layer in it.
+ * This is worked out once on construction.
  */
 class ObjectVsBroadPhaseLayerFilterImpl : public ObjectVsBroadPhaseLayerFilter
 {
 public:
+    ObjectVsBroadPhaseLayerFilterImpl(JoltLayerTable const& layers);
+
     bool ShouldCollide(ObjectLayer inLayer1, BroadPhaseLayer inLayer2) const override
     {
-        switch (inLayer1)
-        {
-        case Layers::NON_MOVING:
-            return inLayer2 == BroadPhaseLayers::MOVING;
-        case Layers::MOVING:
-            return true;
-        default:
-            JPH_ASSERT(false);
-            return false;
-        }
+        JPH_ASSERT(inLayer1 < m_objectLayerCount);
+        return m_collides[std::size_t(inLayer1) * m_broadPhaseCount + BroadPhaseLayer::Type(inLayer2)];
     }
+
+private:
+    std::vector<bool>   m_collides;
+    uint                m_objectLayerCount;
+    uint                m_broadPhaseCount;
 };
 
 struct ACtxJoltWorld;
 
-//The physics callback to sync bodies between osp and jolt
+/**
+ * @brief Number of step listeners Jolt runs in a single job.
+ *
+ * Matches Jolt's default PhysicsSettings::mStepListenersBatchSize.
+ */
+inline constexpr uint gc_joltListenerBatchSize = 8;
+
+/**
+ * @brief Minimum number of bodies added or removed at once to rebuild the broadphase after.
+ *
+ * OptimizeBroadPhase is about as expensive as rebuilding the trees, not worth it for the few
+ * bodies spawned during normal play, but keeps queries fast after spawning a large vehicle or
+ * clearing out many entities.
+ */
+inline constexpr std::size_t gc_joltOptimizeBroadPhaseMin = 256;
+
+/**
+ * @brief Step listener that applies force factors to a slice of ACtxJoltWorld::m_activeBodies
+ *
+ * Jolt runs batches of step listeners as separate jobs. Several listeners that each handle a
+ * disjoint slice of the active bodies can run in parallel without locking.
+ */
 class PhysicsStepListenerImpl : public PhysicsStepListener
 {
 public:
-    PhysicsStepListenerImpl(ACtxJoltWorld* pContext) : m_context(pContext) {};
+    PhysicsStepListenerImpl(ACtxJoltWorld* pContext, uint index) : m_context(pContext), m_index(index) {};
     void OnStep(float inDeltaTime, PhysicsSystem& rPhysicsSystem) override;
 
 private:
-    ACtxJoltWorld* m_context;
+    ACtxJoltWorld*  m_context;
+    uint            m_index;
 };
 
 using ShapeStorage_t = osp::Storage_t<osp::active::ActiveEnt, Ref<Shape>>;
 
+/**
+ * @brief Child shape of a compound, see SysJolt::create_compound
+ */
+struct JoltCompoundChild
+{
+    Vec3        m_position;
+    Quat        m_rotation;
+    Ref<Shape>  m_shape;
+};
+
 /**
  * @brief Represents an instance of a Jolt physics world in the scene
  */
@@ -257,12 +345,17 @@ public:
     // The default values are the one suggested in the Jolt hello world exemple for a "real" project.
     // It might be overkill here.
     ACtxJoltWorld(  int threadCount = 2,
+                    JoltLayerTable layers = make_osp_layer_table(),
                     uint maxBodies = 65536, 
                     uint numBodyMutexes = 0, 
                     uint maxBodyPairs = 65536, 
                     uint maxContactConstraints = 10240
                 ) : m_pPhysicsSystem(std::make_unique<PhysicsSystem>()), 
                     m_temp_allocator(10 * 1024 * 1024),
+                    m_layers(std::move(layers)),
+                    m_objectLayerFilter(m_layers),
+                    m_bPLInterface(m_layers),
+                    m_objectVsBPLFilter(m_layers),
                     m_joltJobSystem(std::make_unique<JobSystemThreadPool>(cMaxPhysicsJobs, cMaxPhysicsBarriers, threadCount))
     {
         m_pPhysicsSystem->Init(maxBodies, 
@@ -274,8 +367,14 @@ public:
                     m_objectLayerFilter);
         //gravity is handled on the OSP side
         m_pPhysicsSystem->SetGravity(Vec3Arg::sZero());
-        m_listener = std::make_unique<PhysicsStepListenerImpl>(this);
-        m_pPhysicsSystem->AddStepListener(m_listener.get());
+
+        // Enough listeners to give every job system thread a batch
+        uint const listenerCount = gc_joltListenerBatchSize * uint(m_joltJobSystem->GetMaxConcurrency());
+        m_listeners.reserve(listenerCount);
+        for (uint i = 0; i < listenerCount; ++i)
+        {
+            m_pPhysicsSystem->AddStepListener(m_listeners.emplace_back(std::make_unique<PhysicsStepListenerImpl>(this, i)).get());
+        }
     }
 
     //mandatory jolt initialization steps
@@ -288,6 +387,9 @@ public:
     
 
     TempAllocatorImpl                                   m_temp_allocator;
+
+    /// Referenced by the filters below, must not change after construction
+    JoltLayerTable                                      m_layers;
     ObjectLayerPairFilterImpl                           m_objectLayerFilter;
     BPLayerInterfaceImpl                                m_bPLInterface;
     ObjectVsBroadPhaseLayerFilterImpl                   m_objectVsBPLFilter;
@@ -295,18 +397,43 @@ public:
 
     std::unique_ptr<PhysicsSystem>                      m_pPhysicsSystem;
 
-    std::unique_ptr<PhysicsStepListenerImpl>		    m_listener;
+    std::vector<std::unique_ptr<PhysicsStepListenerImpl>> m_listeners;
 
     lgrn::IdRegistryStl<BodyId>                         m_bodyIds;
-    osp::IdMap_t<BodyId, ForceFactors_t>                m_bodyFactors;
+    osp::KeyedVec<BodyId, ForceFactors_t>               m_bodyFactors;
     lgrn::IdSetStl<BodyId>                              m_bodyDirty;
 
-    osp::IdMap_t<BodyId, osp::active::ActiveEnt>        m_bodyToEnt;
+    osp::KeyedVec<BodyId, osp::active::ActiveEnt>       m_bodyToEnt;
     osp::IdMap_t<osp::active::ActiveEnt, BodyId>        m_entToBody;
 
+    /// Rigid bodies active at the start of the step, sliced between step listeners
+    BodyIDVector                                        m_activeBodies;
+
+    /// Bodies whose transforms are written back after the step; m_activeBodies plus bodies
+    /// activated during the step
+    BodyIDVector                                        m_movedBodies;
+
+    /// Set by SysJolt::update_translate, which also moves sleeping bodies. The next
+    /// write_transforms then writes back every body instead of only active ones.
+    bool                                                m_originTranslated{false};
+
+    /// World transforms of m_movedBodies, gathered from Jolt before scattering to m_pTransform
+    osp::KeyedVec<BodyId, osp::Matrix4>                 m_bodyTransforms;
+
+    /// Bodies from SysJolt::create_body, added to the world together by add_created_bodies
+    BodyIDVector                                        m_bodiesToAdd;
+
+    /// Bodies from SysJolt::remove_components, removed and destroyed together by
+    /// remove_queued_bodies. Their BodyIds stay reserved until then.
+    BodyIDVector                                        m_bodiesToRemove;
+
     std::vector<ForceFactorFunc>                        m_factors;
     ShapeStorage_t                                      m_shapes;
 
+    /// Immutable shapes shared between bodies, keyed by content. Filled by
+    /// SysJolt::create_primitive, scale_shape, and create_compound
+    std::unordered_map<osp::ShapeKey, Ref<Shape>>       m_shapeCache;
+
     osp::active::ACompTransformStorage_t                *m_pTransform{nullptr};
 
 private:
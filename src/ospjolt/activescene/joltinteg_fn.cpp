@@ -26,6 +26,7 @@
 #include "joltinteg_fn.h"          // IWYU pragma: associated
 #include <osp/activescene/basic_fn.h>
 
+#include <algorithm>                 // for std::sort, std::unique, std::partition
 #include <utility>                   // for std::exchange
 #include <cassert>                   // for assert
 
@@ -50,32 +51,60 @@ using osp::Vector3;
 void SysJolt::resize_body_data(ACtxJoltWorld& rCtxWorld)
 {
     std::size_t const capacity = rCtxWorld.m_bodyIds.capacity();
+    rCtxWorld.m_bodyToEnt       .resize(capacity);
+    rCtxWorld.m_bodyFactors     .resize(capacity);
+    rCtxWorld.m_bodyTransforms  .resize(capacity);
 }
 
 
 void SysJolt::update_translate(ACtxPhysics& rCtxPhys, ACtxJoltWorld& rCtxWorld) noexcept
 {
-
     // Origin translation
-    if (Vector3 const translate = std::exchange(rCtxPhys.m_originTranslate, {});
-        ! translate.isZero())
+    Vector3 const translate = std::exchange(rCtxPhys.m_originTranslate, {});
+    if (translate.isZero())
     {
-        PhysicsSystem* pJoltWorld = rCtxWorld.m_pPhysicsSystem.get();
-        BodyIDVector allBodiesIds;
-        pJoltWorld->GetBodies(allBodiesIds);
+        return;
+    }
+
+    PhysicsSystem &rJoltWorld = *rCtxWorld.m_pPhysicsSystem;
+    Vec3 const joltTranslate = Vec3MagnumToJolt(translate);
+
+    BodyIDVector allBodiesIds;
+    rJoltWorld.GetBodies(allBodiesIds);
 
-        BodyInterface &bodyInterface = pJoltWorld->GetBodyInterface();
+    BodyIDVector inBroadPhase;
+    inBroadPhase.reserve(allBodiesIds.size());
 
-        // Translate every jolt body
-        for (BodyID bodyId : allBodiesIds)
+    // Write positions directly with every body mutex locked once, instead of a lock and a
+    // broadphase update per body through BodyInterface::SetPosition. As we are translating the
+    // whole world, we don't need to wake up asleep bodies.
+    {
+        BodyLockMultiWrite lock(rJoltWorld.GetBodyLockInterface(), allBodiesIds.data(), int(allBodiesIds.size()));
+        for (int i = 0; i < int(allBodiesIds.size()); ++i)
         {
-            RVec3 position = bodyInterface.GetPosition(bodyId);
-            Matrix4 matrix;
-            position += Vec3MagnumToJolt(translate);
-            //As we are translating the whole world, we don't need to wake up asleep bodies. 
-            bodyInterface.SetPosition(bodyId, position, EActivation::DontActivate);
+            Body *pBody = lock.GetBody(i);
+            if (pBody == nullptr)
+            {
+                continue;
+            }
+
+            pBody->SetPositionAndRotationInternal(pBody->GetPosition() + joltTranslate, pBody->GetRotation());
+
+            // Bodies removed from the world (e.g. pooled terrain colliders) aren't in the broadphase
+            if (pBody->IsInBroadPhase())
+            {
+                inBroadPhase.push_back(allBodiesIds[i]);
+            }
         }
     }
+
+    // Update all broadphase bounds at once. GetBroadPhaseQuery returns the PhysicsSystem's
+    // BroadPhase, which is only exposed as its query interface. Widened tree nodes are rebuilt
+    // incrementally by the broadphase update of following steps.
+    auto &rBroadPhase = const_cast<BroadPhase&>(static_cast<BroadPhase const&>(rJoltWorld.GetBroadPhaseQuery()));
+    rBroadPhase.NotifyBodiesAABBChanged(inBroadPhase.data(), int(inBroadPhase.size()));
+
+    rCtxWorld.m_originTranslated = true;
 }
 
 using Corrade::Containers::ArrayView;
@@ -85,6 +114,16 @@ void SysJolt::update_world(
         ACtxJoltWorld&              rCtxWorld,
         float                       timestep,
         ACompTransformStorage_t&    rTf) noexcept
+{
+    step_world(rCtxPhys, rCtxWorld, timestep, rTf);
+    write_transforms(rCtxPhys, rCtxWorld, rTf);
+}
+
+void SysJolt::step_world(
+        ACtxPhysics&                rCtxPhys,
+        ACtxJoltWorld&              rCtxWorld,
+        float                       timestep,
+        ACompTransformStorage_t&    rTf) noexcept
 {
     PhysicsSystem *pJoltWorld = rCtxWorld.m_pPhysicsSystem.get();
     BodyInterface &bodyInterface = pJoltWorld->GetBodyInterface();
@@ -99,29 +138,190 @@ void SysJolt::update_world(
 
     rCtxWorld.m_pTransform = std::addressof(rTf);
 
+    // Snapshot of active bodies, sliced between step listeners for force factors. Taken here
+    // instead of from within the listeners, since they must all see the same list.
+    pJoltWorld->GetActiveBodies(EBodyType::RigidBody, rCtxWorld.m_activeBodies);
+
     int collisionSteps = 1;
     pJoltWorld->Update(timestep, collisionSteps, &rCtxWorld.m_temp_allocator, rCtxWorld.m_joltJobSystem.get());
 }
 
+void SysJolt::write_transforms(ACtxPhysics& rCtxPhys, ACtxJoltWorld& rCtxWorld, ACompTransformStorage_t& rTf) noexcept
+{
+    PhysicsSystem &rJoltWorld = *rCtxWorld.m_pPhysicsSystem;
+
+    // No other threads are using Jolt at this point
+    BodyInterface &bodyInterface = rJoltWorld.GetBodyInterfaceNoLock();
+
+    // Bodies that moved this step are the ones active at the start (some may have fallen asleep
+    // during the step), plus ones that were woken up during the step. An origin translation
+    // since the last step moved every body, including sleeping ones.
+    BodyIDVector &rMoved = rCtxWorld.m_movedBodies;
+    if (std::exchange(rCtxWorld.m_originTranslated, false))
+    {
+        rJoltWorld.GetBodies(rMoved);
+    }
+    else
+    {
+        rJoltWorld.GetActiveBodies(EBodyType::RigidBody, rMoved);
+        rMoved.insert(rMoved.end(), rCtxWorld.m_activeBodies.begin(), rCtxWorld.m_activeBodies.end());
+    }
+    std::sort(rMoved.begin(), rMoved.end());
+    rMoved.erase(std::unique(rMoved.begin(), rMoved.end()), rMoved.end());
+
+    // Gather from Jolt into a dense array. Sorted IDs keep this mostly sequential.
+    for (BodyID const joltBodyId : rMoved)
+    {
+        BodyId const bodyId{joltBodyId.GetIndex()};
+        bodyInterface.GetWorldTransform(joltBodyId).StoreFloat4x4(
+                reinterpret_cast<Float4*>(rCtxWorld.m_bodyTransforms[bodyId].data()));
+    }
+
+    // Scatter to transform components
+    rCtxPhys.m_moved.clear();
+    for (BodyID const joltBodyId : rMoved)
+    {
+        BodyId    const bodyId{joltBodyId.GetIndex()};
+        ActiveEnt const ent = rCtxWorld.m_bodyToEnt[bodyId];
+
+        if (ent == lgrn::id_null<ActiveEnt>() || bodyInterface.GetMotionType(joltBodyId) != EMotionType::Dynamic)
+        {
+            continue;
+        }
+
+        rTf.get(ent).m_transform = rCtxWorld.m_bodyTransforms[bodyId];
+        rCtxPhys.m_moved.insert(ent);
+    }
+}
+
+BodyId SysJolt::create_body(
+        ACtxJoltWorld&                  rCtxWorld,
+        ActiveEnt                       ent,
+        BodyCreationSettings const&     settings,
+        ForceFactors_t                  factors)
+{
+    BodyId const bodyId = rCtxWorld.m_bodyIds.create();
+    resize_body_data(rCtxWorld);
+
+    JPH::BodyID const joltBodyId = BToJolt(bodyId);
+    rCtxWorld.m_pPhysicsSystem->GetBodyInterface().CreateBodyWithID(joltBodyId, settings);
+
+    rCtxWorld.m_bodyToEnt[bodyId]   = ent;
+    rCtxWorld.m_bodyFactors[bodyId] = factors;
+    rCtxWorld.m_entToBody.emplace(ent, bodyId);
+    rCtxWorld.m_bodiesToAdd.push_back(joltBodyId);
+
+    return bodyId;
+}
+
+BodyId SysJolt::create_unowned_body(
+        ACtxJoltWorld&                  rCtxWorld,
+        BodyCreationSettings const&     settings)
+{
+    BodyId const bodyId = rCtxWorld.m_bodyIds.create();
+    resize_body_data(rCtxWorld);
+
+    rCtxWorld.m_pPhysicsSystem->GetBodyInterface().CreateBodyWithID(BToJolt(bodyId), settings);
+
+    rCtxWorld.m_bodyToEnt[bodyId]   = lgrn::id_null<ActiveEnt>();
+    rCtxWorld.m_bodyFactors[bodyId] = {};
+
+    return bodyId;
+}
+
+void SysJolt::add_created_bodies(ACtxJoltWorld& rCtxWorld, EActivation activation)
+{
+    BodyIDVector &rToAdd = rCtxWorld.m_bodiesToAdd;
+    if (rToAdd.empty())
+    {
+        return;
+    }
+
+    BodyInterface &bodyInterface = rCtxWorld.m_pPhysicsSystem->GetBodyInterface();
+    int const count = int(rToAdd.size());
+
+    // Bodies are added all at once for performance reasons. Note that this reorders rToAdd.
+    BodyInterface::AddState addState = bodyInterface.AddBodiesPrepare(rToAdd.data(), count);
+    bodyInterface.AddBodiesFinalize(rToAdd.data(), count, addState, activation);
+
+    if (rToAdd.size() >= gc_joltOptimizeBroadPhaseMin)
+    {
+        rCtxWorld.m_pPhysicsSystem->OptimizeBroadPhase();
+    }
+
+    rToAdd.clear();
+}
+
 void SysJolt::remove_components(ACtxJoltWorld& rCtxWorld, ActiveEnt ent) noexcept
 {
     auto itBodyId = rCtxWorld.m_entToBody.find(ent);
-    BodyInterface &bodyInterface = rCtxWorld.m_pPhysicsSystem->GetBodyInterface();
 
     if (itBodyId != rCtxWorld.m_entToBody.end())
     {
         BodyId const bodyId = itBodyId->second;
-        JPH::BodyID joltBodyId = BToJolt(bodyId);
-        bodyInterface.RemoveBody(joltBodyId);
-        bodyInterface.DestroyBody(joltBodyId);
-        rCtxWorld.m_bodyIds.remove(bodyId);
+        rCtxWorld.m_bodiesToRemove.push_back(BToJolt(bodyId));
         rCtxWorld.m_bodyToEnt[bodyId] = lgrn::id_null<ActiveEnt>();
         rCtxWorld.m_entToBody.erase(itBodyId);
     }
 
+    rCtxWorld.m_shapes.remove(ent);
 }
 
-Ref<Shape> SysJolt::create_primitive(ACtxJoltWorld &rCtxWorld, osp::EShape shape, Vec3Arg scale)
+void SysJolt::remove_queued_bodies(ACtxJoltWorld& rCtxWorld) noexcept
+{
+    BodyIDVector &rToRemove = rCtxWorld.m_bodiesToRemove;
+    if (rToRemove.empty())
+    {
+        return;
+    }
+
+    BodyInterface &bodyInterface = rCtxWorld.m_pPhysicsSystem->GetBodyInterface();
+
+    // Bodies created but not added yet are only destroyed
+    if ( ! rCtxWorld.m_bodiesToAdd.empty() )
+    {
+        BodyIDVector &rToAdd = rCtxWorld.m_bodiesToAdd;
+        std::sort(rToRemove.begin(), rToRemove.end());
+        rToAdd.erase(std::remove_if(rToAdd.begin(), rToAdd.end(), [&rToRemove] (JPH::BodyID const joltBodyId)
+        {
+            return std::binary_search(rToRemove.begin(), rToRemove.end(), joltBodyId);
+        }), rToAdd.end());
+    }
+    auto const itNotAdded = std::partition(rToRemove.begin(), rToRemove.end(), [&bodyInterface] (JPH::BodyID const joltBodyId)
+    {
+        return bodyInterface.IsAdded(joltBodyId);
+    });
+
+    if (int const addedCount = int(std::distance(rToRemove.begin(), itNotAdded));
+        addedCount != 0)
+    {
+        bodyInterface.RemoveBodies(rToRemove.data(), addedCount);
+    }
+    bodyInterface.DestroyBodies(rToRemove.data(), int(rToRemove.size()));
+
+    // Ids can only be reused once Jolt destroyed their bodies
+    for (JPH::BodyID const joltBodyId : rToRemove)
+    {
+        rCtxWorld.m_bodyIds.remove(BodyId{joltBodyId.GetIndex()});
+    }
+
+    if (rToRemove.size() >= gc_joltOptimizeBroadPhaseMin)
+    {
+        rCtxWorld.m_pPhysicsSystem->OptimizeBroadPhase();
+    }
+
+    rToRemove.clear();
+}
+
+namespace
+{
+
+// Leading values of osp::ShapeKey that tell apart the kinds of cached shapes. Primitive keys
+// start with their EShape instead, which is never negative.
+constexpr std::int32_t gc_scaledShapeKey    = -1;
+constexpr std::int32_t gc_compoundShapeKey  = -2;
+
+Ref<Shape> make_primitive(EShape shape, Vec3Arg scale)
 {
     switch (shape)
     {
@@ -143,18 +343,76 @@ Ref<Shape> SysJolt::create_primitive(ACtxJoltWorld &rCtxWorld, osp::EShape shape
     }
 }
 
-void SysJolt::scale_shape(Ref<Shape> rShape, Vec3Arg scale) {
-    if (rShape->GetSubType() == EShapeSubType::Scaled) {
-        ScaledShape* rScaledShape = dynamic_cast<ScaledShape*>(rShape.GetPtr());
-        if (rScaledShape != nullptr) 
+} // namespace
+
+Ref<Shape> SysJolt::create_primitive(ACtxJoltWorld &rCtxWorld, osp::EShape shape, Vec3Arg scale)
+{
+    osp::ShapeKey key;
+    key.add(shape).add_lengths(Vec3JoltToMagnum(scale));
+
+    Ref<Shape> &rShape = rCtxWorld.m_shapeCache[std::move(key)];
+    if (rShape == nullptr)
+    {
+        rShape = make_primitive(shape, scale);
+    }
+    return rShape;
+}
+
+Ref<Shape> SysJolt::scale_shape(ACtxJoltWorld &rCtxWorld, Ref<Shape> const& shape, Vec3Arg scale)
+{
+    Shape const *pInner     = shape.GetPtr();
+    Vec3        totalScale  = scale;
+
+    if (shape->GetSubType() == EShapeSubType::Scaled)
+    {
+        auto const *pScaled = static_cast<ScaledShape const*>(shape.GetPtr());
+        pInner      = pScaled->GetInnerShape();
+        totalScale  = scale * pScaled->GetScale();
+    }
+
+    // The cached ScaledShape holds a reference to pInner, keeping the pointer in the key valid
+    osp::ShapeKey key;
+    key.add(gc_scaledShapeKey).add_ptr(pInner).add_lengths(Vec3JoltToMagnum(totalScale));
+
+    Ref<Shape> &rShape = rCtxWorld.m_shapeCache[std::move(key)];
+    if (rShape == nullptr)
+    {
+        rShape = new ScaledShape(pInner, totalScale);
+    }
+    return rShape;
+}
+
+Ref<Shape> SysJolt::create_compound(ACtxJoltWorld &rCtxWorld, ArrayView<JoltCompoundChild const> children)
+{
+    osp::ShapeKey key;
+    key.add(gc_compoundShapeKey).add(std::int32_t(children.size()));
+    for (JoltCompoundChild const& child : children)
+    {
+        key.add_ptr(child.m_shape.GetPtr())
+           .add_lengths(Vec3JoltToMagnum(child.m_position))
+           .add_rotation(QuatJoltToMagnum(child.m_rotation));
+    }
+
+    Ref<Shape> &rShape = rCtxWorld.m_shapeCache[std::move(key)];
+    if (rShape == nullptr)
+    {
+        // Cached compounds are shared, so they can be static instead of mutable
+        StaticCompoundShapeSettings compound;
+        for (JoltCompoundChild const& child : children)
         {
-            rShape = new ScaledShape(rScaledShape->GetInnerShape(), scale * rScaledShape->GetScale());
+            compound.AddShape(child.m_position, child.m_rotation, child.m_shape);
         }
+        rShape = compound.Create().Get();
     }
-    else 
+    return rShape;
+}
+
+void SysJolt::collect_unused_shapes(ACtxJoltWorld &rCtxWorld)
+{
+    std::erase_if(rCtxWorld.m_shapeCache, [] (auto const& entry)
     {
-        rShape = new ScaledShape(rShape, scale);
-    }
+        return entry.second->GetRefCount() == 1;
+    });
 }
 
 float SysJolt::get_inverse_mass_no_lock(PhysicsSystem &physicsSystem,
@@ -180,19 +438,16 @@ void SysJolt::find_shapes_recurse(
         ACompTransformStorage_t const&          rTf,
         ActiveEnt                               ent,
         Matrix4 const&                          transform,
-        CompoundShapeSettings&                  rCompound) noexcept
+        std::vector<JoltCompoundChild>&         rChildren) noexcept
 {
     // Add jolt shape if exists
     if (rCtxWorld.m_shapes.contains(ent))
     {
-        Ref<Shape> rShape = rCtxWorld.m_shapes.get(ent);
-
         // Set transform relative to root body
-        SysJolt::scale_shape(rShape, Vec3MagnumToJolt(transform.scaling()));
-        rCompound.AddShape(
-            Vec3MagnumToJolt(transform.translation()), 
-            QuatMagnumToJolt(osp::Quaternion::fromMatrix(transform.rotation())), 
-            rShape);
+        rChildren.push_back({
+            .m_position = Vec3MagnumToJolt(transform.translation()),
+            .m_rotation = QuatMagnumToJolt(osp::Quaternion::fromMatrix(transform.rotation())),
+            .m_shape    = SysJolt::scale_shape(rCtxWorld, rCtxWorld.m_shapes.get(ent), Vec3MagnumToJolt(transform.scaling()))});
     }
 
     if ( ! rCtxPhys.m_hasColliders.contains(ent) )
@@ -210,46 +465,46 @@ void SysJolt::find_shapes_recurse(
             Matrix4 const childMatrix = transform * rChildTransform.m_transform;
 
             find_shapes_recurse(
-                    rCtxPhys, rCtxWorld, rScnGraph, rTf, child, childMatrix, rCompound);
+                    rCtxPhys, rCtxWorld, rScnGraph, rTf, child, childMatrix, rChildren);
         }
 
     }
 
 }
 
-//TODO this is locking on all bodies. Is it bad ?
-//The easy fix is to provide multiple step listeners for disjoint sets of bodies, which can then run in parallel.
-//It might not be worth it considering this function should be quite fast.
 void PhysicsStepListenerImpl::OnStep(float inDeltaTime, PhysicsSystem &rPhysicsSystem)
 {
+    BodyIDVector const &activeBodies = m_context->m_activeBodies;
+
+    // This listener's slice of active bodies. Slices are disjoint, so listeners running in
+    // parallel never touch the same body.
+    std::size_t const listenerCount = m_context->m_listeners.size();
+    std::size_t const first         = activeBodies.size() * m_index / listenerCount;
+    std::size_t const last          = activeBodies.size() * (m_index + 1) / listenerCount;
+
     //no lock as all bodies are already locked
     BodyInterface &bodyInterface = rPhysicsSystem.GetBodyInterfaceNoLock();
-    for (BodyId bodyId : m_context->m_bodyIds)
+    for (std::size_t i = first; i < last; ++i)
     {
-        JPH::BodyID joltBodyId = BToJolt(bodyId);
-        if (bodyInterface.GetMotionType(joltBodyId) != EMotionType::Dynamic) 
+        JPH::BodyID const joltBodyId = activeBodies[i];
+        BodyId      const bodyId{joltBodyId.GetIndex()};
+
+        ForceFactors_t const factors = m_context->m_bodyFactors[bodyId];
+        if (factors.none() || bodyInterface.GetMotionType(joltBodyId) != EMotionType::Dynamic)
         {
             continue;
         }
 
-        //Transform jolt -> osp
-
-
-        ActiveEnt const ent = m_context->m_bodyToEnt[bodyId];
-        Mat44 worldTranform = bodyInterface.GetWorldTransform(joltBodyId);
-
-        worldTranform.StoreFloat4x4((Float4*)m_context->m_pTransform->get(ent).m_transform.data());
-
         //Force and torque osp -> jolt
         Vector3 force{0.0f};
         Vector3 torque{0.0f};
 
         LGRN_ASSERT(ForceFactors_t{}.size() == 64u);
-        auto const factorsInts = std::initializer_list<std::uint64_t>{m_context->m_bodyFactors[bodyId].to_ullong()};
+        auto const factorsInts = std::initializer_list<std::uint64_t>{factors.to_ullong()};
         auto const factorsBits = lgrn::bit_view(factorsInts);
 
         for (std::size_t const factorIdx : factorsBits.ones())
-        {   
+        {
             ACtxJoltWorld::ForceFactorFunc const& factor = m_context->m_factors[factorIdx];
             factor.m_func(bodyId, *m_context, factor.m_userData, force, torque);
         }
@@ -257,3 +512,50 @@ void PhysicsStepListenerImpl::OnStep(float inDeltaTime, PhysicsSystem &rPhysicsS
         bodyInterface.AddForceAndTorque(joltBodyId, Vec3MagnumToJolt(force), Vec3MagnumToJolt(torque));
     }
 }
+
+JoltLayerTable ospjolt::make_osp_layer_table()
+{
+    JoltLayerTable out;
+
+    out.m_objectToBroadPhase.resize(Layers::NUM_LAYERS);
+    out.m_objectToBroadPhase[Layers::NON_MOVING]    = BroadPhaseLayers::NON_MOVING;
+    out.m_objectToBroadPhase[Layers::MOVING]        = BroadPhaseLayers::MOVING;
+    out.m_objectToBroadPhase[Layers::TERRAIN]       = BroadPhaseLayers::TERRAIN;
+    out.m_objectToBroadPhase[Layers::DEBRIS]        = BroadPhaseLayers::DEBRIS;
+    out.m_objectToBroadPhase[Layers::VEHICLE]       = BroadPhaseLayers::MOVING;
+
+    out.m_broadPhaseNames.resize(BroadPhaseLayers::NUM_LAYERS);
+    out.m_broadPhaseNames[BroadPhaseLayer::Type(BroadPhaseLayers::NON_MOVING)]  = "NON_MOVING";
+    out.m_broadPhaseNames[BroadPhaseLayer::Type(BroadPhaseLayers::TERRAIN)]     = "TERRAIN";
+    out.m_broadPhaseNames[BroadPhaseLayer::Type(BroadPhaseLayers::MOVING)]      = "MOVING";
+    out.m_broadPhaseNames[BroadPhaseLayer::Type(BroadPhaseLayers::DEBRIS)]      = "DEBRIS";
+
+    for (ObjectLayer const dynamic : {Layers::MOVING, Layers::DEBRIS, Layers::VEHICLE})
+    {
+        for (ObjectLayer other = 0; other < Layers::NUM_LAYERS; ++other)
+        {
+            out.set_collides(dynamic, other);
+        }
+    }
+
+    return out;
+}
+
+ObjectVsBroadPhaseLayerFilterImpl::ObjectVsBroadPhaseLayerFilterImpl(JoltLayerTable const& layers)
+ : m_objectLayerCount   {layers.object_layer_count()}
+ , m_broadPhaseCount    {layers.broadphase_layer_count()}
+{
+    m_collides.resize(std::size_t(m_objectLayerCount) * m_broadPhaseCount, false);
+
+    for (ObjectLayer a = 0; a < m_objectLayerCount; ++a)
+    {
+        for (ObjectLayer b = 0; b < m_objectLayerCount; ++b)
+        {
+            if (layers.collides(a, b))
+            {
+                auto const bpLayer = BroadPhaseLayer::Type(layers.m_objectToBroadPhase[b]);
+                m_collides[std::size_t(a) * m_broadPhaseCount + bpLayer] = true;
+            }
+        }
+    }
+}
@@ -30,7 +30,7 @@
 #include <osp/activescene/basic.h>
 #include <osp/activescene/physics.h>
 
-#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Containers/ArrayViewStl.h>
 
 // IWYU pragma: no_include <cstdint>
 // IWYU pragma: no_include <stdint.h>
@@ -53,6 +53,11 @@ public:
     /**
      * @brief Respond to scene origin shifts by translating all rigid bodies
      *
+     * Body positions are written directly under a single multi-body lock, then the broadphase
+     * is notified of all changed bounds in one call. Must not run while the world is stepping.
+     * Sleeping bodies are moved without waking them, but still count as moved by the next step
+     * (ACtxPhysics::m_moved).
+     *
      * @param rCtxPhys      [ref] Generic physics context with m_originTranslate
      * @param rCtxWorld     [ref] Jolt World
      */
@@ -63,6 +68,9 @@ public:
     /**
      * @brief Step the entire Jolt World forward in time
      *
+     * Force factors are applied to active bodies by ACtxJoltWorld::m_listeners in parallel during
+     * the step. Transforms of moved bodies are written back afterwards, see write_transforms.
+     *
      * @param rCtxPhys      [ref] Generic Physics context. Updates linear and angular velocity.
      * @param rCtxWorld     [ref] Jolt world to update
      * @param timestep      [in] Time to step world, passed to Jolt update
@@ -74,23 +82,127 @@ public:
             float                                   timestep,
             osp::active::ACompTransformStorage_t&   rTf) noexcept;
 
+    /**
+     * @brief Step the Jolt World without writing transforms back; first half of update_world
+     */
+    static void step_world(
+            ACtxPhysics&                            rCtxPhys,
+            ACtxJoltWorld&                          rCtxWorld,
+            float                                   timestep,
+            osp::active::ACompTransformStorage_t&   rTf) noexcept;
+
+    /**
+     * @brief Copy world transforms of bodies that moved in the last step to their entities
+     *
+     * Transforms are first gathered into ACtxJoltWorld::m_bodyTransforms, then scattered to rTf
+     * in a single pass. Only dynamic bodies are written.
+     *
+     * @param rCtxPhys      [ref] Generic physics context, ACtxPhysics::m_moved is rewritten
+     * @param rCtxWorld     [ref] Jolt world, just after stepping
+     * @param rTf           [ref] Transforms to write to
+     */
+    static void write_transforms(
+            ACtxPhysics&                            rCtxPhys,
+            ACtxJoltWorld&                          rCtxWorld,
+            ACompTransformStorage_t&                rTf) noexcept;
+
+    /**
+     * @brief Create a body for an entity, without adding it to the world yet
+     *
+     * The body is queued in ACtxJoltWorld::m_bodiesToAdd; call add_created_bodies once all of a
+     * frame's bodies are created.
+     *
+     * @return Id of the new body
+     */
+    static BodyId create_body(
+            ACtxJoltWorld&                  rCtxWorld,
+            ActiveEnt                       ent,
+            BodyCreationSettings const&     settings,
+            ForceFactors_t                  factors);
+
+    /**
+     * @brief Create a body not attached to any entity, eg. a terrain chunk collider
+     *
+     * Reserves a BodyId the same way as create_body, but the body is neither queued nor added
+     * to the world. The caller adds and removes it, and can reuse it later with a new shape.
+     *
+     * @return Id of the new body
+     */
+    static BodyId create_unowned_body(
+            ACtxJoltWorld&                  rCtxWorld,
+            BodyCreationSettings const&     settings);
+
+    /**
+     * @brief Add all bodies queued by create_body to the world in a single batch
+     *
+     * Uses Jolt's AddBodiesPrepare/AddBodiesFinalize to insert them into the broadphase at once,
+     * then optimizes the broadphase if at least gc_joltOptimizeBroadPhaseMin were added.
+     */
+    static void add_created_bodies(
+            ACtxJoltWorld&                  rCtxWorld,
+            EActivation                     activation = EActivation::Activate);
+
+    /**
+     * @brief Detach an entity's body and shape, queueing the body for remove_queued_bodies
+     */
     static void remove_components(
             ACtxJoltWorld& rCtxWorld, ActiveEnt ent) noexcept;
 
+    /**
+     * @brief Remove and destroy all bodies queued by remove_components in a single batch
+     *
+     * Optimizes the broadphase afterwards if at least gc_joltOptimizeBroadPhaseMin were removed.
+     */
+    static void remove_queued_bodies(ACtxJoltWorld& rCtxWorld) noexcept;
+
+    /**
+     * @brief Get a shared primitive shape from ACtxJoltWorld::m_shapeCache, creating it if needed
+     *
+     * Shapes with the same EShape and (quantized) scale are the same Shape. Returned shapes are
+     * shared and must not be modified.
+     */
     static Ref<Shape> create_primitive(ACtxJoltWorld &rCtxWorld, osp::EShape shape, Vec3Arg scale);
 
+    /**
+     * @brief Get a shared ScaledShape of a shape, creating it if needed
+     *
+     * Scaling an existing ScaledShape multiplies scales instead of nesting.
+     */
+    static Ref<Shape> scale_shape(ACtxJoltWorld &rCtxWorld, Ref<Shape> const& shape, Vec3Arg scale);
+
+    /**
+     * @brief Get a shared compound shape, creating it if needed
+     *
+     * Compounds are keyed by their child shapes and (quantized) child transforms, so identical
+     * vehicles share a single compound built from shapes that are themselves cached.
+     */
+    static Ref<Shape> create_compound(ACtxJoltWorld &rCtxWorld, Corrade::Containers::ArrayView<JoltCompoundChild const> children);
+
+    /**
+     * @brief Release cached shapes no longer used by any body or component
+     *
+     * Children of a released compound may only be released by a later call.
+     */
+    static void collect_unused_shapes(ACtxJoltWorld &rCtxWorld);
+
     template<typename IT_T>
     static void update_delete(
             ACtxJoltWorld &rCtxWorld, IT_T first, IT_T const& last) noexcept
     {
+        if (first == last)
+        {
+            return;
+        }
+
         while (first != last)
         {
             remove_components(rCtxWorld, *first);
             std::advance(first, 1);
         }
+
+        remove_queued_bodies(rCtxWorld);
+        collect_unused_shapes(rCtxWorld);
     }
-    //Apply a scale to a shape.
-    static void scale_shape(Ref<Shape> rShape, Vec3Arg scale);
 
     //Get the inverse mass of a jolt body
     static float get_inverse_mass_no_lock(PhysicsSystem& physicsSystem, BodyId bodyId);
@@ -98,8 +210,8 @@ public:
 private:
 
     /**
-     * @brief Find shapes in an entity and its hierarchy, and add them to
-     *        a Jolt Compound Shape
+     * @brief Find shapes in an entity and its hierarchy, and collect them as
+     *        children of a Jolt Compound Shape
      *
      * @param rCtxPhys      [in] Generic Physics context.
      * @param rCtxWorld     [ref] Jolt world
@@ -107,7 +219,7 @@ private:
      * @param rTf           [in] Storage for relative hierarchy transforms
      * @param ent           [in] Entity to search
      * @param transform     [in] Transform relative to root (part of recursion)
-     * @param rCompound     [out] Jolt CompoundShapeSettings to add shapes to
+     * @param rChildren     [out] Compound children to add shapes to, see create_compound
      */
     static void find_shapes_recurse(
             ACtxPhysics const&                      rCtxPhys,
@@ -116,7 +228,7 @@ private:
             ACompTransformStorage_t const&          rTf,
             ActiveEnt                               ent,
             osp::Matrix4 const&                     transform,
-            CompoundShapeSettings&                  rCompound) noexcept;
+            std::vector<JoltCompoundChild>&         rChildren) noexcept;
 
 };
 
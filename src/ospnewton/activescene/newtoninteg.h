@@ -28,6 +28,7 @@
 
 #include <osp/activescene/basic.h>
 #include <osp/core/id_map.h>
+#include <osp/scientific/shape_key.h>
 
 #include <Newton.h>
 
@@ -36,6 +37,12 @@
 
 #include <entt/core/any.hpp>
 
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 
 namespace ospnewton
 {
@@ -66,6 +73,12 @@ using ColliderStorage_t = osp::Storage_t<osp::active::ActiveEnt, NwtColliderPtr_
 struct ACtxNwtWorld
 {
 
+    /**
+     * @brief Force factor, called from Newton worker threads during NewtonUpdate
+     *
+     * Must only read shared data; many bodies are evaluated at the same time. Transforms
+     * (m_pTransform) are safe to read, since they are only written after the update.
+     */
     struct ForceFactorFunc
     {
         using UserData_t = std::array<void*, 6u>;
@@ -80,10 +93,33 @@ struct ACtxNwtWorld
         void operator() (NewtonWorld* pNwtWorld) { NewtonDestroy(pNwtWorld); }
     };
 
+    /**
+     * @brief Transforms written by a single Newton worker thread, merged after NewtonUpdate
+     */
+    struct ThreadStaging
+    {
+        std::vector< std::pair<BodyId, osp::Matrix4> > m_transforms;
+    };
+
+    /**
+     * @brief Compound collision shared by content, see SysNewton::find_compound
+     */
+    struct CachedCompound
+    {
+        NwtColliderPtr_t    m_compound;
+
+        /// Bodies created from m_compound, see SysNewton::set_body_compound
+        std::uint32_t       m_bodyCount{};
+    };
+
     ACtxNwtWorld(int threadCount)
      : m_world(NewtonCreate())
     {
         NewtonWorldSetUserData(m_world.get(), this);
+        NewtonSetThreadsCount(m_world.get(), std::max(threadCount, 1));
+
+        // Newton may clamp the thread count, use what it actually picked
+        m_perThread.resize(std::size_t(std::max(NewtonGetThreadsCount(m_world.get()), 1)));
     }
 
     // note: important that m_nwtBodies and m_nwtColliders are destructed
@@ -102,6 +138,23 @@ struct ACtxNwtWorld
 
     ColliderStorage_t                               m_colliders;
 
+    /// Unit primitives indexed by EShape. SysNewton::create_primative returns instances of
+    /// these, which share their geometry
+    std::array<NwtColliderPtr_t, 6>                 m_primitives;
+
+    /// Compound collisions shared by content, see SysNewton::find_compound
+    std::unordered_map<osp::ShapeKey, CachedCompound> m_compoundCache;
+
+    /// Cached compound each body was created from, or nullptr. Points into m_compoundCache.
+    std::vector<CachedCompound*>                    m_bodyCompound;
+
+    /// Indexed by NwtThreadIndex_t
+    std::vector<ThreadStaging>                      m_perThread;
+
+    /// Set by SysNewton::update_translate, which also moves sleeping bodies. The next
+    /// merge_transforms then reads back every body instead of only staged ones.
+    bool                                            m_originTranslated{false};
+
     osp::active::ACompTransformStorage_t            *m_pTransform;
 };
 
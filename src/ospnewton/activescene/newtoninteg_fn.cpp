@@ -79,11 +79,52 @@ void SysNewton::cb_set_transform(
     ACtxNwtWorld &rWorldCtx = SysNewton::context_from_nwtbody(pBody);
     BodyId const bodyId     = SysNewton::get_userdata_bodyid(pBody);
 
-    ActiveEnt const ent = rWorldCtx.m_bodyToEnt[bodyId];
-
-    NewtonBodyGetMatrix(pBody, rWorldCtx.m_pTransform->get(ent).m_transform.data());
+    // Called from worker threads. Stage per-thread and write to m_pTransform later in
+    // merge_transforms, so force factors on other threads can safely read transforms.
+    auto &rTransforms = rWorldCtx.m_perThread[std::size_t(thread)].m_transforms;
+    NewtonBodyGetMatrix(pBody, rTransforms.emplace_back(bodyId, Matrix4{}).second.data());
 } // cb_set_transform()
 
+void SysNewton::merge_transforms(ACtxPhysics& rCtxPhys, ACtxNwtWorld& rCtxWorld, ACompTransformStorage_t& rTf) noexcept
+{
+    rCtxPhys.m_moved.clear();
+
+    // Sleeping bodies moved by update_translate don't go through cb_set_transform
+    if (std::exchange(rCtxWorld.m_originTranslated, false))
+    {
+        for (BodyId const bodyId : rCtxWorld.m_bodyIds)
+        {
+            ActiveEnt const ent = rCtxWorld.m_bodyToEnt[bodyId];
+            if (ent != lgrn::id_null<ActiveEnt>())
+            {
+                NewtonBodyGetMatrix(rCtxWorld.m_bodyPtrs[bodyId].get(), rTf.get(ent).m_transform.data());
+                rCtxPhys.m_moved.insert(ent);
+            }
+        }
+
+        for (ACtxNwtWorld::ThreadStaging &rStaging : rCtxWorld.m_perThread)
+        {
+            rStaging.m_transforms.clear();
+        }
+        return;
+    }
+
+    // Newton only calls cb_set_transform for bodies that moved, sleeping ones aren't staged
+    for (ACtxNwtWorld::ThreadStaging &rStaging : rCtxWorld.m_perThread)
+    {
+        for (auto const& [bodyId, matrix] : rStaging.m_transforms)
+        {
+            ActiveEnt const ent = rCtxWorld.m_bodyToEnt[bodyId];
+            if (ent != lgrn::id_null<ActiveEnt>())
+            {
+                rTf.get(ent).m_transform = matrix;
+                rCtxPhys.m_moved.insert(ent);
+            }
+        }
+        rStaging.m_transforms.clear();
+    }
+}
+
 
 void SysNewton::resize_body_data(ACtxNwtWorld& rCtxWorld)
 {
@@ -91,32 +132,83 @@ void SysNewton::resize_body_data(ACtxNwtWorld& rCtxWorld)
     rCtxWorld.m_bodyPtrs    .resize(capacity);
     rCtxWorld.m_bodyToEnt   .resize(capacity);
     rCtxWorld.m_bodyFactors .resize(capacity);
+    rCtxWorld.m_bodyCompound.resize(capacity, nullptr);
 }
 
 NwtColliderPtr_t SysNewton::create_primative(
         ACtxNwtWorld&   rCtxWorld,
         EShape          shape)
 {
-    NewtonWorld* pNwtWorld = rCtxWorld.m_world.get();
-    NewtonCollision* pCollision;
-    switch (shape)
+    NwtColliderPtr_t &rPrimitive = rCtxWorld.m_primitives.at(std::size_t(shape));
+
+    if (rPrimitive == nullptr)
+    {
+        NewtonWorld* pNwtWorld = rCtxWorld.m_world.get();
+        NewtonCollision* pCollision;
+        switch (shape)
+        {
+        case EShape::Sphere:
+            pCollision = NewtonCreateSphere(pNwtWorld, 1.0f, 0, nullptr);
+            break;
+        case EShape::Box:
+            pCollision = NewtonCreateBox(pNwtWorld, 2, 2, 2, 0, nullptr);
+            break;
+        case EShape::Cylinder:
+            pCollision = NewtonCreateCylinder(pNwtWorld, 1, 1, 2, 0, nullptr);
+            break;
+        default:
+            // TODO: support other shapes, sphere is used for now
+            pCollision = NewtonCreateSphere(pNwtWorld, 1.0f, 0, nullptr);
+            break;
+        }
+        rPrimitive.reset(pCollision);
+    }
+
+    return NwtColliderPtr_t{NewtonCollisionCreateInstance(rPrimitive.get())};
+}
+
+NwtColliderPtr_t SysNewton::find_compound(
+        ACtxNwtWorld&           rCtxWorld,
+        osp::ShapeKey const&    key)
+{
+    auto const it = rCtxWorld.m_compoundCache.find(key);
+    if (it == rCtxWorld.m_compoundCache.end())
     {
-    case EShape::Sphere:
-        pCollision = NewtonCreateSphere(pNwtWorld, 1.0f, 0, nullptr);
-        break;
-    case EShape::Box:
-        pCollision = NewtonCreateBox(pNwtWorld, 2, 2, 2, 0, nullptr);
-        break;
-    case EShape::Cylinder:
-        pCollision = NewtonCreateCylinder(pNwtWorld, 1, 1, 2, 0, nullptr);
-        break;
-    default:
-        // TODO: support other shapes, sphere is used for now
-        pCollision = NewtonCreateSphere(pNwtWorld, 1.0f, 0, nullptr);
-        break;
+        return nullptr;
     }
+    return NwtColliderPtr_t{NewtonCollisionCreateInstance(it->second.m_compound.get())};
+}
 
-    return NwtColliderPtr_t{pCollision};
+void SysNewton::cache_compound(
+        ACtxNwtWorld&           rCtxWorld,
+        osp::ShapeKey           key,
+        NwtColliderPtr_t        pCompound)
+{
+    // Replacing a compound keeps its body count, since those bodies still use the key
+    rCtxWorld.m_compoundCache[std::move(key)].m_compound = std::move(pCompound);
+}
+
+void SysNewton::set_body_compound(
+        ACtxNwtWorld&           rCtxWorld,
+        BodyId                  bodyId,
+        osp::ShapeKey const&    key)
+{
+    ACtxNwtWorld::CachedCompound *&rpBodyCompound = rCtxWorld.m_bodyCompound[bodyId];
+    if (rpBodyCompound != nullptr)
+    {
+        -- rpBodyCompound->m_bodyCount;
+    }
+
+    rpBodyCompound = &rCtxWorld.m_compoundCache.at(key);
+    ++ rpBodyCompound->m_bodyCount;
+}
+
+void SysNewton::collect_unused_compounds(ACtxNwtWorld &rCtxWorld)
+{
+    std::erase_if(rCtxWorld.m_compoundCache, [] (auto const& entry)
+    {
+        return entry.second.m_bodyCount == 0;
+    });
 }
 
 void SysNewton::orient_collision(
@@ -163,6 +255,8 @@ void SysNewton::update_translate(ACtxPhysics& rCtxPhys, ACtxNwtWorld& rCtxWorld)
             matrix.translation() += translate;
             NewtonBodySetMatrix(pBody, matrix.data());
         }
+
+        rCtxWorld.m_originTranslated = true;
     }
 }
 
@@ -174,6 +268,16 @@ void SysNewton::update_world(
         float                       timestep,
         ACtxSceneGraph const&       rScnGraph,
         ACompTransformStorage_t&    rTf) noexcept
+{
+    step_world(rCtxPhys, rCtxWorld, timestep, rTf);
+    merge_transforms(rCtxPhys, rCtxWorld, rTf);
+}
+
+void SysNewton::step_world(
+        ACtxPhysics&                rCtxPhys,
+        ACtxNwtWorld&               rCtxWorld,
+        float                       timestep,
+        ACompTransformStorage_t&    rTf) noexcept
 {
     NewtonWorld const* pNwtWorld = rCtxWorld.m_world.get();
 
@@ -200,6 +304,12 @@ void SysNewton::remove_components(ACtxNwtWorld& rCtxWorld, ActiveEnt ent) noexce
     {
         BodyId const bodyId = itBodyId->second;
         rCtxWorld.m_bodyPtrs[bodyId].reset();
+
+        if (ACtxNwtWorld::CachedCompound *pCompound = std::exchange(rCtxWorld.m_bodyCompound[bodyId], nullptr);
+            pCompound != nullptr)
+        {
+            -- pCompound->m_bodyCount;
+        }
         rCtxWorld.m_bodyToEnt[bodyId] = lgrn::id_null<ActiveEnt>();
         rCtxWorld.m_entToBody.erase(itBodyId);
     }
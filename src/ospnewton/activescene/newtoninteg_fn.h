@@ -57,10 +57,50 @@ public:
 
     static void resize_body_data(ACtxNwtWorld& rCtxWorld);
 
+    /**
+     * @brief Create an instance of a unit primitive collision
+     *
+     * Instances share geometry through ACtxNwtWorld::m_primitives; each can still be given its
+     * own matrix and scale with orient_collision.
+     */
     [[nodiscard]] static NwtColliderPtr_t create_primative(
             ACtxNwtWorld&           rCtxWorld,
             osp::EShape       shape);
 
+    /**
+     * @brief Create an instance of a compound collision cached with cache_compound
+     *
+     * @return New instance, or nullptr if nothing is cached for key
+     */
+    [[nodiscard]] static NwtColliderPtr_t find_compound(
+            ACtxNwtWorld&           rCtxWorld,
+            osp::ShapeKey const&    key);
+
+    /**
+     * @brief Cache a finished compound collision for find_compound, usually keyed by the
+     *        EShape, transform, and scale of each child
+     */
+    static void cache_compound(
+            ACtxNwtWorld&           rCtxWorld,
+            osp::ShapeKey           key,
+            NwtColliderPtr_t        pCompound);
+
+    /**
+     * @brief Record that a body was created from a compound cached under key
+     *
+     * The compound stays cached while any body created from it exists. Must be called before
+     * the next update_delete, or the compound may already be released.
+     */
+    static void set_body_compound(
+            ACtxNwtWorld&           rCtxWorld,
+            BodyId                  bodyId,
+            osp::ShapeKey const&    key);
+
+    /**
+     * @brief Release cached compounds no longer used by any body
+     */
+    static void collect_unused_compounds(ACtxNwtWorld &rCtxWorld);
+
 
     static void orient_collision(
             NewtonCollision const*  pCollision,
@@ -110,6 +150,30 @@ public:
             ACtxSceneGraph const&                   rScnGraph,
             osp::active::ACompTransformStorage_t&   rTf) noexcept;
 
+    /**
+     * @brief Step the Newton World, leaving transforms staged; first half of update_world
+     */
+    static void step_world(
+            ACtxPhysics&                            rCtxPhys,
+            ACtxNwtWorld&                           rCtxWorld,
+            float                                   timestep,
+            osp::active::ACompTransformStorage_t&   rTf) noexcept;
+
+    /**
+     * @brief Write transforms staged by cb_set_transform to transform components
+     *
+     * Called by update_world after NewtonUpdate, once all worker threads are done. After an
+     * update_translate, every body is read back instead, see ACtxNwtWorld::m_originTranslated.
+     *
+     * @param rCtxPhys      [ref] Generic physics context, ACtxPhysics::m_moved is rewritten
+     * @param rCtxWorld     [ref] Newton world with ACtxNwtWorld::m_perThread to clear
+     * @param rTf           [ref] Transforms to write to
+     */
+    static void merge_transforms(
+            ACtxPhysics&                            rCtxPhys,
+            ACtxNwtWorld&                           rCtxWorld,
+            osp::active::ACompTransformStorage_t&   rTf) noexcept;
+
     static void remove_components(
             ACtxNwtWorld& rCtxWorld, ActiveEnt ent) noexcept;
 
@@ -117,11 +181,18 @@ public:
     static void update_delete(
             ACtxNwtWorld &rCtxWorld, IT_T first, IT_T const& last) noexcept
     {
+        if (first == last)
+        {
+            return;
+        }
+
         while (first != last)
         {
             remove_components(rCtxWorld, *first);
             std::advance(first, 1);
         }
+
+        collect_unused_compounds(rCtxWorld);
     }
 
     static ACtxNwtWorld& context_from_nwtbody(NewtonBody const* const pBody)
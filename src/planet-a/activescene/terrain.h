@@ -24,6 +24,7 @@
  */
 #pragma once
 
+#include "../chunk_cache.h"
 #include "../chunk_generate.h"
 #include "../geometry.h"
 #include "../skeleton_subdiv.h"
@@ -45,7 +46,15 @@ struct ACtxTerrainFrame
 {
     /// Position of scene's (0, 0, 0) origin point from the terrain's frame of reference.
     osp::Vector3l       position;
+
+    /// Rotates directions in the terrain's frame of reference into the scene's. Its inverse
+    /// brings scene positions (relative to the scene origin) into the terrain's frame.
     osp::Quaterniond    rotation;
+
+    /// Translation applied to everything in the scene by floating origin shifts, accumulated
+    /// until consumed. Physics moves its bodies by this, see ACtxPhysics::m_originTranslate.
+    osp::Vector3        sceneTranslate;
+
     bool                active      {false};
 };
 
@@ -59,6 +68,9 @@ struct ACtxTerrain
 
     planeta::ChunkMeshBufferInfo        chunkInfo{};
     planeta::BasicChunkMeshGeometry     chunkGeom;
+    planeta::ChunkMeshCompactGeometry   chunkGeomCompact;   ///< Optional, see is_used()
+
+    planeta::ChunkFillCache             chunkCache;         ///< Optional, see is_used()
 
     planeta::ChunkScratchpad            chunkSP;
     planeta::SkeletonSubdivScratchpad   scratchpad;
@@ -66,6 +78,52 @@ struct ACtxTerrain
     osp::draw::MeshIdOwner_t            terrainMesh;
 };
 
+/**
+ * @brief Level of detail of one terrain among many sharing a global chunk budget
+ */
+struct TerrainLod
+{
+    /// Approximate radius of the planet on screen in pixels, see SysTerrainIco::screen_size
+    float           screenSize      {};
+
+    /// Max number of chunks this terrain should use, see SysTerrainIco::distribute_chunk_budget
+    std::uint32_t   chunkLimit      {};
+
+    /// Multiplier for subdivision distance thresholds. 1.0 is full detail.
+    double          distanceScale   {1.0};
+};
+
+/**
+ * @brief Terrain chunks that have physics colliders, see SysTerrainCollision
+ *
+ * Only chunks near physics bodies get colliders. The physics integration creates, reuses, and
+ * releases the actual colliders according to added and removed.
+ */
+struct ACtxTerrainCollision
+{
+    /// Chunks closer than this to a body get colliders, in meters past the chunk's own radius
+    float                                   margin          {16.0f};
+
+    /// Chunks that have colliders
+    lgrn::IdSetStl<ChunkId>                 active;
+
+    /// Skeleton triangle and stitch of each active chunk at the time its collider was built.
+    /// A different triangle means the ChunkId was reused, a different stitch means the chunk's
+    /// edge triangles were redone; either way the collider is rebuilt.
+    osp::KeyedVec<ChunkId, SkTriId>         builtTri;
+    osp::KeyedVec<ChunkId, ChunkStitch>     builtStitch;
+
+    /// Chunks that need a collider since the last update. A ChunkId can be in both removed and
+    /// added if its collider needs rebuilding, so handle removed first.
+    std::vector<ChunkId>                    added;
+
+    /// Chunks that no longer need a collider since the last update
+    std::vector<ChunkId>                    removed;
+
+    /// Positions of physics bodies in the scene, filled by the caller of SysTerrainCollision::update
+    std::vector<osp::Vector3>               bodyPositions;
+};
+
 struct ACtxTerrainIco
 {
     /// Planet lowest ground level in meters. Lowest valley.
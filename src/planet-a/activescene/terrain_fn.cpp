@@ -0,0 +1,750 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "terrain_fn.h"
+
+#include "../icosahedron.h"
+
+#include <osp/core/math_int64.h>
+#include <osp/util/logging.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using osp::ArrayView;
+using osp::MaybeNewId;
+using osp::Quaterniond;
+using osp::Vector3;
+using osp::Vector3d;
+using osp::Vector3l;
+using osp::Vector3u;
+using osp::ZeroInit;
+using osp::as_2d;
+
+namespace planeta
+{
+
+void SysTerrainIco::initialize(
+        TerrainIcoSpecs             const &specs,
+        ACtxTerrainFrame                  &rTerrainFrame,
+        ACtxTerrain                       &rTerrain,
+        ACtxTerrainIco                    &rTerrainIco)
+{
+    rTerrainFrame.active = true;
+
+    // ## Create initial icosahedron skeleton
+
+    rTerrainIco.radius          = specs.radius;
+    rTerrainIco.height          = specs.height;
+    rTerrain.skData.precision   = specs.skelPrecision;
+    rTerrain.skeleton = create_skeleton_icosahedron(
+            rTerrainIco.radius,
+            rTerrainIco.icoVrtx,
+            rTerrainIco.icoGroups,
+            rTerrainIco.icoTri,
+            rTerrain.skData);
+
+    rTerrain.skeleton.levelMax = specs.skelMaxSubdivLevels;
+
+    // ## Assign skeleton icosahedron position data
+
+    rTerrain.skData.resize(rTerrain.skeleton);
+
+    double const maxRadius = rTerrainIco.radius + rTerrainIco.height;
+
+    for (SkTriGroupId const groupId : rTerrainIco.icoGroups)
+    {
+        ico_calc_sphere_tri_center(groupId, maxRadius, rTerrainIco.height, rTerrain.skeleton, rTerrain.skData);
+    }
+
+    // ## Prepare the skeleton subdiv scratchpad.
+    // This contains intermediate variables used when subdividing the triangle skeleton.
+
+    SkeletonSubdivScratchpad &rSP = rTerrain.scratchpad;
+    rSP.resize(rTerrain.skeleton);
+    for (SkTriGroupId const groupId : rTerrainIco.icoGroups)
+    {
+        // Notify subsequent functions of the newly added initial icosahedron faces
+        rSP.surfaceAdded.insert(tri_id(groupId, 0));
+        rSP.surfaceAdded.insert(tri_id(groupId, 1));
+        rSP.surfaceAdded.insert(tri_id(groupId, 2));
+        rSP.surfaceAdded.insert(tri_id(groupId, 3));
+    }
+
+    // Set function pointer to apply spherical curvature to the skeleton on subdivision.
+    // Spherical planets are not hard-coded into subdivision logic, it's intended to work
+    // to work for non-spherical shapes too.
+    rTerrain.scratchpad.onSubdivUserData[0] = &rTerrainIco;
+    rSP.onSubdiv = [] (
+            SkTriId                             tri,
+            SkTriGroupId                        groupId,
+            std::array<SkVrtxId, 3>             corners,
+            std::array<MaybeNewId<SkVrtxId>, 3> middles,
+            SubdivTriangleSkeleton              &rSkel,
+            SkeletonVertexData                  &rSkData,
+            SkeletonSubdivScratchpad::UserData_t userData) noexcept
+    {
+        auto const& rTerrainIco = *reinterpret_cast<ACtxTerrainIco*>(userData[0]);
+        ico_calc_middles(rTerrainIco.radius, corners, middles, rSkData);
+        ico_calc_sphere_tri_center(groupId, rTerrainIco.radius + rTerrainIco.height, rTerrainIco.height, rSkel, rSkData);
+    };
+
+    // Nothing to do on un-subdivide
+    rSP.onUnsubdiv = [] (
+            SkTriId                         tri,
+            SkeletonTriangle                &rTri,
+            SubdivTriangleSkeleton          &rSkel,
+            SkeletonVertexData              &rSkData,
+            SkeletonSubdivScratchpad::UserData_t userData) noexcept
+    { };
+
+    set_distance_thresholds(1.0, rTerrain, rTerrainIco);
+
+    // ## Prepare Chunk Skeleton
+
+    std::uint8_t const chunkSubdivLevels = specs.chunkSubdivLevels;
+
+    rTerrain.skChunks = make_skeleton_chunks(chunkSubdivLevels);
+
+    // Approximate max number of chunks. Determined experimentally with margin. Surprisingly linear.
+    std::uint32_t const maxChunksRequested = (specs.maxChunks != 0)
+                                           ? specs.maxChunks
+                                           : 42 * specs.skelMaxSubdivLevels + 30;
+
+    // ChunkId is 16-bit. Capacity is rounded up to whole 64-bit blocks, so leave room for that
+    // below the null ID.
+    constexpr std::uint32_t maxChunkIds = std::numeric_limits<std::uint16_t>::max() - 64u;
+    if (maxChunksRequested > maxChunkIds)
+    {
+        OSP_LOG_WARN("Terrain maxChunks {} is more than ChunkId can address, clamped to {}",
+                     maxChunksRequested, maxChunkIds);
+    }
+    std::uint32_t const maxChunksApprox = std::min(maxChunksRequested, maxChunkIds);
+
+    // Approximate max number of shared vertices. Determined experimentally, roughly 60% of all
+    // vertices end up being shared. Margin is inherited from maxChunksApprox.
+    std::uint32_t const maxVrtxApprox = maxChunksApprox * rTerrain.skChunks.m_chunkSharedCount;
+    std::uint32_t const maxSharedVrtxApprox = std::uint32_t(0.6f * float(maxVrtxApprox));
+
+    rTerrain.skChunks.chunk_reserve(std::uint16_t(maxChunksApprox));
+    rTerrain.skChunks.shared_reserve(maxSharedVrtxApprox);
+
+    // ## Prepare Chunk geometry and buffer information
+
+    rTerrain.chunkInfo = make_chunk_mesh_buffer_info(rTerrain.skChunks);
+    rTerrain.chunkGeom.resize(rTerrain.skChunks, rTerrain.chunkInfo);
+
+    // Compact positions are relative to an origin kept within maxRadius of the planet's center,
+    // so they're never further than the diameter away. This only affects range, not precision.
+    int const compactExponent = compact_pos_exponent(2.0 * maxRadius);
+    rTerrain.chunkGeomCompact.resize(rTerrain.chunkInfo, specs.compactNormals, compactExponent);
+
+    // ## Prepare Chunk scratchpad
+
+    rTerrain.chunkSP.lut = make_chunk_vrtx_subdiv_lut(chunkSubdivLevels);
+    rTerrain.chunkSP.resize(rTerrain.skChunks);
+
+    // ## Prepare Chunk cache
+
+    rTerrain.chunkCache.resize(specs.chunkCacheBytes, rTerrain.chunkInfo.fillVrtxCount, rTerrain.skChunks.m_chunkIds.capacity());
+
+    OSP_LOG_INFO("Terrain Chunk Properties:\n"
+                 "* MaxChunks: {}\n"
+                 "* FillVerticesPerChunk: {}\n"
+                 "* SharedVerticesPerChunk: {}\n"
+                 "* MaxTrianglesPerChunk: {}\n"
+                 "* MaxSharedVertices: {}\n"
+                 "* VertexBufferSize: {} bytes\n"
+                 "* CompactVertexBufferSize: {} bytes\n"
+                 "* IndexBufferSize: {} bytes",
+                 rTerrain.skChunks.m_chunkIds.capacity(),
+                 rTerrain.chunkInfo.fillVrtxCount,
+                 rTerrain.skChunks.m_chunkSharedCount,
+                 rTerrain.chunkInfo.chunkMaxFaceCount,
+                 rTerrain.skChunks.m_sharedIds.capacity(),
+                 fmt::group_digits(rTerrain.chunkGeom.vrtxBuffer.size()),
+                 fmt::group_digits(rTerrain.chunkGeomCompact.vrtxBuffer.size()),
+                 fmt::group_digits(rTerrain.chunkGeom.indxBuffer.size() * sizeof(Vector3u)));
+}
+
+void SysTerrainIco::set_distance_thresholds(
+        double                      const distanceScale,
+        ACtxTerrain                       &rTerrain,
+        ACtxTerrainIco              const &rTerrainIco)
+{
+    SkeletonSubdivScratchpad &rSP = rTerrain.scratchpad;
+
+    double const scale = std::exp2(double(rTerrain.skData.precision));
+
+    // Calculate distance thresholds for when skeleton triangles should be subdivided and
+    // unsubdivided. These threshold values are used by
+    // subdivide_level_by_distance(...) and unsubdivide_select_by_distance(...)
+    for (int level = 0; level < gc_maxSubdivLevels; ++level)
+    {
+        // Good-enough bounding sphere is ~75% of the edge length (determined using Blender)
+        double const edgeLength = gc_icoMaxEdgeVsLevel[level] * rTerrainIco.radius * scale;
+        double const subdivRadius = 0.75 * edgeLength * distanceScale;
+
+        // TODO: Pick thresholds based on the angular diameter (size on screen) of the
+        //       chunk triangle mesh that will actually be rendered.
+        rSP.distanceThresholdSubdiv[level] = subdivRadius;
+
+        // Unsubdivide thresholds should be slightly larger (arbitrary x2) to avoid rapid
+        // terrain changes when moving back and forth quickly
+        rSP.distanceThresholdUnsubdiv[level] = 2.0f * subdivRadius;
+    }
+}
+
+void SysTerrainIco::subdivide_by_distance(
+        ACtxTerrain                       &rTerrain,
+        ACtxTerrainIco              const &rTerrainIco)
+{
+    SubdivTriangleSkeleton     &rSkel      = rTerrain.skeleton;
+    SkeletonVertexData         &rSkData    = rTerrain.skData;
+    SkeletonSubdivScratchpad   &rSkSP      = rTerrain.scratchpad;
+
+    Vector3l const& viewerPos = rTerrain.scratchpad.viewerPosition;
+
+    // ## Unsubdivide triangles that are too far away
+
+    // Unsubdivide is performed first, since it's better to remove stuff before adding new
+    // stuff; this reduces peak memory requirements.
+
+    // Unsubdividing is performed per-level, starting from the highest detail. In order to
+    // respect invariants, triangles must be removed in groups (removing triangles 1-by-1 can
+    // violate invariants mid-way).
+    for (int level = rSkel.levelMax-1; level >= 0; --level)
+    {
+        // Select and deselect only modifies rSkSP
+        unsubdivide_select_by_distance(level, viewerPos, rSkel, rSkData, rSkSP);
+        unsubdivide_deselect_invariant_violations(level, rSkel, rSkData, rSkSP);
+
+        // Perform changes on skeleton, delete selected triangles
+        unsubdivide_level(level, rSkel, rSkData, rSkSP);
+    }
+    rSkSP.distanceTestDone.clear();
+
+    // ## Subdivide nearby triangles
+
+    // Distance testing is performed 'recursively' per level. A triangle within the subdivision
+    // threshold and needs to be subdivided, will trigger a subdivision check for its children
+    // on the next level. To start, we seed the distance checker with the root triangles.
+    if (rSkel.levelMax > 0)
+    {
+        for (SkTriId const sktriId : rTerrainIco.icoTri)
+        {
+            rSkSP.levels[0].distanceTestNext.push_back(sktriId);
+            rSkSP.distanceTestDone.insert(sktriId);
+        }
+        rSkSP.levelNeedProcess = 0;
+    }
+
+    // Do the subdivide for real
+    for (int level = 0; level < rSkel.levelMax; ++level)
+    {
+        subdivide_level_by_distance(viewerPos, level, rSkel, rSkData, rSkSP);
+    }
+    rSkSP.distanceTestDone.clear();
+
+    // Uncomment these if some new change breaks something
+    //rSkel.debug_check_invariants();
+}
+
+void SysTerrainIco::update_chunks(
+        ACtxTerrainFrame            const &rTerrainFrame,
+        ACtxTerrain                       &rTerrain,
+        ACtxTerrainIco              const &rTerrainIco)
+{
+    SubdivTriangleSkeleton     &rSkel      = rTerrain.skeleton;
+    SkeletonVertexData         &rSkData    = rTerrain.skData;
+    ChunkSkeleton              &rSkCh      = rTerrain.skChunks;
+    ChunkMeshBufferInfo        &rChInfo    = rTerrain.chunkInfo;
+    BasicChunkMeshGeometry     &rChGeo     = rTerrain.chunkGeom;
+    ChunkScratchpad            &rChSP      = rTerrain.chunkSP;
+    SkeletonSubdivScratchpad   &rSkSP      = rTerrain.scratchpad;
+
+    rChSP.chunksAdded       .clear();
+    rChSP.chunksRemoved     .clear();
+    rChSP.sharedNormalsDirty.clear();
+    rChSP.sharedAdded       .clear();
+    rChSP.sharedRemoved     .clear();
+
+    ChunkFillCache &rChCache = rTerrain.chunkCache;
+
+    // Delete chunks of now-deleted Skeleton Triangles
+    for (SkTriId const sktriId : rSkSP.surfaceRemoved)
+    {
+        ChunkId const chunkId = rSkCh.m_triToChunk[sktriId];
+        if (chunkId.has_value())
+        {
+            if (rChCache.is_used())
+            {
+                auto const fillPos = rChGeo.vbufPositions.view_const(rChGeo.vrtxBuffer, rChInfo.vrtxTotal)
+                                                         .sliceSize(fill_to_vrtx(rChInfo, chunkId, 0), rChInfo.fillVrtxCount);
+                rChCache.store(chunkId, fillPos, rChGeo.originSkelPos);
+            }
+            subtract_normal_contrib(chunkId, false, rChGeo, rChInfo, rChSP, rSkCh);
+            rSkCh.chunk_remove(chunkId, sktriId, rChSP.sharedRemoved, rSkel);
+            rChSP.chunksRemoved.insert(chunkId);
+        }
+    }
+
+    auto const chLevel  = rSkCh.m_chunkSubdivLevel;
+    auto const edgeSize = rSkCh.m_chunkEdgeVrtxCount-1;
+
+    // Create new chunks for each new surface Skeleton Triangle added
+    rSkCh.m_triToChunk.resize(rSkel.tri_group_ids().capacity() * 4);
+    for (SkTriId const sktriId : rSkSP.surfaceAdded)
+    {
+        auto const &corners = rSkel.tri_at(sktriId).vertices;
+
+        ArrayView< MaybeNewId<SkVrtxId> > const edgeVrtxView = rChSP.edgeVertices;
+        ArrayView< MaybeNewId<SkVrtxId> > const edgeLft = edgeVrtxView.sliceSize(edgeSize * 0ul, edgeSize);
+        ArrayView< MaybeNewId<SkVrtxId> > const edgeBtm = edgeVrtxView.sliceSize(edgeSize * 1ul, edgeSize);
+        ArrayView< MaybeNewId<SkVrtxId> > const edgeRte = edgeVrtxView.sliceSize(edgeSize * 2ul, edgeSize);
+
+        rSkel.vrtx_create_chunk_edge_recurse(chLevel, corners[0], corners[1], edgeLft);
+        rSkel.vrtx_create_chunk_edge_recurse(chLevel, corners[1], corners[2], edgeBtm);
+        rSkel.vrtx_create_chunk_edge_recurse(chLevel, corners[2], corners[0], edgeRte);
+
+        ChunkId const chunkId = rSkCh.chunk_create(sktriId, rSkel, rChSP.sharedAdded, edgeLft, edgeBtm, edgeRte);
+
+        rChSP.chunksAdded.insert(chunkId);
+
+        if (rChCache.is_used())
+        {
+            rChCache.assign_chunk(chunkId, tri_path_key(sktriId, rSkel));
+        }
+
+        // chunk_create creates new Skeleton Vertices. Resize is needed after each call
+        rSkData.resize(rSkel);
+        rSkSP.resize(rSkel);
+
+        // Calculates positions and normals with spherical curvature
+        ico_calc_chunk_edge(rTerrainIco.radius, chLevel, corners[0], corners[1], edgeLft, rSkData);
+        ico_calc_chunk_edge(rTerrainIco.radius, chLevel, corners[1], corners[2], edgeBtm, rSkData);
+        ico_calc_chunk_edge(rTerrainIco.radius, chLevel, corners[2], corners[0], edgeRte, rSkData);
+    }
+
+    for (ChunkId const chunkId : rChSP.chunksAdded)
+    {
+        restitch_check(chunkId, rSkCh.m_chunkToTri[chunkId], rSkCh, rSkel, rSkData, rChSP);
+    }
+
+    float const scale = std::exp2(float(-rSkData.precision));
+
+    auto const vbufPosView = rChGeo.vbufPositions.view(rChGeo.vrtxBuffer, rChInfo.vrtxTotal);
+    auto const vbufNrmView = rChGeo.vbufNormals  .view(rChGeo.vrtxBuffer, rChInfo.vrtxTotal);
+
+    // TODO: temporary code of course
+    auto const heightmap = [scale, h = rTerrainIco.height] (Vector3l posl) -> float
+    {
+        return h * std::clamp<double>(    0.1*(0.5 - 0.5*std::cos(0.000050*posl.x()*scale*2.0*3.14159))
+                                        + 0.9*(0.5 - 0.5*std::cos(0.000005*posl.y()*scale*2.0*3.14159)) , 0.0, 1.0 );
+    };
+
+    auto const update_shared_vrtx_position
+            = [&vbufPosView, &heightmap, scale, &rSkCh, &rChInfo, &rSkData, &rChGeo, &rTerrainIco]
+              (SharedVrtxId const sharedVrtxId)
+    {
+        SkVrtxId  const skelVrtx   = rSkCh.m_sharedToSkVrtx[sharedVrtxId];
+        VertexIdx const vbufVertex = rChInfo.vbufSharedOffset + sharedVrtxId.value;
+        Vector3l  const skPos      = rSkData.positions[skelVrtx];
+        Vector3   const posOut     = Vector3{skPos - rChGeo.originSkelPos} * scale;
+        Vector3   const radialDir  = Vector3{Vector3d(skPos) * scale / rTerrainIco.radius};
+
+        rChGeo.sharedPosNoHeightmap[sharedVrtxId] = posOut;
+        vbufPosView[vbufVertex]                   = posOut + radialDir * heightmap(skPos);
+    };
+
+    // TODO: Limit rChGeo.originSkelPos to always be near the surface. There isn't a point in
+    //       translating the mesh when moving away from the terrain.
+    //       Also add a threshold to only translate if the two positions diverge too far. Vary
+    //       the threshold by the maximum present subdivision level, so less translations are
+    //       needed when moving across low-detail terrain.
+
+    bool const originMoved = rChGeo.originSkelPos != rTerrainFrame.position;
+
+    if ( ! originMoved )
+    {
+        // Copy offsetted positions from the skeleton for newly added shared vertices
+
+        for (SharedVrtxId const sharedVrtxId : rChSP.sharedAdded)
+        {
+            update_shared_vrtx_position(sharedVrtxId);
+        }
+    }
+    else
+    {
+        // The scene position relative to planet origin has changed.
+        OSP_LOG_INFO("Translating Terrain Mesh");
+
+        Vector3l const deltaOffset  = rChGeo.originSkelPos - rTerrainFrame.position;
+        Vector3  const deltaOffsetF = Vector3(deltaOffset) * scale;
+        rChGeo.originSkelPos = rTerrainFrame.position;
+        rTerrain.chunkGeomCompact.origin += deltaOffsetF;
+
+        // Refresh all shared vertex positions
+        for (SharedVrtxId const sharedVrtxId : rSkCh.m_sharedIds)
+        {
+            update_shared_vrtx_position(sharedVrtxId);
+        }
+
+        // Translate all existing chunk fill vertices
+        for (ChunkId const chunkId : rSkCh.m_chunkIds)
+        {
+            if (rChSP.chunksAdded.contains(chunkId))
+            {
+                continue; // Not added yet, no need to translate
+            }
+
+            std::size_t const fillOffset = rChInfo.vbufFillOffset + chunkId.value*rChInfo.fillVrtxCount;
+            for (Vector3 &rPos : vbufPosView.sliceSize(fillOffset, rChInfo.fillVrtxCount))
+            {
+                rPos += deltaOffsetF;
+            }
+        }
+    }
+
+    Vector3d const center = -Vector3d(rChGeo.originSkelPos) * scale;
+
+    // Calculate new fill vertex positions
+    for (ChunkId const chunkId : rChSP.chunksAdded)
+    {
+        std::size_t const fillOffset = rChInfo.vbufFillOffset + chunkId.value*rChInfo.fillVrtxCount;
+        osp::ArrayView<SharedVrtxOwner_t const> sharedUsed = rSkCh.shared_vertices_used(chunkId);
+
+        // Reuse positions from when the same area was visited previously
+        if (rChCache.take(chunkId, rChGeo.originSkelPos, scale, vbufPosView.sliceSize(fillOffset, rChInfo.fillVrtxCount)))
+        {
+            continue;
+        }
+
+        // Use ChunkFillSubdivLUT to generate a spherically curved triangle fill through
+        // building up and subdividing pairs of vertices. Don't apply heightmap yet, as this
+        // will interfere with middle position and curvature calculations.
+        for (ChunkFillSubdivLUT::ToSubdiv const& toSubdiv : rChSP.lut.data())
+        {
+            Vector3 const vrtxAPos = toSubdiv.aIsShared
+                                   ? rChGeo.sharedPosNoHeightmap[sharedUsed[toSubdiv.vrtxA]]
+                                   : vbufPosView[fillOffset + toSubdiv.vrtxA];
+            Vector3 const vrtxBPos = toSubdiv.bIsShared
+                                   ? rChGeo.sharedPosNoHeightmap[sharedUsed[toSubdiv.vrtxB]]
+                                   : vbufPosView[fillOffset + toSubdiv.vrtxB];
+
+            Vector3d    const middle     = 0.5*( Vector3d(vrtxAPos) + Vector3d(vrtxBPos) );
+            Vector3d    const centerDiff = Vector3d(middle) - center;
+            double      const centerDist = centerDiff.length();
+            Vector3d    const radialDir  = centerDiff / centerDist;
+            double      const roundness  = rTerrainIco.radius - centerDiff.length();
+            Vector3d    const posOut     = middle + radialDir * roundness;
+
+            vbufPosView[fillOffset + toSubdiv.fillOut] = Vector3(posOut);
+        }
+
+        // Apply heightmap afterwards
+        for (Vector3 &rPos : vbufPosView.sliceSize(fillOffset, rChInfo.fillVrtxCount))
+        {
+            Vector3d   const centerDiff = Vector3d(rPos) - center;
+            double     const centerDist = centerDiff.length();
+            Vector3    const radialDir  = Vector3{centerDiff / centerDist};
+
+            Vector3l const bigpos = Vector3l(rPos / scale) + rChGeo.originSkelPos;
+
+            rPos += radialDir * heightmap(bigpos);
+        }
+    }
+
+    // Normal is not cleaned up by the previous user; Initially set them to zero.
+    // Face normals added in update_faces(...) will accumulate here.
+    for (SharedVrtxId const sharedVrtxId : rChSP.sharedAdded)
+    {
+        rChGeo.sharedNormalSum[sharedVrtxId] = Vector3{ZeroInit};
+    }
+
+    // Update Index buffer
+
+    // Add or remove faces according to chunk changes. This also calculates normals.
+    // Vertex normals are calculated from a weighted sum of face normals of connected faces.
+    // For shared vertices, we add or subtract face normals from rChGeo.sharedNormalSum.
+    for (ChunkId const chunkId : rSkCh.m_chunkIds)
+    {
+        SkTriId const sktriId    = rSkCh.m_chunkToTri[chunkId];
+        bool    const newlyAdded = rSkSP.surfaceAdded.contains(sktriId);
+
+        update_faces(chunkId, sktriId, newlyAdded, rSkel, rSkData, rChGeo, rChInfo, rChSP, rSkCh);
+    }
+
+    // Keep the compact vertex buffer's origin near the viewer, but not further than maxRadius
+    // from the planet's center so positions stay within half-float range.
+    Vector3d const viewerPos  = Vector3d(rSkSP.viewerPosition - rChGeo.originSkelPos) * double(scale);
+    Vector3d const viewerDir  = viewerPos - center;
+    double   const maxRadius  = rTerrainIco.radius + rTerrainIco.height;
+    Vector3d const compactPos = (viewerDir.length() > maxRadius)
+                              ? center + viewerDir.normalized() * maxRadius
+                              : viewerPos;
+    bool const compactMoved = compact_recenter(rTerrain.chunkGeomCompact, Vector3(compactPos));
+    bool const allVertices  = originMoved || compactMoved;
+
+    record_dirty_ranges(allVertices, rChSP, rChInfo, rSkCh);
+    std::fill(rChSP.stitchCmds.begin(), rChSP.stitchCmds.end(), ChunkStitch{});
+
+    // Fill unused parts of the index buffer with zeros. This includes chunks that are deleted
+    // but not (yet) reused.
+    auto const ibuf2d = as_2d(rChGeo.indxBuffer, rChInfo.chunkMaxFaceCount);
+    for (ChunkId const chunkId : rChSP.chunksRemoved)
+    {
+        if ( ! rSkCh.m_chunkIds.exists(chunkId) )
+        {
+            auto const indicesView = ibuf2d.row(chunkId.value);
+            std::fill(indicesView.begin(), indicesView.end(), Vector3u{0, 0, 0});
+        }
+    }
+
+    // Update vertex buffer normals of shared vertices, as rChGeo.sharedNormalSum was modified.
+    for (SharedVrtxId const sharedId : rChSP.sharedNormalsDirty)
+    {
+        Vector3 const normalSum = rChGeo.sharedNormalSum[sharedId];
+        vbufNrmView[rChInfo.vbufSharedOffset + sharedId.value] = normalSum.normalized();
+    }
+
+    update_compact_vertices(allVertices, rChGeo, rTerrain.chunkGeomCompact, rChInfo, rChSP, rSkCh);
+
+    // Uncomment these if some new change breaks something
+    //debug_check_invariants(rChGeo, rChInfo, rSkCh);
+}
+
+float SysTerrainIco::screen_size(double radius, double distance, float fovY, float viewportHeight) noexcept
+{
+    if (distance <= radius)
+    {
+        return viewportHeight; // Inside the sphere, fills the screen
+    }
+
+    double const tanAngularRadius = radius / std::sqrt(distance*distance - radius*radius);
+    return float(tanAngularRadius / std::tan(0.5 * fovY) * 0.5 * viewportHeight);
+}
+
+void SysTerrainIco::distribute_chunk_budget(std::uint32_t const totalChunks, ArrayView<TerrainLod> const lods) noexcept
+{
+    if (lods.isEmpty())
+    {
+        return;
+    }
+
+    std::uint32_t const minTotal = gc_minTerrainChunks * std::uint32_t(lods.size());
+
+    if (totalChunks <= minTotal)
+    {
+        // Not enough for everyone's minimum, share evenly regardless of size on screen
+        for (TerrainLod &rLod : lods)
+        {
+            rLod.chunkLimit = totalChunks / std::uint32_t(lods.size());
+        }
+        return;
+    }
+
+    std::uint32_t const remaining = totalChunks - minTotal;
+
+    // Weight by area on screen
+    double weightTotal = 0.0;
+    for (TerrainLod const &lod : lods)
+    {
+        weightTotal += double(lod.screenSize) * double(lod.screenSize);
+    }
+
+    for (TerrainLod &rLod : lods)
+    {
+        double const weight = (weightTotal > 0.0)
+                            ? double(rLod.screenSize) * double(rLod.screenSize) / weightTotal
+                            : 1.0 / double(lods.size());
+
+        rLod.chunkLimit = gc_minTerrainChunks + std::uint32_t(weight * double(remaining));
+    }
+}
+
+void SysTerrainIco::update_lod(
+        TerrainLod                        &rLod,
+        ACtxTerrain                       &rTerrain,
+        ACtxTerrainIco              const &rTerrainIco)
+{
+    // Never go over chunk capacity, leave some margin since a single update can add many chunks
+    std::uint32_t const capacity = rTerrain.skChunks.m_chunkIds.capacity();
+    std::uint32_t const limit    = std::min(rLod.chunkLimit, capacity - capacity / 4);
+    std::uint32_t const chunks   = rTerrain.skChunks.m_chunkIds.size();
+
+    double const distanceScaleOld = rLod.distanceScale;
+
+    // Shrink quickly and grow slowly, settling below the limit without oscillating
+    if (chunks > limit)
+    {
+        rLod.distanceScale *= 0.75;
+    }
+    else if (chunks < limit - limit / 4)
+    {
+        rLod.distanceScale *= 1.05;
+    }
+
+    rLod.distanceScale = std::clamp(rLod.distanceScale, 1.0 / 1024.0, 1.0);
+
+    if (rLod.distanceScale != distanceScaleOld)
+    {
+        set_distance_thresholds(rLod.distanceScale, rTerrain, rTerrainIco);
+    }
+}
+
+void SysTerrainCollision::update(
+        ACtxTerrainCollision              &rTerrainColl,
+        ACtxTerrain                 const &rTerrain,
+        ACtxTerrainFrame            const &rTerrainFrame)
+{
+    ChunkSkeleton       const &rSkCh   = rTerrain.skChunks;
+    SkeletonVertexData  const &rSkData = rTerrain.skData;
+
+    rTerrainColl.added  .clear();
+    rTerrainColl.removed.clear();
+
+    std::size_t const capacity = rSkCh.m_chunkIds.capacity();
+    rTerrainColl.active     .resize(capacity);
+    rTerrainColl.builtTri   .resize(capacity);
+    rTerrainColl.builtStitch.resize(capacity, ChunkStitch{});
+
+    // Drop colliders of chunks that were deleted, reused, or restitched
+    for (ChunkId const chunkId : rTerrainColl.active)
+    {
+        if (   ! rSkCh.m_chunkIds.exists(chunkId)
+            || rSkCh.m_chunkToTri[chunkId]  != rTerrainColl.builtTri[chunkId]
+            || rSkCh.m_chunkStitch[chunkId] != rTerrainColl.builtStitch[chunkId] )
+        {
+            rTerrainColl.removed.push_back(chunkId);
+        }
+    }
+    for (ChunkId const chunkId : rTerrainColl.removed)
+    {
+        rTerrainColl.active.erase(chunkId);
+    }
+
+    // Body positions in skeleton space, and their bounding box
+    double      const scale       = std::exp2(double(rSkData.precision));
+    Quaterniond const sceneToTerr = rTerrainFrame.rotation.inverted();
+
+    std::vector<Vector3d> bodies;
+    bodies.reserve(rTerrainColl.bodyPositions.size());
+
+    Vector3d boundsMin{std::numeric_limits<double>::max()};
+    Vector3d boundsMax{std::numeric_limits<double>::lowest()};
+    for (Vector3 const pos : rTerrainColl.bodyPositions)
+    {
+        Vector3d const skPos = Vector3d(rTerrainFrame.position) + sceneToTerr.transformVector(Vector3d(pos)) * scale;
+        bodies.push_back(skPos);
+        boundsMin = Magnum::Math::min(boundsMin, skPos);
+        boundsMax = Magnum::Math::max(boundsMax, skPos);
+    }
+
+    double const margin = double(rTerrainColl.margin) * scale;
+
+    for (ChunkId const chunkId : rSkCh.m_chunkIds)
+    {
+        SkTriId  const sktriId = rSkCh.m_chunkToTri[chunkId];
+        Vector3d const center  = Vector3d(rSkData.centers[sktriId]);
+
+        bool near = false;
+        if ( ! bodies.empty() )
+        {
+            double radiusSq = 0.0;
+            for (SkVrtxOwner_t const& corner : rTerrain.skeleton.tri_at(sktriId).vertices)
+            {
+                radiusSq = std::max(radiusSq, (Vector3d(rSkData.positions[corner.value()]) - center).dot());
+            }
+            double const reach   = std::sqrt(radiusSq) + margin;
+            double const reachSq = reach * reach;
+
+            bool const inBounds = (center + Vector3d{reach} >= boundsMin).all()
+                               && (center - Vector3d{reach} <= boundsMax).all();
+
+            near = inBounds && std::any_of(bodies.begin(), bodies.end(), [center, reachSq] (Vector3d const& body)
+            {
+                return (body - center).dot() < reachSq;
+            });
+        }
+
+        bool const active = rTerrainColl.active.contains(chunkId);
+        if (near && ! active)
+        {
+            rTerrainColl.active.insert(chunkId);
+            rTerrainColl.builtTri   [chunkId] = sktriId;
+            rTerrainColl.builtStitch[chunkId] = rSkCh.m_chunkStitch[chunkId];
+            rTerrainColl.added.push_back(chunkId);
+        }
+        else if ( ! near && active )
+        {
+            rTerrainColl.active.erase(chunkId);
+            rTerrainColl.removed.push_back(chunkId);
+        }
+    }
+}
+
+Vector3 SysTerrainCollision::chunk_position(
+        ACtxTerrain                 const &rTerrain,
+        ACtxTerrainFrame            const &rTerrainFrame,
+        ChunkId                     const chunkId) noexcept
+{
+    double   const scale  = std::exp2(double(rTerrain.skData.precision));
+    Vector3l const center = rTerrain.skData.centers[rTerrain.skChunks.m_chunkToTri[chunkId]];
+
+    return Vector3(rTerrainFrame.rotation.transformVector(Vector3d(center - rTerrainFrame.position)) / scale);
+}
+
+void SysTerrainCollision::chunk_triangles(
+        ACtxTerrain                 const &rTerrain,
+        ChunkId                     const chunkId,
+        std::vector<Vector3>              &rTriangles)
+{
+    BasicChunkMeshGeometry const &rGeom   = rTerrain.chunkGeom;
+    ChunkMeshBufferInfo    const &rChInfo = rTerrain.chunkInfo;
+
+    float    const scale  = std::exp2(float(rTerrain.skData.precision));
+    Vector3l const center = rTerrain.skData.centers[rTerrain.skChunks.m_chunkToTri[chunkId]];
+
+    // Vertex positions are relative to originSkelPos, make them relative to the chunk center
+    Vector3 const offset = Vector3(rGeom.originSkelPos - center) / scale;
+
+    auto const vbufPos = rGeom.vbufPositions.view_const(rGeom.vrtxBuffer, rChInfo.vrtxTotal);
+    auto const faces   = as_2d(rGeom.indxBuffer, rChInfo.chunkMaxFaceCount).row(chunkId.value);
+
+    for (Vector3u const face : faces)
+    {
+        if (face.x() == face.y() || face.y() == face.z() || face.z() == face.x())
+        {
+            continue; // Unused or degenerate
+        }
+
+        rTriangles.push_back(vbufPos[face.x()] + offset);
+        rTriangles.push_back(vbufPos[face.y()] + offset);
+        rTriangles.push_back(vbufPos[face.z()] + offset);
+    }
+}
+
+} // namespace planeta
\ No newline at end of file
@@ -0,0 +1,190 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "terrain.h"
+
+namespace planeta
+{
+
+/**
+ * @brief Parameters for a spherical icosahedron planet terrain
+ */
+struct TerrainIcoSpecs
+{
+    /// Planet lowest ground level in meters
+    double          radius              {};
+
+    /// Planet max ground height in meters
+    double          height              {};
+
+    /// Skeleton Vector3l precision (2^precision units = 1 meter)
+    int             skelPrecision       {};
+
+    /// Skeleton max subdivision levels. 0 for no subdivision. Max is 23.
+    std::uint8_t    skelMaxSubdivLevels {};
+
+    /// Number of times an initial triangle is subdivided to form a chunk.
+    /// Due to bugs (LOL XD): Minimum is 2, Maximum is 8.
+    std::uint8_t    chunkSubdivLevels   {};
+
+    /// Normal format of the compact vertex buffer, which renderers upload instead of the float
+    /// vertex buffer. None to only use the float vertex buffer.
+    ///
+    /// Off by default; the terrain is currently only drawn with a wireframe shader, which
+    /// doesn't read normals, and half-float positions are less precise than floats.
+    EChunkCompactNormals compactNormals {EChunkCompactNormals::None};
+
+    /// Memory limit for caching fill vertices of removed chunks. 0 to disable the cache.
+    std::size_t     chunkCacheBytes     {};
+
+    /// Capacity of chunks and chunk mesh buffers. 0 for an estimate based on skelMaxSubdivLevels.
+    /// Set this from a global budget when many terrains are loaded at once.
+    std::uint32_t   maxChunks           {};
+};
+
+/**
+ * @brief Subdivision and chunk mesh generation for icosahedron sphere planets
+ *
+ * Does not depend on osp::fw, and can be driven headlessly.
+ */
+class SysTerrainIco
+{
+public:
+
+    /**
+     * @brief Allocate and set parameters for an icosahedron planet, given specifications
+     */
+    static void initialize(
+            TerrainIcoSpecs             const &specs,
+            ACtxTerrainFrame                  &rTerrainFrame,
+            ACtxTerrain                       &rTerrain,
+            ACtxTerrainIco                    &rTerrainIco);
+
+    /**
+     * @brief Subdivide and unsubdivide the skeleton by distance to SkeletonSubdivScratchpad::viewerPosition
+     *
+     * Populates SkeletonSubdivScratchpad::surfaceAdded and surfaceRemoved.
+     */
+    static void subdivide_by_distance(
+            ACtxTerrain                       &rTerrain,
+            ACtxTerrainIco              const &rTerrainIco);
+
+    /**
+     * @brief Create, remove, and restitch chunks according to skeleton surface changes
+     */
+    static void update_chunks(
+            ACtxTerrainFrame            const &rTerrainFrame,
+            ACtxTerrain                       &rTerrain,
+            ACtxTerrainIco              const &rTerrainIco);
+
+    /**
+     * @brief Set subdivision distance thresholds, scaled to reduce level of detail
+     *
+     * @param distanceScale [in] 1.0 for full detail, smaller values subdivide less
+     */
+    static void set_distance_thresholds(
+            double                      const distanceScale,
+            ACtxTerrain                       &rTerrain,
+            ACtxTerrainIco              const &rTerrainIco);
+
+    /**
+     * @brief Approximate radius of a sphere on screen in pixels
+     *
+     * @param radius         [in] Sphere radius
+     * @param distance       [in] Distance from the camera to the sphere's center
+     * @param fovY           [in] Vertical field of view in radians
+     * @param viewportHeight [in] Viewport height in pixels
+     */
+    static float screen_size(double radius, double distance, float fovY, float viewportHeight) noexcept;
+
+    /**
+     * @brief Split a global chunk budget between terrains, weighted by area on screen
+     *
+     * Each terrain is given at least gc_minTerrainChunks. If totalChunks is too small for that,
+     * it is split evenly instead. Uses TerrainLod::screenSize and writes TerrainLod::chunkLimit.
+     */
+    static void distribute_chunk_budget(std::uint32_t totalChunks, osp::ArrayView<TerrainLod> lods) noexcept;
+
+    /**
+     * @brief Adjust TerrainLod::distanceScale so the terrain's chunk count stays under its limit
+     *
+     * Call once per update, before subdivide_by_distance(...).
+     */
+    static void update_lod(
+            TerrainLod                        &rLod,
+            ACtxTerrain                       &rTerrain,
+            ACtxTerrainIco              const &rTerrainIco);
+
+    /// Minimum chunks given to a terrain; enough for the 20 icosahedron faces with some detail
+    static constexpr std::uint32_t gc_minTerrainChunks = 64;
+};
+
+/**
+ * @brief Picks terrain chunks that need physics colliders and extracts their triangles
+ *
+ * Physics engine independent, see ACtxTerrainCollision.
+ */
+class SysTerrainCollision
+{
+public:
+
+    /**
+     * @brief Refill ACtxTerrainCollision::added and removed
+     *
+     * A chunk is near a body if the body is within the chunk's bounding sphere plus margin.
+     * Chunks outside the bounding box of all bodies are skipped without checking each body.
+     *
+     * @param rTerrainColl  [ref] Collision state, bodyPositions must already be filled
+     */
+    static void update(
+            ACtxTerrainCollision              &rTerrainColl,
+            ACtxTerrain                 const &rTerrain,
+            ACtxTerrainFrame            const &rTerrainFrame);
+
+    /**
+     * @brief Position of a chunk's collider in the scene in meters, at its skeleton triangle's center
+     *
+     * Triangles from chunk_triangles are in the terrain's orientation, so the collider also
+     * needs ACtxTerrainFrame::rotation.
+     */
+    [[nodiscard]] static osp::Vector3 chunk_position(
+            ACtxTerrain                 const &rTerrain,
+            ACtxTerrainFrame            const &rTerrainFrame,
+            ChunkId                           chunkId) noexcept;
+
+    /**
+     * @brief Append a chunk's mesh triangles, 3 vertices each, relative to chunk_position
+     *
+     * Reads the same vertex and index buffers as the chunk mesh. Unused and degenerate faces
+     * are skipped.
+     */
+    static void chunk_triangles(
+            ACtxTerrain                 const &rTerrain,
+            ChunkId                           chunkId,
+            std::vector<osp::Vector3>         &rTriangles);
+};
+
+} // namespace planeta
@@ -0,0 +1,188 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "chunk_cache.h"
+
+#include <longeron/utility/asserts.hpp>
+
+#include <algorithm>
+
+namespace planeta
+{
+
+SkTriPathKey tri_path_key(SkTriId const sktriId, SubdivTriangleSkeleton const& rSkel)
+{
+    SkTriPathKey    siblings = 0;
+    SkTriId         current  = sktriId;
+    std::uint8_t    depth    = 0;
+
+    for (SkTriId parent = rSkel.tri_group_at(tri_group_id(current)).parent;
+         parent.has_value();
+         parent = rSkel.tri_group_at(tri_group_id(current)).parent)
+    {
+        siblings |= SkTriPathKey(tri_sibling_index(current)) << (2u * depth);
+        current = parent;
+        ++depth;
+    }
+
+    LGRN_ASSERTMV(current.value < (1u << 13u), "Root triangle ID too large for path key", current.value);
+    LGRN_ASSERTMV(depth < gc_maxSubdivLevels, "Path too deep", depth);
+
+    return (SkTriPathKey(current.value) << 51u) | (SkTriPathKey(depth) << 46u) | siblings;
+}
+
+void ChunkFillCache::resize(std::size_t const maxBytes, std::uint32_t const fillVrtxCount, std::size_t const maxChunks)
+{
+    std::size_t const bytesPerEntry = sizeof(osp::Vector3) * fillVrtxCount;
+    std::size_t const entryCount    = (bytesPerEntry == 0) ? 0 : (maxBytes / bytesPerEntry);
+
+    m_fillVrtxCount = fillVrtxCount;
+    m_positions .assign(entryCount * fillVrtxCount, osp::Vector3{osp::ZeroInit});
+    m_entries   .assign(entryCount, Entry{});
+    m_chunkToKey.resize(maxChunks);
+    m_keyToEntry.clear();
+    m_keyToEntry.reserve(entryCount);
+
+    m_free.resize(entryCount);
+    // Pop from the back, so lowest entry indices are used first
+    std::generate(m_free.rbegin(), m_free.rend(), [i = std::uint32_t(0)] () mutable { return i++; });
+
+    m_mostRecent  = smc_null;
+    m_leastRecent = smc_null;
+}
+
+void ChunkFillCache::store(
+        ChunkId                                                     const chunkId,
+        Corrade::Containers::StridedArrayView1D<osp::Vector3 const> const positions,
+        osp::Vector3l                                               const origin)
+{
+    if ( ! is_used() )
+    {
+        return;
+    }
+
+    LGRN_ASSERT(positions.size() == m_fillVrtxCount);
+
+    SkTriPathKey const key = m_chunkToKey[chunkId];
+
+    std::uint32_t entryIdx;
+    if (auto const found = m_keyToEntry.find(key);
+        found != m_keyToEntry.end())
+    {
+        // Shouldn't normally happen, since entries are taken when used
+        entryIdx = found->second;
+        unlink(entryIdx);
+    }
+    else
+    {
+        if (m_free.empty())
+        {
+            // Evict least recently used
+            entryIdx = m_leastRecent;
+            unlink(entryIdx);
+            m_keyToEntry.erase(m_entries[entryIdx].key);
+        }
+        else
+        {
+            entryIdx = m_free.back();
+            m_free.pop_back();
+        }
+        m_keyToEntry.emplace(key, entryIdx);
+    }
+
+    Entry &rEntry = m_entries[entryIdx];
+    rEntry.key    = key;
+    rEntry.origin = origin;
+    std::copy(positions.begin(), positions.end(), positions_of(entryIdx).begin());
+
+    link_front(entryIdx);
+}
+
+bool ChunkFillCache::take(
+        ChunkId                                               const chunkId,
+        osp::Vector3l                                         const origin,
+        float                                                 const scale,
+        Corrade::Containers::StridedArrayView1D<osp::Vector3> const rPositionsOut)
+{
+    if ( ! is_used() )
+    {
+        return false;
+    }
+
+    auto const found = m_keyToEntry.find(m_chunkToKey[chunkId]);
+    if (found == m_keyToEntry.end())
+    {
+        ++misses;
+        return false;
+    }
+    ++hits;
+
+    std::uint32_t const entryIdx = found->second;
+    m_keyToEntry.erase(found);
+    unlink(entryIdx);
+    m_free.push_back(entryIdx);
+
+    LGRN_ASSERT(rPositionsOut.size() == m_fillVrtxCount);
+
+    // Same as translating chunk fill vertices when the mesh origin moves
+    osp::Vector3 const delta = osp::Vector3(m_entries[entryIdx].origin - origin) * scale;
+    auto const cached = positions_of(entryIdx);
+    for (std::size_t i = 0; i < m_fillVrtxCount; ++i)
+    {
+        rPositionsOut[i] = cached[i] + delta;
+    }
+
+    return true;
+}
+
+void ChunkFillCache::unlink(std::uint32_t const entryIdx) noexcept
+{
+    Entry &rEntry = m_entries[entryIdx];
+
+    (rEntry.prev != smc_null ? m_entries[rEntry.prev].next : m_mostRecent)  = rEntry.next;
+    (rEntry.next != smc_null ? m_entries[rEntry.next].prev : m_leastRecent) = rEntry.prev;
+
+    rEntry.prev = smc_null;
+    rEntry.next = smc_null;
+}
+
+void ChunkFillCache::link_front(std::uint32_t const entryIdx) noexcept
+{
+    Entry &rEntry = m_entries[entryIdx];
+
+    rEntry.prev = smc_null;
+    rEntry.next = m_mostRecent;
+
+    if (m_mostRecent != smc_null)
+    {
+        m_entries[m_mostRecent].prev = entryIdx;
+    }
+    else
+    {
+        m_leastRecent = entryIdx;
+    }
+    m_mostRecent = entryIdx;
+}
+
+} // namespace planeta
@@ -0,0 +1,152 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Cache for reusing generated chunk fill vertices when revisiting terrain
+ */
+#pragma once
+
+#include "skeleton.h"
+
+#include <osp/core/array_view.h>
+#include <osp/core/id_map.h>
+#include <osp/core/keyed_vector.h>
+#include <osp/core/math_types.h>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace planeta
+{
+
+/**
+ * @brief Identifies a skeleton triangle by its path from a root triangle
+ *
+ * Unlike SkTriIds, which get reused after triangles are deleted, a path stays the same when a
+ * region of terrain is unsubdivided then subdivided again.
+ *
+ * Packed as [13-bit root SkTriId][5-bit depth][2-bit sibling index per level, leaf first]
+ */
+using SkTriPathKey = std::uint64_t;
+
+/**
+ * @brief Calculate path key of an existing skeleton triangle
+ */
+SkTriPathKey tri_path_key(SkTriId sktriId, SubdivTriangleSkeleton const& rSkel);
+
+/**
+ * @brief Bounded least-recently-used cache of chunk fill vertex positions
+ *
+ * When a chunk is removed, its fill vertex positions are stored, keyed by the skeleton
+ * triangle's path. If a chunk is created over the same triangle later, positions are taken from
+ * the cache instead of being generated again.
+ *
+ * Fill normals are not cached; they're accumulated from face normals by update_faces alongside
+ * the shared vertex normal contributions that must be recalculated anyway.
+ *
+ * Positions are stored the way they appear in BasicChunkMeshGeometry::vrtxBuffer, along with the
+ * originSkelPos they're relative to.
+ */
+class ChunkFillCache
+{
+    static constexpr std::uint32_t smc_null = ~std::uint32_t(0);
+
+    struct Entry
+    {
+        SkTriPathKey    key;
+        osp::Vector3l   origin;
+        std::uint32_t   prev    {smc_null}; ///< Towards more recently used
+        std::uint32_t   next    {smc_null}; ///< Towards less recently used
+    };
+
+public:
+
+    /**
+     * @brief Allocate cache storage
+     *
+     * @param maxBytes      [in] Memory limit for cached positions; 0 to disable the cache
+     * @param fillVrtxCount [in] Fill vertices per chunk, see ChunkMeshBufferInfo::fillVrtxCount
+     * @param maxChunks     [in] Chunk ID capacity
+     */
+    void resize(std::size_t maxBytes, std::uint32_t fillVrtxCount, std::size_t maxChunks);
+
+    [[nodiscard]] constexpr bool is_used() const noexcept { return ! m_entries.empty(); }
+
+    /**
+     * @brief Remember which triangle a chunk was created over, so it can be stored when removed
+     */
+    void assign_chunk(ChunkId const chunkId, SkTriPathKey const key) { m_chunkToKey[chunkId] = key; }
+
+    /**
+     * @brief Store fill vertex positions of a chunk that's about to be removed
+     *
+     * Evicts the least recently used entry if the cache is full.
+     */
+    void store(ChunkId chunkId, Corrade::Containers::StridedArrayView1D<osp::Vector3 const> positions, osp::Vector3l origin);
+
+    /**
+     * @brief Remove the entry matching a newly created chunk's triangle and copy its positions,
+     *        if found
+     *
+     * @param origin        [in]  Current BasicChunkMeshGeometry::originSkelPos
+     * @param scale         [in]  Meters per skeleton unit, 2^-precision
+     * @param rPositionsOut [out] Positions translated to be relative to origin
+     *
+     * @return true if found
+     */
+    bool take(ChunkId chunkId, osp::Vector3l origin, float scale, Corrade::Containers::StridedArrayView1D<osp::Vector3> rPositionsOut);
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_keyToEntry.size(); }
+    [[nodiscard]] std::size_t capacity() const noexcept { return m_entries.size(); }
+
+    std::uint32_t hits      {0};
+    std::uint32_t misses    {0};
+
+private:
+
+    void unlink(std::uint32_t entryIdx) noexcept;
+    void link_front(std::uint32_t entryIdx) noexcept;
+
+    osp::ArrayView<osp::Vector3> positions_of(std::uint32_t const entryIdx) noexcept
+    {
+        return osp::arrayView(m_positions).sliceSize(std::size_t(entryIdx) * m_fillVrtxCount, m_fillVrtxCount);
+    }
+
+    std::vector<osp::Vector3>               m_positions;
+    std::vector<Entry>                      m_entries;
+    std::vector<std::uint32_t>              m_free;
+    osp::IdMap_t<SkTriPathKey, std::uint32_t> m_keyToEntry;
+    osp::KeyedVec<ChunkId, SkTriPathKey>    m_chunkToKey;
+
+    std::uint32_t                           m_mostRecent    {smc_null};
+    std::uint32_t                           m_leastRecent   {smc_null};
+    std::uint32_t                           m_fillVrtxCount {0};
+
+}; // class ChunkFillCache
+
+} // namespace planeta
@@ -26,6 +26,7 @@
 
 #include <Corrade/Containers/ArrayViewStl.h>
 
+#include <algorithm>
 #include <ostream>
 
 using osp::ArrayView;
@@ -375,6 +376,139 @@ void subtract_normal_contrib(
     }
 }
 
+void record_dirty_ranges(
+        bool                          const allVertices,
+        ChunkScratchpad                     &rChSP,
+        ChunkMeshBufferInfo           const &rChInfo,
+        ChunkSkeleton                 const &rSkCh)
+{
+    // Gaps are in elements. Shared vertices are scattered and benefit from a larger gap.
+    constexpr std::uint32_t c_vrtxMaxGap = 64;
+    constexpr std::uint32_t c_faceMaxGap = 0;
+
+    if (allVertices)
+    {
+        rChSP.vrtxDirty.assign(1, ChunkMeshBufRange{ .first = 0, .count = rChInfo.vrtxTotal });
+    }
+    else
+    {
+        for (ChunkId const chunkId : rChSP.chunksAdded)
+        {
+            rChSP.vrtxDirty.push_back({ .first = fill_to_vrtx(rChInfo, chunkId, 0), .count = rChInfo.fillVrtxCount });
+        }
+
+        // Newly added shared vertices also have their normals dirtied by faces of the chunk that
+        // added them, but positions can be modified without normals if the chunk is removed in
+        // the same update.
+        for (SharedVrtxId const sharedId : rChSP.sharedAdded)
+        {
+            rChSP.vrtxDirty.push_back({ .first = rChInfo.vbufSharedOffset + sharedId.value, .count = 1 });
+        }
+        for (SharedVrtxId const sharedId : rChSP.sharedNormalsDirty)
+        {
+            rChSP.vrtxDirty.push_back({ .first = rChInfo.vbufSharedOffset + sharedId.value, .count = 1 });
+        }
+    }
+
+    auto const add_chunk_faces = [&rChSP, &rChInfo] (ChunkId const chunkId)
+    {
+        rChSP.faceDirty.push_back({ .first = chunkId.value * rChInfo.chunkMaxFaceCount, .count = rChInfo.chunkMaxFaceCount });
+    };
+
+    // Added chunks are restitched too, so only stitchCmds and removed chunks need checking
+    for (ChunkId const chunkId : rSkCh.m_chunkIds)
+    {
+        if (rChSP.stitchCmds[chunkId].enabled || rChSP.chunksAdded.contains(chunkId))
+        {
+            add_chunk_faces(chunkId);
+        }
+    }
+    for (ChunkId const chunkId : rChSP.chunksRemoved)
+    {
+        if ( ! rSkCh.m_chunkIds.exists(chunkId) )
+        {
+            add_chunk_faces(chunkId);
+        }
+    }
+
+    coalesce_ranges(rChSP.vrtxDirty, c_vrtxMaxGap);
+    coalesce_ranges(rChSP.faceDirty, c_faceMaxGap);
+}
+
+void coalesce_ranges(std::vector<ChunkMeshBufRange> &rRanges, std::uint32_t const maxGap)
+{
+    if (rRanges.size() < 2)
+    {
+        return;
+    }
+
+    std::sort(rRanges.begin(), rRanges.end(), [] (ChunkMeshBufRange const& lhs, ChunkMeshBufRange const& rhs)
+    {
+        return lhs.first < rhs.first;
+    });
+
+    auto outIt = rRanges.begin();
+    for (auto it = std::next(rRanges.begin()); it != rRanges.end(); ++it)
+    {
+        if (it->first <= outIt->end() + maxGap)
+        {
+            outIt->count = std::max(outIt->end(), it->end()) - outIt->first;
+        }
+        else
+        {
+            ++outIt;
+            *outIt = *it;
+        }
+    }
+    rRanges.erase(std::next(outIt), rRanges.end());
+}
+
+void update_compact_vertices(
+        bool                          const allPositions,
+        BasicChunkMeshGeometry        const &rGeom,
+        ChunkMeshCompactGeometry            &rCompact,
+        ChunkMeshBufferInfo           const &rChInfo,
+        ChunkScratchpad               const &rChSP,
+        ChunkSkeleton                 const &rSkCh)
+{
+    if ( ! rCompact.is_used() )
+    {
+        return;
+    }
+
+    if (allPositions)
+    {
+        for (ChunkId const chunkId : rSkCh.m_chunkIds)
+        {
+            compact_write_vertices(rGeom, rCompact, rChInfo, fill_to_vrtx(rChInfo, chunkId, 0), rChInfo.fillVrtxCount);
+        }
+        for (SharedVrtxId const sharedId : rSkCh.m_sharedIds)
+        {
+            compact_write_vertices(rGeom, rCompact, rChInfo, rChInfo.vbufSharedOffset + sharedId.value, 1);
+        }
+        return;
+    }
+
+    for (ChunkId const chunkId : rChSP.chunksAdded)
+    {
+        compact_write_vertices(rGeom, rCompact, rChInfo, fill_to_vrtx(rChInfo, chunkId, 0), rChInfo.fillVrtxCount);
+    }
+
+    // sharedAdded and sharedNormalsDirty overlap a lot; sharedAdded vertices always have
+    // their normals dirtied by the faces of the chunk that added them
+    for (SharedVrtxId const sharedId : rChSP.sharedNormalsDirty)
+    {
+        compact_write_vertices(rGeom, rCompact, rChInfo, rChInfo.vbufSharedOffset + sharedId.value, 1);
+    }
+    for (SharedVrtxId const sharedId : rChSP.sharedAdded)
+    {
+        if ( ! rChSP.sharedNormalsDirty.contains(sharedId) )
+        {
+            compact_write_vertices(rGeom, rCompact, rChInfo, rChInfo.vbufSharedOffset + sharedId.value, 1);
+        }
+    }
+}
+
 void debug_check_invariants(
         BasicChunkMeshGeometry        const &rGeom,
         ChunkMeshBufferInfo           const &rChInfo,
@@ -34,6 +34,17 @@
 namespace planeta
 {
 
+/**
+ * @brief Range of elements within a chunk mesh buffer; either vertices or faces (triangles)
+ */
+struct ChunkMeshBufRange
+{
+    constexpr std::uint32_t end() const noexcept { return first + count; }
+
+    std::uint32_t first;
+    std::uint32_t count;
+};
+
 struct ChunkScratchpad
 {
     void resize(ChunkSkeleton const& rChSk);
@@ -55,6 +66,13 @@ struct ChunkScratchpad
 
     /// Shared vertices that need to recalculate normals
     lgrn::IdSetStl<SharedVrtxId> sharedNormalsDirty;
+
+    /// Vertex ranges modified by chunk updates, sorted and coalesced. Accumulates over multiple
+    /// updates; consumers (e.g. GPU upload) are expected to clear this once synchronized.
+    std::vector<ChunkMeshBufRange> vrtxDirty;
+
+    /// Face ranges modified by chunk updates, sorted and coalesced. Same as vrtxDirty.
+    std::vector<ChunkMeshBufRange> faceDirty;
 };
 
 /**
@@ -101,6 +119,43 @@ void subtract_normal_contrib(
         ChunkScratchpad                 &rChSP,
         ChunkSkeleton             const &rSkCh);
 
+/**
+ * @brief Record which parts of the vertex and index buffers were modified by a chunk update
+ *
+ * Must be called after update_faces but before ChunkScratchpad::stitchCmds is cleared. Appends to
+ * and coalesces ChunkScratchpad::vrtxDirty and faceDirty.
+ *
+ * @param allVertices [in] Mark the entire vertex buffer dirty, required after the origin moves
+ */
+void record_dirty_ranges(
+        bool                            allVertices,
+        ChunkScratchpad                 &rChSP,
+        ChunkMeshBufferInfo       const &rChInfo,
+        ChunkSkeleton             const &rSkCh);
+
+/**
+ * @brief Sort ranges and merge ones that overlap or have a gap less than or equal to maxGap
+ *
+ * Uploading a few unmodified elements is cheaper than issuing many tiny uploads.
+ */
+void coalesce_ranges(std::vector<ChunkMeshBufRange> &rRanges, std::uint32_t maxGap);
+
+/**
+ * @brief Copy vertices modified by the most recent chunk update into the compact vertex buffer
+ *
+ * Writes fill vertices of ChunkScratchpad::chunksAdded, and shared vertices in sharedAdded or
+ * sharedNormalsDirty. Does nothing if the compact vertex buffer isn't used.
+ *
+ * @param allPositions [in] Write all vertices instead, required after the mesh origin moves
+ */
+void update_compact_vertices(
+        bool                            allPositions,
+        BasicChunkMeshGeometry    const &rGeom,
+        ChunkMeshCompactGeometry        &rCompact,
+        ChunkMeshBufferInfo       const &rChInfo,
+        ChunkScratchpad           const &rChSP,
+        ChunkSkeleton             const &rSkCh);
+
 /**
  * @brief Does asserts, checks if chunk normals are normalized
  */
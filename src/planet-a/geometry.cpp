@@ -25,6 +25,9 @@
 
 #include "geometry.h"
 
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Packing.h>
+
 namespace planeta
 {
 
@@ -49,4 +52,140 @@ void BasicChunkMeshGeometry::resize(ChunkSkeleton const& skCh, ChunkMeshBufferIn
     sharedPosNoHeightmap   .resize(maxSharedVrtx, osp::Vector3{osp::ZeroInit});
 }
 
+void ChunkMeshCompactGeometry::resize(ChunkMeshBufferInfo const& info, EChunkCompactNormals const normalFormat, int const exponent)
+{
+    normals     = normalFormat;
+    posExponent = exponent;
+    origin      = osp::Vector3{osp::ZeroInit};
+
+    vbufPositions    = {};
+    vbufNormalsOct8  = {};
+    vbufNormalsOct16 = {};
+
+    osp::BufferFormatBuilder formatBuilder;
+    switch (normals)
+    {
+    case EChunkCompactNormals::None:
+        vrtxBuffer = {};
+        return;
+    case EChunkCompactNormals::Oct8:
+        formatBuilder.insert_interleave(info.vrtxTotal, vbufPositions, vbufNormalsOct8);
+        break;
+    case EChunkCompactNormals::Oct16:
+        formatBuilder.insert_interleave(info.vrtxTotal, vbufPositions, vbufNormalsOct16);
+        break;
+    }
+
+    vrtxBuffer = Corrade::Containers::Array<std::byte>(Corrade::ValueInit, formatBuilder.total_size());
+}
+
+int compact_pos_exponent(double const maxDistance) noexcept
+{
+    // Largest finite half-float is 65504. Leave some margin for heightmap and translations.
+    constexpr double c_halfMaxSafe = 32768.0;
+
+    int exponent = 0;
+    while (maxDistance / std::exp2(double(exponent)) > c_halfMaxSafe)
+    {
+        ++exponent;
+    }
+    return exponent;
+}
+
+bool compact_recenter(ChunkMeshCompactGeometry &rCompact, osp::Vector3 const viewer) noexcept
+{
+    if ( ! rCompact.is_used() || (viewer - rCompact.origin).length() <= rCompact.originMaxDistance )
+    {
+        return false;
+    }
+
+    // Whole meters, so the mesh transform's translation is exact
+    rCompact.origin = Magnum::Math::round(viewer);
+    return true;
+}
+
+osp::Vector2 octahedral_encode(osp::Vector3 const normal) noexcept
+{
+    using Magnum::Math::abs;
+
+    // Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower half (z < 0) over
+    // the diagonal edges onto the outer triangles of the [-1, 1] square
+    float const manhattan = abs(normal.x()) + abs(normal.y()) + abs(normal.z());
+    if (manhattan == 0.0f)
+    {
+        return {}; // Unused vertex, normal not calculated
+    }
+
+    osp::Vector3 const proj = normal / manhattan;
+    osp::Vector2 const xy   = proj.xy();
+
+    if (proj.z() >= 0.0f)
+    {
+        return xy;
+    }
+
+    osp::Vector2 const signNotZero{xy.x() >= 0.0f ? 1.0f : -1.0f, xy.y() >= 0.0f ? 1.0f : -1.0f};
+    return (osp::Vector2{1.0f} - abs(osp::Vector2{xy.y(), xy.x()})) * signNotZero;
+}
+
+osp::Vector3 octahedral_decode(osp::Vector2 const encoded) noexcept
+{
+    using Magnum::Math::abs;
+
+    osp::Vector3 out{encoded.x(), encoded.y(), 1.0f - abs(encoded.x()) - abs(encoded.y())};
+
+    if (out.z() < 0.0f)
+    {
+        osp::Vector2 const signNotZero{out.x() >= 0.0f ? 1.0f : -1.0f, out.y() >= 0.0f ? 1.0f : -1.0f};
+        osp::Vector2 const folded = (osp::Vector2{1.0f} - abs(osp::Vector2{out.y(), out.x()})) * signNotZero;
+        out.x() = folded.x();
+        out.y() = folded.y();
+    }
+
+    return out.normalized();
+}
+
+void compact_write_vertices(
+        BasicChunkMeshGeometry      const &rGeom,
+        ChunkMeshCompactGeometry          &rCompact,
+        ChunkMeshBufferInfo         const &rChInfo,
+        VertexIdx                   const first,
+        std::uint32_t               const count) noexcept
+{
+    using Magnum::Math::pack;
+
+    if ( ! rCompact.is_used() )
+    {
+        return;
+    }
+
+    auto const srcPos = rGeom.vbufPositions.view_const(rGeom.vrtxBuffer, rChInfo.vrtxTotal).sliceSize(first, count);
+    auto const srcNrm = rGeom.vbufNormals  .view_const(rGeom.vrtxBuffer, rChInfo.vrtxTotal).sliceSize(first, count);
+    auto const dstPos = rCompact.vbufPositions.view(rCompact.vrtxBuffer, rChInfo.vrtxTotal).sliceSize(first, count);
+
+    float const invScale = std::exp2(float(-rCompact.posExponent));
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        dstPos[i] = osp::Vector3h{(srcPos[i] - rCompact.origin) * invScale};
+    }
+
+    if (rCompact.normals == EChunkCompactNormals::Oct8)
+    {
+        auto const dstNrm = rCompact.vbufNormalsOct8.view(rCompact.vrtxBuffer, rChInfo.vrtxTotal).sliceSize(first, count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            dstNrm[i] = pack<osp::Vector2b>(octahedral_encode(srcNrm[i]));
+        }
+    }
+    else
+    {
+        auto const dstNrm = rCompact.vbufNormalsOct16.view(rCompact.vrtxBuffer, rChInfo.vrtxTotal).sliceSize(first, count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            dstNrm[i] = pack<osp::Vector2s>(octahedral_encode(srcNrm[i]));
+        }
+    }
+}
+
 } // namespace planeta
@@ -108,6 +108,97 @@ struct BasicChunkMeshGeometry
     osp::Vector3l originSkelPos{osp::ZeroInit};
 };
 
+/**
+ * @brief Normal encoding used by \c ChunkMeshCompactGeometry, or None to not use it at all
+ */
+enum class EChunkCompactNormals : std::uint8_t
+{
+    None,   ///< Compact vertex buffer is not used
+    Oct8,   ///< Octahedral-encoded, 2x signed normalized 8-bit
+    Oct16   ///< Octahedral-encoded, 2x signed normalized 16-bit
+};
+
+/**
+ * @brief Optional compact copy of \c BasicChunkMeshGeometry::vrtxBuffer, uploaded to the GPU in
+ *        place of the float buffer when used
+ *
+ * Interleaves a 6-byte position with a 2 or 4-byte normal, compared to 24 bytes per vertex in
+ * BasicChunkMeshGeometry. Float positions and normals are still kept there on the CPU, as
+ * they're needed to accumulate normals and subdivide chunk fill vertices.
+ *
+ * Positions are half-floats relative to \c origin, divided by 2^posExponent to fit the planet
+ * within half-float range. A per-chunk origin isn't used, since shared vertices belong to
+ * multiple chunks and the whole buffer is drawn as a single mesh.
+ *
+ * Half-floats have 11 significant bits, so error is about 1/2048th of the distance from
+ * \c origin regardless of posExponent. BasicChunkMeshGeometry::originSkelPos only follows the
+ * scene's floating origin, which can be tens of kilometers away from the viewer, so this keeps
+ * its own origin within originMaxDistance of the viewer instead; see \c compact_recenter.
+ *
+ * Multiply positions by 2^posExponent then add \c origin (e.g. through the mesh's transform) to
+ * get meters relative to BasicChunkMeshGeometry::originSkelPos.
+ */
+struct ChunkMeshCompactGeometry
+{
+    void resize(ChunkMeshBufferInfo const& info, EChunkCompactNormals normalFormat, int exponent);
+
+    constexpr bool is_used() const noexcept { return normals != EChunkCompactNormals::None; }
+
+    Corrade::Containers::Array<std::byte>   vrtxBuffer; ///< Compact output vertex buffer
+
+    osp::BufAttribFormat<osp::Vector3h>     vbufPositions;      ///< Scaled half-float positions
+    osp::BufAttribFormat<osp::Vector2b>     vbufNormalsOct8;    ///< Used if normals == Oct8
+    osp::BufAttribFormat<osp::Vector2s>     vbufNormalsOct16;   ///< Used if normals == Oct16
+
+    EChunkCompactNormals                    normals     {EChunkCompactNormals::None};
+
+    /// Positions are stored divided by 2^posExponent
+    int                                     posExponent {};
+
+    /// Origin of positions in meters, relative to BasicChunkMeshGeometry::originSkelPos
+    osp::Vector3                            origin      {osp::ZeroInit};
+
+    /// Distance in meters the viewer can move away from \c origin before it's moved, which
+    /// requires rewriting all positions. Vertex error near the viewer is at most about
+    /// 1/2048th of this plus the vertex's distance to the viewer.
+    float                                   originMaxDistance {512.0f};
+};
+
+/**
+ * @brief Pick a ChunkMeshCompactGeometry::posExponent that fits positions up to maxDistance
+ *        meters away from the mesh origin within half-float range
+ */
+int compact_pos_exponent(double maxDistance) noexcept;
+
+/**
+ * @brief Move ChunkMeshCompactGeometry::origin to the viewer if it's too far away
+ *
+ * @param viewer [in] Viewer position in meters, relative to BasicChunkMeshGeometry::originSkelPos
+ *
+ * @return true if the origin moved, and all compact positions must be rewritten
+ */
+bool compact_recenter(ChunkMeshCompactGeometry &rCompact, osp::Vector3 viewer) noexcept;
+
+/**
+ * @brief Encode a unit vector into 2 components in [-1, 1] using octahedral mapping
+ */
+osp::Vector2 octahedral_encode(osp::Vector3 normal) noexcept;
+
+/**
+ * @brief Decode a vector encoded with \c octahedral_encode; result is normalized
+ */
+osp::Vector3 octahedral_decode(osp::Vector2 encoded) noexcept;
+
+/**
+ * @brief Copy a range of vertices from BasicChunkMeshGeometry into the compact vertex buffer
+ */
+void compact_write_vertices(
+        BasicChunkMeshGeometry      const &rGeom,
+        ChunkMeshCompactGeometry          &rCompact,
+        ChunkMeshBufferInfo         const &rChInfo,
+        VertexIdx                         first,
+        std::uint32_t                     count) noexcept;
+
 /**
  * @brief Face writer used for ChunkFanStitcher
  *
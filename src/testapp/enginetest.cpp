@@ -98,7 +98,7 @@ struct EngineTestScene
 
     // Set of DrawEnts that are assigned a Phong material
     osp::draw::DrawEntSet_t         m_matPhong;
-    std::vector<osp::draw::DrawEnt> m_matPhongDirty;
+    osp::draw::DrawEntDirty         m_matPhongDirty;
 
     osp::draw::ACtxSceneRender      m_scnRdr;
 };
@@ -149,14 +149,14 @@ entt::any make_scene(osp::Resources& rResources, osp::PkgId const pkg)
     rScene.m_scnRdr.m_needDrawTf.insert(cubeEnt);
     rScene.m_scnRdr.m_activeToDraw[cubeEnt] = cubeDraw;
     rScene.m_scnRdr.m_mesh[cubeDraw] = rScene.m_drawing.m_meshRefCounts.ref_add(meshCube);
-    rScene.m_scnRdr.m_meshDirty.push_back(cubeDraw);
+    rScene.m_scnRdr.m_meshDirty.mark(cubeDraw);
 
     // Add transform
     rScene.m_basic.m_transform.emplace(cubeEnt);
 
     // Add phong material to cube
     rScene.m_matPhong.insert(cubeDraw);
-    rScene.m_matPhongDirty.push_back(cubeDraw);
+    rScene.m_matPhongDirty.mark(cubeDraw);
 
     // Add drawble, opaque, and visible component
     rScene.m_scnRdr.m_visible.insert(cubeDraw);
@@ -209,6 +209,10 @@ struct EngineTestRenderer
     // for ActiveEnts
     osp::draw::ACtxSceneRenderGL m_sceneRenderGL{};
 
+    // Draw state published by sync_test_scene, which rendering reads instead
+    // of the scene
+    osp::draw::ACtxRenderSnapshots m_snapshots;
+
     // Pre-built easy camera controls
     osp::draw::Camera m_cam;
     ACtxCameraController m_camCtrl;
@@ -238,9 +242,10 @@ void sync_test_scene(
     rScene.m_scnRdr.m_drawTransform         .resize(rScene.m_scnRdr.m_drawIds.capacity());
     rRenderer.m_sceneRenderGL.m_diffuseTexId.resize(rScene.m_scnRdr.m_drawIds.capacity());
     rRenderer.m_sceneRenderGL.m_meshId      .resize(rScene.m_scnRdr.m_drawIds.capacity());
+    rRenderer.m_sceneRenderGL.m_pending     .resize(rScene.m_scnRdr.m_drawIds.capacity());
 
     // Assign or remove phong shaders from entities marked dirty
-    sync_drawent_phong(rScene.m_matPhongDirty.cbegin(), rScene.m_matPhongDirty.cend(),
+    sync_drawent_phong(rScene.m_matPhongDirty.begin(), rScene.m_matPhongDirty.end(),
     {
         .hasMaterial    = rScene.m_matPhong,
         .pStorageOpaque = &rRenderer.m_groupFwdOpaque.entities,
@@ -250,9 +255,10 @@ void sync_test_scene(
         .rData          = rRenderer.m_phong
     });
 
-    // Load required meshes and textures into OpenGL
+    // Queue required meshes and textures for upload, and copy what's been prepared so far
     SysRenderGL::compile_resource_meshes  (rScene.m_drawingRes, *rScene.m_pResources, rRenderGl);
     SysRenderGL::compile_resource_textures(rScene.m_drawingRes, *rScene.m_pResources, rRenderGl);
+    SysRenderGL::upload_resources(rRenderGl);
 
     // Assign GL meshes to entities with a mesh component
     SysRenderGL::sync_drawent_mesh(
@@ -261,6 +267,7 @@ void sync_test_scene(
             rScene.m_scnRdr.m_mesh,
             rScene.m_drawingRes.m_meshToRes,
             rRenderer.m_sceneRenderGL.m_meshId,
+            rRenderer.m_sceneRenderGL.m_pending,
             rRenderGl);
 
     // Assign GL textures to entities with a texture component
@@ -270,8 +277,12 @@ void sync_test_scene(
             rScene.m_scnRdr.m_diffuseTex,
             rScene.m_drawingRes.m_texToRes,
             rRenderer.m_sceneRenderGL.m_diffuseTexId,
+            rRenderer.m_sceneRenderGL.m_pending,
             rRenderGl);
 
+    // Entities with meshes or textures still uploading are left out of the render queue
+    SysRenderGL::update_pending(rRenderer.m_sceneRenderGL, rRenderGl);
+
     // Calculate hierarchy transforms
 
     auto drawTfDirty = {rScene.m_cube};
@@ -282,10 +293,13 @@ void sync_test_scene(
                 .transforms   = rScene.m_basic .m_transform,
                 .activeToDraw = rScene.m_scnRdr.m_activeToDraw,
                 .needDrawTf   = rScene.m_scnRdr.m_needDrawTf,
-                .rDrawTf      = rScene.m_scnRdr.m_drawTransform
+                .rDrawTf      = rScene.m_scnRdr.m_drawTransform,
+                .pDirty       = &rScene.m_scnRdr.m_drawTfDirty
             },
             drawTfDirty.begin(),
             drawTfDirty.end());
+
+    SysRenderSnapshot::publish(rRenderer.m_snapshots, rScene.m_scnRdr);
 }
 
 /**
@@ -317,10 +331,21 @@ void render_test_scene(
     rFbo.clear( FramebufferClear::Color | FramebufferClear::Depth
                 | FramebufferClear::Stencil);
 
+    SysRenderSnapshot::interpolate(rRenderer.m_snapshots, 1.0f);
+    RenderFrame const &frame = rRenderer.m_snapshots.frame;
+
     // Forward Render fwd_opaque group to FBO
-    SysRenderGL::render_opaque(
-            rRenderer.m_groupFwdOpaque,
-            rScene.m_scnRdr.m_visible, viewProj);
+    ACtxCulling &rCulling = rRenderer.m_sceneRenderGL.m_culling;
+    SysCulling::update(rCulling, frame, rScene.m_scnRdr, rScene.m_drawing, viewProj.m_viewProj);
+    SysRenderGL::select_lods(rRenderer.m_sceneRenderGL, rRenderGl, rCulling, viewProj);
+
+    RenderQueue &rQueue   = rRenderer.m_sceneRenderGL.m_renderQueue;
+    DrawBatches &rBatches = rRenderer.m_sceneRenderGL.m_drawBatches;
+    SysRenderGL::build_render_queue(
+            rQueue, rBatches, rRenderer.m_groupFwdOpaque, rCulling.visible,
+            frame, rScene.m_scnRdr, rRenderer.m_sceneRenderGL,
+            viewProj, ERenderOrder::StateFirst);
+    SysRenderGL::render_opaque(rQueue, rBatches, viewProj);
 
     // Display FBO
     Texture2D &rFboColor = rRenderGl.m_texGl.get(rRenderGl.m_fboColor);
@@ -341,9 +366,17 @@ entt::any make_renderer(EngineTestScene& rScene, MagnumWindowApp &rApp, RenderGL
     auto const texturedFlags
             = PhongGL::Flag::DiffuseTexture | PhongGL::Flag::AlphaMask
             | PhongGL::Flag::AmbientTexture;
-    rRenderer.m_phong.shaderDiffuse    = PhongGL{PhongGL::Configuration{}.setFlags(texturedFlags).setLightCount(2)};
-    rRenderer.m_phong.shaderUntextured = PhongGL{PhongGL::Configuration{}.setLightCount(2)};
-    rRenderer.m_phong.assign_pointers(rScene.m_scnRdr, rRenderer.m_sceneRenderGL, rRenderGl);
+    auto const instancedFlags
+            = PhongGL::Flag::InstancedTransformation | PhongGL::Flag::VertexColor;
+    auto const uniformConfig = PhongGL::Configuration{}
+                               .setLightCount(2)
+                               .setMaterialCount(PhongUniformBuffers::smc_drawsPerChunk)
+                               .setDrawCount(PhongUniformBuffers::smc_drawsPerChunk);
+    rRenderer.m_phong.shaderDiffuse    = PhongGL{PhongGL::Configuration{uniformConfig}.setFlags(texturedFlags | PhongGL::Flag::UniformBuffers)};
+    rRenderer.m_phong.shaderUntextured = PhongGL{PhongGL::Configuration{uniformConfig}.setFlags(PhongGL::Flag::UniformBuffers)};
+    rRenderer.m_phong.shaderDiffuseInstanced    = PhongGL{PhongGL::Configuration{}.setFlags(texturedFlags | instancedFlags).setLightCount(2)};
+    rRenderer.m_phong.shaderUntexturedInstanced = PhongGL{PhongGL::Configuration{}.setFlags(instancedFlags).setLightCount(2)};
+    rRenderer.m_phong.assign_pointers(rRenderer.m_snapshots.frame, rRenderer.m_sceneRenderGL, rRenderGl);
 
     rRenderer.m_cam.set_aspect_ratio(
             osp::Vector2(Magnum::GL::defaultFramebuffer.viewport().size()));
@@ -355,13 +388,13 @@ entt::any make_renderer(EngineTestScene& rScene, MagnumWindowApp &rApp, RenderGL
         // Set all meshs dirty
         if (rScene.m_scnRdr.m_mesh[drawEnt] != lgrn::id_null<MeshId>())
         {
-            rScene.m_scnRdr.m_meshDirty.push_back(drawEnt);
+            rScene.m_scnRdr.m_meshDirty.mark(drawEnt);
         }
 
         // Set all textures dirty
         if (rScene.m_scnRdr.m_diffuseTex[drawEnt] != lgrn::id_null<TexId>())
         {
-            rScene.m_scnRdr.m_diffuseDirty.push_back(drawEnt);
+            rScene.m_scnRdr.m_diffuseDirty.mark(drawEnt);
         }
     }
 
@@ -370,13 +403,13 @@ entt::any make_renderer(EngineTestScene& rScene, MagnumWindowApp &rApp, RenderGL
         Material &mat = rScene.m_scnRdr.m_materials[materialId];
         for (DrawEnt const drawEnt : mat.m_ents)
         {
-            mat.m_dirty.push_back(drawEnt);
+            mat.m_dirty.mark(drawEnt);
         }
     }
 
     for (DrawEnt const drawEnt : rScene.m_matPhong)
     {
-        rScene.m_matPhongDirty.emplace_back(drawEnt);
+        rScene.m_matPhongDirty.mark(drawEnt);
     }
 
     sync_test_scene(rRenderGl, rScene, rRenderer);
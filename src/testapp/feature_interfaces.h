@@ -69,6 +69,35 @@ struct FIMagnumScene {
 };
 
 
+struct FIHeadless {
+    struct DataIds {
+        DataId renderNull;
+    };
+
+    struct Pipelines {
+        PipelineDef<EStgCont> meshNull          {"meshNull"};
+        PipelineDef<EStgCont> textureNull       {"textureNull"};
+
+        PipelineDef<EStgCont> entMeshNull       {"entMeshNull"};
+        PipelineDef<EStgCont> entTextureNull    {"entTextureNull"};
+    };
+};
+
+
+struct FIHeadlessScene {
+    struct DataIds {
+        DataId scnRenderNull;
+        DataId groupFwd;
+        DataId camera;
+        DataId drawNull;
+    };
+
+    struct Pipelines {
+        PipelineDef<EStgCont> camera            {"camera"};
+    };
+};
+
+
 struct FIShaderVisualizer {
     struct DataIds {
         DataId shader;
@@ -0,0 +1,229 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "headless.h"
+
+#include "../feature_interfaces.h"
+
+#include <osp/drawing/drawing.h>
+#include <osp_drawing_null/rendernull.h>
+
+using namespace osp::active;
+using namespace osp::draw;
+using namespace osp::fw;
+using namespace osp;
+using namespace ftr_inter;
+using namespace ftr_inter::stages;
+
+namespace testapp
+{
+
+using DrawNullMaterials_t = KeyedVec<MaterialId, ACtxDrawNull>;
+
+FeatureDef const ftrHeadless = feature_def("Headless", [] (
+        FeatureBuilder              &rFB,
+        Implement<FIHeadless>       headless,
+        DependOn<FICleanupContext>  cleanup,
+        DependOn<FIWindowApp>       windowApp,
+        DependOn<FIMainApp>         mainApp)
+{
+    rFB.pipeline(headless.pl.meshNull)         .parent(windowApp.pl.sync);
+    rFB.pipeline(headless.pl.textureNull)      .parent(windowApp.pl.sync);
+    rFB.pipeline(headless.pl.entMeshNull)      .parent(windowApp.pl.sync);
+    rFB.pipeline(headless.pl.entTextureNull)   .parent(windowApp.pl.sync);
+
+    rFB.data_emplace<RenderNull>(headless.di.renderNull);
+
+    rFB.task()
+        .name       ("Clean up headless renderer")
+        .run_on     ({cleanup.pl.cleanup(Run_)})
+        .args       ({    mainApp.di.resources,  headless.di.renderNull})
+        .func       ([] (Resources &rResources, RenderNull &rRenderNull) noexcept
+    {
+        SysRenderNull::clear_resource_owners(rRenderNull, rResources);
+    });
+
+}); // ftrHeadless
+
+
+
+FeatureDef const ftrHeadlessScene = feature_def("HeadlessScene", [] (
+        FeatureBuilder              &rFB,
+        Implement<FIHeadlessScene>  headlessScn,
+        DependOn<FIMainApp>         mainApp,
+        DependOn<FICommonScene>     comScn,
+        DependOn<FIHeadless>        headless,
+        DependOn<FIWindowApp>       windowApp,
+        DependOn<FISceneRenderer>   scnRender)
+{
+    rFB.pipeline(headlessScn.pl.camera).parent(scnRender.pl.render);
+
+    auto &rScnRender    = rFB.data_get< ACtxSceneRender >       (scnRender.di.scnRender);
+    auto &rSnapshots    = rFB.data_get< ACtxRenderSnapshots >   (scnRender.di.snapshots);
+
+    auto &rScnRenderNull = rFB.data_emplace< ACtxSceneRenderNull > (headlessScn.di.scnRenderNull);
+    /* not used here */    rFB.data_emplace< RenderGroup >         (headlessScn.di.groupFwd);
+    auto &rCamera        = rFB.data_emplace< Camera >              (headlessScn.di.camera);
+    auto &rDrawNull      = rFB.data_emplace< DrawNullMaterials_t > (headlessScn.di.drawNull);
+
+    rCamera.m_far = 100000000.0f;
+    rCamera.m_near = 1.0f;
+    rCamera.m_fov = Magnum::Deg(45.0f);
+
+    // Not resized after this, as EntityToDraw stores pointers to these
+    rDrawNull.resize(rScnRender.m_materialIds.capacity());
+    for (MaterialId const matId : rScnRender.m_materialIds)
+    {
+        rDrawNull[matId].materialId = matId;
+        rDrawNull[matId].assign_pointers(rSnapshots.frame, rScnRenderNull);
+    }
+
+    rFB.task()
+        .name       ("Resize ACtxSceneRenderNull to fit all DrawEnts")
+        .run_on     ({scnRender.pl.drawEntResized(Run)})
+        .sync_with  ({})
+        .args       ({ scnRender.di.scnRender, headlessScn.di.scnRenderNull })
+        .func       ([] (ACtxSceneRender const &rScnRender, ACtxSceneRenderNull &rScnRenderNull) noexcept
+    {
+        std::size_t const capacity = rScnRender.m_drawIds.capacity();
+        rScnRenderNull.m_diffuseTexId   .resize(capacity);
+        rScnRenderNull.m_meshId         .resize(capacity);
+    });
+
+    rFB.task()
+        .name       ("Compile Resource Meshes to headless renderer")
+        .run_on     ({scnRender.pl.meshResDirty(UseOrRun)})
+        .sync_with  ({scnRender.pl.mesh(Ready), headless.pl.meshNull(New), scnRender.pl.entMeshDirty(UseOrRun)})
+        .args       ({                 comScn.di.drawingRes,                mainApp.di.resources,        headless.di.renderNull })
+        .func([] (ACtxDrawingRes const &rDrawingRes, osp::Resources &rResources, RenderNull &rRenderNull) noexcept
+    {
+        SysRenderNull::compile_resource_meshes(rDrawingRes, rResources, rRenderNull);
+    });
+
+    rFB.task()
+        .name       ("Compile Resource Textures to headless renderer")
+        .run_on     ({scnRender.pl.textureResDirty(UseOrRun)})
+        .sync_with  ({scnRender.pl.texture(Ready), headless.pl.textureNull(New)})
+        .args       ({                 comScn.di.drawingRes,                mainApp.di.resources,        headless.di.renderNull })
+        .func([] (ACtxDrawingRes const &rDrawingRes, osp::Resources &rResources, RenderNull &rRenderNull) noexcept
+    {
+        SysRenderNull::compile_resource_textures(rDrawingRes, rResources, rRenderNull);
+    });
+
+    rFB.task()
+        .name       ("Sync headless textures to entities with scene textures")
+        .run_on     ({scnRender.pl.entTextureDirty(UseOrRun)})
+        .sync_with  ({scnRender.pl.texture(Ready), scnRender.pl.entTexture(Ready), headless.pl.textureNull(Ready), headless.pl.entTextureNull(Modify), scnRender.pl.drawEntResized(Done)})
+        .args       ({           comScn.di.drawingRes,                 scnRender.di.scnRender,                   headlessScn.di.scnRenderNull,        headless.di.renderNull })
+        .func([] (ACtxDrawingRes &rDrawingRes, ACtxSceneRender &rScnRender, ACtxSceneRenderNull &rScnRenderNull, RenderNull const &rRenderNull) noexcept
+    {
+        SysRenderNull::sync_drawent_texture(
+                rScnRender.m_diffuseDirty.begin(),
+                rScnRender.m_diffuseDirty.end(),
+                rScnRender.m_diffuseTex,
+                rDrawingRes.m_texToRes,
+                rScnRenderNull.m_diffuseTexId,
+                rRenderNull);
+    });
+
+    rFB.task()
+        .name       ("Sync headless meshes to entities with scene meshes")
+        .run_on     ({scnRender.pl.entMeshDirty(UseOrRun)})
+        .sync_with  ({scnRender.pl.mesh(Ready), scnRender.pl.entMesh(Ready), headless.pl.meshNull(Ready), headless.pl.entMeshNull(Modify), scnRender.pl.drawEntResized(Done)})
+        .args       ({           comScn.di.drawingRes,                 scnRender.di.scnRender,                   headlessScn.di.scnRenderNull,        headless.di.renderNull })
+        .func       ([] (ACtxDrawingRes &rDrawingRes, ACtxSceneRender &rScnRender, ACtxSceneRenderNull &rScnRenderNull, RenderNull const &rRenderNull) noexcept
+    {
+        SysRenderNull::sync_drawent_mesh(
+                rScnRender.m_meshDirty.begin(),
+                rScnRender.m_meshDirty.end(),
+                rScnRender.m_mesh,
+                rDrawingRes.m_meshToRes,
+                rScnRenderNull.m_meshId,
+                rRenderNull);
+    });
+
+    rFB.task()
+        .name       ("Sync headless DrawEnts of all materials")
+        .run_on     ({windowApp.pl.sync(Run)})
+        .sync_with  ({scnRender.pl.materialDirty(UseOrRun), scnRender.pl.groupEnts(Modify), scnRender.pl.group(Modify)})
+        .args       ({        scnRender.di.scnRender,  headlessScn.di.groupFwd,          headlessScn.di.drawNull })
+        .func       ([] (ACtxSceneRender &rScnRender, RenderGroup &rGroupFwd, DrawNullMaterials_t &rDrawNull) noexcept
+    {
+        for (MaterialId const matId : rScnRender.m_materialIds)
+        {
+            if (std::size_t(matId) >= rDrawNull.size() || rDrawNull[matId].materialId != matId)
+            {
+                continue; // Added after ftrHeadlessScene
+            }
+
+            Material const &rMat = rScnRender.m_materials[matId];
+            sync_drawent_null(rMat.m_dirty.begin(), rMat.m_dirty.end(),
+            {
+                .hasMaterial    = rMat.m_ents,
+                .pStorageOpaque = &rGroupFwd.entities,
+                /* TODO: set .pStorageTransparent */
+                .opaque         = rScnRender.m_opaque,
+                .transparent    = rScnRender.m_transparent,
+                .rData          = rDrawNull[matId]
+            });
+        }
+    });
+
+    rFB.task()
+        .name       ("Render Entities headlessly")
+        .run_on     ({scnRender.pl.render(Run)})
+        .sync_with  ({scnRender.pl.group(Ready), scnRender.pl.groupEnts(Ready), headlessScn.pl.camera(Ready), scnRender.pl.snapshot(Ready), scnRender.pl.entMesh(Ready), scnRender.pl.entTexture(Ready),
+                      headless.pl.entMeshNull(Ready), headless.pl.entTextureNull(Ready),
+                      scnRender.pl.drawEnt(Ready)})
+        .args       ({              comScn.di.drawing,            scnRender.di.scnRender,                    scnRender.di.snapshots,                   headlessScn.di.scnRenderNull,  headlessScn.di.groupFwd,     headlessScn.di.camera })
+        .func       ([] (ACtxDrawing const &rDrawing, ACtxSceneRender &rScnRender, ACtxRenderSnapshots &rSnapshots, ACtxSceneRenderNull &rScnRenderNull, RenderGroup const &rGroupFwd, Camera const &rCamera) noexcept
+    {
+        ViewProjMatrix viewProj{rCamera.m_transform.inverted(), rCamera.perspective()};
+
+        // Commands are kept until the next frame so they can be inspected
+        rScnRenderNull.m_commands.clear();
+
+        SysRenderSnapshot::interpolate(rSnapshots, 1.0f);
+
+        SysCulling::update(rScnRenderNull.m_culling, rSnapshots.frame, rScnRender, rDrawing, viewProj.m_viewProj);
+
+        SysRenderNull::build_render_queue(rScnRenderNull.m_renderQueue, rScnRenderNull.m_drawBatches, rGroupFwd, rScnRenderNull.m_culling.visible, rSnapshots.frame, rScnRender, rScnRenderNull, viewProj, ERenderOrder::StateFirst);
+        SysRenderNull::render(rScnRenderNull.m_renderQueue, rScnRenderNull.m_drawBatches, viewProj);
+    });
+
+    rFB.task()
+        .name       ("Delete entities from headless render groups")
+        .run_on     ({scnRender.pl.drawEntDelete(UseOrRun)})
+        .sync_with  ({scnRender.pl.groupEnts(Delete)})
+        .args       ({              comScn.di.drawing,          headlessScn.di.groupFwd,              comScn.di.drawEntDel })
+        .func       ([] (ACtxDrawing const &rDrawing, RenderGroup &rGroup, DrawEntVec_t const &rDrawEntDel) noexcept
+    {
+        for (DrawEnt const drawEnt : rDrawEntDel)
+        {
+            rGroup.entities.remove(drawEnt);
+        }
+    });
+}); // ftrHeadlessScene
+
+} // namespace testapp
@@ -91,6 +91,16 @@ FeatureDef const ftrMagnum = feature_def("Magnum", [] (
 
     SysRenderGL::setup_context(rRenderGl);
 
+    rFB.task()
+        .name       ("Upload prepared meshes and textures to GL")
+        .run_on     ({windowApp.pl.sync(Run)})
+        .sync_with  ({magnum.pl.meshGL(Modify), magnum.pl.textureGL(Modify)})
+        .args       ({      magnum.di.renderGl })
+        .func       ([] (RenderGL &rRenderGl) noexcept
+    {
+        SysRenderGL::upload_resources(rRenderGl);
+    });
+
     rFB.task()
         .name       ("Clean up Magnum renderer")
         .run_on     ({cleanup.pl.cleanup(Run_)})
@@ -137,6 +147,7 @@ FeatureDef const ftrMagnumScene = feature_def("MagnumScene", [] (
         std::size_t const capacity = rScnRender.m_drawIds.capacity();
         rScnRenderGl.m_diffuseTexId   .resize(capacity);
         rScnRenderGl.m_meshId         .resize(capacity);
+        rScnRenderGl.m_pending        .resize(capacity);
     });
 
     rFB.task()
@@ -172,27 +183,10 @@ FeatureDef const ftrMagnumScene = feature_def("MagnumScene", [] (
                 rScnRender.m_diffuseTex,
                 rDrawingRes.m_texToRes,
                 rScnRenderGl.m_diffuseTexId,
+                rScnRenderGl.m_pending,
                 rRenderGl);
     });
 
-    rFB.task()
-        .name       ("Resync GL textures")
-        .run_on     ({windowApp.pl.resync(Run)})
-        .sync_with  ({scnRender.pl.texture(Ready), magnum.pl.textureGL(Ready), magnum.pl.entTextureGL(Modify), scnRender.pl.drawEntResized(Done)})
-        .args       ({           comScn.di.drawingRes,                 scnRender.di.scnRender,                   magnumScn.di.scnRenderGl,          magnum.di.renderGl })
-        .func([] (ACtxDrawingRes &rDrawingRes, ACtxSceneRender &rScnRender, ACtxSceneRenderGL &rScnRenderGl, RenderGL &rRenderGl) noexcept
-    {
-        for (DrawEnt const drawEnt : rScnRender.m_drawIds)
-        {
-            SysRenderGL::sync_drawent_texture(
-                    drawEnt,
-                    rScnRender.m_diffuseTex,
-                    rDrawingRes.m_texToRes,
-                    rScnRenderGl.m_diffuseTexId,
-                    rRenderGl);
-        }
-    });
-
     rFB.task()
         .name       ("Sync GL meshes to entities with scene meshes")
         .run_on     ({scnRender.pl.entMeshDirty(UseOrRun)})
@@ -206,25 +200,18 @@ FeatureDef const ftrMagnumScene = feature_def("MagnumScene", [] (
                 rScnRender.m_mesh,
                 rDrawingRes.m_meshToRes,
                 rScnRenderGl.m_meshId,
+                rScnRenderGl.m_pending,
                 rRenderGl);
     });
 
     rFB.task()
-        .name       ("Resync GL meshes")
-        .run_on     ({windowApp.pl.resync(Run)})
-        .sync_with  ({scnRender.pl.mesh(Ready), magnum.pl.meshGL(Ready), magnum.pl.entMeshGL(Modify), scnRender.pl.drawEntResized(Done)})
-        .args       ({           comScn.di.drawingRes,                 scnRender.di.scnRender,                   magnumScn.di.scnRenderGl,          magnum.di.renderGl })
-        .func([] (ACtxDrawingRes &rDrawingRes, ACtxSceneRender &rScnRender, ACtxSceneRenderGL &rScnRenderGl, RenderGL &rRenderGl) noexcept
+        .name       ("Draw DrawEnts once their GL meshes and textures are uploaded")
+        .run_on     ({windowApp.pl.sync(Run)})
+        .sync_with  ({magnum.pl.meshGL(Ready), magnum.pl.textureGL(Ready), magnum.pl.entMeshGL(Modify), magnum.pl.entTextureGL(Modify), scnRender.pl.drawEntResized(Done)})
+        .args       ({                 magnumScn.di.scnRenderGl,          magnum.di.renderGl })
+        .func       ([] (ACtxSceneRenderGL &rScnRenderGl, RenderGL const &rRenderGl) noexcept
     {
-        for (DrawEnt const drawEnt : rScnRender.m_drawIds)
-        {
-            SysRenderGL::sync_drawent_mesh(
-                    drawEnt,
-                    rScnRender.m_mesh,
-                    rDrawingRes.m_meshToRes,
-                    rScnRenderGl.m_meshId,
-                    rRenderGl);
-        }
+        SysRenderGL::update_pending(rScnRenderGl, rRenderGl);
     });
 
     rFB.task()
@@ -250,16 +237,23 @@ FeatureDef const ftrMagnumScene = feature_def("MagnumScene", [] (
     rFB.task()
         .name       ("Render Entities")
         .run_on     ({scnRender.pl.render(Run)})
-        .sync_with  ({scnRender.pl.group(Ready), scnRender.pl.groupEnts(Ready), magnumScn.pl.camera(Ready), scnRender.pl.drawTransforms(UseOrRun), scnRender.pl.entMesh(Ready), scnRender.pl.entTexture(Ready),
+        .sync_with  ({scnRender.pl.group(Ready), scnRender.pl.groupEnts(Ready), magnumScn.pl.camera(Ready), scnRender.pl.snapshot(Ready), scnRender.pl.entMesh(Ready), scnRender.pl.entTexture(Ready),
                       magnum.pl.entMeshGL(Ready), magnum.pl.entTextureGL(Ready),
                       scnRender.pl.drawEnt(Ready)})
-        .args       ({            scnRender.di.scnRender,          magnum.di.renderGl,    magnumScn.di.groupFwd,     magnumScn.di.camera })
-        .func       ([] (ACtxSceneRender &rScnRender, RenderGL &rRenderGl, RenderGroup const &rGroupFwd, Camera const &rCamera) noexcept
+        .args       ({              comScn.di.drawing,            scnRender.di.scnRender,                    scnRender.di.snapshots,                   magnumScn.di.scnRenderGl,          magnum.di.renderGl,    magnumScn.di.groupFwd,     magnumScn.di.camera })
+        .func       ([] (ACtxDrawing const &rDrawing, ACtxSceneRender &rScnRender, ACtxRenderSnapshots &rSnapshots, ACtxSceneRenderGL &rScnRenderGl, RenderGL const &rRenderGl, RenderGroup const &rGroupFwd, Camera const &rCamera) noexcept
     {
         ViewProjMatrix viewProj{rCamera.m_transform.inverted(), rCamera.perspective()};
 
+        // Draw the latest snapshot; there's no fixed physics step to interpolate within yet
+        SysRenderSnapshot::interpolate(rSnapshots, 1.0f);
+
+        SysCulling::update(rScnRenderGl.m_culling, rSnapshots.frame, rScnRender, rDrawing, viewProj.m_viewProj);
+        SysRenderGL::select_lods(rScnRenderGl, rRenderGl, rScnRenderGl.m_culling, viewProj);
+
         // Forward Render fwd_opaque group to FBO
-        SysRenderGL::render_opaque(rGroupFwd, rScnRender.m_visible, viewProj);
+        SysRenderGL::build_render_queue(rScnRenderGl.m_renderQueue, rScnRenderGl.m_drawBatches, rGroupFwd, rScnRenderGl.m_culling.visible, rSnapshots.frame, rScnRender, rScnRenderGl, viewProj, ERenderOrder::StateFirst);
+        SysRenderGL::render_opaque(rScnRenderGl.m_renderQueue, rScnRenderGl.m_drawBatches, viewProj);
     });
 
     rFB.task()
@@ -326,7 +320,7 @@ FeatureDef const ftrShaderVisualizer = feature_def("ShaderVisualizer", [] (
     auto const materialId = userData /* if not null */ ? entt::any_cast<MaterialId>(userData)
                                                        : MaterialId{};
 
-    auto &rScnRender    = rFB.data_get< ACtxSceneRender >    (scnRender.di.scnRender);
+    auto &rSnapshots    = rFB.data_get< ACtxRenderSnapshots >(scnRender.di.snapshots);
     auto &rScnRenderGl  = rFB.data_get< ACtxSceneRenderGL >  (magnumScn.di.scnRenderGl);
     auto &rRenderGl     = rFB.data_get< RenderGL >           (magnum.di.renderGl);
 
@@ -334,7 +328,7 @@ FeatureDef const ftrShaderVisualizer = feature_def("ShaderVisualizer", [] (
 
     rDrawVisual.m_materialId = materialId;
     rDrawVisual.m_shader = MeshVisualizer{ MeshVisualizer::Configuration{}.setFlags(MeshVisualizer::Flag::Wireframe) };
-    rDrawVisual.assign_pointers(rScnRender, rScnRenderGl, rRenderGl);
+    rDrawVisual.assign_pointers(rSnapshots.frame, rScnRenderGl, rRenderGl);
 
     // Default colors
     rDrawVisual.m_shader.setWireframeColor({0.7f, 0.5f, 0.7f, 1.0f});
@@ -358,19 +352,6 @@ FeatureDef const ftrShaderVisualizer = feature_def("ShaderVisualizer", [] (
         sync_drawent_visualizer(rMat.m_dirty.begin(), rMat.m_dirty.end(), rMat.m_ents, rGroupFwd.entities, rDrawShVisual);
     });
 
-    rFB.task()
-        .name       ("Resync MeshVisualizer shader DrawEnts")
-        .run_on     ({windowApp.pl.resync(Run)})
-        .sync_with  ({scnRender.pl.groupEnts(Modify), scnRender.pl.group(Modify)})
-        .args       ({            scnRender.di.scnRender,             magnumScn.di.groupFwd,                        shVisual.di.shader})
-        .func([] (ACtxSceneRender &rScnRender, RenderGroup &rGroupFwd, ACtxDrawMeshVisualizer &rDrawShVisual) noexcept
-    {
-        Material const &rMat = rScnRender.m_materials[rDrawShVisual.m_materialId];
-        for (DrawEnt const drawEnt : rMat.m_ents)
-        {
-            sync_drawent_visualizer(drawEnt, rMat.m_ents, rGroupFwd.entities, rDrawShVisual);
-        }
-    });
 }); // ftrShaderVisualizer
 
 
@@ -386,16 +367,23 @@ FeatureDef const ftrShaderFlat = feature_def("ShaderFlat", [] (
     auto const materialId = userData /* if not null */ ? entt::any_cast<MaterialId>(userData)
                                                        : MaterialId{};
 
-    auto &rScnRender    = rFB.data_get< ACtxSceneRender >    (scnRender.di.scnRender);
+    auto &rSnapshots    = rFB.data_get< ACtxRenderSnapshots >(scnRender.di.snapshots);
     auto &rScnRenderGl  = rFB.data_get< ACtxSceneRenderGL >  (magnumScn.di.scnRenderGl);
     auto &rRenderGl     = rFB.data_get< RenderGL >           (magnum.di.renderGl);
 
     auto &rDrawFlat = rFB.data_emplace< ACtxDrawFlat >(shFlat.di.shader);
 
-    rDrawFlat.shaderDiffuse       = FlatGL3D{FlatGL3D::Configuration{}.setFlags(FlatGL3D::Flag::Textured)};
-    rDrawFlat.shaderUntextured    = FlatGL3D{FlatGL3D::Configuration{}};
+    // Non-instanced shaders read all uniforms from buffers, see prepare_ent_flat
+    auto const uniformConfig      = FlatGL3D::Configuration{}
+                                    .setMaterialCount(FlatUniformBuffers::smc_drawsPerChunk)
+                                    .setDrawCount(FlatUniformBuffers::smc_drawsPerChunk);
+    auto const instancedFlags     = FlatGL3D::Flag::InstancedTransformation | FlatGL3D::Flag::VertexColor;
+    rDrawFlat.shaderDiffuse       = FlatGL3D{FlatGL3D::Configuration{uniformConfig}.setFlags(FlatGL3D::Flag::Textured | FlatGL3D::Flag::UniformBuffers)};
+    rDrawFlat.shaderUntextured    = FlatGL3D{FlatGL3D::Configuration{uniformConfig}.setFlags(FlatGL3D::Flag::UniformBuffers)};
+    rDrawFlat.shaderDiffuseInstanced    = FlatGL3D{FlatGL3D::Configuration{}.setFlags(FlatGL3D::Flag::Textured | instancedFlags)};
+    rDrawFlat.shaderUntexturedInstanced = FlatGL3D{FlatGL3D::Configuration{}.setFlags(instancedFlags)};
     rDrawFlat.materialId          = materialId;
-    rDrawFlat.assign_pointers(rScnRender, rScnRenderGl, rRenderGl);
+    rDrawFlat.assign_pointers(rSnapshots.frame, rScnRenderGl, rRenderGl);
 
     if (materialId == lgrn::id_null<MaterialId>())
     {
@@ -424,28 +412,6 @@ FeatureDef const ftrShaderFlat = feature_def("ShaderFlat", [] (
         });
     });
 
-    rFB.task()
-        .name       ("Resync Flat shader DrawEnts")
-        .run_on     ({windowApp.pl.resync(Run)})
-        .sync_with  ({scnRender.pl.materialDirty(UseOrRun), magnum.pl.textureGL(Ready), scnRender.pl.groupEnts(Modify), scnRender.pl.group(Modify)})
-        .args       ({            scnRender.di.scnRender,             magnumScn.di.groupFwd,                         magnumScn.di.scnRenderGl,              shFlat.di.shader})
-        .func([] (ACtxSceneRender &rScnRender, RenderGroup &rGroupFwd, ACtxSceneRenderGL const &rScnRenderGl, ACtxDrawFlat &rDrawShFlat) noexcept
-    {
-        Material const &rMat = rScnRender.m_materials[rDrawShFlat.materialId];
-        for (DrawEnt const drawEnt : rMat.m_ents)
-        {
-            sync_drawent_flat(drawEnt,
-            {
-                .hasMaterial    = rMat.m_ents,
-                .pStorageOpaque = &rGroupFwd.entities,
-                /* TODO: set .pStorageTransparent */
-                .opaque         = rScnRender.m_opaque,
-                .transparent    = rScnRender.m_transparent,
-                .diffuse        = rScnRenderGl.m_diffuseTexId,
-                .rData          = rDrawShFlat
-            });
-        }
-    });
 }); // ftrShaderFlat
 
 FeatureDef const ftrShaderPhong = feature_def("ShaderPhong", [] (
@@ -460,17 +426,26 @@ FeatureDef const ftrShaderPhong = feature_def("ShaderPhong", [] (
     auto const materialId = userData /* if not null */ ? entt::any_cast<MaterialId>(userData)
                                                        : MaterialId{};
 
-    auto &rScnRender    = rFB.data_get< ACtxSceneRender >    (scnRender.di.scnRender);
+    auto &rSnapshots    = rFB.data_get< ACtxRenderSnapshots >(scnRender.di.snapshots);
     auto &rScnRenderGl  = rFB.data_get< ACtxSceneRenderGL >  (magnumScn.di.scnRenderGl);
     auto &rRenderGl     = rFB.data_get< RenderGL >           (magnum.di.renderGl);
 
     auto &rDrawPhong = rFB.data_emplace< ACtxDrawPhong >(shPhong.di.shader);
 
     auto const texturedFlags    = PhongGL::Flag::DiffuseTexture | PhongGL::Flag::AlphaMask | PhongGL::Flag::AmbientTexture;
-    rDrawPhong.shaderDiffuse    = PhongGL{PhongGL::Configuration{}.setFlags(texturedFlags).setLightCount(2)};
-    rDrawPhong.shaderUntextured = PhongGL{PhongGL::Configuration{}.setLightCount(2)};
+    auto const instancedFlags   = PhongGL::Flag::InstancedTransformation | PhongGL::Flag::VertexColor;
+
+    // Non-instanced shaders read all uniforms from buffers, see prepare_ent_phong
+    auto const uniformConfig    = PhongGL::Configuration{}
+                                  .setLightCount(2)
+                                  .setMaterialCount(PhongUniformBuffers::smc_drawsPerChunk)
+                                  .setDrawCount(PhongUniformBuffers::smc_drawsPerChunk);
+    rDrawPhong.shaderDiffuse    = PhongGL{PhongGL::Configuration{uniformConfig}.setFlags(texturedFlags | PhongGL::Flag::UniformBuffers)};
+    rDrawPhong.shaderUntextured = PhongGL{PhongGL::Configuration{uniformConfig}.setFlags(PhongGL::Flag::UniformBuffers)};
+    rDrawPhong.shaderDiffuseInstanced    = PhongGL{PhongGL::Configuration{}.setFlags(texturedFlags | instancedFlags).setLightCount(2)};
+    rDrawPhong.shaderUntexturedInstanced = PhongGL{PhongGL::Configuration{}.setFlags(instancedFlags).setLightCount(2)};
     rDrawPhong.materialId       = materialId;
-    rDrawPhong.assign_pointers(rScnRender, rScnRenderGl, rRenderGl);
+    rDrawPhong.assign_pointers(rSnapshots.frame, rScnRenderGl, rRenderGl);
 
     if (materialId == lgrn::id_null<MaterialId>())
     {
@@ -499,27 +474,6 @@ FeatureDef const ftrShaderPhong = feature_def("ShaderPhong", [] (
         });
     });
 
-    rFB.task()
-        .name       ("Resync Phong shader DrawEnts")
-        .run_on     ({windowApp.pl.resync(Run)})
-        .sync_with  ({scnRender.pl.materialDirty(UseOrRun), magnum.pl.entTextureGL(Ready), scnRender.pl.groupEnts(Modify), scnRender.pl.group(Modify)})
-        .args       ({        scnRender.di.scnRender,  magnumScn.di.groupFwd,              magnumScn.di.scnRenderGl,      shPhong.di.shader})
-        .func       ([] (ACtxSceneRender &rScnRender, RenderGroup &rGroupFwd, ACtxSceneRenderGL const &rScnRenderGl, ACtxDrawPhong &rShader) noexcept
-    {
-        Material const &rMat = rScnRender.m_materials[rShader.materialId];
-        for (DrawEnt const drawEnt : rMat.m_ents)
-        {
-            sync_drawent_phong(drawEnt,
-            {
-                .hasMaterial    = rMat.m_ents,
-                .pStorageOpaque = &rGroupFwd.entities,
-                .opaque         = rScnRender.m_opaque,
-                .transparent    = rScnRender.m_transparent,
-                .diffuse        = rScnRenderGl.m_diffuseTexId,
-                .rData          = rShader
-            });
-        }
-    });
 }); // ftrShaderPhong
 
 
@@ -575,26 +529,6 @@ FeatureDef const ftrTerrainDrawMagnum = feature_def("ShaderPhong", [] (
         }
     });
 
-    rFB.task()
-        .name       ("Resync terrainMeshGl to entities with terrainMesh")
-        .run_on     ({windowApp.pl.resync(Run)})
-        .sync_with  ({scnRender.pl.mesh(Ready), magnum.pl.meshGL(Ready), magnum.pl.entMeshGL(Modify), scnRender.pl.drawEntResized(Done)})
-        .args       ({              terrainMgn.di.drawTerrainGL,             terrain.di.terrain,                 scnRender.di.scnRender,              magnumScn.di.scnRenderGl,          magnum.di.renderGl })
-        .func([] (ACtxDrawTerrainGL &rDrawTerrainGl, ACtxTerrain &rTerrain, ACtxSceneRender &rScnRender, ACtxSceneRenderGL &rScnRenderGl, RenderGL &rRenderGl) noexcept
-    {
-        for (DrawEnt const drawEnt : rScnRender.m_drawIds)
-        {
-            MeshIdOwner_t const &entMeshScnId = rScnRender.m_mesh[drawEnt];
-
-            if (entMeshScnId == rTerrain.terrainMesh)
-            {
-                rScnRenderGl.m_meshId[drawEnt] = ACompMeshGl{
-                        .m_scnId = rTerrain.terrainMesh,
-                        .m_glId  = rDrawTerrainGl.terrainMeshGl };
-            }
-        }
-    });
-
     rFB.task()
         .name       ("Update terrain mesh GPU buffer data")
         .run_on     ({windowApp.pl.sync(Run)})
@@ -602,7 +536,8 @@ FeatureDef const ftrTerrainDrawMagnum = feature_def("ShaderPhong", [] (
         .args       ({            scnRender.di.scnRender,             magnumScn.di.groupFwd,                         magnumScn.di.scnRenderGl,          magnum.di.renderGl,                   terrainMgn.di.drawTerrainGL,            terrain.di.terrain})
         .func([] (ACtxSceneRender &rScnRender, RenderGroup &rGroupFwd, ACtxSceneRenderGL const &rScnRenderGl, RenderGL &rRenderGl, ACtxDrawTerrainGL &rDrawTerrainGl, ACtxTerrain &rTerrain) noexcept
     {
-        if ( ! rDrawTerrainGl.enabled )
+        bool const newlyEnabled = ! rDrawTerrainGl.enabled;
+        if (newlyEnabled)
         {
             rDrawTerrainGl.enabled = true;
 
@@ -613,29 +548,77 @@ FeatureDef const ftrTerrainDrawMagnum = feature_def("ShaderPhong", [] (
 
             rMesh = Mesh{Magnum::GL::MeshPrimitive::Triangles};
 
-            auto const &posFormat = rTerrain.chunkGeom.vbufPositions;
-            auto const &nrmFormat = rTerrain.chunkGeom.vbufNormals;
+            if (rTerrain.chunkGeomCompact.is_used())
+            {
+                // Only the compact buffer is uploaded. Positions are scaled down half-floats, see
+                // "Reposition terrain surface mesh". Octahedral normals are not bound, as the
+                // wireframe MeshVisualizer used to draw terrain doesn't read normals.
+                using Position = Magnum::Shaders::GenericGL3D::Position;
+                auto const &posFormat = rTerrain.chunkGeomCompact.vbufPositions;
+
+                rMesh.addVertexBuffer(rDrawTerrainGl.vrtxBufGL, GLintptr(posFormat.offset), GLsizei(posFormat.stride - sizeof(Vector3h)), Position{Position::DataType::Half});
+            }
+            else
+            {
+                auto const &posFormat = rTerrain.chunkGeom.vbufPositions;
+                auto const &nrmFormat = rTerrain.chunkGeom.vbufNormals;
 
+                rMesh.addVertexBuffer(rDrawTerrainGl.vrtxBufGL, GLintptr(posFormat.offset), GLsizei(posFormat.stride - sizeof(Vector3u)), Magnum::Shaders::GenericGL3D::Position{})
+                     .addVertexBuffer(rDrawTerrainGl.vrtxBufGL, GLintptr(nrmFormat.offset), GLsizei(nrmFormat.stride - sizeof(Vector3u)), Magnum::Shaders::GenericGL3D::Normal{});
+            }
 
-            rMesh.addVertexBuffer(rDrawTerrainGl.vrtxBufGL, GLintptr(posFormat.offset), GLsizei(posFormat.stride - sizeof(Vector3u)), Magnum::Shaders::GenericGL3D::Position{})
-                 .addVertexBuffer(rDrawTerrainGl.vrtxBufGL, GLintptr(nrmFormat.offset), GLsizei(nrmFormat.stride - sizeof(Vector3u)), Magnum::Shaders::GenericGL3D::Normal{})
-                 .setIndexBuffer(rDrawTerrainGl.indxBufGL, 0, Magnum::MeshIndexType::UnsignedInt)
+            rMesh.setIndexBuffer(rDrawTerrainGl.indxBufGL, 0, Magnum::MeshIndexType::UnsignedInt)
                  .setCount(Magnum::Int(3*rTerrain.chunkInfo.faceTotal)); // 3 vertices in each triangle
         }
 
-        auto const indxBuffer = arrayCast<unsigned char const>(rTerrain.chunkGeom.indxBuffer);
-        auto const vrtxBuffer = arrayView<std::byte const>(rTerrain.chunkGeom.vrtxBuffer);
+        bool const compact    = rTerrain.chunkGeomCompact.is_used();
+        auto const indxBuffer = arrayCast<std::byte const>(rTerrain.chunkGeom.indxBuffer);
+        auto const vrtxBuffer = compact ? arrayView<std::byte const>(rTerrain.chunkGeomCompact.vrtxBuffer)
+                                        : arrayView<std::byte const>(rTerrain.chunkGeom.vrtxBuffer);
+
+        ChunkScratchpad &rChSP = rTerrain.chunkSP;
+
+        if (newlyEnabled)
+        {
+            // Upload everything once, afterwards only upload ranges that were modified
+            rDrawTerrainGl.indxBufGL.setData(indxBuffer);
+            rDrawTerrainGl.vrtxBufGL.setData(vrtxBuffer);
+            rChSP.vrtxDirty.clear();
+            rChSP.faceDirty.clear();
+            return;
+        }
 
-        // There's faster ways to sync the buffer, but keeping it simple for now
+        auto const upload_attrib_ranges = [&rDrawTerrainGl, vrtxBuffer, &rChSP] (auto const &format)
+        {
+            for (ChunkMeshBufRange const range : rChSP.vrtxDirty)
+            {
+                std::size_t const offset = format.offset + range.first * std::size_t(format.stride);
+                std::size_t const size   = range.count * std::size_t(format.stride);
+                rDrawTerrainGl.vrtxBufGL.setSubData(GLintptr(offset), vrtxBuffer.sliceSize(offset, size));
+            }
+        };
 
-        // see "Buffer re-specification" in
-        // https://www.khronos.org/opengl/wiki/Buffer_Object_Streaming
+        if (compact)
+        {
+            // Interleaved, each range of positions covers the normals too
+            upload_attrib_ranges(rTerrain.chunkGeomCompact.vbufPositions);
+        }
+        else
+        {
+            // Positions and normals are stored in separate blocks
+            upload_attrib_ranges(rTerrain.chunkGeom.vbufPositions);
+            upload_attrib_ranges(rTerrain.chunkGeom.vbufNormals);
+        }
 
-        rDrawTerrainGl.indxBufGL.setData({nullptr, indxBuffer.size()});
-        rDrawTerrainGl.indxBufGL.setData(indxBuffer);
+        for (ChunkMeshBufRange const range : rChSP.faceDirty)
+        {
+            std::size_t const offset = range.first * sizeof(Vector3u);
+            std::size_t const size   = range.count * sizeof(Vector3u);
+            rDrawTerrainGl.indxBufGL.setSubData(GLintptr(offset), indxBuffer.sliceSize(offset, size));
+        }
 
-        rDrawTerrainGl.vrtxBufGL.setData({nullptr, vrtxBuffer.size()});
-        rDrawTerrainGl.vrtxBufGL.setData(vrtxBuffer);
+        rChSP.vrtxDirty.clear();
+        rChSP.faceDirty.clear();
     });
 
 }); // ftrShaderPhong
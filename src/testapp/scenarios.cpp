@@ -262,7 +262,8 @@ static ScenarioMap_t make_scenarios()
             .height                 = 20000.0,   // Height between Mariana Trench and Mount Everest
             .skelPrecision          = 10,        // 2^10 units = 1024 units = 1 meter
             .skelMaxSubdivLevels    = 19,
-            .chunkSubdivLevels      = 4
+            .chunkSubdivLevels      = 4,
+            .chunkCacheBytes        = 16u * 1024u * 1024u
         });
 
         // Set scene position relative to planet to be just on the surface
@@ -313,6 +314,104 @@ static ScenarioMap_t make_scenarios()
 
 
 
+    add_scenario({
+        .name        = "terrain_vehicles",
+        .brief       = "Vehicles and physics shapes landing on planet terrain (1km radius planet)",
+        .description = "Controls (VEHICLE):\n"
+                       "* [WS]              - RCS Pitch\n"
+                       "* [AD]              - RCS Yaw\n"
+                       "* [QE]              - RCS Roll\n"
+                       "* [Shift]           - Throttle Up\n"
+                       "* [Ctrl]            - Throttle Down\n"
+                       "* [Z]               - Throttle Max\n"
+                       "* [X]               - Throttle Zero\n"
+                       "Controls:\n"
+                       "* [Drag MouseRight] - Orbit camera\n"
+                       "* [Space]           - Throw spheres\n"
+                       "* [V]               - Switch vehicles\n",
+        .loadFunc = [] (TestApp& rTestApp)
+    {
+        auto        &rFW      = rTestApp.m_framework;
+        auto  const mainApp   = rFW.get_interface<FIMainApp>  (rTestApp.m_mainContext);
+
+        ContextId const sceneCtx = rFW.m_contextIds.create();
+        rFW.data_get<adera::AppContexts&>(mainApp.di.appContexts).scene = sceneCtx;
+
+        ContextBuilder  sceneCB { sceneCtx, {rTestApp.m_mainContext}, rFW };
+        sceneCB.add_feature(ftrScene);
+        sceneCB.add_feature(ftrCommonScene, rTestApp.m_defaultPkg);
+        sceneCB.add_feature(ftrPhysics);
+        sceneCB.add_feature(ftrPhysicsShapes);
+        sceneCB.add_feature(ftrDroppers);
+        sceneCB.add_feature(ftrBounds);
+
+        sceneCB.add_feature(ftrPrefabs);
+        sceneCB.add_feature(ftrParts);
+        sceneCB.add_feature(ftrSignalsFloat);
+        sceneCB.add_feature(ftrVehicleSpawn);
+        sceneCB.add_feature(ftrVehicleSpawnVBData);
+        sceneCB.add_feature(ftrPrebuiltVehicles);
+
+        sceneCB.add_feature(ftrMachMagicRockets);
+        sceneCB.add_feature(ftrMachRCSDriver);
+
+        sceneCB.add_feature(ftrJolt);
+        sceneCB.add_feature(ftrJoltConstAccel);
+        sceneCB.add_feature(ftrPhysicsShapesJolt);
+        sceneCB.add_feature(ftrVehicleSpawnJolt);
+        sceneCB.add_feature(ftrRocketThrustJolt);
+
+        sceneCB.add_feature(ftrTerrain);
+        sceneCB.add_feature(ftrTerrainIcosahedron);
+        sceneCB.add_feature(ftrTerrainSubdivDist);
+        sceneCB.add_feature(ftrTerrainCollision);
+        sceneCB.add_feature(ftrTerrainCollisionJolt);
+
+        ContextBuilder::finalize(std::move(sceneCB));
+
+        // Planet is small enough for gravity to be treated as constant near the scene origin
+        ospjolt::ForceFactors_t const gravity = add_constant_acceleration(sc_gravityForce, rFW, sceneCtx);
+        set_phys_shape_factors     (gravity, rFW, sceneCtx);
+        set_vehicle_default_factors(gravity, rFW, sceneCtx);
+
+        auto terrain        = rFW.get_interface<FITerrain>(sceneCtx);
+        auto &rTerrainFrame = rFW.data_get<ACtxTerrainFrame>(terrain.di.terrainFrame);
+
+        constexpr std::uint64_t c_radius = 1000;
+
+        initialize_ico_terrain(rFW, sceneCtx, {
+            .radius                 = double(c_radius),
+            .height                 = 5.0,
+            .skelPrecision          = 10, // 2^10 units = 1024 units = 1 meter
+            .skelMaxSubdivLevels    = 8,
+            .chunkSubdivLevels      = 4
+        });
+
+        // Scene origin just on the surface, with +Z pointing up
+        rTerrainFrame.position = Vector3l{0,0,c_radius} * 1024;
+
+        auto vhclSpawn          = rFW.get_interface<FIVehicleSpawn>(sceneCtx);
+        auto vhclSpawnVB        = rFW.get_interface<FIVehicleSpawnVB>(sceneCtx);
+        auto testVhcls          = rFW.get_interface<FITestVehicles>(sceneCtx);
+
+        auto &rVehicleSpawn     = rFW.data_get<ACtxVehicleSpawn>     (vhclSpawn.di.vehicleSpawn);
+        auto &rVehicleSpawnVB   = rFW.data_get<ACtxVehicleSpawnVB>   (vhclSpawnVB.di.vehicleSpawnVB);
+        auto &rPrebuiltVehicles = rFW.data_get<PrebuiltVehicles>     (testVhcls.di.prebuiltVehicles);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            rVehicleSpawn.spawnRequest.push_back(
+            {
+               .position = {float(i - 2) * 8.0f, 0.0f, 15.0f},
+               .velocity = {0.0f, 0.0f, 0.0f},
+               .rotation = {}
+            });
+            rVehicleSpawnVB.dataVB.push_back(rPrebuiltVehicles[gc_pbvSimpleCommandServiceModule].get());
+        }
+    }});
+
+
+
     add_scenario({
         .name        = "universe",
         .brief       = "Universe test scenario with very unrealistic planets",
@@ -0,0 +1,121 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scenarios_headless.h"
+#include "feature_interfaces.h"
+#include "features/headless.h"
+
+#include <adera_app/application.h>
+#include <adera_app/features/common.h>
+#include <adera_app/features/misc.h>
+#include <adera_app/features/physics.h>
+#include <adera_app/features/shapes.h>
+#include <adera_app/features/vehicles.h>
+#include <adera_app/features/vehicles_machines.h>
+
+#include <osp/drawing/drawing.h>
+
+using namespace adera;
+using namespace ftr_inter;
+using namespace osp::draw;
+using namespace osp::fw;
+using namespace osp;
+
+namespace testapp
+{
+
+ContextId make_headless_scene_renderer(TestApp &rTestApp, ContextId sceneCtx, ContextId windowCtx)
+{
+    Framework &rFW = rTestApp.m_framework;
+
+    ContextId const scnRdrCtx = rFW.m_contextIds.create();
+
+    ContextBuilder  scnRdrCB { scnRdrCtx, { rTestApp.m_mainContext, windowCtx, sceneCtx }, rFW };
+
+    if ( ! rFW.get_interface_id<FICommonScene>(sceneCtx).has_value() )
+    {
+        ContextBuilder::finalize(std::move(scnRdrCB));
+        return scnRdrCtx;
+    }
+
+    scnRdrCB.add_feature(ftrSceneRenderer);
+
+    // Same materials as the Magnum scene renderer. They must exist before ftrHeadlessScene.
+    auto scnRender      = rFW.get_interface<FISceneRenderer>        (scnRdrCtx);
+    auto &rScnRender    = rFW.data_get<draw::ACtxSceneRender>       (scnRender.di.scnRender);
+    MaterialId const matFlat        = rScnRender.m_materialIds.create();
+    MaterialId const matPhong       = rScnRender.m_materialIds.create();
+    [[maybe_unused]] MaterialId const matVisualizer  = rScnRender.m_materialIds.create();
+    rScnRender.m_materials.resize(rScnRender.m_materialIds.size());
+
+    scnRdrCB.add_feature(ftrHeadlessScene);
+
+    auto headlessScn    = rFW.get_interface<FIHeadlessScene>        (scnRdrCtx);
+    auto &rCamera       = rFW.data_get<draw::Camera>                (headlessScn.di.camera);
+    rCamera.m_transform = Matrix4::lookAt({0.0f, -40.0f, 20.0f}, {0.0f, 0.0f, 0.0f}, Vector3::zAxis());
+    rCamera.set_aspect_ratio({1280.0f, 720.0f});
+
+    if (rFW.get_interface_id<FIPhysShapes>(sceneCtx).has_value())
+    {
+        scnRdrCB.add_feature(ftrPhysicsShapesDraw, matPhong);
+    }
+
+    if (rFW.get_interface_id<FIPrefabs>(sceneCtx).has_value())
+    {
+        scnRdrCB.add_feature(ftrPrefabDraw, matPhong);
+    }
+
+    if (rFW.get_interface_id<FIVehicleSpawn>(sceneCtx).has_value())
+    {
+        scnRdrCB.add_feature(ftrVehicleSpawnDraw);
+    }
+
+    if (rFW.get_interface_id<FIRocketsJolt>(sceneCtx).has_value())
+    {
+        scnRdrCB.add_feature(ftrMagicRocketThrustIndicator, TplPkgIdMaterialId{ rTestApp.m_defaultPkg, matFlat });
+    }
+
+    ContextBuilder::finalize(std::move(scnRdrCB));
+    return scnRdrCtx;
+}
+
+void start_headless_renderer(Framework &rFW, ContextId ctx, entt::any userData)
+{
+    TestApp    &rTestApp = entt::any_cast<TestApp&>(userData);
+    auto const mainApp   = rFW.get_interface<FIMainApp>(ctx);
+    auto       &rAppCtxs = rFW.data_get<AppContexts>(mainApp.di.appContexts);
+
+    ContextId const sceneCtx  = rAppCtxs.scene;
+    ContextId const windowCtx = rFW.m_contextIds.create();
+
+    ContextBuilder  windowCB { windowCtx, { ctx, sceneCtx }, rFW };
+    windowCB.add_feature(adera::ftrWindowApp);
+    windowCB.add_feature(ftrHeadless);
+    ContextBuilder::finalize(std::move(windowCB));
+
+    rAppCtxs.window      = windowCtx;
+    rAppCtxs.sceneRender = make_headless_scene_renderer(rTestApp, sceneCtx, windowCtx);
+}
+
+} // namespace testapp
@@ -0,0 +1,51 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "testapp.h"
+
+#include <osp/framework/framework.h>
+
+namespace testapp
+{
+
+/**
+ * @brief Create a scene renderer context that draws a scene with the headless render backend
+ *
+ * Adds the same drawing features as the Magnum scene renderer, except for ones that need user
+ * input through a camera controller. The camera is left looking at the origin.
+ */
+osp::fw::ContextId make_headless_scene_renderer(TestApp &rTestApp, osp::fw::ContextId sceneCtx, osp::fw::ContextId windowCtx);
+
+/**
+ * @brief Open a window context with the headless render backend and a renderer for the current
+ *        scene, without a window or GL context
+ *
+ * Same signature as start_magnum_renderer to work as a FrameworkModify command. The framework
+ * main loop must be stopped, and needs to be reloaded afterwards.
+ */
+void start_headless_renderer(osp::fw::Framework &rFW, osp::fw::ContextId ctx, entt::any userData);
+
+} // namespace testapp
@@ -176,6 +176,19 @@ void TestApp::clear_resource_owners()
         }
     };
 
+    // Meshes own their simplified levels of detail
+    for (osp::ResId const id : rResources.ids(gc_mesh))
+    {
+        auto * const pData = rResources.data_try_get<osp::MeshLods>(gc_mesh, id);
+        if (pData != nullptr)
+        {
+            for (osp::ResIdOwner_t &rOwner : std::move(pData->levels))
+            {
+                rResources.owner_destroy(gc_mesh, std::move(rOwner));
+            }
+        }
+    };
+
     // Importer data own a lot of other resources
     for (osp::ResId const id : rResources.ids(gc_importer))
     {
@@ -214,6 +227,7 @@ void TestApp::load_a_bunch_of_stuff()
     rResources.data_register<Trade::TextureData>(gc_texture);
     rResources.data_register<osp::TextureImgSource>(gc_texture);
     rResources.data_register<Trade::MeshData>(gc_mesh);
+    rResources.data_register<osp::MeshLods>(gc_mesh);
     rResources.data_register<osp::ImporterData>(gc_importer);
     rResources.data_register<osp::Prefabs>(gc_importer);
     osp::register_tinygltf_resources(rResources);
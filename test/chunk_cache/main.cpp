@@ -0,0 +1,218 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <planet-a/chunk_cache.h>
+#include <planet-a/icosahedron.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <set>
+#include <vector>
+
+using namespace planeta;
+
+using osp::Vector3;
+using osp::Vector3l;
+
+namespace
+{
+
+struct TestSkeleton
+{
+    TestSkeleton()
+     : skel{create_skeleton_icosahedron(1.0, vrtxIds, groupIds, triIds, skData)}
+    { }
+
+    /// Subdivide a triangle, returns IDs of its 4 children
+    std::array<SkTriId, 4> subdivide(SkTriId const triId)
+    {
+        SkeletonTriangle &rTri = skel.tri_at(triId);
+        std::array<SkVrtxId, 3> const corners{rTri.vertices[0], rTri.vertices[1], rTri.vertices[2]};
+        auto const middles = skel.vrtx_create_middles(corners);
+
+        SkTriGroupId const group = skel.tri_subdiv(triId, skel.tri_at(triId), {middles[0].id, middles[1].id, middles[2].id}).id;
+        return {tri_id(group, 0), tri_id(group, 1), tri_id(group, 2), tri_id(group, 3)};
+    }
+
+    std::array<SkVrtxId, 12>        vrtxIds;
+    std::array<SkTriGroupId, 5>     groupIds;
+    std::array<SkTriId, 20>         triIds;
+    SkeletonVertexData              skData;
+    SubdivTriangleSkeleton          skel;
+};
+
+constexpr std::uint32_t gc_fillVrtxCount = 4;
+
+std::vector<Vector3> make_positions(float const base)
+{
+    return { {base, 0.0f, 0.0f}, {base, 1.0f, 0.0f}, {base, 0.0f, 1.0f}, {base, 1.0f, 1.0f} };
+}
+
+/// Store positions for a chunk created over the triangle identified by key
+void store(ChunkFillCache &rCache, ChunkId const chunkId, SkTriPathKey const key, float const base, Vector3l const origin = {})
+{
+    std::vector<Vector3> const positions = make_positions(base);
+    rCache.assign_chunk(chunkId, key);
+    rCache.store(chunkId, Corrade::Containers::arrayView(positions), origin);
+}
+
+/// Take positions for a new chunk created over the triangle identified by key
+bool take(ChunkFillCache &rCache, ChunkId const chunkId, SkTriPathKey const key, std::vector<Vector3> &rOut, Vector3l const origin = {}, float const scale = 1.0f)
+{
+    rOut.assign(gc_fillVrtxCount, Vector3{-1.0f});
+    rCache.assign_chunk(chunkId, key);
+    return rCache.take(chunkId, origin, scale, Corrade::Containers::arrayView(rOut));
+}
+
+} // namespace
+
+// Test that path keys are unique between roots, siblings, and depths
+TEST(ChunkCache, PathKeyUnique)
+{
+    TestSkeleton test;
+
+    std::vector<SkTriId> tris{test.triIds.begin(), test.triIds.end()};
+
+    // Subdivide two different roots, then two different children of one of them
+    std::array<SkTriId, 4> const childrenA  = test.subdivide(test.triIds[0]);
+    std::array<SkTriId, 4> const childrenB  = test.subdivide(test.triIds[7]);
+    std::array<SkTriId, 4> const grandA0    = test.subdivide(childrenA[0]);
+    std::array<SkTriId, 4> const grandA3    = test.subdivide(childrenA[3]);
+    std::array<SkTriId, 4> const greatA00   = test.subdivide(grandA0[0]);
+
+    for (auto const &children : {childrenA, childrenB, grandA0, grandA3, greatA00})
+    {
+        tris.insert(tris.end(), children.begin(), children.end());
+    }
+
+    std::set<SkTriPathKey> keys;
+    for (SkTriId const tri : tris)
+    {
+        keys.insert(tri_path_key(tri, test.skel));
+    }
+    EXPECT_EQ(keys.size(), tris.size());
+
+    // First child along the same path at each depth only differs by depth
+    SkTriPathKey const root   = tri_path_key(test.triIds[0], test.skel);
+    SkTriPathKey const depth1 = tri_path_key(childrenA[0],   test.skel);
+    SkTriPathKey const depth2 = tri_path_key(grandA0[0],     test.skel);
+    SkTriPathKey const depth3 = tri_path_key(greatA00[0],    test.skel);
+    EXPECT_NE(root, depth1);
+    EXPECT_NE(depth1, depth2);
+    EXPECT_NE(depth2, depth3);
+    EXPECT_EQ((root   >> 46u) & 31u, 0u);
+    EXPECT_EQ((depth1 >> 46u) & 31u, 1u);
+    EXPECT_EQ((depth2 >> 46u) & 31u, 2u);
+    EXPECT_EQ((depth3 >> 46u) & 31u, 3u);
+
+    // Same sibling index under different parents
+    EXPECT_NE(tri_path_key(childrenA[2], test.skel), tri_path_key(childrenB[2], test.skel));
+    EXPECT_NE(tri_path_key(grandA0[1],   test.skel), tri_path_key(grandA3[1],   test.skel));
+
+    // Keys only depend on the path, so they're the same when recalculated
+    EXPECT_EQ(tri_path_key(greatA00[2], test.skel), tri_path_key(greatA00[2], test.skel));
+}
+
+// Test that taken positions match stored ones, translated to the new mesh origin
+TEST(ChunkCache, StoreTakeRoundTrip)
+{
+    ChunkFillCache cache;
+    cache.resize(2 * gc_fillVrtxCount * sizeof(Vector3), gc_fillVrtxCount, 8);
+    ASSERT_TRUE(cache.is_used());
+    ASSERT_EQ(cache.capacity(), 2u);
+
+    Vector3l const originStored{1024, 0, -2048};
+    Vector3l const originNow   {0,    0,  0};
+    float    const scale       = 1.0f / 1024.0f;
+
+    store(cache, ChunkId{0}, 42, 5.0f, originStored);
+    EXPECT_EQ(cache.size(), 1u);
+
+    // A different chunk created over the same triangle later
+    std::vector<Vector3> out;
+    ASSERT_TRUE(take(cache, ChunkId{3}, 42, out, originNow, scale));
+    EXPECT_EQ(cache.size(), 0u);
+
+    std::vector<Vector3> const expected = make_positions(5.0f);
+    for (std::size_t i = 0; i < gc_fillVrtxCount; ++i)
+    {
+        EXPECT_EQ(out[i], expected[i] + Vector3{1.0f, 0.0f, -2.0f});
+    }
+
+    // Taken entries are removed
+    EXPECT_FALSE(take(cache, ChunkId{3}, 42, out));
+    EXPECT_FALSE(take(cache, ChunkId{4}, 43, out));
+    EXPECT_EQ(cache.hits,   1u);
+    EXPECT_EQ(cache.misses, 2u);
+}
+
+// Test that the least recently stored entries are evicted once the byte limit is reached
+TEST(ChunkCache, Eviction)
+{
+    ChunkFillCache cache;
+
+    // Room for 2 entries and a bit, not enough for a 3rd
+    cache.resize(3 * gc_fillVrtxCount * sizeof(Vector3) - 1, gc_fillVrtxCount, 8);
+    ASSERT_EQ(cache.capacity(), 2u);
+
+    store(cache, ChunkId{0}, 100, 0.0f);
+    store(cache, ChunkId{1}, 101, 1.0f);
+    store(cache, ChunkId{2}, 102, 2.0f); // Evicts 100
+    EXPECT_EQ(cache.size(), 2u);
+
+    store(cache, ChunkId{0}, 103, 3.0f); // Evicts 101
+    EXPECT_EQ(cache.size(), 2u);
+
+    std::vector<Vector3> out;
+    EXPECT_FALSE(take(cache, ChunkId{4}, 100, out));
+    EXPECT_FALSE(take(cache, ChunkId{4}, 101, out));
+
+    ASSERT_TRUE(take(cache, ChunkId{4}, 102, out));
+    EXPECT_EQ(out, make_positions(2.0f));
+
+    // Taking frees an entry, so storing another doesn't evict 103
+    store(cache, ChunkId{5}, 104, 4.0f);
+    EXPECT_EQ(cache.size(), 2u);
+
+    ASSERT_TRUE(take(cache, ChunkId{6}, 103, out));
+    EXPECT_EQ(out, make_positions(3.0f));
+    ASSERT_TRUE(take(cache, ChunkId{6}, 104, out));
+    EXPECT_EQ(out, make_positions(4.0f));
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+// Test that a zero byte limit disables the cache
+TEST(ChunkCache, Disabled)
+{
+    ChunkFillCache cache;
+    cache.resize(0, gc_fillVrtxCount, 8);
+    EXPECT_FALSE(cache.is_used());
+
+    store(cache, ChunkId{0}, 100, 0.0f);
+    EXPECT_EQ(cache.size(), 0u);
+
+    std::vector<Vector3> out;
+    EXPECT_FALSE(take(cache, ChunkId{1}, 100, out));
+}
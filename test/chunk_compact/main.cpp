@@ -0,0 +1,235 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <planet-a/geometry.h>
+
+#include <Magnum/Math/Constants.h>
+#include <Magnum/Math/Packing.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace planeta;
+
+using osp::Vector2;
+using osp::Vector3;
+using osp::Vector3h;
+
+using Constants = Magnum::Math::Constants<float>;
+
+namespace
+{
+
+/**
+ * @brief Unit vectors spread over the whole sphere, plus the axes and octahedron edges, which
+ *        land on the folds of the octahedral mapping
+ */
+std::vector<Vector3> test_directions()
+{
+    std::vector<Vector3> out;
+
+    // Fibonacci sphere
+    constexpr int   count       = 500;
+    float const     goldenAngle = Constants::pi() * (3.0f - std::sqrt(5.0f));
+    for (int i = 0; i < count; ++i)
+    {
+        float const z = 1.0f - 2.0f * (float(i) + 0.5f) / float(count);
+        float const r = std::sqrt(1.0f - z * z);
+        float const a = goldenAngle * float(i);
+        out.emplace_back(r * std::cos(a), r * std::sin(a), z);
+    }
+
+    for (float const a : {-1.0f, 1.0f})
+    {
+        out.emplace_back(a, 0.0f, 0.0f);
+        out.emplace_back(0.0f, a, 0.0f);
+        out.emplace_back(0.0f, 0.0f, a);
+        for (float const b : {-1.0f, 1.0f})
+        {
+            out.push_back(Vector3{a, b, 0.0f}.normalized());
+            out.push_back(Vector3{a, 0.0f, b}.normalized());
+            out.push_back(Vector3{0.0f, a, b}.normalized());
+        }
+    }
+
+    return out;
+}
+
+/**
+ * @return Angle between two vectors in degrees, calculated in double precision
+ */
+double angle_deg(Vector3 const a, Vector3 const b)
+{
+    osp::Vector3d const ad{a};
+    osp::Vector3d const bd{b};
+    double const rad = std::atan2(Magnum::Math::cross(ad, bd).length(), Magnum::Math::dot(ad, bd));
+    return rad * 180.0 / Magnum::Math::Constants<double>::pi();
+}
+
+} // namespace
+
+// Test that decoding an encoded normal gives the same normal back
+TEST(ChunkCompact, OctahedralRoundTrip)
+{
+    for (Vector3 const normal : test_directions())
+    {
+        Vector2 const encoded = octahedral_encode(normal);
+        EXPECT_LE(std::abs(encoded.x()), 1.0f);
+        EXPECT_LE(std::abs(encoded.y()), 1.0f);
+
+        Vector3 const decoded = octahedral_decode(encoded);
+        EXPECT_NEAR(decoded.length(), 1.0f, 1e-5f);
+        EXPECT_NEAR(Magnum::Math::dot(decoded, normal), 1.0f, 1e-5f)
+            << "normal " << normal.x() << ", " << normal.y() << ", " << normal.z();
+    }
+}
+
+// Test that non-normalized normals encode the same as their normalized direction, and that the
+// zero normal of unused vertices doesn't produce NaNs
+TEST(ChunkCompact, OctahedralUnnormalized)
+{
+    Vector3 const normal{0.3f, -0.5f, -0.8f};
+
+    Vector2 const encodedScaled = octahedral_encode(normal * 7.0f);
+    Vector2 const encoded       = octahedral_encode(normal.normalized());
+    EXPECT_NEAR(encodedScaled.x(), encoded.x(), 1e-6f);
+    EXPECT_NEAR(encodedScaled.y(), encoded.y(), 1e-6f);
+
+    Vector2 const encodedZero = octahedral_encode(Vector3{0.0f});
+    EXPECT_EQ(encodedZero, Vector2{0.0f});
+}
+
+// Test the precision of normals packed into the 8 and 16-bit formats used by the compact buffer
+TEST(ChunkCompact, OctahedralPacked)
+{
+    using Magnum::Math::pack;
+    using Magnum::Math::unpack;
+
+    for (Vector3 const normal : test_directions())
+    {
+        Vector2 const encoded = octahedral_encode(normal);
+
+        Vector3 const decoded8  = octahedral_decode(unpack<Vector2>(pack<osp::Vector2b>(encoded)));
+        Vector3 const decoded16 = octahedral_decode(unpack<Vector2>(pack<osp::Vector2s>(encoded)));
+
+        // Worst case angular error is around a degree for 8-bit, and a hundredth of that for 16-bit
+        EXPECT_LT(angle_deg(decoded8,  normal), 2.5);
+        EXPECT_LT(angle_deg(decoded16, normal), 0.02);
+    }
+}
+
+// Test that the exponent is the smallest that keeps positions within half-float range
+TEST(ChunkCompact, PosExponent)
+{
+    EXPECT_EQ(compact_pos_exponent(0.0), 0);
+    EXPECT_EQ(compact_pos_exponent(1000.0), 0);
+    EXPECT_EQ(compact_pos_exponent(32768.0), 0);
+    EXPECT_EQ(compact_pos_exponent(32769.0), 1);
+    EXPECT_EQ(compact_pos_exponent(65536.0), 1);
+
+    for (double const distance : {1.0e3, 5.0e4, 1.0e5, 2.0 * 6391000.0, 1.0e9})
+    {
+        int const exponent = compact_pos_exponent(distance);
+        double const scaled = distance / std::exp2(double(exponent));
+
+        EXPECT_LE(scaled, 32768.0);
+        if (exponent != 0)
+        {
+            EXPECT_GT(scaled * 2.0, 32768.0);
+        }
+    }
+}
+
+// Test that positions survive the trip through scaled half-floats, to within half-float precision
+TEST(ChunkCompact, PosRoundTrip)
+{
+    double const maxDistance = 2.0 * 6391000.0; // Earth-sized planet diameter
+    int    const exponent    = compact_pos_exponent(maxDistance);
+    float  const scale       = std::exp2(float(exponent));
+
+    for (Vector3 const pos : {Vector3{0.0f}, Vector3{1.5f, -2.25f, 3.0f}, Vector3{6391000.0f, -1234567.0f, 42.0f},
+                              Vector3{float(-maxDistance), 0.0f, float(maxDistance)}})
+    {
+        Vector3h const packed   = Vector3h{pos / scale};
+        Vector3  const unpacked = Vector3{packed} * scale;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            ASSERT_TRUE(std::isfinite(unpacked[i]));
+
+            // Half-floats have 11 significant bits
+            float const tolerance = std::max(std::abs(pos[i]) * (1.0f / 2048.0f), scale * (1.0f / 16384.0f));
+            EXPECT_NEAR(unpacked[i], pos[i], tolerance);
+        }
+    }
+}
+
+// Test that the compact origin only follows the viewer once it's moved far enough away
+TEST(ChunkCompact, Recenter)
+{
+    ChunkMeshCompactGeometry compact;
+    EXPECT_FALSE(compact_recenter(compact, Vector3{1.0e6f, 0.0f, 0.0f})); // Not used
+
+    compact.normals           = EChunkCompactNormals::Oct16;
+    compact.originMaxDistance = 512.0f;
+
+    EXPECT_FALSE(compact_recenter(compact, Vector3{300.0f, 300.0f, 0.0f}));
+    EXPECT_EQ(compact.origin, Vector3{0.0f});
+
+    EXPECT_TRUE(compact_recenter(compact, Vector3{10000.4f, -20.6f, 3.0f}));
+    EXPECT_EQ(compact.origin, (Vector3{10000.0f, -21.0f, 3.0f}));
+
+    EXPECT_FALSE(compact_recenter(compact, Vector3{10200.0f, 0.0f, 300.0f}));
+    EXPECT_EQ(compact.origin, (Vector3{10000.0f, -21.0f, 3.0f}));
+}
+
+// Test that vertices near the viewer stay precise when the viewer is far from the float origin
+TEST(ChunkCompact, RecenterPrecision)
+{
+    int   const exponent = compact_pos_exponent(2.0 * 6391000.0);
+    float const scale    = std::exp2(float(exponent));
+
+    ChunkMeshCompactGeometry compact;
+    compact.normals = EChunkCompactNormals::Oct16;
+
+    Vector3 const viewer{40000.0f, -25000.0f, 1000.0f};
+    compact_recenter(compact, viewer);
+
+    for (Vector3 const offset : {Vector3{0.0f}, Vector3{3.7f, -1.2f, 0.4f}, Vector3{-150.0f, 80.0f, 5.0f}})
+    {
+        Vector3  const pos      = viewer + offset;
+        Vector3h const packed   = Vector3h{(pos - compact.origin) / scale};
+        Vector3  const unpacked = Vector3{packed} * scale + compact.origin;
+
+        // Within 1/2048th of distance to the compact origin, instead of to the float origin
+        float const tolerance = std::max((pos - compact.origin).length() * (1.0f / 2048.0f), 0.01f);
+        for (int i = 0; i < 3; ++i)
+        {
+            EXPECT_NEAR(unpacked[i], pos[i], tolerance);
+        }
+    }
+}
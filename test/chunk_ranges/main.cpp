@@ -0,0 +1,211 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <planet-a/chunk_generate.h>
+#include <planet-a/chunk_utils.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using namespace planeta;
+
+using RangePairs_t = std::vector< std::pair<std::uint32_t, std::uint32_t> >;
+
+namespace
+{
+
+/// Convert ranges to {first, count} pairs, which gtest can compare and print
+RangePairs_t as_pairs(std::vector<ChunkMeshBufRange> const& ranges)
+{
+    RangePairs_t out;
+    out.reserve(ranges.size());
+    for (ChunkMeshBufRange const& range : ranges)
+    {
+        out.emplace_back(range.first, range.count);
+    }
+    return out;
+}
+
+RangePairs_t coalesced(std::vector<ChunkMeshBufRange> ranges, std::uint32_t const maxGap)
+{
+    coalesce_ranges(ranges, maxGap);
+    return as_pairs(ranges);
+}
+
+/// Chunk skeleton, buffer info and scratchpad sized the same way terrain does
+struct TestChunks
+{
+    TestChunks()
+    {
+        skCh.chunk_reserve(8);
+        skCh.shared_reserve(256);
+        chInfo = make_chunk_mesh_buffer_info(skCh);
+        chSP.resize(skCh);
+    }
+
+    ChunkSkeleton       skCh{make_skeleton_chunks(3)};
+    ChunkMeshBufferInfo chInfo{};
+    ChunkScratchpad     chSP;
+};
+
+} // namespace
+
+// Test that coalescing nothing or a single range leaves them unchanged
+TEST(ChunkRanges, CoalesceEmpty)
+{
+    EXPECT_EQ(coalesced({}, 0), RangePairs_t{});
+    EXPECT_EQ(coalesced({}, 64), RangePairs_t{});
+    EXPECT_EQ(coalesced({{ .first = 7, .count = 3 }}, 64), (RangePairs_t{{7, 3}}));
+}
+
+// Test that ranges touching end-to-start are merged, even in reverse order
+TEST(ChunkRanges, CoalesceAdjacent)
+{
+    EXPECT_EQ(coalesced({{ .first = 0, .count = 4 }, { .first = 4, .count = 4 }}, 0), (RangePairs_t{{0, 8}}));
+    EXPECT_EQ(coalesced({{ .first = 8, .count = 2 }, { .first = 4, .count = 4 }, { .first = 0, .count = 4 }}, 0), (RangePairs_t{{0, 10}}));
+}
+
+// Test that overlapping and contained ranges are merged into one covering all of them
+TEST(ChunkRanges, CoalesceOverlapping)
+{
+    EXPECT_EQ(coalesced({{ .first = 10, .count = 5 }, { .first = 0, .count = 12 }}, 0), (RangePairs_t{{0, 15}}));
+
+    // Contained range must not shrink the range containing it
+    EXPECT_EQ(coalesced({{ .first = 0, .count = 10 }, { .first = 2, .count = 3 }}, 0), (RangePairs_t{{0, 10}}));
+
+    // Duplicates
+    EXPECT_EQ(coalesced({{ .first = 5, .count = 1 }, { .first = 5, .count = 1 }, { .first = 5, .count = 1 }}, 0), (RangePairs_t{{5, 1}}));
+}
+
+// Test that disjoint ranges are sorted, and only merged if the gap between them is within maxGap
+TEST(ChunkRanges, CoalesceDisjoint)
+{
+    std::vector<ChunkMeshBufRange> const ranges{{ .first = 20, .count = 2 }, { .first = 0, .count = 4 }, { .first = 50, .count = 1 }};
+
+    EXPECT_EQ(coalesced(ranges, 0),  (RangePairs_t{{0, 4}, {20, 2}, {50, 1}}));
+    EXPECT_EQ(coalesced(ranges, 15), (RangePairs_t{{0, 4}, {20, 2}, {50, 1}}));
+
+    // Gap between [0, 4) and [20, 22) is exactly 16
+    EXPECT_EQ(coalesced(ranges, 16), (RangePairs_t{{0, 22}, {50, 1}}));
+    EXPECT_EQ(coalesced(ranges, 28), (RangePairs_t{{0, 51}}));
+}
+
+// Test that nothing is recorded if nothing changed
+TEST(ChunkRanges, RecordEmpty)
+{
+    TestChunks test;
+    test.skCh.m_chunkIds.create();
+
+    record_dirty_ranges(false, test.chSP, test.chInfo, test.skCh);
+
+    EXPECT_TRUE(test.chSP.vrtxDirty.empty());
+    EXPECT_TRUE(test.chSP.faceDirty.empty());
+}
+
+// Test that added chunks dirty their fill vertices and faces, and added shared vertices dirty
+// themselves, merging ones close together
+TEST(ChunkRanges, RecordAdded)
+{
+    TestChunks test;
+    ChunkMeshBufferInfo const &info = test.chInfo;
+
+    ChunkId const chunkA = test.skCh.m_chunkIds.create();
+    ChunkId const chunkB = test.skCh.m_chunkIds.create();
+    test.chSP.chunksAdded.insert(chunkA);
+    test.chSP.chunksAdded.insert(chunkB);
+
+    test.chSP.sharedAdded       .insert(SharedVrtxId{0});
+    test.chSP.sharedNormalsDirty.insert(SharedVrtxId{10});
+    test.chSP.sharedAdded       .insert(SharedVrtxId{200});
+
+    record_dirty_ranges(false, test.chSP, info, test.skCh);
+
+    // Fill vertices of chunks are contiguous; shared vertices are far away from them
+    ASSERT_GT(info.vbufSharedOffset, fill_to_vrtx(info, chunkB, info.fillVrtxCount) + 64);
+    EXPECT_EQ(as_pairs(test.chSP.vrtxDirty), (RangePairs_t{
+        {fill_to_vrtx(info, chunkA, 0), 2 * info.fillVrtxCount},
+        {info.vbufSharedOffset,         11},
+        {info.vbufSharedOffset + 200,   1}
+    }));
+
+    EXPECT_EQ(as_pairs(test.chSP.faceDirty), (RangePairs_t{
+        {chunkA.value * info.chunkMaxFaceCount, 2 * info.chunkMaxFaceCount}
+    }));
+}
+
+// Test that restitched and removed chunks only dirty their faces
+TEST(ChunkRanges, RecordStitchedRemoved)
+{
+    TestChunks test;
+    ChunkMeshBufferInfo const &info = test.chInfo;
+
+    test.skCh.m_chunkIds.create(); // Untouched
+    ChunkId const removed   = test.skCh.m_chunkIds.create();
+    ChunkId const stitched  = test.skCh.m_chunkIds.create();
+    test.skCh.m_chunkIds.create(); // Untouched, separates farRemove from the others
+    ChunkId const farRemove = test.skCh.m_chunkIds.create();
+
+    test.skCh.m_chunkIds.remove(removed);
+    test.skCh.m_chunkIds.remove(farRemove);
+    test.chSP.chunksRemoved.insert(removed);
+    test.chSP.chunksRemoved.insert(farRemove);
+    test.chSP.stitchCmds[stitched].enabled = true;
+
+    record_dirty_ranges(false, test.chSP, info, test.skCh);
+
+    EXPECT_TRUE(test.chSP.vrtxDirty.empty());
+    EXPECT_EQ(as_pairs(test.chSP.faceDirty), (RangePairs_t{
+        {removed.value   * info.chunkMaxFaceCount, 2 * info.chunkMaxFaceCount},
+        {farRemove.value * info.chunkMaxFaceCount, info.chunkMaxFaceCount}
+    }));
+}
+
+// Test that ranges accumulate over multiple updates, and allVertices replaces vertex ranges
+TEST(ChunkRanges, RecordAccumulate)
+{
+    TestChunks test;
+    ChunkMeshBufferInfo const &info = test.chInfo;
+
+    ChunkId const chunkA = test.skCh.m_chunkIds.create();
+    test.chSP.chunksAdded.insert(chunkA);
+    record_dirty_ranges(false, test.chSP, info, test.skCh);
+    test.chSP.chunksAdded.clear();
+
+    ChunkId const chunkB = test.skCh.m_chunkIds.create();
+    test.chSP.chunksAdded.insert(chunkB);
+    record_dirty_ranges(false, test.chSP, info, test.skCh);
+
+    EXPECT_EQ(as_pairs(test.chSP.vrtxDirty), (RangePairs_t{{fill_to_vrtx(info, chunkA, 0), 2 * info.fillVrtxCount}}));
+    EXPECT_EQ(as_pairs(test.chSP.faceDirty), (RangePairs_t{{chunkA.value * info.chunkMaxFaceCount, 2 * info.chunkMaxFaceCount}}));
+
+    test.chSP.chunksAdded.clear();
+    test.chSP.sharedAdded.insert(SharedVrtxId{3});
+    record_dirty_ranges(true, test.chSP, info, test.skCh);
+
+    EXPECT_EQ(as_pairs(test.chSP.vrtxDirty), (RangePairs_t{{0, info.vrtxTotal}}));
+    EXPECT_EQ(as_pairs(test.chSP.faceDirty), (RangePairs_t{{chunkA.value * info.chunkMaxFaceCount, 2 * info.chunkMaxFaceCount}}));
+}
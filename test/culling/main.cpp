@@ -0,0 +1,148 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/drawing/culling.h>
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+using namespace osp;
+using namespace osp::draw;
+
+namespace
+{
+
+struct TestScene
+{
+    ACtxDrawing         drawing;
+    ACtxSceneRender     scnRender;
+    RenderFrame         frame;
+    MeshId              mesh;
+
+    explicit TestScene(std::size_t entCount)
+    {
+        mesh = drawing.m_meshIds.create();
+        drawing.m_meshBounds.resize(drawing.m_meshIds.capacity());
+        drawing.m_meshBounds[mesh] = {.center = Vector3{0.0f}, .radius = 1.0f};
+
+        std::vector<DrawEnt> ents(entCount);
+        scnRender.m_drawIds.create(ents.begin(), ents.end());
+        scnRender.resize_draw();
+
+        frame.drawTransform .resize(scnRender.m_drawIds.capacity());
+        frame.visible       .resize(scnRender.m_drawIds.capacity());
+    }
+
+    void add(DrawEnt ent, Vector3 position, bool hasMesh = true)
+    {
+        frame.visible.insert(ent);
+        frame.drawTransform[ent] = Matrix4::translation(position);
+        if (hasMesh)
+        {
+            scnRender.m_mesh[ent] = drawing.m_meshRefCounts.ref_add(mesh);
+        }
+    }
+
+    ~TestScene()
+    {
+        for (MeshIdOwner_t &rOwner : scnRender.m_mesh)
+        {
+            if (rOwner.has_value())
+            {
+                drawing.m_meshRefCounts.ref_release(std::move(rOwner));
+            }
+        }
+    }
+};
+
+// Camera at origin looking down -Z, 90 degree FOV, near 1, far 100
+Matrix4 const gc_viewProj = Matrix4::perspectiveProjection(Deg{90.0f}, 1.0f, 1.0f, 100.0f);
+
+} // namespace
+
+// Test spheres against frustum planes, including partially intersecting ones
+TEST(Culling, Spheres)
+{
+    TestScene scene{8};
+
+    scene.add(DrawEnt{0}, {  0.0f,  0.0f,  -10.0f});        // Center of view
+    scene.add(DrawEnt{1}, {  0.0f,  0.0f,   10.0f});        // Behind camera
+    scene.add(DrawEnt{2}, { 10.5f,  0.0f,  -10.0f});        // Touching right edge
+    scene.add(DrawEnt{3}, { 12.0f,  0.0f,  -10.0f});        // Past right edge
+    scene.add(DrawEnt{4}, {  0.0f,  0.0f, -100.5f});        // Touching far plane
+    scene.add(DrawEnt{5}, {  0.0f,  0.0f, -102.0f});        // Past far plane
+    scene.add(DrawEnt{6}, {  0.0f, 50.0f,   10.0f}, false); // No mesh, never culled
+    // DrawEnt 7 is not visible
+
+    ACtxCulling cull;
+    SysCulling::update(cull, scene.frame, scene.scnRender, scene.drawing, gc_viewProj);
+
+    EXPECT_TRUE (cull.visible.contains(DrawEnt{0}));
+    EXPECT_FALSE(cull.visible.contains(DrawEnt{1}));
+    EXPECT_TRUE (cull.visible.contains(DrawEnt{2}));
+    EXPECT_FALSE(cull.visible.contains(DrawEnt{3}));
+    EXPECT_TRUE (cull.visible.contains(DrawEnt{4}));
+    EXPECT_FALSE(cull.visible.contains(DrawEnt{5}));
+    EXPECT_TRUE (cull.visible.contains(DrawEnt{6}));
+    EXPECT_FALSE(cull.visible.contains(DrawEnt{7}));
+}
+
+// Test that spatially sorted blocks give the same result as testing every sphere
+TEST(Culling, Blocks)
+{
+    constexpr std::size_t entCount = SysCulling::smc_blockSortThreshold + 1234;
+
+    TestScene scene{entCount};
+
+    std::mt19937 gen{42};
+    std::uniform_real_distribution<float> coord{-200.0f, 200.0f};
+
+    std::vector<bool> expected(entCount);
+    Frustum const frustum = SysCulling::make_frustum(gc_viewProj);
+
+    for (std::uint32_t i = 0; i < entCount; ++i)
+    {
+        Vector3 const pos{coord(gen), coord(gen), coord(gen)};
+        scene.add(DrawEnt{i}, pos);
+
+        bool inside = true;
+        for (Vector4 const& plane : frustum.planes)
+        {
+            inside = inside && (Magnum::Math::dot(plane.xyz(), pos) + plane.w() >= -1.0f);
+        }
+        expected[i] = inside;
+    }
+
+    ACtxCulling cull;
+    SysCulling::update(cull, scene.frame, scene.scnRender, scene.drawing, gc_viewProj);
+
+    ASSERT_TRUE(cull.useBlocks);
+
+    for (std::uint32_t i = 0; i < entCount; ++i)
+    {
+        EXPECT_EQ(cull.visible.contains(DrawEnt{i}), expected[i]) << "DrawEnt " << i;
+    }
+}
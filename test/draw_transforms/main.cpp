@@ -0,0 +1,274 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/activescene/basic_fn.h>
+#include <osp/drawing/drawing_fn.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace osp;
+using namespace osp::active;
+using namespace osp::draw;
+
+namespace
+{
+
+//  A               F
+//  ├── B           └── G
+//  │   └── C
+//  └── D
+//      └── E
+//  H (not in the scene graph)
+struct TestScene
+{
+    static constexpr ActiveEnt A{0}, B{1}, C{2}, D{3}, E{4}, F{5}, G{6}, H{7};
+    static constexpr std::size_t smc_count = 8;
+
+    ACtxSceneGraph                  scnGraph;
+    ACompTransformStorage_t         transform;
+    KeyedVec<ActiveEnt, DrawEnt>    activeToDraw;
+    ActiveEntSet_t                  needDrawTf;
+    std::vector<ActiveEnt>          roots{A, F};
+
+    TestScene()
+    {
+        scnGraph.resize(smc_count);
+        activeToDraw.resize(smc_count, lgrn::id_null<DrawEnt>());
+        needDrawTf.resize(smc_count);
+
+        SubtreeBuilder bldScnRoot = SysSceneGraph::add_descendants(scnGraph, 7);
+        SubtreeBuilder bldA = bldScnRoot.add_child(A, 4);
+        SubtreeBuilder bldB = bldA.add_child(B, 1);
+        bldB.add_child(C);
+        SubtreeBuilder bldD = bldA.add_child(D, 1);
+        bldD.add_child(E);
+        SubtreeBuilder bldF = bldScnRoot.add_child(F, 1);
+        bldF.add_child(G);
+
+        // Emplaced out of scene graph order, as if parts were attached over time
+        for (ActiveEnt const ent : {H, E, B, G, A, D, F, C})
+        {
+            float const i = float(ent.value);
+            transform.emplace(ent, ACompTransform{Matrix4::translation({i, 1.0f, -i})
+                                                * Matrix4::rotationZ(Magnum::Deg{10.0f * i})
+                                                * Matrix4::scaling({1.0f, 1.0f + 0.1f * i, 1.0f})});
+            needDrawTf.insert(ent);
+        }
+
+        // D has no DrawEnt, but its children still need its transform
+        for (ActiveEnt const ent : {A, B, C, E, F, G, H})
+        {
+            activeToDraw[ent] = DrawEnt{ent.value};
+        }
+    }
+
+    SysRender::ArgsForUpdDrawTransform args_for(DrawTransforms_t &rDrawTf)
+    {
+        return {
+            .scnGraph     = scnGraph,
+            .transforms   = transform,
+            .activeToDraw = activeToDraw,
+            .needDrawTf   = needDrawTf,
+            .rDrawTf      = rDrawTf
+        };
+    }
+};
+
+/// Draw transforms that were never written
+DrawTransforms_t unwritten()
+{
+    DrawTransforms_t out;
+    out.resize(TestScene::smc_count, Matrix4{Magnum::Math::ZeroInit});
+    return out;
+}
+
+/// Reference recursive walk, same as SysRender::update_draw_transforms before it was made linear
+void recurse(SysRender::ArgsForUpdDrawTransform const &args, ActiveEnt ent, Matrix4 const &parentTf, int depth, std::vector<int> &rDepths)
+{
+    Matrix4 const entDrawTf = parentTf * args.transforms.get(ent).m_transform;
+    rDepths[ent.value] = depth;
+
+    DrawEnt const drawEnt = args.activeToDraw[ent];
+    if (drawEnt != lgrn::id_null<DrawEnt>())
+    {
+        args.rDrawTf[drawEnt] = entDrawTf;
+    }
+
+    for (ActiveEnt const entChild : SysSceneGraph::children(args.scnGraph, ent))
+    {
+        if (args.needDrawTf.contains(entChild))
+        {
+            recurse(args, entChild, entDrawTf, depth + 1, rDepths);
+        }
+    }
+}
+
+void reference(SysRender::ArgsForUpdDrawTransform const &args, std::vector<ActiveEnt> const &roots, std::vector<int> &rDepths)
+{
+    for (ActiveEnt const root : roots)
+    {
+        bool const unchanged = args.pUnchanged != nullptr && args.pUnchanged->contains(root);
+        if (args.needDrawTf.contains(root) && ! unchanged)
+        {
+            recurse(args, root, Matrix4{}, 1, rDepths);
+        }
+    }
+}
+
+/// Run both update_draw_transforms and the reference walk, and expect identical results
+void expect_same_as_reference(TestScene &rScene, ActiveEntSet_t const *pUnchanged = nullptr)
+{
+    DrawTransforms_t drawTf    = unwritten();
+    DrawTransforms_t drawTfRef = unwritten();
+    std::vector<int> depths    (TestScene::smc_count, 0);
+    std::vector<int> depthsRef (TestScene::smc_count, 0);
+
+    auto args = rScene.args_for(drawTf);
+    args.pUnchanged = pUnchanged;
+    SysRender::update_draw_transforms(args, rScene.roots.begin(), rScene.roots.end(),
+                                      [&depths] (Matrix4 const&, ActiveEnt const ent, int const depth)
+    {
+        depths[ent.value] = depth;
+    });
+
+    auto argsRef = rScene.args_for(drawTfRef);
+    argsRef.pUnchanged = pUnchanged;
+    reference(argsRef, rScene.roots, depthsRef);
+
+    for (std::size_t i = 0; i < TestScene::smc_count; ++i)
+    {
+        EXPECT_EQ(drawTf[DrawEnt(std::uint32_t(i))], drawTfRef[DrawEnt(std::uint32_t(i))]) << "DrawEnt " << i;
+    }
+    EXPECT_EQ(depths, depthsRef);
+}
+
+} // namespace
+
+// Test that the linear scan matches a recursive walk, whether or not transforms are sorted
+TEST(DrawTransforms, MatchesRecursive)
+{
+    TestScene scene;
+    expect_same_as_reference(scene);
+
+    SysSceneGraph::sort_by_tree(scene.scnGraph, scene.transform);
+    expect_same_as_reference(scene);
+
+    // Roots given in any order
+    std::reverse(scene.roots.begin(), scene.roots.end());
+    expect_same_as_reference(scene);
+
+    // Sanity check against a hand-computed transform
+    DrawTransforms_t drawTf = unwritten();
+    SysRender::update_draw_transforms(scene.args_for(drawTf), scene.roots.begin(), scene.roots.end());
+    Matrix4 const expectC = scene.transform.get(TestScene::A).m_transform
+                          * scene.transform.get(TestScene::B).m_transform
+                          * scene.transform.get(TestScene::C).m_transform;
+    EXPECT_EQ(drawTf[DrawEnt(TestScene::C.value)], expectC);
+}
+
+// Test that subtrees of entities that don't need draw transforms are skipped as a whole
+TEST(DrawTransforms, SkipSubtree)
+{
+    TestScene scene;
+    SysSceneGraph::sort_by_tree(scene.scnGraph, scene.transform);
+
+    // C is left in needDrawTf, but is still skipped since its parent isn't
+    scene.needDrawTf.erase(TestScene::B);
+    expect_same_as_reference(scene);
+
+    DrawTransforms_t drawTf = unwritten();
+    SysRender::update_draw_transforms(scene.args_for(drawTf), scene.roots.begin(), scene.roots.end());
+
+    EXPECT_EQ(drawTf[DrawEnt(TestScene::B.value)], Matrix4{Magnum::Math::ZeroInit});
+    EXPECT_EQ(drawTf[DrawEnt(TestScene::C.value)], Matrix4{Magnum::Math::ZeroInit});
+    EXPECT_NE(drawTf[DrawEnt(TestScene::E.value)], Matrix4{Magnum::Math::ZeroInit});
+
+    // Skipping a root skips its whole tree
+    scene.needDrawTf.erase(TestScene::F);
+    expect_same_as_reference(scene);
+}
+
+// Test that roots in pUnchanged are skipped, and only calculated DrawEnts are marked dirty
+TEST(DrawTransforms, Unchanged)
+{
+    TestScene scene;
+    SysSceneGraph::sort_by_tree(scene.scnGraph, scene.transform);
+
+    ActiveEntSet_t unchanged;
+    unchanged.resize(TestScene::smc_count);
+    unchanged.insert(TestScene::F);
+
+    // Only roots are checked against pUnchanged
+    unchanged.insert(TestScene::B);
+
+    expect_same_as_reference(scene, &unchanged);
+
+    DrawTransforms_t drawTf = unwritten();
+    DrawEntDirty     dirty;
+
+    auto args = scene.args_for(drawTf);
+    args.pUnchanged = &unchanged;
+    args.pDirty     = &dirty;
+    SysRender::update_draw_transforms(args, scene.roots.begin(), scene.roots.end());
+
+    EXPECT_EQ(drawTf[DrawEnt(TestScene::F.value)], Matrix4{Magnum::Math::ZeroInit});
+    EXPECT_EQ(drawTf[DrawEnt(TestScene::G.value)], Matrix4{Magnum::Math::ZeroInit});
+    EXPECT_NE(drawTf[DrawEnt(TestScene::B.value)], Matrix4{Magnum::Math::ZeroInit});
+
+    // A, B, C, E; D has no DrawEnt
+    EXPECT_EQ(dirty.size(), 4u);
+    for (ActiveEnt const ent : {TestScene::A, TestScene::B, TestScene::C, TestScene::E})
+    {
+        EXPECT_TRUE(dirty.contains(DrawEnt(ent.value)));
+    }
+    EXPECT_FALSE(dirty.contains(DrawEnt(TestScene::G.value)));
+}
+
+// Test that entities with transforms outside the scene graph are sorted last and left alone
+TEST(DrawTransforms, OutsideTree)
+{
+    TestScene scene;
+    SysSceneGraph::sort_by_tree(scene.scnGraph, scene.transform);
+
+    auto const &entities = static_cast<ACompTransformStorage_t::base_type const&>(scene.transform);
+    std::vector<ActiveEnt> const order(entities.begin(), entities.end());
+
+    std::vector<ActiveEnt> const expectOrder{TestScene::A, TestScene::B, TestScene::C, TestScene::D,
+                                             TestScene::E, TestScene::F, TestScene::G, TestScene::H};
+    EXPECT_EQ(order, expectOrder);
+
+    // Sorting again changes nothing
+    SysSceneGraph::sort_by_tree(scene.scnGraph, scene.transform);
+    EXPECT_TRUE(std::equal(entities.begin(), entities.end(), expectOrder.begin()));
+
+    DrawTransforms_t drawTf = unwritten();
+    SysRender::update_draw_transforms(scene.args_for(drawTf), scene.roots.begin(), scene.roots.end());
+
+    EXPECT_EQ(drawTf[DrawEnt(TestScene::H.value)], Matrix4{Magnum::Math::ZeroInit});
+    expect_same_as_reference(scene);
+}
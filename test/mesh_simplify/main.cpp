@@ -0,0 +1,225 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/drawing/mesh_lod.h>
+#include <osp/drawing/mesh_simplify.h>
+
+#include <Magnum/Math/Vector2.h>
+#include <Magnum/Trade/MeshData.h>
+
+#include <Corrade/Containers/Array.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+using namespace osp;
+using namespace osp::draw;
+
+using Magnum::MeshAttribute;
+using Magnum::MeshIndexType;
+using Magnum::MeshPrimitive;
+using Magnum::Trade::MeshAttributeData;
+using Magnum::Trade::MeshData;
+using Magnum::Trade::MeshIndexData;
+
+namespace
+{
+
+constexpr std::uint32_t gc_gridSize = 9; ///< Vertices per side
+
+/**
+ * @brief Flat square grid on the XY plane, facing +Z
+ */
+struct Grid
+{
+    Grid()
+    {
+        for (std::uint32_t y = 0; y < gc_gridSize; ++y)
+        {
+            for (std::uint32_t x = 0; x < gc_gridSize; ++x)
+            {
+                positions.emplace_back(float(x), float(y), 0.0f);
+            }
+        }
+
+        for (std::uint32_t y = 0; y + 1 < gc_gridSize; ++y)
+        {
+            for (std::uint32_t x = 0; x + 1 < gc_gridSize; ++x)
+            {
+                std::uint32_t const a = y * gc_gridSize + x;
+                indices.insert(indices.end(), {a, a + 1, a + gc_gridSize + 1,
+                                               a, a + gc_gridSize + 1, a + gc_gridSize});
+            }
+        }
+    }
+
+    std::vector<Vector3>        positions;
+    std::vector<std::uint32_t>  indices;
+};
+
+bool is_border(Vector3 const pos)
+{
+    float const last = float(gc_gridSize - 1);
+    return pos.x() == 0.0f || pos.y() == 0.0f || pos.x() == last || pos.y() == last;
+}
+
+} // namespace
+
+// Test that interior vertices of a flat surface collapse freely while borders stay
+TEST(MeshSimplify, FlatGrid)
+{
+    Grid const grid;
+
+    std::vector<std::uint32_t> const out = SysMeshSimplify::simplify(
+            arrayView(grid.positions), arrayView(grid.indices), grid.indices.size() / 4, 0.01f);
+
+    ASSERT_EQ(out.size() % 3, 0u);
+    EXPECT_LT(out.size(), grid.indices.size() / 2);
+
+    std::vector<bool> used(grid.positions.size(), false);
+    for (std::size_t i = 0; i < out.size(); i += 3)
+    {
+        std::uint32_t const a = out[i], b = out[i + 1], c = out[i + 2];
+        ASSERT_LT(a, grid.positions.size());
+        ASSERT_LT(b, grid.positions.size());
+        ASSERT_LT(c, grid.positions.size());
+
+        // No degenerate or flipped triangles
+        EXPECT_TRUE(a != b && b != c && c != a);
+        Vector3 const normal = Magnum::Math::cross(grid.positions[b] - grid.positions[a],
+                                                   grid.positions[c] - grid.positions[a]);
+        EXPECT_GT(normal.z(), 0.0f);
+
+        used[a] = used[b] = used[c] = true;
+    }
+
+    // Border vertices are locked
+    for (std::size_t i = 0; i < grid.positions.size(); ++i)
+    {
+        if (is_border(grid.positions[i]))
+        {
+            EXPECT_TRUE(used[i]);
+        }
+    }
+}
+
+// Test that collapses are refused if they would change the shape more than the allowed error
+TEST(MeshSimplify, ErrorLimit)
+{
+    // Octahedron, every collapse moves the surface
+    std::array<Vector3, 6> const positions
+    {{
+        { 1.0f,  0.0f,  0.0f}, {-1.0f,  0.0f,  0.0f},
+        { 0.0f,  1.0f,  0.0f}, { 0.0f, -1.0f,  0.0f},
+        { 0.0f,  0.0f,  1.0f}, { 0.0f,  0.0f, -1.0f}
+    }};
+    std::array<std::uint32_t, 24> const indices
+    {
+        0, 2, 4,   2, 1, 4,   1, 3, 4,   3, 0, 4,
+        2, 0, 5,   1, 2, 5,   3, 1, 5,   0, 3, 5
+    };
+
+    std::vector<std::uint32_t> const out = SysMeshSimplify::simplify(
+            arrayView(positions), arrayView(indices), 0, 0.01f);
+
+    EXPECT_EQ(out.size(), indices.size());
+    EXPECT_TRUE(std::equal(out.begin(), out.end(), indices.begin()));
+}
+
+// Test that simplify_mesh drops unused vertices and keeps their other attributes
+TEST(MeshSimplify, SimplifyMesh)
+{
+    Grid const grid;
+
+    struct Vertex
+    {
+        Vector3 position;
+        Vector2 uv;
+    };
+
+    Corrade::Containers::Array<char> vertexData{Corrade::NoInit, grid.positions.size() * sizeof(Vertex)};
+    auto const vertices = Corrade::Containers::arrayCast<Vertex>(vertexData);
+    for (std::size_t i = 0; i < grid.positions.size(); ++i)
+    {
+        vertices[i] = {grid.positions[i], grid.positions[i].xy() / float(gc_gridSize - 1)};
+    }
+
+    Corrade::Containers::Array<char> indexData{Corrade::NoInit, grid.indices.size() * sizeof(std::uint32_t)};
+    std::memcpy(indexData.data(), grid.indices.data(), indexData.size());
+    MeshIndexData const indexView{MeshIndexType::UnsignedInt, indexData};
+
+    Corrade::Containers::StridedArrayView1D<Vector3> const positionsView{vertices, &vertices[0].position, vertices.size(), sizeof(Vertex)};
+    Corrade::Containers::StridedArrayView1D<Vector2> const uvView       {vertices, &vertices[0].uv,       vertices.size(), sizeof(Vertex)};
+
+    MeshData const mesh{MeshPrimitive::Triangles, std::move(indexData), indexView, std::move(vertexData),
+                        Corrade::Containers::array({
+                            MeshAttributeData{MeshAttribute::Position,          positionsView},
+                            MeshAttributeData{MeshAttribute::TextureCoordinates, uvView} })};
+
+    auto const simplified = SysMeshSimplify::simplify_mesh(mesh, 0.25f, 0.01f);
+    ASSERT_TRUE(simplified);
+
+    EXPECT_EQ(simplified->indexType(), MeshIndexType::UnsignedInt);
+    EXPECT_LT(simplified->indexCount(),  mesh.indexCount() / 2);
+    EXPECT_LT(simplified->vertexCount(), mesh.vertexCount());
+
+    auto const outPositions = simplified->positions3DAsArray();
+    auto const outUvs       = simplified->textureCoordinates2DAsArray();
+    ASSERT_EQ(outPositions.size(), outUvs.size());
+    for (std::size_t i = 0; i < outPositions.size(); ++i)
+    {
+        EXPECT_EQ(outUvs[i], outPositions[i].xy() / float(gc_gridSize - 1));
+    }
+
+    // Every remaining vertex is referenced
+    std::vector<bool> used(simplified->vertexCount(), false);
+    for (Magnum::UnsignedInt const index : simplified->indicesAsArray())
+    {
+        ASSERT_LT(index, used.size());
+        used[index] = true;
+    }
+    EXPECT_TRUE(std::all_of(used.begin(), used.end(), [] (bool x) { return x; }));
+
+    // Lines can't be simplified
+    MeshData const lines{MeshPrimitive::Lines, 2};
+    EXPECT_FALSE(SysMeshSimplify::simplify_mesh(lines, 0.5f, 0.01f));
+}
+
+TEST(MeshLod, SelectLevel)
+{
+    std::array<float, 3> const maxScreenSize{0.25f, 0.1f, 0.04f};
+
+    EXPECT_EQ(SysMeshLod::select_level(arrayView(maxScreenSize), 1.0f),   0u);
+    EXPECT_EQ(SysMeshLod::select_level(arrayView(maxScreenSize), 0.25f),  0u);
+    EXPECT_EQ(SysMeshLod::select_level(arrayView(maxScreenSize), 0.2f),   1u);
+    EXPECT_EQ(SysMeshLod::select_level(arrayView(maxScreenSize), 0.05f),  2u);
+    EXPECT_EQ(SysMeshLod::select_level(arrayView(maxScreenSize), 0.001f), 3u);
+
+    // No levels
+    EXPECT_EQ(SysMeshLod::select_level({}, 0.001f), 0u);
+}
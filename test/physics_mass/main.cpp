@@ -0,0 +1,172 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/activescene/basic_fn.h>
+#include <osp/activescene/physics_fn.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+
+using namespace osp;
+using namespace osp::active;
+
+using namespace Magnum::Math::Literals;
+
+namespace
+{
+
+//  A (colliders)
+//  ├── B (mass)
+//  └── C (colliders, mass)
+//      ├── D (mass)
+//      └── E
+struct TestScene
+{
+    static constexpr ActiveEnt A{0}, B{1}, C{2}, D{3}, E{4};
+
+    ACtxSceneGraph          scnGraph;
+    ACompTransformStorage_t transform;
+    ACtxPhysics             phys;
+
+    TestScene()
+    {
+        scnGraph.resize(5);
+        phys.m_hasColliders.resize(5);
+
+        SubtreeBuilder bldScnRoot = SysSceneGraph::add_descendants(scnGraph, 5);
+        SubtreeBuilder bldA = bldScnRoot.add_child(A, 4);
+        bldA.add_child(B);
+        SubtreeBuilder bldC = bldA.add_child(C, 2);
+        bldC.add_child(D);
+        bldC.add_child(E);
+
+        // Intermediate entities are only rotated and translated, leaves are scaled too
+        transform.emplace(A, ACompTransform{Matrix4::translation({10.0f, 0.0f, 0.0f})});
+        transform.emplace(B, ACompTransform{Matrix4::translation({0.0f, 2.0f, 0.0f})
+                                          * Matrix4::scaling({1.0f, 2.0f, 3.0f})});
+        transform.emplace(C, ACompTransform{Matrix4::translation({1.0f, -1.0f, 3.0f})
+                                          * Matrix4::rotationZ(30.0_degf)});
+        transform.emplace(D, ACompTransform{Matrix4::translation({2.0f, 0.0f, 0.0f})
+                                          * Matrix4::rotationX(45.0_degf)});
+        transform.emplace(E, ACompTransform{Matrix4::translation({0.0f, 0.0f, -4.0f})});
+
+        phys.m_hasColliders.insert(A);
+        phys.m_hasColliders.insert(C);
+        phys.m_mass.emplace(B, ACompMass{ {0.0f, 0.5f, 0.0f}, {1.0f, 2.0f, 3.0f}, 2.0f });
+        phys.m_mass.emplace(C, ACompMass{ {0.0f, 0.0f, 0.0f}, {4.0f, 4.0f, 1.0f}, 5.0f });
+        phys.m_mass.emplace(D, ACompMass{ {1.0f, 0.0f, 0.0f}, {0.5f, 0.5f, 0.5f}, 1.5f });
+    }
+
+    ACompSubtreeMass cached(ActiveEnt const ent)
+    {
+        return SysPhysics::subtree_mass(transform, phys, scnGraph, ent);
+    }
+
+    ACompSubtreeMass from_scratch(ActiveEnt const ent)
+    {
+        phys.m_subtreeMass.clear();
+        return SysPhysics::subtree_mass(transform, phys, scnGraph, ent);
+    }
+};
+
+void expect_same(ACompSubtreeMass const& incremental, ACompSubtreeMass const& scratch)
+{
+    constexpr float epsilon = 1e-4f;
+
+    EXPECT_NEAR(incremental.m_mass, scratch.m_mass, epsilon);
+
+    Vector3 const centerInc     = SysPhysics::subtree_center(incremental);
+    Vector3 const centerScratch = SysPhysics::subtree_center(scratch);
+    for (int i = 0; i < 3; ++i)
+    {
+        EXPECT_NEAR(centerInc[i], centerScratch[i], epsilon);
+    }
+
+    Matrix3 const inertiaInc     = SysPhysics::subtree_inertia_about_center(incremental);
+    Matrix3 const inertiaScratch = SysPhysics::subtree_inertia_about_center(scratch);
+    for (int col = 0; col < 3; ++col)
+    {
+        for (int row = 0; row < 3; ++row)
+        {
+            EXPECT_NEAR(inertiaInc[col][row], inertiaScratch[col][row], epsilon);
+        }
+    }
+}
+
+} // namespace
+
+// Test that adding a part to cached subtrees matches recalculating them
+TEST(PhysicsMass, Add)
+{
+    TestScene scene;
+
+    ACompSubtreeMass const before = scene.cached(TestScene::A);
+
+    scene.phys.m_mass.emplace(TestScene::E, ACompMass{ {0.0f, 0.0f, 1.0f}, {2.0f, 1.0f, 2.0f}, 3.0f });
+    scene.phys.m_hasColliders.insert(TestScene::E);
+    SysPhysics::subtree_mass_add(scene.transform, scene.phys, scene.scnGraph, TestScene::E);
+
+    ACompSubtreeMass const incremental = scene.cached(TestScene::A);
+    EXPECT_NEAR(incremental.m_mass, before.m_mass + 3.0f, 1e-4f);
+    expect_same(incremental, scene.from_scratch(TestScene::A));
+}
+
+// Test that removing and deleting a part from cached subtrees matches recalculating them
+TEST(PhysicsMass, Remove)
+{
+    TestScene scene;
+
+    (void) scene.cached(TestScene::A);
+
+    // Same order as deleting out-of-bounds entities: remove mass, cut, then delete components
+    std::array<ActiveEnt, 1> const toDelete{TestScene::D};
+    ActiveEntVec_t deleted;
+    SysPhysics::subtree_mass_remove(scene.transform, scene.phys, scene.scnGraph, TestScene::D);
+    SysSceneGraph::queue_delete_entities(scene.scnGraph, deleted, toDelete.begin(), toDelete.end());
+    SysPhysics::update_delete_phys(scene.phys, deleted.cbegin(), deleted.cend());
+
+    ACompSubtreeMass const incrementalA = scene.cached(TestScene::A);
+    ACompSubtreeMass const incrementalC = scene.cached(TestScene::C);
+
+    expect_same(incrementalC, scene.from_scratch(TestScene::C));
+    expect_same(incrementalA, scene.from_scratch(TestScene::A));
+}
+
+// Test that invalidating a moved part drops its ancestors' caches, and recalculating them matches
+TEST(PhysicsMass, Invalidate)
+{
+    TestScene scene;
+
+    (void) scene.cached(TestScene::A);
+
+    scene.transform.get(TestScene::D).m_transform = Matrix4::translation({-3.0f, 1.0f, 0.0f});
+    SysPhysics::subtree_mass_invalidate(scene.phys, scene.scnGraph, TestScene::D);
+
+    EXPECT_FALSE(scene.phys.m_subtreeMass.contains(TestScene::A));
+    EXPECT_FALSE(scene.phys.m_subtreeMass.contains(TestScene::C));
+
+    ACompSubtreeMass const recalculated = scene.cached(TestScene::A);
+    expect_same(recalculated, scene.from_scratch(TestScene::A));
+}
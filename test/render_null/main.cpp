@@ -0,0 +1,393 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp_drawing_null/rendernull.h>
+
+#include <osp/util/logging.h>
+
+#include <spdlog/sinks/null_sink.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <vector>
+
+using namespace osp;
+using namespace osp::draw;
+
+namespace
+{
+
+/**
+ * @brief Headless renderer that keeps its own copy of scene draw state, synced only through
+ *        ACtxSceneRender's dirty lists like the GL renderer
+ */
+struct HeadlessRenderer
+{
+    explicit HeadlessRenderer(std::array<MaterialId, 2> const materials)
+    {
+        for (std::size_t m = 0; m < drawNull.size(); ++m)
+        {
+            drawNull[m].materialId = materials[m];
+            drawNull[m].assign_pointers(frame, scnRenderNull);
+        }
+    }
+
+    HeadlessRenderer(HeadlessRenderer const&) = delete; // drawNull points into this
+
+    /// Consume dirty lists of one scene update
+    void sync(ACtxSceneRender const &scnRender)
+    {
+        std::size_t const capacity = scnRender.m_drawIds.capacity();
+        frame.drawTransform         .resize(capacity);
+        frame.color                 .resize(capacity);
+        scnRenderNull.m_meshId      .resize(capacity);
+        scnRenderNull.m_diffuseTexId.resize(capacity);
+
+        for (ACtxDrawNull &rDrawNull : drawNull)
+        {
+            Material const &rMat = scnRender.m_materials[rDrawNull.materialId];
+            sync_drawent_null(rMat.m_dirty.begin(), rMat.m_dirty.end(),
+            {
+                .hasMaterial    = rMat.m_ents,
+                .pStorageOpaque = &group.entities,
+                .opaque         = scnRender.m_opaque,
+                .transparent    = scnRender.m_transparent,
+                .rData          = rDrawNull
+            });
+        }
+
+        SysRenderNull::sync_drawent_mesh(scnRender.m_meshDirty.begin(), scnRender.m_meshDirty.end(),
+                                         scnRender.m_mesh, meshToRes, scnRenderNull.m_meshId, renderNull);
+
+        for (DrawEnt const ent : scnRender.m_drawTfDirty)
+        {
+            frame.drawTransform[ent] = scnRender.m_drawTransform[ent];
+        }
+        for (DrawEnt const ent : scnRender.m_colorDirty)
+        {
+            frame.color[ent] = scnRender.m_color[ent];
+        }
+    }
+
+    NullCmdStats draw(ACtxSceneRender const &scnRender, DrawEntSet_t const &visible)
+    {
+        ViewProjMatrix const viewProj{Matrix4{}, Matrix4::perspectiveProjection(Magnum::Deg(90.0f), 1.0f, 0.1f, 100.0f)};
+
+        scnRenderNull.m_commands.clear();
+        SysRenderNull::build_render_queue(scnRenderNull.m_renderQueue, scnRenderNull.m_drawBatches, group, visible,
+                                          frame, scnRender, scnRenderNull, viewProj, ERenderOrder::StateFirst);
+        SysRenderNull::render(scnRenderNull.m_renderQueue, scnRenderNull.m_drawBatches, viewProj);
+        return SysRenderNull::count(scnRenderNull.m_commands);
+    }
+
+    RenderNull                      renderNull;
+    IdMap_t<MeshId, ResIdOwner_t>   meshToRes; // No mesh resources, only scene MeshIds are synced
+    ACtxSceneRenderNull             scnRenderNull;
+    RenderFrame                     frame;
+    RenderGroup                     group;
+    std::array<ACtxDrawNull, 2>     drawNull;
+};
+
+/// Clear dirty lists at the end of a scene update, whether or not a renderer read them
+void end_scene_update(ACtxSceneRender &rScnRender)
+{
+    rScnRender.m_drawTfDirty .clear();
+    rScnRender.m_colorDirty  .clear();
+    rScnRender.m_diffuseDirty.clear();
+    rScnRender.m_meshDirty   .clear();
+    for (MaterialId const matId : rScnRender.m_materialIds)
+    {
+        rScnRender.m_materials[matId].m_dirty.clear();
+    }
+}
+
+} // namespace
+
+// Test that headless draws go through the same queue and batching as GL, and get recorded
+TEST(RenderNull, RecordDraws)
+{
+    constexpr std::size_t entCount = 10;
+
+    ACtxSceneRender     scnRender;
+    ACtxSceneRenderNull scnRenderNull;
+    RenderFrame         frame;
+    RenderGroup         group;
+
+    MaterialId const matA = scnRender.m_materialIds.create();
+    MaterialId const matB = scnRender.m_materialIds.create();
+    scnRender.m_materials.resize(scnRender.m_materialIds.capacity());
+
+    std::array<ACtxDrawNull, 2> drawNull;
+    drawNull[0].materialId = matA;
+    drawNull[1].materialId = matB;
+    drawNull[0].assign_pointers(frame, scnRenderNull);
+    drawNull[1].assign_pointers(frame, scnRenderNull);
+
+    for (std::size_t i = 0; i < entCount; ++i)
+    {
+        scnRender.m_drawIds.create();
+    }
+    scnRender.resize_draw();
+    frame.drawTransform .resize(entCount);
+    frame.color         .resize(entCount, {1.0f, 1.0f, 1.0f, 1.0f});
+    scnRenderNull.m_meshId      .resize(entCount);
+    scnRenderNull.m_diffuseTexId.resize(entCount);
+
+    DrawEntSet_t visible;
+    visible.resize(entCount);
+
+    // Entities 0-5: material A, mesh 0. Enough to be drawn instanced.
+    // Entities 6-7: material A, mesh 1
+    // Entities 8-9: material B, mesh 0
+    for (std::uint32_t i = 0; i < entCount; ++i)
+    {
+        DrawEnt const ent{i};
+        MaterialId const mat = (i < 8) ? matA : matB;
+
+        scnRender.m_materials[mat].m_ents.insert(ent);
+        scnRender.m_opaque.insert(ent);
+        visible.insert(ent);
+
+        scnRenderNull.m_meshId[ent].m_nullId = MeshNullId{ (i == 6 || i == 7) ? 1u : 0u };
+        frame.drawTransform[ent] = Matrix4::translation({0.0f, 0.0f, -float(i + 1)});
+    }
+
+    for (std::size_t m = 0; m < drawNull.size(); ++m)
+    {
+        Material const &rMat = scnRender.m_materials[drawNull[m].materialId];
+        sync_drawent_null(rMat.m_ents.begin(), rMat.m_ents.end(),
+        {
+            .hasMaterial    = rMat.m_ents,
+            .pStorageOpaque = &group.entities,
+            .opaque         = scnRender.m_opaque,
+            .transparent    = scnRender.m_transparent,
+            .rData          = drawNull[m]
+        });
+    }
+    ASSERT_EQ(group.entities.size(), entCount);
+
+    ViewProjMatrix const viewProj{Matrix4{}, Matrix4::perspectiveProjection(Magnum::Deg(90.0f), 1.0f, 0.1f, 100.0f)};
+
+    SysRenderNull::build_render_queue(scnRenderNull.m_renderQueue, scnRenderNull.m_drawBatches, group, visible,
+                                      frame, scnRender, scnRenderNull, viewProj, ERenderOrder::StateFirst);
+    SysRenderNull::render(scnRenderNull.m_renderQueue, scnRenderNull.m_drawBatches, viewProj);
+
+    NullCmdBuffer const &cmds = scnRenderNull.m_commands;
+
+    // One instanced draw of 6, and 4 single draws
+    NullCmdStats const stats = SysRenderNull::count(cmds);
+    EXPECT_EQ(stats.drawCalls,      5u);
+    EXPECT_EQ(stats.instancedCalls, 1u);
+    EXPECT_EQ(stats.entsDrawn,      entCount);
+    EXPECT_EQ(stats.shaderChanges,  2u);
+    EXPECT_EQ(cmds.transformProj.size(), 4u);
+
+    std::size_t prepared = 0;
+    std::size_t single   = 0;
+    for (NullCmd const& cmd : cmds.commands)
+    {
+        switch (cmd.type)
+        {
+        case ENullCmd::Prepare:
+            // Prepare only gets entities that aren't instanced
+            EXPECT_EQ(cmd.count, 2u);
+            ++prepared;
+            break;
+        case ENullCmd::DrawInstanced:
+            EXPECT_EQ(cmd.material, matA);
+            EXPECT_EQ(cmd.mesh,     MeshNullId{0});
+            EXPECT_EQ(cmd.count,    6u);
+            break;
+        case ENullCmd::Draw:
+            EXPECT_EQ(cmd.material, std::size_t(cmd.ent) < 8 ? matA : matB);
+            EXPECT_EQ(cmds.transformProj[single], viewProj.m_viewProj * frame.drawTransform[cmd.ent]);
+            ++single;
+            break;
+        }
+    }
+    EXPECT_EQ(prepared, 2u);
+}
+
+// Test that each DrawEnt is listed once until cleared
+TEST(DrawEntDirty, Dedupe)
+{
+    DrawEntDirty dirty;
+
+    dirty.mark(DrawEnt{3});
+    dirty.mark(DrawEnt{1});
+    dirty.mark(DrawEnt{3});
+
+    std::array<DrawEnt, 4> const more{DrawEnt{1}, DrawEnt{7}, DrawEnt{3}, DrawEnt{7}};
+    dirty.mark(more.begin(), more.end());
+
+    std::vector<DrawEnt> const listed(dirty.begin(), dirty.end());
+    EXPECT_EQ(listed, (std::vector<DrawEnt>{DrawEnt{3}, DrawEnt{1}, DrawEnt{7}}));
+    EXPECT_TRUE(dirty.contains(DrawEnt{7}));
+    EXPECT_FALSE(dirty.contains(DrawEnt{2}));
+    EXPECT_FALSE(dirty.contains(DrawEnt{100})); // Past stamps, not an error
+}
+
+// Test that clear() bumps the generation, so previous marks no longer count
+TEST(DrawEntDirty, Clear)
+{
+    DrawEntDirty dirty;
+    dirty.resize(8);
+    std::uint32_t const generation = dirty.generation();
+
+    dirty.mark(DrawEnt{2});
+    dirty.clear();
+
+    EXPECT_EQ(dirty.generation(), generation + 1);
+    EXPECT_TRUE(dirty.empty());
+    EXPECT_FALSE(dirty.contains(DrawEnt{2}));
+
+    dirty.mark(DrawEnt{2});
+    EXPECT_EQ(dirty.size(), 1u);
+    EXPECT_TRUE(dirty.contains(DrawEnt{2}));
+}
+
+// Test that stamps from before the generation wraps around don't count as marked afterwards
+TEST(DrawEntDirty, GenerationWrap)
+{
+    constexpr std::uint32_t last = std::numeric_limits<std::uint32_t>::max();
+
+    DrawEntDirty dirty{last};
+    EXPECT_EQ(dirty.generation(), last);
+
+    // Stamped with the last generation
+    dirty.mark(DrawEnt{0});
+    dirty.clear();
+
+    EXPECT_EQ(dirty.generation(), 1u);
+    EXPECT_FALSE(dirty.contains(DrawEnt{0}));
+
+    // Wrap back around to the same stamp, still not marked since stamps were reset
+    DrawEntDirty dirtyB{last - 1};
+    dirtyB.mark(DrawEnt{5});
+    dirtyB.clear();
+    dirtyB.clear();
+    EXPECT_EQ(dirtyB.generation(), 1u);
+    EXPECT_FALSE(dirtyB.contains(DrawEnt{5}));
+
+    dirtyB.mark(DrawEnt{5});
+    EXPECT_TRUE(dirtyB.contains(DrawEnt{5}));
+    EXPECT_EQ(dirtyB.size(), 1u);
+
+    // Generation 0 would match unmarked stamps
+    EXPECT_EQ(DrawEntDirty{0}.generation(), 1u);
+}
+
+// Test that a headless renderer that reconnects after missing scene updates gets the full scene
+// through SysRender::mark_all_dirty
+TEST(RenderNull, ReconnectResync)
+{
+    osp::set_thread_logger(std::make_shared<spdlog::logger>("test", std::make_shared<spdlog::sinks::null_sink_mt>()));
+
+    constexpr std::size_t entCount = 6;
+
+    ACtxDrawing         drawing;
+    ACtxSceneRender     scnRender;
+
+    MaterialId const matA = scnRender.m_materialIds.create();
+    MaterialId const matB = scnRender.m_materialIds.create();
+    scnRender.m_materials.resize(scnRender.m_materialIds.capacity());
+
+    for (std::size_t i = 0; i < entCount; ++i)
+    {
+        scnRender.m_drawIds.create();
+    }
+    scnRender.resize_draw();
+
+    MeshId const mesh = drawing.m_meshIds.create();
+
+    DrawEntSet_t visible;
+    visible.resize(entCount);
+
+    // Entities 0-3: material A, 4-5: material B. All have the same mesh.
+    for (std::uint32_t i = 0; i < entCount; ++i)
+    {
+        DrawEnt const ent{i};
+        MaterialId const mat = (i < 4) ? matA : matB;
+
+        scnRender.m_materials[mat].m_ents.insert(ent);
+        scnRender.m_materials[mat].m_dirty.mark(ent);
+        scnRender.m_opaque.insert(ent);
+        scnRender.m_mesh[ent] = drawing.m_meshRefCounts.ref_add(mesh);
+        scnRender.m_meshDirty.mark(ent);
+        scnRender.m_drawTransform[ent] = Matrix4::translation({0.0f, 0.0f, -float(i + 1)});
+        scnRender.m_drawTfDirty.mark(ent);
+        visible.insert(ent);
+    }
+
+    std::optional<HeadlessRenderer> renderer;
+    renderer.emplace(std::array<MaterialId, 2>{matA, matB});
+    renderer->sync(scnRender);
+    end_scene_update(scnRender);
+
+    EXPECT_EQ(renderer->group.entities.size(), entCount);
+    EXPECT_EQ(renderer->draw(scnRender, visible).entsDrawn, entCount);
+
+    // Renderer closes. The scene keeps updating and clearing its dirty lists.
+    renderer.reset();
+
+    scnRender.m_drawTransform[DrawEnt{2}] = Matrix4::translation({1.0f, 0.0f, -3.0f});
+    scnRender.m_drawTfDirty.mark(DrawEnt{2});
+    end_scene_update(scnRender);
+
+    // A new renderer only gets what's dirty, which is nothing
+    renderer.emplace(std::array<MaterialId, 2>{matA, matB});
+    renderer->sync(scnRender);
+    EXPECT_EQ(renderer->group.entities.size(), 0u);
+
+    // Resync, with a mark from the same update that must not be listed twice
+    scnRender.m_drawTfDirty.mark(DrawEnt{2});
+    SysRender::mark_all_dirty(scnRender);
+
+    EXPECT_EQ(scnRender.m_drawTfDirty.size(), entCount);
+    EXPECT_EQ(scnRender.m_meshDirty.size(),   entCount);
+    EXPECT_EQ(scnRender.m_materials[matA].m_dirty.size(), 4u);
+    EXPECT_EQ(scnRender.m_materials[matB].m_dirty.size(), 2u);
+
+    renderer->sync(scnRender);
+    end_scene_update(scnRender);
+
+    EXPECT_EQ(renderer->group.entities.size(), entCount);
+    for (std::uint32_t i = 0; i < entCount; ++i)
+    {
+        DrawEnt const ent{i};
+        EXPECT_EQ(renderer->frame.drawTransform[ent], scnRender.m_drawTransform[ent]);
+        EXPECT_EQ(renderer->scnRenderNull.m_meshId[ent].m_scnId, mesh);
+    }
+
+    // Same draws as before disconnecting
+    NullCmdStats const stats = renderer->draw(scnRender, visible);
+    EXPECT_EQ(stats.entsDrawn,      entCount);
+    EXPECT_EQ(stats.shaderChanges,  2u);
+
+    SysRender::clear_owners(scnRender, drawing);
+}
@@ -0,0 +1,302 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/drawing/instancing.h>
+#include <osp/drawing/render_queue.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+using namespace osp;
+using namespace osp::draw;
+
+static void draw_dummy_a(DrawEnt, ViewProjMatrix const&, EntityToDraw::UserData_t, RenderStateChanges) noexcept { }
+static void draw_dummy_b(DrawEnt, ViewProjMatrix const&, EntityToDraw::UserData_t, RenderStateChanges) noexcept { }
+static void draw_dummy_instanced(DrawEnt, ArrayView<InstanceData const>, ViewProjMatrix const&, EntityToDraw::UserData_t, RenderStateChanges) noexcept { }
+
+// Test ordering of packed keys
+TEST(RenderQueue, Keys)
+{
+    using Sys = SysRenderQueue;
+
+    constexpr RenderKeyParts partsA{.material = 1, .texture = 5, .mesh = 7};
+    constexpr RenderKeyParts partsB{.material = 1, .texture = 5, .mesh = 8};
+
+    // Depth quantization keeps order, and clamps values behind the camera
+    EXPECT_LT(Sys::quantize_depth(0.5f),   Sys::quantize_depth(1.0f));
+    EXPECT_LT(Sys::quantize_depth(1.0f),   Sys::quantize_depth(1000.0f));
+    EXPECT_EQ(Sys::quantize_depth(-10.0f), Sys::quantize_depth(0.0f));
+
+    // State first: shader beats mesh, mesh beats depth
+    EXPECT_LT(Sys::make_key(0, partsB, 100.0f, ERenderOrder::StateFirst),
+              Sys::make_key(1, partsA,   1.0f, ERenderOrder::StateFirst));
+    EXPECT_LT(Sys::make_key(0, partsA, 100.0f, ERenderOrder::StateFirst),
+              Sys::make_key(0, partsB,   1.0f, ERenderOrder::StateFirst));
+    EXPECT_LT(Sys::make_key(0, partsA,   1.0f, ERenderOrder::StateFirst),
+              Sys::make_key(0, partsA, 100.0f, ERenderOrder::StateFirst));
+
+    // Back to front: far objects first regardless of state
+    EXPECT_LT(Sys::make_key(1, partsB, 100.0f, ERenderOrder::BackToFront),
+              Sys::make_key(0, partsA,   1.0f, ERenderOrder::BackToFront));
+}
+
+// Test that radix sorting gives the same order as a stable comparison sort
+TEST(RenderQueue, Sort)
+{
+    std::mt19937_64 gen{1234};
+
+    for (std::size_t const count : {std::size_t{0}, std::size_t{10}, std::size_t{1000}, std::size_t{20000}})
+    {
+        RenderQueue queue;
+
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            // Few distinct shaders and materials in the top bytes, like a real scene
+            RenderKey_t const key = (gen() % 3) << 56 | (gen() % 4) << 48 | (gen() & 0xFFFF'FFFF'FFFFull);
+            queue.items.push_back({key, i});
+        }
+
+        std::vector<RenderQueueItem> expected = queue.items;
+        std::stable_sort(expected.begin(), expected.end(), [] (RenderQueueItem const& lhs, RenderQueueItem const& rhs)
+        {
+            return lhs.key < rhs.key;
+        });
+
+        SysRenderQueue::sort(queue);
+
+        ASSERT_EQ(queue.items.size(), expected.size());
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            EXPECT_EQ(queue.items[i].key,   expected[i].key);
+            EXPECT_EQ(queue.items[i].index, expected[i].index);
+        }
+    }
+}
+
+// Test building a queue from a RenderGroup and the render state changes between commands
+TEST(RenderQueue, Build)
+{
+    constexpr std::size_t entCount = 8;
+
+    int shaderA = 0;
+    int shaderB = 0;
+
+    RenderGroup         group;
+    DrawEntSet_t        visible;
+    DrawTransforms_t    drawTf;
+    visible.resize(entCount);
+    drawTf .resize(entCount);
+
+    // Meshes by DrawEnt
+    std::vector<std::uint32_t> const meshes { 2, 1, 2, 1, 3, 3, 1, 2 };
+
+    for (std::uint32_t i = 0; i < entCount; ++i)
+    {
+        DrawEnt const ent{i};
+
+        // Even entities use shader A, odd use B
+        EntityToDraw const toDraw = (i % 2 == 0)
+                                  ? EntityToDraw{&draw_dummy_a, {&shaderA}}
+                                  : EntityToDraw{&draw_dummy_b, {&shaderB}};
+        group.entities.emplace(ent, toDraw);
+
+        // Entity 5 is hidden
+        if (i != 5)
+        {
+            visible.insert(ent);
+        }
+
+        // Further away with higher Ids, camera looks down -Z
+        drawTf[ent] = Matrix4::translation({0.0f, 0.0f, -float(i + 1)});
+    }
+
+    RenderQueue queue;
+    SysRenderQueue::build(queue,
+                          {
+                              .group   = group,
+                              .visible = visible,
+                              .drawTf  = drawTf,
+                              .view    = Matrix4{},
+                              .order   = ERenderOrder::StateFirst
+                          },
+                          [&meshes] (DrawEnt const ent)
+    {
+        return RenderKeyParts{.material = 0, .texture = 0, .mesh = meshes[std::size_t(ent)]};
+    });
+
+    ASSERT_EQ(queue.shaders.size(), 2);
+    ASSERT_EQ(queue.commands.size(), entCount - 1);
+
+    // Group by shader, then mesh, then front-to-back
+    std::vector<DrawEnt> order;
+    for (RenderCmd const& cmd : queue.commands)
+    {
+        order.push_back(cmd.ent);
+    }
+
+    std::uint32_t const shaderIdxA = queue.commands.front().shader;
+    bool const aFirst = (queue.shaders[shaderIdxA].draw == &draw_dummy_a);
+
+    std::vector<DrawEnt> const evens { DrawEnt{6}, DrawEnt{0}, DrawEnt{2}, DrawEnt{4} };  // meshes 1, 2, 2, 3
+    std::vector<DrawEnt> const odds  { DrawEnt{1}, DrawEnt{3}, DrawEnt{7} };              // meshes 1, 1, 2
+
+    std::vector<DrawEnt> expected;
+    for (std::vector<DrawEnt> const* pList : (aFirst ? std::array{&evens, &odds} : std::array{&odds, &evens}))
+    {
+        expected.insert(expected.end(), pList->begin(), pList->end());
+    }
+    EXPECT_EQ(order, expected);
+
+    // State changes: first of each shader changes everything, then only mesh changes
+    for (std::size_t i = 0; i < queue.commands.size(); ++i)
+    {
+        RenderCmd const &cmd = queue.commands[i];
+        if (i == 0 || queue.commands[i - 1].shader != cmd.shader)
+        {
+            EXPECT_EQ(cmd.changed, gc_renderStateAll);
+            continue;
+        }
+
+        bool const meshChanged = meshes[std::size_t(queue.commands[i - 1].ent)] != meshes[std::size_t(cmd.ent)];
+        EXPECT_EQ(cmd.changed, meshChanged ? RenderStateChanges{RenderStateChange::Mesh} : RenderStateChanges{});
+    }
+}
+
+// Test splitting a queue into instanced and non-instanced batches
+TEST(RenderQueue, InstanceBatches)
+{
+    constexpr std::size_t entCount = 12;
+
+    int shaderA = 0;
+    int shaderB = 0;
+
+    RenderGroup         group;
+    DrawEntSet_t        visible;
+    DrawTransforms_t    drawTf;
+    DrawEntColors_t     colors;
+    visible.resize(entCount);
+    drawTf .resize(entCount);
+    colors .resize(entCount);
+
+    // Entities 0-7 use instanceable shader A: five with mesh 1, three with mesh 2.
+    // Entities 8-11 use shader B, which can't be instanced, all with mesh 1.
+    std::vector<std::uint32_t> const meshes { 1, 2, 1, 2, 1, 2, 1, 1, 1, 1, 1, 1 };
+
+    for (std::uint32_t i = 0; i < entCount; ++i)
+    {
+        DrawEnt const ent{i};
+
+        EntityToDraw const toDraw = (i < 8)
+                                  ? EntityToDraw{&draw_dummy_a, {&shaderA}, &draw_dummy_instanced}
+                                  : EntityToDraw{&draw_dummy_b, {&shaderB}};
+        group.entities.emplace(ent, toDraw);
+        visible.insert(ent);
+
+        drawTf[ent] = Matrix4::translation({float(i), 0.0f, -1.0f});
+        colors[ent] = Magnum::Color4{float(i) / entCount};
+    }
+
+    RenderQueue queue;
+    SysRenderQueue::build(queue,
+                          {
+                              .group   = group,
+                              .visible = visible,
+                              .drawTf  = drawTf,
+                              .view    = Matrix4{}
+                          },
+                          [&meshes] (DrawEnt const ent)
+    {
+        return RenderKeyParts{.material = 0, .texture = 0, .mesh = meshes[std::size_t(ent)]};
+    });
+
+    DrawBatches batches;
+    SysInstancing::build(batches, queue, drawTf, &colors, 4);
+
+    // Mesh 1 run of shader A is instanced. Mesh 2 run of shader A is too short, and merges with
+    // shader B's entities if they're adjacent in the queue.
+    std::size_t instancedCount = 0;
+    std::size_t totalCount     = 0;
+    for (std::size_t i = 0; i < batches.batches.size(); ++i)
+    {
+        DrawBatch const &batch = batches.batches[i];
+        totalCount += batch.count;
+
+        if (i != 0 && batch.instanced() != batches.batches[i - 1].instanced())
+        {
+            EXPECT_EQ(batch.changed, gc_renderStateAll);
+        }
+
+        if ( ! batch.instanced() )
+        {
+            continue;
+        }
+
+        ++instancedCount;
+        ASSERT_EQ(batch.count, 5);
+
+        for (std::uint32_t j = 0; j < batch.count; ++j)
+        {
+            DrawEnt const       ent      = queue.commands[batch.cmdFirst + j].ent;
+            InstanceData const &instance = batches.instances[batch.instFirst + j];
+
+            EXPECT_EQ(meshes[std::size_t(ent)], 1);
+            EXPECT_LT(std::size_t(ent), 8);
+            EXPECT_EQ(instance.transform, drawTf[ent]);
+            EXPECT_EQ(instance.color,     colors[ent]);
+        }
+    }
+
+    EXPECT_EQ(instancedCount, 1);
+    EXPECT_EQ(totalCount, entCount);
+    EXPECT_EQ(batches.instances.size(), 5);
+
+    // Each shader lists the entities it draws without instancing, in draw order
+    ASSERT_EQ(batches.shaderEnts.size(), queue.shaders.size());
+    std::size_t notInstancedCount = 0;
+    for (std::size_t shader = 0; shader < batches.shaderEnts.size(); ++shader)
+    {
+        std::vector<DrawEnt> const &ents = batches.shaderEnts[shader];
+        notInstancedCount += ents.size();
+
+        auto cmdIt = queue.commands.begin();
+        for (DrawEnt const ent : ents)
+        {
+            cmdIt = std::find_if(cmdIt, queue.commands.end(), [ent] (RenderCmd const& cmd) { return cmd.ent == ent; });
+            ASSERT_NE(cmdIt, queue.commands.end());
+            EXPECT_EQ(cmdIt->shader, shader);
+            EXPECT_TRUE(std::size_t(ent) >= 8 || meshes[std::size_t(ent)] == 2);
+        }
+    }
+    EXPECT_EQ(notInstancedCount, entCount - 5);
+
+    // Nothing is instanced if runs are too short
+    SysInstancing::build(batches, queue, drawTf, &colors, 6);
+    ASSERT_EQ(batches.batches.size(), 1);
+    EXPECT_FALSE(batches.batches.front().instanced());
+    EXPECT_EQ(batches.batches.front().count, entCount);
+}
@@ -0,0 +1,193 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/drawing/render_snapshot.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <vector>
+
+using namespace osp;
+using namespace osp::draw;
+
+using namespace Magnum::Math::Literals;
+
+namespace
+{
+
+struct TestScene
+{
+    ACtxSceneRender     scnRender;
+    ACtxRenderSnapshots snapshots;
+
+    explicit TestScene(std::size_t entCount)
+    {
+        std::vector<DrawEnt> ents(entCount);
+        scnRender.m_drawIds.create(ents.begin(), ents.end());
+        scnRender.resize_draw();
+    }
+
+    void move(DrawEnt ent, Vector3 position, bool markDirty = true)
+    {
+        scnRender.m_drawTransform[ent] = Matrix4::translation(position);
+        if (markDirty)
+        {
+            scnRender.m_drawTfDirty.mark(ent);
+        }
+    }
+
+    void publish()
+    {
+        SysRenderSnapshot::publish(snapshots, scnRender);
+    }
+};
+
+} // namespace
+
+// Test that only dirty entities are copied, and that every snapshot catches up with changes
+TEST(RenderSnapshot, Publish)
+{
+    TestScene scene{4};
+
+    // First write of each snapshot copies everything
+    scene.move(DrawEnt{0}, {1.0f, 0.0f, 0.0f}, false);
+    for (std::uint32_t i = 0; i < ACtxRenderSnapshots::smc_count; ++i)
+    {
+        scene.publish();
+        EXPECT_TRUE(scene.snapshots.latest().resized);
+        EXPECT_EQ(scene.snapshots.latest().drawTransform[DrawEnt{0}].translation(), Vector3(1.0f, 0.0f, 0.0f));
+    }
+
+    // Changes not in the dirty lists are not copied
+    scene.move(DrawEnt{1}, {2.0f, 0.0f, 0.0f}, false);
+    scene.move(DrawEnt{2}, {3.0f, 0.0f, 0.0f});
+    scene.scnRender.m_color[DrawEnt{3}] = 0xff0000ff_rgbaf;
+    scene.scnRender.m_colorDirty.mark(DrawEnt{3});
+
+    // Every snapshot gets the changes when it's written next, not only the one written first
+    for (std::uint32_t i = 0; i < ACtxRenderSnapshots::smc_count + 1; ++i)
+    {
+        scene.publish();
+        EXPECT_TRUE(scene.scnRender.m_drawTfDirty.empty());
+        EXPECT_TRUE(scene.scnRender.m_colorDirty.empty());
+
+        RenderSnapshot const &snap = scene.snapshots.latest();
+        EXPECT_FALSE(snap.resized);
+        EXPECT_EQ(snap.drawTransform[DrawEnt{0}].translation(), Vector3(1.0f, 0.0f, 0.0f));
+        EXPECT_EQ(snap.drawTransform[DrawEnt{1}].translation(), Vector3(0.0f));
+        EXPECT_EQ(snap.drawTransform[DrawEnt{2}].translation(), Vector3(3.0f, 0.0f, 0.0f));
+        EXPECT_EQ(snap.color[DrawEnt{3}], 0xff0000ff_rgbaf);
+    }
+
+    // Resizing copies everything again
+    scene.scnRender.m_drawTransform .resize(8);
+    scene.scnRender.m_color         .resize(8);
+    scene.publish();
+    EXPECT_TRUE(scene.snapshots.latest().resized);
+    EXPECT_EQ(scene.snapshots.latest().drawTransform[DrawEnt{1}].translation(), Vector3(2.0f, 0.0f, 0.0f));
+}
+
+// Test interpolating between the two latest snapshots
+TEST(RenderSnapshot, Interpolate)
+{
+    TestScene scene{2};
+
+    scene.move(DrawEnt{0}, {0.0f, 0.0f, 0.0f});
+    scene.move(DrawEnt{1}, {5.0f, 0.0f, 0.0f});
+    scene.publish();
+    scene.move(DrawEnt{0}, {4.0f, 0.0f, 0.0f});
+    scene.publish();
+
+    RenderFrame const &frame = scene.snapshots.frame;
+
+    SysRenderSnapshot::interpolate(scene.snapshots, 0.25f);
+    EXPECT_EQ(frame.drawTransform[DrawEnt{0}].translation(), Vector3(1.0f, 0.0f, 0.0f));
+    EXPECT_EQ(frame.drawTransform[DrawEnt{1}].translation(), Vector3(5.0f, 0.0f, 0.0f));
+
+    SysRenderSnapshot::interpolate(scene.snapshots, 0.5f);
+    EXPECT_EQ(frame.drawTransform[DrawEnt{0}].translation(), Vector3(2.0f, 0.0f, 0.0f));
+
+    // Entity stopped moving, frame must not be left at an interpolated position
+    scene.publish();
+    SysRenderSnapshot::interpolate(scene.snapshots, 0.5f);
+    EXPECT_EQ(frame.drawTransform[DrawEnt{0}].translation(), Vector3(4.0f, 0.0f, 0.0f));
+
+    // Several publishes between interpolations
+    scene.move(DrawEnt{1}, {6.0f, 0.0f, 0.0f});
+    scene.publish();
+    scene.publish();
+    SysRenderSnapshot::interpolate(scene.snapshots, 0.5f);
+    EXPECT_EQ(frame.drawTransform[DrawEnt{1}].translation(), Vector3(6.0f, 0.0f, 0.0f));
+}
+
+// Test interpolating rotation and scale separately from translation
+TEST(RenderSnapshot, InterpolateTransform)
+{
+    Matrix4 const a = Matrix4::translation({0.0f, 0.0f, 0.0f}) * Matrix4::rotationZ(0.0_degf)  * Matrix4::scaling(Vector3{2.0f});
+    Matrix4 const b = Matrix4::translation({2.0f, 0.0f, 0.0f}) * Matrix4::rotationZ(90.0_degf) * Matrix4::scaling(Vector3{4.0f});
+
+    Matrix4 const expected = Matrix4::translation({1.0f, 0.0f, 0.0f}) * Matrix4::rotationZ(45.0_degf) * Matrix4::scaling(Vector3{3.0f});
+    Matrix4 const result   = SysRenderSnapshot::interpolate_transform(a, b, 0.5f);
+
+    for (int col = 0; col < 4; ++col)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            EXPECT_NEAR(result[col][row], expected[col][row], 1e-5f);
+        }
+    }
+
+    EXPECT_EQ(SysRenderSnapshot::interpolate_transform(a, b, 0.0f).translation(), a.translation());
+    EXPECT_EQ(SysRenderSnapshot::interpolate_transform(a, b, 1.0f).translation(), b.translation());
+}
+
+// Test that dirty lists hold each DrawEnt once per generation
+TEST(RenderSnapshot, DirtyList)
+{
+    DrawEntDirty dirty;
+    dirty.resize(4);
+
+    dirty.mark(DrawEnt{2});
+    dirty.mark(DrawEnt{2});
+    dirty.mark(DrawEnt{9}); // past resize, grows
+    std::array const more{DrawEnt{0}, DrawEnt{2}, DrawEnt{9}};
+    dirty.mark(more.begin(), more.end());
+
+    EXPECT_EQ(std::vector<DrawEnt>(dirty.begin(), dirty.end()), (std::vector{DrawEnt{2}, DrawEnt{9}, DrawEnt{0}}));
+    EXPECT_TRUE(dirty.contains(DrawEnt{9}));
+    EXPECT_FALSE(dirty.contains(DrawEnt{1}));
+    EXPECT_FALSE(dirty.contains(DrawEnt{100}));
+
+    std::uint32_t const generation = dirty.generation();
+    dirty.clear();
+    EXPECT_TRUE(dirty.empty());
+    EXPECT_NE(dirty.generation(), generation);
+    EXPECT_FALSE(dirty.contains(DrawEnt{2}));
+
+    // Marked again after clearing
+    dirty.mark(DrawEnt{2});
+    EXPECT_EQ(dirty.size(), 1u);
+    EXPECT_TRUE(dirty.contains(DrawEnt{2}));
+}
@@ -0,0 +1,433 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <planet-a/activescene/terrain.h>
+#include <planet-a/activescene/terrain_fn.h>
+
+#include <osp/util/logging.h>
+
+#include <spdlog/sinks/null_sink.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <vector>
+
+using namespace planeta;
+
+using osp::Vector3;
+using osp::Vector3d;
+using osp::Vector3l;
+
+using ChunkSet_t = std::set<std::uint16_t>;
+
+namespace
+{
+
+constexpr double gc_radius = 100.0;
+
+/// Small planet with a few levels of subdivision, same as the terrain scenario
+struct TestTerrain
+{
+    TestTerrain()
+    {
+        osp::set_thread_logger(std::make_shared<spdlog::logger>("test", std::make_shared<spdlog::sinks::null_sink_mt>()));
+
+        SysTerrainIco::initialize({
+            .radius                 = gc_radius,
+            .height                 = 2.0,
+            .skelPrecision          = 10,
+            .skelMaxSubdivLevels    = 5,
+            .chunkSubdivLevels      = 4 }, frame, terrain, ico);
+    }
+
+    /// Subdivide around a viewer until there are no more changes
+    void update(Vector3d const viewer)
+    {
+        terrain.scratchpad.viewerPosition = Vector3l(viewer * std::exp2(double(terrain.skData.precision)));
+        for (int i = 0; i < 8; ++i)
+        {
+            SysTerrainIco::subdivide_by_distance(terrain, ico);
+            SysTerrainIco::update_chunks(frame, terrain, ico);
+            terrain.scratchpad.surfaceAdded  .clear();
+            terrain.scratchpad.surfaceRemoved.clear();
+        }
+    }
+
+    ACtxTerrainFrame    frame;
+    ACtxTerrain         terrain;
+    ACtxTerrainIco      ico;
+};
+
+/// Point on the planet's surface in meters
+Vector3d surface(Vector3d const dir)
+{
+    return dir.normalized() * gc_radius;
+}
+
+/// Chunks near a body found by checking every chunk, for comparison
+ChunkSet_t reference_near(ACtxTerrain const &rTerrain, std::vector<Vector3d> const &bodiesMeters, double const margin)
+{
+    double const scale = std::exp2(double(rTerrain.skData.precision));
+
+    ChunkSet_t out;
+    for (ChunkId const chunkId : rTerrain.skChunks.m_chunkIds)
+    {
+        SkTriId  const sktriId = rTerrain.skChunks.m_chunkToTri[chunkId];
+        Vector3d const center  = Vector3d(rTerrain.skData.centers[sktriId]) / scale;
+
+        double radius = 0.0;
+        for (SkVrtxOwner_t const& corner : rTerrain.skeleton.tri_at(sktriId).vertices)
+        {
+            radius = std::max(radius, (Vector3d(rTerrain.skData.positions[corner.value()]) / scale - center).length());
+        }
+
+        for (Vector3d const& body : bodiesMeters)
+        {
+            if ((body - center).length() < radius + margin)
+            {
+                out.insert(chunkId.value);
+            }
+        }
+    }
+    return out;
+}
+
+ChunkSet_t as_set(std::vector<ChunkId> const& chunks)
+{
+    ChunkSet_t out;
+    for (ChunkId const chunkId : chunks)
+    {
+        out.insert(chunkId.value);
+    }
+    return out;
+}
+
+ChunkSet_t as_set(lgrn::IdSetStl<ChunkId> const& chunks)
+{
+    ChunkSet_t out;
+    for (ChunkId const chunkId : chunks)
+    {
+        out.insert(chunkId.value);
+    }
+    return out;
+}
+
+/// Create or remove chunk IDs without any mesh, to control the chunk count seen by update_lod
+void set_chunk_count(ACtxTerrain &rTerrain, std::size_t const count)
+{
+    auto &rChunkIds = rTerrain.skChunks.m_chunkIds;
+    while (rChunkIds.size() < count)
+    {
+        rChunkIds.create();
+    }
+    while (rChunkIds.size() > count)
+    {
+        rChunkIds.remove(*rChunkIds.begin());
+    }
+}
+
+} // namespace
+
+// Test that nothing gets colliders without any bodies
+TEST(TerrainCollision, NoBodies)
+{
+    TestTerrain test;
+    test.update(surface({0.0, 0.0, 1.0}));
+
+    ACtxTerrainCollision coll;
+    SysTerrainCollision::update(coll, test.terrain, test.frame);
+
+    EXPECT_TRUE(coll.added.empty());
+    EXPECT_TRUE(coll.removed.empty());
+    EXPECT_TRUE(coll.active.empty());
+}
+
+// Test that chunks are selected if a body is within their bounding sphere plus margin
+TEST(TerrainCollision, SelectByMargin)
+{
+    TestTerrain test;
+    Vector3d const body = surface({0.2, 0.3, 1.0});
+    test.update(body);
+
+    ACtxTerrainCollision coll;
+    coll.margin = 4.0f;
+    coll.bodyPositions = { Vector3(body) };
+    SysTerrainCollision::update(coll, test.terrain, test.frame);
+
+    ChunkSet_t const expected = reference_near(test.terrain, {body}, coll.margin);
+    ASSERT_FALSE(expected.empty());
+    EXPECT_LT(expected.size(), test.terrain.skChunks.m_chunkIds.size());
+    EXPECT_EQ(as_set(coll.added), expected);
+    EXPECT_EQ(as_set(coll.active), expected);
+    EXPECT_TRUE(coll.removed.empty());
+
+    // A margin larger than the planet selects every chunk
+    coll.margin = float(4.0 * gc_radius);
+    SysTerrainCollision::update(coll, test.terrain, test.frame);
+
+    EXPECT_EQ(coll.active.size(), test.terrain.skChunks.m_chunkIds.size());
+    EXPECT_EQ(as_set(coll.added).size() + expected.size(), coll.active.size());
+    EXPECT_TRUE(coll.removed.empty());
+
+    // Shrinking the margin back only removes the extra chunks
+    coll.margin = 4.0f;
+    SysTerrainCollision::update(coll, test.terrain, test.frame);
+
+    EXPECT_EQ(as_set(coll.active), expected);
+    EXPECT_TRUE(coll.added.empty());
+    EXPECT_EQ(coll.removed.size(), test.terrain.skChunks.m_chunkIds.size() - expected.size());
+}
+
+// Test that body positions are brought into the terrain's frame, so a floating origin translation
+// that moves both the scene and terrain frame doesn't change which chunks are selected
+TEST(TerrainCollision, FramePosition)
+{
+    TestTerrain test;
+    Vector3d const body = surface({-1.0, 0.5, 0.2});
+    test.update(body);
+
+    ACtxTerrainCollision coll;
+    coll.bodyPositions = { Vector3(body) };
+    SysTerrainCollision::update(coll, test.terrain, test.frame);
+    ChunkSet_t const before = as_set(coll.active);
+    ASSERT_FALSE(before.empty());
+
+    Vector3d const shift{40.0, -30.0, 20.0};
+    test.frame.position += Vector3l(shift * std::exp2(double(test.terrain.skData.precision)));
+    coll.bodyPositions = { Vector3(body - shift) };
+    SysTerrainCollision::update(coll, test.terrain, test.frame);
+
+    EXPECT_EQ(as_set(coll.active), before);
+    EXPECT_TRUE(coll.added.empty());
+    EXPECT_TRUE(coll.removed.empty());
+}
+
+// Test that colliders stream in and out as a body moves across the planet
+TEST(TerrainCollision, Streaming)
+{
+    TestTerrain test;
+    Vector3d const bodyA = surface({1.0, 0.0, 0.1});
+    Vector3d const bodyB = surface({-1.0, 0.0, 0.1});
+    test.update(bodyA);
+
+    ACtxTerrainCollision coll;
+    coll.bodyPositions = { Vector3(bodyA) };
+    SysTerrainCollision::update(coll, test.terrain, test.frame);
+    ChunkSet_t const nearA = as_set(coll.active);
+    ASSERT_FALSE(nearA.empty());
+
+    // Body moves to the other side of the planet, terrain is subdivided around it
+    test.update(bodyB);
+    coll.bodyPositions = { Vector3(bodyB) };
+    SysTerrainCollision::update(coll, test.terrain, test.frame);
+
+    ChunkSet_t const nearB = reference_near(test.terrain, {bodyB}, coll.margin);
+    ASSERT_FALSE(nearB.empty());
+    EXPECT_EQ(as_set(coll.active), nearB);
+
+    // Every previously active chunk is gone, either deleted or now far away
+    ChunkSet_t const removed = as_set(coll.removed);
+    EXPECT_EQ(removed.size(), coll.removed.size()); // No duplicates
+    for (std::uint16_t const chunk : nearA)
+    {
+        EXPECT_TRUE(removed.contains(chunk));
+    }
+    EXPECT_EQ(as_set(coll.added), nearB);
+
+    // Moving away entirely removes everything
+    coll.bodyPositions.clear();
+    SysTerrainCollision::update(coll, test.terrain, test.frame);
+    EXPECT_EQ(as_set(coll.removed), nearB);
+    EXPECT_TRUE(coll.active.empty());
+}
+
+// Test that colliders are kept while their chunk is unchanged, and rebuilt if it's restitched
+TEST(TerrainCollision, ColliderReuse)
+{
+    TestTerrain test;
+    Vector3d const body = surface({0.0, 1.0, -0.3});
+    test.update(body);
+
+    ACtxTerrainCollision coll;
+    coll.bodyPositions = { Vector3(body) };
+    SysTerrainCollision::update(coll, test.terrain, test.frame);
+    ChunkSet_t const active = as_set(coll.active);
+    ASSERT_FALSE(active.empty());
+
+    // Nothing changed, so nothing to rebuild
+    test.update(body);
+    SysTerrainCollision::update(coll, test.terrain, test.frame);
+    EXPECT_TRUE(coll.added.empty());
+    EXPECT_TRUE(coll.removed.empty());
+    EXPECT_EQ(as_set(coll.active), active);
+
+    // Edge triangles of a chunk are redone
+    ChunkId const restitched{*active.begin()};
+    ChunkStitch &rStitch = test.terrain.skChunks.m_chunkStitch[restitched];
+    rStitch.detailX2 = ! rStitch.detailX2;
+
+    SysTerrainCollision::update(coll, test.terrain, test.frame);
+    EXPECT_EQ(as_set(coll.removed), ChunkSet_t{restitched.value});
+    EXPECT_EQ(as_set(coll.added),   ChunkSet_t{restitched.value});
+    EXPECT_EQ(as_set(coll.active), active);
+}
+
+// Test that a budget too small for every terrain's minimum is split evenly, ignoring screen size
+TEST(TerrainLod, EvenSplit)
+{
+    constexpr std::uint32_t min = SysTerrainIco::gc_minTerrainChunks;
+
+    std::array<TerrainLod, 3> lods;
+    lods[0].screenSize = 1000.0f;
+    lods[1].screenSize = 1.0f;
+    lods[2].screenSize = 0.0f;
+
+    SysTerrainIco::distribute_chunk_budget(150, {lods.data(), lods.size()});
+    for (TerrainLod const &lod : lods)
+    {
+        EXPECT_EQ(lod.chunkLimit, 50);
+    }
+
+    // Exactly enough for the minimums is still an even split
+    SysTerrainIco::distribute_chunk_budget(min * 3, {lods.data(), lods.size()});
+    for (TerrainLod const &lod : lods)
+    {
+        EXPECT_EQ(lod.chunkLimit, min);
+    }
+
+    // Empty budget
+    SysTerrainIco::distribute_chunk_budget(0, {lods.data(), lods.size()});
+    for (TerrainLod const &lod : lods)
+    {
+        EXPECT_EQ(lod.chunkLimit, 0);
+    }
+}
+
+// Test that chunks above the minimums are split by area on screen, and never exceed the budget
+TEST(TerrainLod, WeightedSplit)
+{
+    constexpr std::uint32_t min = SysTerrainIco::gc_minTerrainChunks;
+
+    std::array<TerrainLod, 2> lods;
+    lods[0].screenSize = 3.0f;
+    lods[1].screenSize = 1.0f;
+
+    // 9:1 by area
+    std::uint32_t const total = min * 2 + 1000;
+    SysTerrainIco::distribute_chunk_budget(total, {lods.data(), lods.size()});
+    EXPECT_NEAR(double(lods[0].chunkLimit), double(min + 900), 1.0);
+    EXPECT_NEAR(double(lods[1].chunkLimit), double(min + 100), 1.0);
+    EXPECT_LE(lods[0].chunkLimit + lods[1].chunkLimit, total);
+
+    // Terrains that aren't visible still get the minimum
+    lods[1].screenSize = 0.0f;
+    SysTerrainIco::distribute_chunk_budget(total, {lods.data(), lods.size()});
+    EXPECT_EQ(lods[0].chunkLimit, min + 1000);
+    EXPECT_EQ(lods[1].chunkLimit, min);
+
+    // Nothing visible, split the rest evenly
+    lods[0].screenSize = 0.0f;
+    SysTerrainIco::distribute_chunk_budget(total, {lods.data(), lods.size()});
+    EXPECT_EQ(lods[0].chunkLimit, min + 500);
+    EXPECT_EQ(lods[1].chunkLimit, min + 500);
+
+    // No terrains, nothing to do
+    SysTerrainIco::distribute_chunk_budget(total, {});
+}
+
+// Test that update_lod shrinks detail quickly over the limit, grows slowly well under it, and
+// holds in between
+TEST(TerrainLod, UpdateLod)
+{
+    TestTerrain test;
+    auto const &thresholds = test.terrain.scratchpad.distanceThresholdSubdiv;
+    double const fullDetail = thresholds[0];
+
+    TerrainLod lod;
+    lod.chunkLimit = 100;
+
+    // Over the limit
+    set_chunk_count(test.terrain, 101);
+    SysTerrainIco::update_lod(lod, test.terrain, test.ico);
+    EXPECT_DOUBLE_EQ(lod.distanceScale, 0.75);
+    EXPECT_DOUBLE_EQ(thresholds[0], fullDetail * 0.75);
+
+    // Between 3/4 of the limit and the limit
+    set_chunk_count(test.terrain, 100);
+    SysTerrainIco::update_lod(lod, test.terrain, test.ico);
+    EXPECT_DOUBLE_EQ(lod.distanceScale, 0.75);
+
+    set_chunk_count(test.terrain, 75);
+    SysTerrainIco::update_lod(lod, test.terrain, test.ico);
+    EXPECT_DOUBLE_EQ(lod.distanceScale, 0.75);
+
+    // Well under the limit
+    set_chunk_count(test.terrain, 74);
+    SysTerrainIco::update_lod(lod, test.terrain, test.ico);
+    EXPECT_DOUBLE_EQ(lod.distanceScale, 0.75 * 1.05);
+    EXPECT_DOUBLE_EQ(thresholds[0], fullDetail * 0.75 * 1.05);
+
+    set_chunk_count(test.terrain, 0);
+}
+
+// Test that distanceScale is clamped to full detail and 1/1024, and the limit to chunk capacity
+TEST(TerrainLod, UpdateLodClamp)
+{
+    TestTerrain test;
+    auto const &thresholds = test.terrain.scratchpad.distanceThresholdSubdiv;
+    double const fullDetail = thresholds[0];
+
+    TerrainLod lod;
+    lod.chunkLimit = 100;
+
+    // Never more than full detail
+    SysTerrainIco::update_lod(lod, test.terrain, test.ico);
+    EXPECT_DOUBLE_EQ(lod.distanceScale, 1.0);
+    EXPECT_DOUBLE_EQ(thresholds[0], fullDetail);
+
+    // Never less than 1/1024
+    set_chunk_count(test.terrain, 101);
+    for (int i = 0; i < 64; ++i)
+    {
+        SysTerrainIco::update_lod(lod, test.terrain, test.ico);
+    }
+    EXPECT_DOUBLE_EQ(lod.distanceScale, 1.0 / 1024.0);
+    EXPECT_DOUBLE_EQ(thresholds[0], fullDetail / 1024.0);
+
+    // A limit larger than capacity is clamped, leaving a quarter of capacity free
+    std::size_t const capacity = test.terrain.skChunks.m_chunkIds.capacity();
+    lod.chunkLimit    = std::uint32_t(capacity * 2);
+    lod.distanceScale = 1.0;
+    set_chunk_count(test.terrain, capacity - capacity / 4 + 1);
+    SysTerrainIco::update_lod(lod, test.terrain, test.ico);
+    EXPECT_DOUBLE_EQ(lod.distanceScale, 0.75);
+
+    set_chunk_count(test.terrain, 0);
+}
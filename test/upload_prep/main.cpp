@@ -0,0 +1,188 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/drawing/upload_prep.h>
+
+#include <Magnum/Math/Vector3.h>
+#include <Magnum/MeshTools/Interleave.h>
+#include <Magnum/Trade/MeshData.h>
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <vector>
+
+using namespace osp;
+using namespace osp::draw;
+
+using Magnum::ImageView2D;
+using Magnum::MeshAttribute;
+using Magnum::MeshPrimitive;
+using Magnum::PixelFormat;
+using Magnum::Vector2i;
+using Magnum::Vector3;
+using Magnum::Trade::MeshAttributeData;
+using Magnum::Trade::MeshData;
+using Magnum::Trade::MeshIndexData;
+
+namespace
+{
+
+struct SeparateVertices
+{
+    std::array<Vector3, 3> positions {{ {0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f} }};
+    std::array<Vector3, 3> normals   {{ {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f} }};
+};
+
+/// Non-owning triangle with positions and normals in separate arrays
+MeshData make_separate_mesh(SeparateVertices const& vertices, std::array<Magnum::UnsignedShort, 3> const& indices)
+{
+    return MeshData{MeshPrimitive::Triangles,
+                    {}, Corrade::Containers::arrayView(indices), MeshIndexData{Corrade::Containers::arrayView(indices)},
+                    {}, Corrade::Containers::arrayView(&vertices, 1),
+                    Corrade::Containers::array({
+                        MeshAttributeData{MeshAttribute::Position, Corrade::Containers::arrayView(vertices.positions)},
+                        MeshAttributeData{MeshAttribute::Normal,   Corrade::Containers::arrayView(vertices.normals)} })};
+}
+
+} // namespace
+
+// Test interleaving a mesh with separate attribute arrays into owned data
+TEST(UploadPrep, PrepareMesh)
+{
+    SeparateVertices const                          vertices;
+    std::array<Magnum::UnsignedShort, 3> const      indices{2, 1, 0};
+
+    MeshData const mesh     = make_separate_mesh(vertices, indices);
+    MeshData const prepared = SysUploadPrep::prepare_mesh(mesh);
+
+    EXPECT_TRUE(Magnum::MeshTools::isInterleaved(prepared));
+    EXPECT_NE(prepared.vertexData().data(), static_cast<void const*>(&vertices));
+    EXPECT_NE(prepared.indexData().data(),  static_cast<void const*>(indices.data()));
+
+    ASSERT_TRUE(prepared.isIndexed());
+    ASSERT_EQ(prepared.indexCount(),  3);
+    ASSERT_EQ(prepared.vertexCount(), 3);
+
+    auto const outIndices   = prepared.indices<Magnum::UnsignedShort>();
+    auto const outPositions = prepared.attribute<Vector3>(MeshAttribute::Position);
+    auto const outNormals   = prepared.attribute<Vector3>(MeshAttribute::Normal);
+
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        EXPECT_EQ(outIndices[i],   indices[i]);
+        EXPECT_EQ(outPositions[i], vertices.positions[i]);
+        EXPECT_EQ(outNormals[i],   vertices.normals[i]);
+    }
+}
+
+TEST(UploadPrep, MipCount)
+{
+    EXPECT_EQ(SysUploadPrep::mip_count({1, 1}),       1);
+    EXPECT_EQ(SysUploadPrep::mip_count({2, 1}),       2);
+    EXPECT_EQ(SysUploadPrep::mip_count({256, 256}),   9);
+    EXPECT_EQ(SysUploadPrep::mip_count({300, 17}),    9);
+}
+
+// Test box filtering down to 1x1, including odd sizes and padded source rows
+TEST(UploadPrep, MipChain)
+{
+    // 3x2 R8, rows padded to 4 bytes by the default pixel storage alignment
+    std::array<char, 8> const pixels
+    {
+        char(0),   char(40),  char(80),  char(0),
+        char(100), char(140), char(200), char(0)
+    };
+    ImageView2D const image{PixelFormat::R8Unorm, {3, 2}, pixels};
+
+    MipChain const chain = SysUploadPrep::build_mip_chain(image, true);
+
+    ASSERT_EQ(chain.level_count(), 2);
+    EXPECT_EQ(chain.sizes[0], Vector2i(3, 2));
+    EXPECT_EQ(chain.sizes[1], Vector2i(1, 1));
+    EXPECT_EQ(chain.level_bytes(0), 6);
+    EXPECT_EQ(chain.level_bytes(1), 1);
+
+    // Level 0 is copied without row padding
+    auto const level0 = chain.level(0);
+    ASSERT_EQ(level0.data().size(), 6);
+    EXPECT_EQ((unsigned char)(level0.data()[2]), 80);
+    EXPECT_EQ((unsigned char)(level0.data()[3]), 100);
+
+    // Level 1 averages the top left 2x2 texels, rounded
+    EXPECT_EQ((unsigned char)(chain.level(1).data()[0]), (0 + 40 + 100 + 140 + 2) / 4);
+}
+
+TEST(UploadPrep, MipChainSingleLevel)
+{
+    std::array<float, 4> const pixels{0.0f, 1.0f, 2.0f, 3.0f};
+
+    // Float formats aren't box filtered
+    ImageView2D const floatImage{PixelFormat::R32F, {2, 2}, pixels};
+    EXPECT_EQ(SysUploadPrep::build_mip_chain(floatImage, true).level_count(), 1);
+
+    // Mipmaps not requested
+    ImageView2D const byteImage{PixelFormat::RGBA8Unorm, {2, 2}, pixels};
+    MipChain const chain = SysUploadPrep::build_mip_chain(byteImage, false);
+    ASSERT_EQ(chain.level_count(), 1);
+    EXPECT_EQ(chain.data.size(), 16);
+}
+
+// Test preparing resources on the worker thread
+TEST(UploadPrep, Worker)
+{
+    SeparateVertices const                          vertices;
+    std::array<Magnum::UnsignedShort, 3> const      indices{0, 1, 2};
+    std::array<char, 16> const                      pixels{};
+
+    ResourcePrepWorker worker;
+
+    worker.submit_mesh(ResId(1), make_separate_mesh(vertices, indices));
+    worker.submit_texture(ResId(2), ImageView2D{PixelFormat::RGBA8Unorm, {2, 2}, pixels}, true);
+    worker.wait_idle();
+
+    std::vector<PreparedMesh> const     meshes   = worker.take_meshes();
+    std::vector<PreparedTexture> const  textures = worker.take_textures();
+
+    ASSERT_EQ(meshes.size(), 1);
+    EXPECT_EQ(meshes[0].res, ResId(1));
+    EXPECT_TRUE(Magnum::MeshTools::isInterleaved(meshes[0].mesh));
+
+    ASSERT_EQ(textures.size(), 1);
+    EXPECT_EQ(textures[0].res, ResId(2));
+    EXPECT_EQ(textures[0].mips.level_count(), 2);
+
+    // Results are only taken once
+    EXPECT_TRUE(worker.take_meshes().empty());
+    EXPECT_TRUE(worker.take_textures().empty());
+
+    // Cleared jobs never produce results
+    worker.submit_texture(ResId(3), ImageView2D{PixelFormat::RGBA8Unorm, {2, 2}, pixels}, true);
+    worker.clear();
+    worker.wait_idle();
+    EXPECT_TRUE(worker.take_textures().empty());
+}